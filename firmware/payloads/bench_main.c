@@ -0,0 +1,649 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * SBI ecall latency benchmark payload.
+ *
+ * Every benchmark issues one SBI call per iteration from S-mode and
+ * measures its round trip with the cycle counter. Results are printed
+ * as one comma separated line per benchmark:
+ *
+ *   bench,<name>,<iterations>,<min>,<median>,<p99>,<max>
+ *
+ * and benchmarks which cannot run are reported as:
+ *
+ *   bench-skip,<name>,<error>
+ *
+ * The batch benchmarks queue several calls in the command ring of the
+ * OpenSBI specific extension and time one doorbell call. Their cycles
+ * are divided by the number of queued calls to give the amortized cost
+ * of one call.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_batch.h>
+#include "payload_sbi.h"
+
+/** Number of timed calls of each benchmark */
+#define BENCH_ITERATIONS	1000
+
+/** Number of untimed calls before the measurement */
+#define BENCH_WARMUP		16
+
+#define BENCH_PAGE_SIZE		4096
+
+/** Number of entries in the batch command ring */
+#define BENCH_BATCH_ENTRIES	16
+
+/** Cycle, time and instret counters which stay claimed once matched */
+#define BENCH_PMU_FIXED_COUNTERS	0x7UL
+
+struct bench_case {
+	const char *name;
+	unsigned long ext;
+	/* Untimed setup, returns an SBI error code */
+	long (*setup)(void);
+	/* Untimed work before each timed call */
+	void (*before)(void);
+	/* The timed SBI call */
+	struct sbiret (*call)(void);
+	/* Untimed work after each timed call */
+	void (*after)(void);
+	/* Untimed cleanup after the last iteration */
+	void (*teardown)(void);
+	/* Number of SBI calls made by each timed call (zero means one) */
+	unsigned long batch;
+};
+
+static unsigned long bench_hartid;
+static unsigned long bench_counter_mask;
+static unsigned long bench_counter;
+static unsigned long bench_fwft_value;
+static unsigned long bench_samples[BENCH_ITERATIONS];
+static char bench_dbcn_buf[8];
+static char bench_mpxy_shmem[BENCH_PAGE_SIZE]
+	__attribute__((aligned(BENCH_PAGE_SIZE)));
+static struct sbi_batch_entry bench_batch_ring[BENCH_BATCH_ENTRIES];
+static unsigned long bench_batch_count;
+
+/*
+ * SSE handler which completes the event right away. SBI restores a6
+ * and a7 of the interrupted context on completion and no other
+ * register is touched.
+ */
+void bench_sse_entry(void);
+asm(".section .text\n"
+    ".align 2\n"
+    "bench_sse_entry:\n"
+    "	li	a7, " PAYLOAD_STR(SBI_EXT_SSE) "\n"
+    "	li	a6, " PAYLOAD_STR(SBI_EXT_SSE_COMPLETE) "\n"
+    "	ecall\n"
+    "	j	bench_sse_entry\n");
+
+static struct sbiret bench_base_get_spec_version(void)
+{
+	return sbi_ecall(SBI_EXT_BASE, SBI_EXT_BASE_GET_SPEC_VERSION,
+			 0, 0, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_base_probe_ext(void)
+{
+	return sbi_ecall(SBI_EXT_BASE, SBI_EXT_BASE_PROBE_EXT,
+			 SBI_EXT_TIME, 0, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_time_set_timer(void)
+{
+	/* Far enough in the future to never fire */
+	return sbi_ecall(SBI_EXT_TIME, SBI_EXT_TIME_SET_TIMER,
+			 -1UL, -1UL, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_ipi_send_self(void)
+{
+	return sbi_ecall(SBI_EXT_IPI, SBI_EXT_IPI_SEND_IPI,
+			 1, bench_hartid, 0, 0, 0, 0);
+}
+
+static void bench_ipi_clear(void)
+{
+	csr_clear(CSR_SIP, SIP_SSIP);
+}
+
+static struct sbiret bench_rfence_fence_i(void)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_FENCE_I,
+			 1, bench_hartid, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_rfence_sfence_vma_page(void)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			 1, bench_hartid, 0, BENCH_PAGE_SIZE, 0, 0);
+}
+
+static struct sbiret bench_rfence_sfence_vma_all(void)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			 1, bench_hartid, 0, -1UL, 0, 0);
+}
+
+static struct sbiret bench_rfence_sfence_vma_asid(void)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA_ASID,
+			 1, bench_hartid, 0, BENCH_PAGE_SIZE, 0, 0);
+}
+
+static struct sbiret bench_hsm_get_status(void)
+{
+	return sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_GET_STATUS,
+			 bench_hartid, 0, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_pmu_num_counters(void)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_NUM_COUNTERS,
+			 0, 0, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_pmu_cfg_match_event(unsigned long flags,
+					       unsigned long type,
+					       unsigned long code)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_CFG_MATCH,
+			 0, bench_counter_mask, flags,
+			 (type << SBI_PMU_EVENT_IDX_TYPE_OFFSET) | code,
+			 0, 0);
+}
+
+static long bench_pmu_setup(void)
+{
+	struct sbiret ret = bench_pmu_num_counters();
+
+	if (ret.error)
+		return ret.error;
+	if (!ret.value)
+		return SBI_ERR_NOT_SUPPORTED;
+
+	/*
+	 * Only match programmable counters. Stopping a fixed counter with
+	 * reset does not release it, so the cycle counter taken by the
+	 * first cfg_match would stay claimed and the later calls would
+	 * time a different path.
+	 */
+	bench_counter_mask = (ret.value < __riscv_xlen) ?
+			     (1UL << ret.value) - 1 : -1UL;
+	bench_counter_mask &= ~BENCH_PMU_FIXED_COUNTERS;
+	if (!bench_counter_mask)
+		return SBI_ERR_NOT_SUPPORTED;
+
+	return 0;
+}
+
+/* Claims a cycle counter for the start and stop benchmarks */
+static long bench_pmu_cycles_setup(void)
+{
+	struct sbiret ret;
+	long rc = bench_pmu_setup();
+
+	if (rc)
+		return rc;
+
+	ret = bench_pmu_cfg_match_event(SBI_PMU_CFG_FLAG_CLEAR_VALUE,
+					SBI_PMU_EVENT_TYPE_HW,
+					SBI_PMU_HW_CPU_CYCLES);
+	if (ret.error)
+		return ret.error;
+
+	bench_counter = ret.value;
+	return 0;
+}
+
+static struct sbiret bench_pmu_cfg_match(void)
+{
+	struct sbiret ret;
+
+	ret = bench_pmu_cfg_match_event(SBI_PMU_CFG_FLAG_CLEAR_VALUE,
+					SBI_PMU_EVENT_TYPE_HW,
+					SBI_PMU_HW_CPU_CYCLES);
+	bench_counter = ret.value;
+	return ret;
+}
+
+static struct sbiret bench_pmu_start(void)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_START,
+			 bench_counter, 1, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_pmu_stop(void)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_STOP,
+			 bench_counter, 1, 0, 0, 0, 0);
+}
+
+static void bench_pmu_start_untimed(void)
+{
+	bench_pmu_start();
+}
+
+static void bench_pmu_stop_untimed(void)
+{
+	bench_pmu_stop();
+}
+
+/* Stopping with reset releases a programmable counter even if it is not running */
+static void bench_pmu_release(void)
+{
+	sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_STOP,
+		  bench_counter, 1, SBI_PMU_STOP_FLAG_RESET, 0, 0, 0);
+}
+
+static long bench_pmu_fw_setup(void)
+{
+	struct sbiret ret;
+	long rc = bench_pmu_setup();
+
+	if (rc)
+		return rc;
+
+	ret = bench_pmu_cfg_match_event(SBI_PMU_CFG_FLAG_CLEAR_VALUE |
+					SBI_PMU_CFG_FLAG_AUTO_START,
+					SBI_PMU_EVENT_TYPE_FW,
+					SBI_PMU_FW_SET_TIMER);
+	if (ret.error)
+		return ret.error;
+
+	bench_counter = ret.value;
+	return 0;
+}
+
+static struct sbiret bench_pmu_fw_read(void)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_FW_READ,
+			 bench_counter, 0, 0, 0, 0, 0);
+}
+
+/* Zero bytes so that only the call path is measured */
+static struct sbiret bench_dbcn_write(void)
+{
+	return sbi_ecall(SBI_EXT_DBCN, SBI_EXT_DBCN_CONSOLE_WRITE,
+			 0, (unsigned long)bench_dbcn_buf, 0, 0, 0, 0);
+}
+
+static long bench_sse_setup(void)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_HART_UNMASK,
+			0, 0, 0, 0, 0, 0);
+	if (ret.error && ret.error != SBI_ERR_ALREADY_STARTED)
+		return ret.error;
+
+	ret = sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_REGISTER,
+			SBI_SSE_EVENT_LOCAL_SOFTWARE,
+			(unsigned long)bench_sse_entry, 0, 0, 0, 0);
+	if (ret.error)
+		return ret.error;
+
+	ret = sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_ENABLE,
+			SBI_SSE_EVENT_LOCAL_SOFTWARE, 0, 0, 0, 0, 0);
+	if (ret.error) {
+		sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_UNREGISTER,
+			  SBI_SSE_EVENT_LOCAL_SOFTWARE, 0, 0, 0, 0, 0);
+		return ret.error;
+	}
+
+	return 0;
+}
+
+/* Includes delivery of the event and its completion by the handler */
+static struct sbiret bench_sse_inject(void)
+{
+	return sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_INJECT,
+			 SBI_SSE_EVENT_LOCAL_SOFTWARE, bench_hartid,
+			 0, 0, 0, 0);
+}
+
+static void bench_sse_teardown(void)
+{
+	sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_DISABLE,
+		  SBI_SSE_EVENT_LOCAL_SOFTWARE, 0, 0, 0, 0, 0);
+	sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_UNREGISTER,
+		  SBI_SSE_EVENT_LOCAL_SOFTWARE, 0, 0, 0, 0, 0);
+	sbi_ecall(SBI_EXT_SSE, SBI_EXT_SSE_HART_MASK, 0, 0, 0, 0, 0, 0);
+}
+
+static struct sbiret bench_fwft_get(void)
+{
+	return sbi_ecall(SBI_EXT_FWFT, SBI_EXT_FWFT_GET,
+			 SBI_FWFT_MISALIGNED_EXC_DELEG, 0, 0, 0, 0, 0);
+}
+
+static long bench_fwft_setup(void)
+{
+	struct sbiret ret = bench_fwft_get();
+
+	if (ret.error)
+		return ret.error;
+
+	bench_fwft_value = ret.value;
+	return 0;
+}
+
+/* Writes back the current value so the payload state is unchanged */
+static struct sbiret bench_fwft_set(void)
+{
+	return sbi_ecall(SBI_EXT_FWFT, SBI_EXT_FWFT_SET,
+			 SBI_FWFT_MISALIGNED_EXC_DELEG, bench_fwft_value,
+			 0, 0, 0, 0);
+}
+
+static struct sbiret bench_mpxy_get_shmem_size(void)
+{
+	return sbi_ecall(SBI_EXT_MPXY, SBI_EXT_MPXY_GET_SHMEM_SIZE,
+			 0, 0, 0, 0, 0, 0);
+}
+
+static long bench_mpxy_setup(void)
+{
+	struct sbiret ret = bench_mpxy_get_shmem_size();
+
+	if (ret.error)
+		return ret.error;
+	if (ret.value > sizeof(bench_mpxy_shmem))
+		return SBI_ERR_NO_SHMEM;
+
+	return 0;
+}
+
+static struct sbiret bench_mpxy_set_shmem(void)
+{
+	return sbi_ecall(SBI_EXT_MPXY, SBI_EXT_MPXY_SET_SHMEM,
+			 (unsigned long)bench_mpxy_shmem, 0, 0, 0, 0, 0);
+}
+
+static long bench_mpxy_channels_setup(void)
+{
+	long rc = bench_mpxy_setup();
+
+	if (rc)
+		return rc;
+
+	return bench_mpxy_set_shmem().error;
+}
+
+static struct sbiret bench_mpxy_get_channel_ids(void)
+{
+	return sbi_ecall(SBI_EXT_MPXY, SBI_EXT_MPXY_GET_CHANNEL_IDS,
+			 0, 0, 0, 0, 0, 0);
+}
+
+static void bench_mpxy_teardown(void)
+{
+	sbi_ecall(SBI_EXT_MPXY, SBI_EXT_MPXY_SET_SHMEM,
+		  -1UL, -1UL, 0, 0, 0, 0);
+}
+
+static void bench_batch_queue(unsigned long idx, unsigned long ext,
+			      unsigned long fid, unsigned long arg0,
+			      unsigned long arg1, unsigned long arg2,
+			      unsigned long arg3)
+{
+	struct sbi_batch_entry *ent = &bench_batch_ring[idx];
+
+	sbi_memset(ent, 0, sizeof(*ent));
+	ent->extid = ext;
+	ent->funcid = fid;
+	ent->args[0] = arg0;
+	ent->args[1] = arg1;
+	ent->args[2] = arg2;
+	ent->args[3] = arg3;
+}
+
+static long bench_batch_register(unsigned long count)
+{
+	bench_batch_count = count;
+	return sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_SET_SHMEM,
+			 (unsigned long)bench_batch_ring, 0,
+			 BENCH_BATCH_ENTRIES, 0, 0, 0).error;
+}
+
+static long bench_batch_set_timer_setup(unsigned long count)
+{
+	unsigned long i;
+
+	for (i = 0; i < count; i++)
+		bench_batch_queue(i, SBI_EXT_TIME, SBI_EXT_TIME_SET_TIMER,
+				  -1UL, -1UL, 0, 0);
+
+	return bench_batch_register(count);
+}
+
+static long bench_batch_set_timer_x1_setup(void)
+{
+	return bench_batch_set_timer_setup(1);
+}
+
+static long bench_batch_set_timer_x4_setup(void)
+{
+	return bench_batch_set_timer_setup(4);
+}
+
+static long bench_batch_set_timer_x16_setup(void)
+{
+	return bench_batch_set_timer_setup(16);
+}
+
+/* Calls of a hypervisor switching to another vCPU */
+static long bench_batch_vcpu_switch_setup(void)
+{
+	bench_batch_queue(0, SBI_EXT_TIME, SBI_EXT_TIME_SET_TIMER,
+			  -1UL, -1UL, 0, 0);
+	bench_batch_queue(1, SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			  1, bench_hartid, 0, BENCH_PAGE_SIZE);
+	bench_batch_queue(2, SBI_EXT_RFENCE,
+			  SBI_EXT_RFENCE_REMOTE_SFENCE_VMA_ASID,
+			  1, bench_hartid, 0, BENCH_PAGE_SIZE);
+	bench_batch_queue(3, SBI_EXT_IPI, SBI_EXT_IPI_SEND_IPI,
+			  1, bench_hartid, 0, 0);
+
+	return bench_batch_register(4);
+}
+
+static struct sbiret bench_batch_doorbell(void)
+{
+	struct sbiret ret;
+	unsigned long i;
+
+	ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_DOORBELL,
+			0, bench_batch_count, 0, 0, 0, 0);
+	if (ret.error)
+		return ret;
+
+	for (i = 0; i < bench_batch_count; i++) {
+		if (bench_batch_ring[i].error) {
+			ret.error = bench_batch_ring[i].error;
+			break;
+		}
+	}
+
+	return ret;
+}
+
+static void bench_batch_teardown(void)
+{
+	sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_SET_SHMEM,
+		  -1UL, -1UL, 0, 0, 0, 0);
+}
+
+static const struct bench_case bench_cases[] = {
+	{ .name = "base.get_spec_version", .ext = SBI_EXT_BASE,
+	  .call = bench_base_get_spec_version },
+	{ .name = "base.probe_ext", .ext = SBI_EXT_BASE,
+	  .call = bench_base_probe_ext },
+	{ .name = "time.set_timer", .ext = SBI_EXT_TIME,
+	  .call = bench_time_set_timer },
+	{ .name = "ipi.send_ipi", .ext = SBI_EXT_IPI,
+	  .call = bench_ipi_send_self, .after = bench_ipi_clear },
+	{ .name = "rfence.fence_i", .ext = SBI_EXT_RFENCE,
+	  .call = bench_rfence_fence_i },
+	{ .name = "rfence.sfence_vma_page", .ext = SBI_EXT_RFENCE,
+	  .call = bench_rfence_sfence_vma_page },
+	{ .name = "rfence.sfence_vma_all", .ext = SBI_EXT_RFENCE,
+	  .call = bench_rfence_sfence_vma_all },
+	{ .name = "rfence.sfence_vma_asid", .ext = SBI_EXT_RFENCE,
+	  .call = bench_rfence_sfence_vma_asid },
+	{ .name = "hsm.get_status", .ext = SBI_EXT_HSM,
+	  .call = bench_hsm_get_status },
+	{ .name = "pmu.num_counters", .ext = SBI_EXT_PMU,
+	  .call = bench_pmu_num_counters },
+	{ .name = "pmu.cfg_match", .ext = SBI_EXT_PMU,
+	  .setup = bench_pmu_setup, .call = bench_pmu_cfg_match,
+	  .after = bench_pmu_release },
+	{ .name = "pmu.start", .ext = SBI_EXT_PMU,
+	  .setup = bench_pmu_cycles_setup, .call = bench_pmu_start,
+	  .after = bench_pmu_stop_untimed,
+	  .teardown = bench_pmu_release },
+	{ .name = "pmu.stop", .ext = SBI_EXT_PMU,
+	  .setup = bench_pmu_cycles_setup, .before = bench_pmu_start_untimed,
+	  .call = bench_pmu_stop, .teardown = bench_pmu_release },
+	{ .name = "pmu.fw_read", .ext = SBI_EXT_PMU,
+	  .setup = bench_pmu_fw_setup, .call = bench_pmu_fw_read,
+	  .teardown = bench_pmu_release },
+	{ .name = "dbcn.write", .ext = SBI_EXT_DBCN,
+	  .call = bench_dbcn_write },
+	{ .name = "sse.inject_complete", .ext = SBI_EXT_SSE,
+	  .setup = bench_sse_setup, .call = bench_sse_inject,
+	  .teardown = bench_sse_teardown },
+	{ .name = "fwft.get", .ext = SBI_EXT_FWFT,
+	  .call = bench_fwft_get },
+	{ .name = "fwft.set", .ext = SBI_EXT_FWFT,
+	  .setup = bench_fwft_setup, .call = bench_fwft_set },
+	{ .name = "mpxy.get_shmem_size", .ext = SBI_EXT_MPXY,
+	  .call = bench_mpxy_get_shmem_size },
+	{ .name = "mpxy.set_shmem", .ext = SBI_EXT_MPXY,
+	  .setup = bench_mpxy_setup, .call = bench_mpxy_set_shmem,
+	  .teardown = bench_mpxy_teardown },
+	{ .name = "mpxy.get_channel_ids", .ext = SBI_EXT_MPXY,
+	  .setup = bench_mpxy_channels_setup,
+	  .call = bench_mpxy_get_channel_ids,
+	  .teardown = bench_mpxy_teardown },
+	{ .name = "batch.set_timer_x1", .ext = SBI_EXT_OPENSBI,
+	  .setup = bench_batch_set_timer_x1_setup,
+	  .call = bench_batch_doorbell, .teardown = bench_batch_teardown,
+	  .batch = 1 },
+	{ .name = "batch.set_timer_x4", .ext = SBI_EXT_OPENSBI,
+	  .setup = bench_batch_set_timer_x4_setup,
+	  .call = bench_batch_doorbell, .teardown = bench_batch_teardown,
+	  .batch = 4 },
+	{ .name = "batch.set_timer_x16", .ext = SBI_EXT_OPENSBI,
+	  .setup = bench_batch_set_timer_x16_setup,
+	  .call = bench_batch_doorbell, .teardown = bench_batch_teardown,
+	  .batch = 16 },
+	{ .name = "batch.vcpu_switch_x4", .ext = SBI_EXT_OPENSBI,
+	  .setup = bench_batch_vcpu_switch_setup,
+	  .call = bench_batch_doorbell, .after = bench_ipi_clear,
+	  .teardown = bench_batch_teardown, .batch = 4 },
+};
+
+static void bench_sort(unsigned long *samples, unsigned long count)
+{
+	unsigned long i, j, val;
+
+	for (i = 1; i < count; i++) {
+		val = samples[i];
+		for (j = i; j && samples[j - 1] > val; j--)
+			samples[j] = samples[j - 1];
+		samples[j] = val;
+	}
+}
+
+static void bench_skip(const struct bench_case *bc, long error)
+{
+	payload_puts("bench-skip,");
+	payload_puts(bc->name);
+	payload_puts(",");
+	payload_putl(error);
+	payload_puts("\n");
+}
+
+static void bench_run(const struct bench_case *bc)
+{
+	unsigned long i, start;
+	struct sbiret ret;
+	long rc;
+
+	ret = sbi_ecall(SBI_EXT_BASE, SBI_EXT_BASE_PROBE_EXT,
+			bc->ext, 0, 0, 0, 0, 0);
+	if (ret.error || !ret.value) {
+		bench_skip(bc, SBI_ERR_NOT_SUPPORTED);
+		return;
+	}
+
+	rc = (bc->setup) ? bc->setup() : 0;
+	if (rc) {
+		bench_skip(bc, rc);
+		return;
+	}
+
+	for (i = 0; i < BENCH_WARMUP + BENCH_ITERATIONS; i++) {
+		if (bc->before)
+			bc->before();
+
+		start = csr_read(CSR_CYCLE);
+		ret = bc->call();
+		start = csr_read(CSR_CYCLE) - start;
+
+		if (bc->after)
+			bc->after();
+
+		if (ret.error) {
+			if (bc->teardown)
+				bc->teardown();
+			bench_skip(bc, ret.error);
+			return;
+		}
+
+		if (bc->batch)
+			start /= bc->batch;
+		if (BENCH_WARMUP <= i)
+			bench_samples[i - BENCH_WARMUP] = start;
+	}
+
+	if (bc->teardown)
+		bc->teardown();
+
+	bench_sort(bench_samples, BENCH_ITERATIONS);
+
+	payload_puts("bench,");
+	payload_puts(bc->name);
+	payload_puts(",");
+	payload_putul(BENCH_ITERATIONS);
+	payload_puts(",");
+	payload_putul(bench_samples[0]);
+	payload_puts(",");
+	payload_putul(bench_samples[BENCH_ITERATIONS / 2]);
+	payload_puts(",");
+	payload_putul(bench_samples[(BENCH_ITERATIONS * 99) / 100]);
+	payload_puts(",");
+	payload_putul(bench_samples[BENCH_ITERATIONS - 1]);
+	payload_puts("\n");
+}
+
+/* Called by test_head.S with the boot HART id in a0 */
+void test_main(unsigned long a0, unsigned long a1)
+{
+	unsigned long i;
+
+	bench_hartid = a0;
+
+	payload_puts("\nSBI ecall benchmark (cycles)\n");
+	payload_puts("bench,name,iterations,min,median,p99,max\n");
+	for (i = 0; i < array_size(bench_cases); i++)
+		bench_run(&bench_cases[i]);
+	payload_puts("bench-done\n");
+
+	payload_shutdown();
+	payload_puts("Shutdown failed to execute.\n");
+}
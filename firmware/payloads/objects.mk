@@ -8,6 +8,8 @@
 #
 
 firmware-bins-$(FW_PAYLOAD) += payloads/test.bin
+firmware-bins-$(FW_PAYLOAD) += payloads/bench.bin
+firmware-bins-$(FW_PAYLOAD) += payloads/stress.bin
 
 test-y += test_head.o
 test-y += test_main.o
@@ -17,3 +19,29 @@ test-y += test_main.o
 
 %/test.dep: $(foreach dep,$(test-y:.o=.dep),%/$(dep))
 	$(call merge_deps,$@,$^)
+
+bench-y += test_head.o
+bench-y += bench_main.o
+
+%/bench.o: $(foreach obj,$(bench-y),%/$(obj))
+	$(call merge_objs,$@,$^)
+
+%/bench.dep: $(foreach dep,$(bench-y:.o=.dep),%/$(dep))
+	$(call merge_deps,$@,$^)
+
+# Same memory layout as the test payload
+%/bench.elf.ld: $(src_dir)/firmware/payloads/test.elf.ldS
+	$(call compile_cpp,$@,$<)
+
+stress-y += test_head.o
+stress-y += stress_main.o
+
+%/stress.o: $(foreach obj,$(stress-y),%/$(obj))
+	$(call merge_objs,$@,$^)
+
+%/stress.dep: $(foreach dep,$(stress-y:.o=.dep),%/$(dep))
+	$(call merge_deps,$@,$^)
+
+# Same memory layout as the test payload
+%/stress.elf.ld: $(src_dir)/firmware/payloads/test.elf.ldS
+	$(call compile_cpp,$@,$<)
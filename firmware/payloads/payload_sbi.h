@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * SBI call and console helpers shared by the benchmark payloads.
+ */
+
+#ifndef __PAYLOAD_SBI_H__
+#define __PAYLOAD_SBI_H__
+
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_string.h>
+
+#define __PAYLOAD_STR(x)	#x
+#define PAYLOAD_STR(x)		__PAYLOAD_STR(x)
+
+struct sbiret {
+	unsigned long error;
+	unsigned long value;
+};
+
+static inline struct sbiret sbi_ecall(int ext, int fid, unsigned long arg0,
+				      unsigned long arg1, unsigned long arg2,
+				      unsigned long arg3, unsigned long arg4,
+				      unsigned long arg5)
+{
+	struct sbiret ret;
+
+	register unsigned long a0 asm ("a0") = (unsigned long)(arg0);
+	register unsigned long a1 asm ("a1") = (unsigned long)(arg1);
+	register unsigned long a2 asm ("a2") = (unsigned long)(arg2);
+	register unsigned long a3 asm ("a3") = (unsigned long)(arg3);
+	register unsigned long a4 asm ("a4") = (unsigned long)(arg4);
+	register unsigned long a5 asm ("a5") = (unsigned long)(arg5);
+	register unsigned long a6 asm ("a6") = (unsigned long)(fid);
+	register unsigned long a7 asm ("a7") = (unsigned long)(ext);
+	asm volatile ("ecall"
+		      : "+r" (a0), "+r" (a1)
+		      : "r" (a2), "r" (a3), "r" (a4), "r" (a5), "r" (a6), "r" (a7)
+		      : "memory");
+	ret.error = a0;
+	ret.value = a1;
+
+	return ret;
+}
+
+static inline void payload_puts(const char *str)
+{
+	sbi_ecall(SBI_EXT_DBCN, SBI_EXT_DBCN_CONSOLE_WRITE,
+		  sbi_strlen(str), (unsigned long)str, 0, 0, 0, 0);
+}
+
+static inline void payload_putul(unsigned long val)
+{
+	char buf[24];
+	int pos = sizeof(buf) - 1;
+
+	buf[pos] = '\0';
+	do {
+		buf[--pos] = '0' + (val % 10);
+		val /= 10;
+	} while (val);
+
+	payload_puts(&buf[pos]);
+}
+
+static inline void payload_putl(long val)
+{
+	if (val < 0) {
+		payload_puts("-");
+		payload_putul(-(unsigned long)val);
+	} else {
+		payload_putul(val);
+	}
+}
+
+static inline void payload_shutdown(void)
+{
+	sbi_ecall(SBI_EXT_SRST, SBI_EXT_SRST_RESET,
+		  SBI_SRST_RESET_TYPE_SHUTDOWN, SBI_SRST_RESET_REASON_NONE,
+		  0, 0, 0, 0);
+}
+
+#endif
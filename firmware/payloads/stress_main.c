@@ -0,0 +1,361 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Multi-HART IPI and remote fence stress payload.
+ *
+ * The boot HART starts all stopped HARTs through HSM and then runs
+ * each traffic pattern on all of them at the same time. Results are
+ * printed as one comma separated line per pattern:
+ *
+ *   stress,<name>,<harts>,<requests>,<cycles>,<req_per_mcycle>,
+ *          <lat_min>,<lat_avg>,<lat_max>,<fifo_full>,<errors>
+ *
+ * where cycles is the wall time of the boot HART, the latencies are
+ * per request across all HARTs and fifo_full is the number of times
+ * the firmware found a remote TLB FIFO full (-1 if not available).
+ * Patterns which cannot run are reported as:
+ *
+ *   stress-skip,<name>,<error>
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include "payload_sbi.h"
+
+/** HART ids probed and maximum number of HARTs taking part */
+#ifndef STRESS_MAX_HARTS
+#define STRESS_MAX_HARTS	512
+#endif
+
+/** Requests sent by each sending HART per pattern */
+#ifndef STRESS_ITERATIONS
+#define STRESS_ITERATIONS	256
+#endif
+
+/** Pages flushed by each ranged fence request */
+#ifndef STRESS_RANGE_PAGES
+#define STRESS_RANGE_PAGES	4
+#endif
+
+#define STRESS_PAGE_SIZE	4096
+#define STRESS_RANGE_SIZE	(STRESS_RANGE_PAGES * STRESS_PAGE_SIZE)
+
+#define STRESS_STACK_SHIFT	10
+#define STRESS_STACK_SIZE	(1 << STRESS_STACK_SHIFT)
+
+/** Polls of the online count before giving up on starting HARTs */
+#define STRESS_START_TIMEOUT	100000000UL
+
+struct stress_pattern {
+	const char *name;
+	/* Only the boot HART sends requests (one-to-many) */
+	bool boot_only;
+	/* Issue request number i of the calling HART */
+	struct sbiret (*request)(unsigned long i);
+};
+
+struct stress_hart {
+	unsigned long hartid;
+	unsigned long lat_min;
+	unsigned long lat_max;
+	unsigned long lat_total;
+	unsigned long requests;
+	unsigned long errors;
+} __aligned(64);
+
+static struct stress_hart stress_harts[STRESS_MAX_HARTS];
+static u32 stress_nharts;
+static u32 stress_online;
+static u32 stress_phase;
+static u32 stress_ready;
+static u32 stress_done;
+static unsigned long stress_start_cycle;
+
+/* Stacks of the secondary HARTs, indexed by their slot */
+char stress_stacks[STRESS_MAX_HARTS][STRESS_STACK_SIZE] __aligned(16);
+
+void stress_secondary(unsigned long hartid, unsigned long slot);
+
+/* HSM start entry with the slot of the HART as opaque argument */
+void stress_secondary_entry(void);
+asm(".section .text\n"
+    ".align 2\n"
+    "stress_secondary_entry:\n"
+    "	lla	t0, _start_hang\n"
+    "	csrw	stvec, t0\n"
+    "	csrw	sie, zero\n"
+    "	lla	sp, stress_stacks\n"
+    "	addi	t0, a1, 1\n"
+    "	slli	t0, t0, " PAYLOAD_STR(STRESS_STACK_SHIFT) "\n"
+    "	add	sp, sp, t0\n"
+    "	call	stress_secondary\n"
+    "	j	_start_hang\n");
+
+/* Requests are addressed to all HARTs with hart_mask_base == -1 */
+static struct sbiret stress_ipi(unsigned long i)
+{
+	return sbi_ecall(SBI_EXT_IPI, SBI_EXT_IPI_SEND_IPI,
+			 0, -1UL, 0, 0, 0, 0);
+}
+
+static struct sbiret stress_fence_i(unsigned long i)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_FENCE_I,
+			 0, -1UL, 0, 0, 0, 0);
+}
+
+/* Ranges move around so that queued requests are not always merged */
+static unsigned long stress_range_start(unsigned long i)
+{
+	return (i % 64) * STRESS_RANGE_SIZE;
+}
+
+static struct sbiret stress_sfence_vma(unsigned long i)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			 0, -1UL, stress_range_start(i), STRESS_RANGE_SIZE,
+			 0, 0);
+}
+
+static struct sbiret stress_sfence_vma_asid(unsigned long i)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA_ASID,
+			 0, -1UL, stress_range_start(i), STRESS_RANGE_SIZE,
+			 i % 16, 0);
+}
+
+static struct sbiret stress_hfence_gvma_vmid(unsigned long i)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_HFENCE_GVMA_VMID,
+			 0, -1UL, stress_range_start(i), STRESS_RANGE_SIZE,
+			 i % 16, 0);
+}
+
+static struct sbiret stress_hfence_vvma_asid(unsigned long i)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA_ASID,
+			 0, -1UL, stress_range_start(i), STRESS_RANGE_SIZE,
+			 i % 16, 0);
+}
+
+static const struct stress_pattern stress_patterns[] = {
+	{ "ipi.all_to_all", false, stress_ipi },
+	{ "fence_i.all_to_all", false, stress_fence_i },
+	{ "sfence_vma.one_to_many", true, stress_sfence_vma },
+	{ "sfence_vma.all_to_all", false, stress_sfence_vma },
+	{ "sfence_vma_asid.one_to_many", true, stress_sfence_vma_asid },
+	{ "sfence_vma_asid.all_to_all", false, stress_sfence_vma_asid },
+	{ "hfence_gvma_vmid.all_to_all", false, stress_hfence_gvma_vmid },
+	{ "hfence_vvma_asid.all_to_all", false, stress_hfence_vvma_asid },
+};
+
+static long stress_fifo_full_count(void)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_TLB_FIFO_FULL_COUNT,
+			0, 0, 0, 0, 0, 0);
+	return (ret.error) ? -1 : (long)ret.value;
+}
+
+static void stress_run(const struct stress_pattern *p, u32 slot)
+{
+	struct stress_hart *sh = &stress_harts[slot];
+	unsigned long i, start, lat;
+	struct sbiret ret;
+
+	/* Start all HARTs together */
+	__atomic_add_fetch(&stress_ready, 1, __ATOMIC_ACQ_REL);
+	while (__atomic_load_n(&stress_ready, __ATOMIC_ACQUIRE) < stress_nharts)
+		csr_clear(CSR_SIP, SIP_SSIP);
+	if (!slot)
+		stress_start_cycle = csr_read(CSR_CYCLE);
+
+	if (p->boot_only && slot)
+		goto done;
+
+	for (i = 0; i < STRESS_ITERATIONS; i++) {
+		start = csr_read(CSR_CYCLE);
+		ret = p->request(i);
+		lat = csr_read(CSR_CYCLE) - start;
+
+		/* Drop the IPI sent to ourselves by the all HART patterns */
+		csr_clear(CSR_SIP, SIP_SSIP);
+
+		if (ret.error) {
+			sh->errors++;
+			continue;
+		}
+
+		sh->requests++;
+		sh->lat_total += lat;
+		if (lat < sh->lat_min)
+			sh->lat_min = lat;
+		if (sh->lat_max < lat)
+			sh->lat_max = lat;
+	}
+
+done:
+	__atomic_add_fetch(&stress_done, 1, __ATOMIC_ACQ_REL);
+}
+
+void stress_secondary(unsigned long hartid, unsigned long slot)
+{
+	u32 phase = 0;
+
+	__atomic_add_fetch(&stress_online, 1, __ATOMIC_ACQ_REL);
+
+	while (1) {
+		while (__atomic_load_n(&stress_phase, __ATOMIC_ACQUIRE) == phase)
+			csr_clear(CSR_SIP, SIP_SSIP);
+
+		phase = __atomic_load_n(&stress_phase, __ATOMIC_ACQUIRE);
+		stress_run(&stress_patterns[phase - 1], slot);
+	}
+}
+
+static void stress_skip(const struct stress_pattern *p, long error)
+{
+	payload_puts("stress-skip,");
+	payload_puts(p->name);
+	payload_puts(",");
+	payload_putl(error);
+	payload_puts("\n");
+}
+
+static void stress_pattern_run(const struct stress_pattern *p, u32 index)
+{
+	unsigned long elapsed, requests = 0, errors = 0, total = 0;
+	unsigned long min = -1UL, max = 0;
+	long fifo_full;
+	struct sbiret ret;
+	u32 i;
+
+	/* One untimed request to find out if the firmware supports it */
+	ret = p->request(0);
+	csr_clear(CSR_SIP, SIP_SSIP);
+	if (ret.error) {
+		stress_skip(p, ret.error);
+		return;
+	}
+
+	for (i = 0; i < stress_nharts; i++) {
+		stress_harts[i].lat_min = -1UL;
+		stress_harts[i].lat_max = 0;
+		stress_harts[i].lat_total = 0;
+		stress_harts[i].requests = 0;
+		stress_harts[i].errors = 0;
+	}
+	stress_ready = 0;
+	stress_done = 0;
+	fifo_full = stress_fifo_full_count();
+
+	/* Release the secondary HARTs */
+	__atomic_store_n(&stress_phase, index + 1, __ATOMIC_RELEASE);
+	stress_run(p, 0);
+	while (__atomic_load_n(&stress_done, __ATOMIC_ACQUIRE) < stress_nharts)
+		csr_clear(CSR_SIP, SIP_SSIP);
+	elapsed = csr_read(CSR_CYCLE) - stress_start_cycle;
+
+	if (0 <= fifo_full)
+		fifo_full = stress_fifo_full_count() - fifo_full;
+
+	for (i = 0; i < stress_nharts; i++) {
+		requests += stress_harts[i].requests;
+		errors += stress_harts[i].errors;
+		total += stress_harts[i].lat_total;
+		if (stress_harts[i].lat_min < min)
+			min = stress_harts[i].lat_min;
+		if (max < stress_harts[i].lat_max)
+			max = stress_harts[i].lat_max;
+	}
+	if (!requests)
+		min = 0;
+	if (!elapsed)
+		elapsed = 1;
+
+	payload_puts("stress,");
+	payload_puts(p->name);
+	payload_puts(",");
+	payload_putul(stress_nharts);
+	payload_puts(",");
+	payload_putul(requests);
+	payload_puts(",");
+	payload_putul(elapsed);
+	payload_puts(",");
+	payload_putul((requests * 1000000UL) / elapsed);
+	payload_puts(",");
+	payload_putul(min);
+	payload_puts(",");
+	payload_putul((requests) ? total / requests : 0);
+	payload_puts(",");
+	payload_putul(max);
+	payload_puts(",");
+	payload_putl(fifo_full);
+	payload_puts(",");
+	payload_putul(errors);
+	payload_puts("\n");
+}
+
+/* Start every stopped HART and wait until all of them are running */
+static int stress_start_harts(unsigned long boot_hartid)
+{
+	unsigned long hartid, timeout = STRESS_START_TIMEOUT;
+	struct sbiret ret;
+
+	stress_harts[0].hartid = boot_hartid;
+	stress_nharts = 1;
+
+	for (hartid = 0; hartid < STRESS_MAX_HARTS; hartid++) {
+		if (hartid == boot_hartid)
+			continue;
+
+		ret = sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_GET_STATUS,
+				hartid, 0, 0, 0, 0, 0);
+		if (ret.error || ret.value != SBI_HSM_STATE_STOPPED)
+			continue;
+
+		ret = sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_START, hartid,
+				(unsigned long)stress_secondary_entry,
+				stress_nharts, 0, 0, 0);
+		if (ret.error)
+			continue;
+
+		stress_harts[stress_nharts++].hartid = hartid;
+	}
+
+	while (__atomic_load_n(&stress_online, __ATOMIC_ACQUIRE) <
+	       stress_nharts - 1) {
+		if (!--timeout)
+			return SBI_ERR_TIMEOUT;
+	}
+
+	return 0;
+}
+
+/* Called by test_head.S with the boot HART id in a0 */
+void test_main(unsigned long a0, unsigned long a1)
+{
+	u32 i;
+	int rc;
+
+	payload_puts("\nSBI IPI and remote fence stress (cycles)\n");
+
+	rc = stress_start_harts(a0);
+	if (rc) {
+		payload_puts("stress-error,hart-start,");
+		payload_putl(rc);
+		payload_puts("\n");
+		goto shutdown;
+	}
+
+	payload_puts("stress,name,harts,requests,cycles,req_per_mcycle,"
+		     "lat_min,lat_avg,lat_max,fifo_full,errors\n");
+	for (i = 0; i < array_size(stress_patterns); i++)
+		stress_pattern_run(&stress_patterns[i], i);
+	payload_puts("stress-done\n");
+
+shutdown:
+	payload_shutdown();
+	payload_puts("Shutdown failed to execute.\n");
+}
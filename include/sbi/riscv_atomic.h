@@ -10,10 +10,29 @@
 #ifndef __RISCV_ATOMIC_H__
 #define __RISCV_ATOMIC_H__
 
+#include <sbi/sbi_types.h>
+
 typedef struct {
 	volatile long counter;
 } atomic_t;
 
+/**
+ * Pair of machine words updated together by atomic_double_cmpxchg().
+ *
+ * Without the Zacas extension the pair is protected by a lock so it
+ * must only be accessed through the atomic_double_*() functions.
+ */
+typedef struct {
+	volatile unsigned long lo;
+	volatile unsigned long hi;
+} __aligned(2 * __SIZEOF_LONG__) atomic_double_t;
+
+#define ATOMIC_DOUBLE_INITIALIZER(_lo, _hi)	\
+	{					\
+		.lo = (_lo),			\
+		.hi = (_hi),			\
+	}
+
 #define ATOMIC_INIT(_lptr, val) (_lptr)->counter = (val)
 
 #define ATOMIC_INITIALIZER(val)   \
@@ -38,6 +57,48 @@ unsigned int atomic_raw_xchg_uint(volatile unsigned int *ptr,
 
 unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
 				    unsigned long newval);
+
+unsigned int atomic_raw_cmpxchg_uint(volatile unsigned int *ptr,
+				     unsigned int oldval, unsigned int newval);
+
+unsigned long atomic_raw_cmpxchg_ulong(volatile unsigned long *ptr,
+				       unsigned long oldval,
+				       unsigned long newval);
+
+/**
+ * Byte and halfword exchange. These use single AMOs with the Zabha
+ * extension and a CAS loop on the containing word otherwise.
+ */
+u8 atomic_raw_xchg_u8(volatile u8 *ptr, u8 newval);
+
+u16 atomic_raw_xchg_u16(volatile u16 *ptr, u16 newval);
+
+u8 atomic_raw_cmpxchg_u8(volatile u8 *ptr, u8 oldval, u8 newval);
+
+u16 atomic_raw_cmpxchg_u16(volatile u16 *ptr, u16 oldval, u16 newval);
+
+/**
+ * Compare and exchange both words of a double word atomic variable.
+ * @atom: atomic variable to modify
+ * @oldlo: expected low word, updated with the current value on failure
+ * @oldhi: expected high word, updated with the current value on failure
+ * @newlo: new low word
+ * @newhi: new high word
+ *
+ * Returns true if the new value was written. Pairing a pointer with a
+ * modification count in the high word makes lock-free updates ABA safe.
+ */
+bool atomic_double_cmpxchg(atomic_double_t *atom,
+			   unsigned long *oldlo, unsigned long *oldhi,
+			   unsigned long newlo, unsigned long newhi);
+
+/** Read both words of a double word atomic variable as one snapshot */
+void atomic_double_read(atomic_double_t *atom,
+			unsigned long *lo, unsigned long *hi);
+
+/** Write both words of a double word atomic variable */
+void atomic_double_write(atomic_double_t *atom,
+			 unsigned long lo, unsigned long hi);
 /**
  * Set a bit in an atomic variable and return the value of bit before modify.
  * @nr : Bit to set.
@@ -801,6 +801,9 @@
 
 /* Vector extension registers */
 #define CSR_VSTART			0x8
+#define CSR_VXSAT			0x9
+#define CSR_VXRM			0xa
+#define CSR_VCSR			0xf
 #define CSR_VL				0xc20
 #define CSR_VTYPE			0xc21
 #define CSR_VLENB			0xc22
@@ -8,6 +8,8 @@
 #ifndef __RISCV_LOCKS_H__
 #define __RISCV_LOCKS_H__
 
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
 #include <sbi/sbi_types.h>
 
 #define TICKET_SHIFT	16
@@ -42,4 +44,83 @@ void spin_lock(spinlock_t *lock);
 
 void spin_unlock(spinlock_t *lock);
 
+/*
+ * Sequence lock for read-mostly data. Writers serialize on a spinlock
+ * and bump the sequence before and after updating. Readers never take
+ * a lock, they retry when the sequence changed while reading.
+ */
+typedef struct {
+	spinlock_t lock;
+	u32 sequence;
+} seqlock_t;
+
+#define __SEQLOCK_UNLOCKED	\
+	(seqlock_t) { .lock = { 0, 0 }, .sequence = 0 }
+
+#define SEQLOCK_INIT(x)		\
+	x = __SEQLOCK_UNLOCKED
+
+#define SEQLOCK_INITIALIZER	\
+	__SEQLOCK_UNLOCKED
+
+#define DEFINE_SEQLOCK(x)	\
+	seqlock_t SEQLOCK_INIT(x)
+
+/** Start a read-side section and return the sequence to check against */
+static inline u32 read_seqbegin(const seqlock_t *sl)
+{
+	u32 seq;
+
+	/* Wait for an in-progress update to finish */
+	while ((seq = *(volatile const u32 *)&sl->sequence) & 1)
+		cpu_relax();
+	RISCV_FENCE(r, r);
+
+	return seq;
+}
+
+/** Check whether data read since read_seqbegin() may be inconsistent */
+static inline bool read_seqretry(const seqlock_t *sl, u32 start)
+{
+	RISCV_FENCE(r, r);
+	return *(volatile const u32 *)&sl->sequence != start;
+}
+
+void write_seqlock(seqlock_t *sl);
+
+void write_sequnlock(seqlock_t *sl);
+
+/*
+ * Reader-writer spinlock. The counter is the number of readers or -1
+ * when held by a writer. Readers are preferred so a writer can starve
+ * under a continuous stream of readers.
+ */
+typedef struct {
+	atomic_t count;
+} rwlock_t;
+
+#define __RW_LOCK_UNLOCKED	\
+	(rwlock_t) { .count = ATOMIC_INITIALIZER(0) }
+
+#define RW_LOCK_INIT(x)		\
+	x = __RW_LOCK_UNLOCKED
+
+#define RW_LOCK_INITIALIZER	\
+	__RW_LOCK_UNLOCKED
+
+#define DEFINE_RW_LOCK(x)	\
+	rwlock_t RW_LOCK_INIT(x)
+
+bool read_trylock(rwlock_t *lock);
+
+void read_lock(rwlock_t *lock);
+
+void read_unlock(rwlock_t *lock);
+
+bool write_trylock(rwlock_t *lock);
+
+void write_lock(rwlock_t *lock);
+
+void write_unlock(rwlock_t *lock);
+
 #endif
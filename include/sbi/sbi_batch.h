@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef __SBI_BATCH_H__
+#define __SBI_BATCH_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Maximum number of entries in the command ring of a HART */
+#define SBI_BATCH_MAX_ENTRIES		256
+
+/** Number of arguments of a queued SBI call */
+#define SBI_BATCH_MAX_ARGS		6
+
+/** Queued SBI call in the command ring (little-endian) */
+struct sbi_batch_entry {
+	/** Extension ID of the call (a7) */
+	u32 extid;
+	/** Function ID of the call (a6) */
+	u32 funcid;
+	/** Arguments of the call (a0 to a5) */
+	u64 args[SBI_BATCH_MAX_ARGS];
+	/** Error code of the call written back by SBI */
+	s64 error;
+	/** Return value of the call written back by SBI */
+	u64 value;
+};
+
+#ifdef CONFIG_SBI_BATCH
+
+/**
+ * Set the command ring of current HART
+ *
+ * Passing -1 as both the lower and upper bits of the address disables
+ * the command ring.
+ *
+ * @param shmem_phys_lo lower XLEN bits of the ring physical address
+ * @param shmem_phys_hi upper XLEN bits of the ring physical address
+ * @param num_entries number of entries in the ring
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_batch_set_shmem(unsigned long shmem_phys_lo,
+			unsigned long shmem_phys_hi,
+			unsigned long num_entries);
+
+/**
+ * Run SBI calls queued in the command ring of current HART
+ *
+ * The entries from start to start + count - 1 (modulo the number of
+ * entries in the ring) are processed in order. The result of each call
+ * is written back to its entry, so a failing call does not stop the
+ * following ones.
+ *
+ * @param start index of the first entry to process
+ * @param count number of entries to process
+ * @param out_count number of entries processed
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_batch_doorbell(unsigned long start, unsigned long count,
+		       unsigned long *out_count);
+
+/** Initialize batched SBI calls */
+int sbi_batch_init(struct sbi_scratch *scratch);
+
+#else
+
+static inline int sbi_batch_set_shmem(unsigned long shmem_phys_lo,
+				      unsigned long shmem_phys_hi,
+				      unsigned long num_entries)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline int sbi_batch_doorbell(unsigned long start, unsigned long count,
+				     unsigned long *out_count)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline int sbi_batch_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
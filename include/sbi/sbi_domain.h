@@ -185,6 +185,16 @@ static inline bool sbi_domain_memregion_is_subset(
 	return false;
 }
 
+/** Address interval with the first memory region matching it */
+struct sbi_domain_addr_interval {
+	/** Start address of the interval */
+	unsigned long start;
+	/** End address of the interval (inclusive) */
+	unsigned long end;
+	/** First matching memory region or NULL if not covered */
+	const struct sbi_domain_memregion *reg;
+};
+
 /** Representation of OpenSBI domain */
 struct sbi_domain {
 	/** Node in linked list of domains */
@@ -195,14 +205,21 @@ struct sbi_domain {
 	u32 index;
 	/** HARTs assigned to this domain */
 	struct sbi_hartmask assigned_harts;
-	/** Spinlock for accessing assigned_harts */
-	spinlock_t assigned_harts_lock;
+	/** Sequence lock for updating assigned_harts */
+	seqlock_t assigned_harts_lock;
 	/** Name of this domain */
 	char name[64];
 	/** Possible HARTs in this domain */
 	const struct sbi_hartmask *possible_harts;
 	/** Array of memory regions terminated by a region with order zero */
 	struct sbi_domain_memregion *regions;
+	/**
+	 * Sorted and contiguous address intervals covering the whole
+	 * address space, built from regions by sbi_domain_finalize()
+	 */
+	struct sbi_domain_addr_interval *addr_intervals;
+	/** Number of entries in addr_intervals */
+	u32 addr_interval_count;
 	/** HART id of the HART booting this domain */
 	u32 boot_hartid;
 	/** Arg1 (or 'a1' register) of next booting stage for this domain */
@@ -319,6 +336,15 @@ bool sbi_domain_check_addr_range(const struct sbi_domain *dom,
 				 unsigned long mode,
 				 unsigned long access_flags);
 
+/**
+ * Build the address lookup table of a domain which is used by
+ * sbi_domain_check_addr() and sbi_domain_check_addr_range(). This
+ * is done for all registered domains by sbi_domain_finalize().
+ * @param dom pointer to domain
+ * @return 0 on success and SBI_Exxx (< 0) on failure
+ */
+int sbi_domain_build_addr_lookup(struct sbi_domain *dom);
+
 /** Dump domain details on the console */
 void sbi_domain_dump(const struct sbi_domain *dom, const char *suffix);
 
@@ -10,6 +10,7 @@
 #include <sbi/sbi_types.h>
 
 struct sbi_domain;
+struct sbi_trap_regs;
 
 /**
  * Enter a specific domain context synchronously
@@ -28,6 +29,16 @@ int sbi_domain_context_enter(struct sbi_domain *dom);
  */
 int sbi_domain_context_exit(void);
 
+/**
+ * Restore FP or vector state of the current domain context which was
+ * hidden by a domain context switch
+ * @param insn the instruction which caused an illegal instruction trap
+ * @param regs pointer to trap registers
+ *
+ * @return true if state was restored and the instruction must be retried
+ */
+bool sbi_domain_context_lazy_restore(ulong insn, struct sbi_trap_regs *regs);
+
 /**
  * Initialize domain context support
  *
@@ -42,6 +42,12 @@ struct sbi_ecall_extension {
 	unsigned long extid_end;
 	/* flag showing whether given extension is experimental or not */
 	bool experimental;
+	/*
+	 * flag showing whether calls of given extension can be queued in
+	 * the batch command ring. The handler of such extension must only
+	 * use the a0 to a5 registers and must not set skip_regs_update.
+	 */
+	bool batchable;
 	/*
 	 * register_extensions
 	 *
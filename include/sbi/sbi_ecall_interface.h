@@ -39,6 +39,9 @@
 #define SBI_EXT_FWFT				0x46574654
 #define SBI_EXT_MPXY				0x4D505859
 
+/* OpenSBI specific extension (firmware range with OpenSBI impid) */
+#define SBI_EXT_OPENSBI				0x0A000001
+
 /* SBI function IDs for BASE extension*/
 #define SBI_EXT_BASE_GET_SPEC_VERSION		0x0
 #define SBI_EXT_BASE_GET_IMP_ID			0x1
@@ -478,6 +481,16 @@ enum sbi_sse_state {
 #define SBI_MPXY_NOTIF_HDR_LOST_OFFSET		0x08
 #define SBI_MPXY_NOTIF_HDR_RESERVED_OFFSET	0x0C
 
+/* SBI function IDs for OpenSBI specific extension */
+#define SBI_EXT_OPENSBI_PROF_NUM_RECORDS	0x0
+#define SBI_EXT_OPENSBI_PROF_READ_RECORDS	0x1
+#define SBI_EXT_OPENSBI_HSM_SUSPEND_STATS	0x2
+#define SBI_EXT_OPENSBI_TLB_FIFO_FULL_COUNT	0x3
+#define SBI_EXT_OPENSBI_TRACE_SET_EVENTS	0x4
+#define SBI_EXT_OPENSBI_TRACE_READ_RECORDS	0x5
+#define SBI_EXT_OPENSBI_BATCH_SET_SHMEM		0x6
+#define SBI_EXT_OPENSBI_BATCH_DOORBELL		0x7
+
 /* SBI base specification related macros */
 #define SBI_SPEC_VERSION_MAJOR_OFFSET		24
 #define SBI_SPEC_VERSION_MAJOR_MASK		0x7f
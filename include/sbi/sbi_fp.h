@@ -23,6 +23,7 @@ struct sbi_fp_context {
 #if defined(__riscv_f) || defined(__riscv_d)
 void sbi_fp_save(struct sbi_fp_context *dst);
 void sbi_fp_restore(const struct sbi_fp_context *src);
+void sbi_fp_clear(void);
 #else
 static inline void sbi_fp_save(struct sbi_fp_context *dst)
 {
@@ -30,6 +31,9 @@ static inline void sbi_fp_save(struct sbi_fp_context *dst)
 static inline void sbi_fp_restore(const struct sbi_fp_context *src)
 {
 }
+static inline void sbi_fp_clear(void)
+{
+}
 #endif /* __riscv_f || __riscv_d */
 
 #endif /*__SBI_FP_H__ */
@@ -29,6 +29,12 @@ struct sbi_hart_protection {
 	/** Unconfigure protection for current HART (Mandatory) */
 	void (*unconfigure)(struct sbi_scratch *scratch);
 
+	/**
+	 * Re-configure protection for current HART after a domain
+	 * change by only updating what differs (Optional)
+	 */
+	int (*reconfigure)(struct sbi_scratch *scratch, bool fence);
+
 	/** Create temporary mapping to access address range on current HART (Optional) */
 	int (*map_range)(struct sbi_scratch *scratch,
 			 unsigned long base, unsigned long size);
@@ -36,6 +42,14 @@ struct sbi_hart_protection {
 	/** Destroy temporary mapping on current HART (Optional) */
 	int (*unmap_range)(struct sbi_scratch *scratch,
 			   unsigned long base, unsigned long size);
+
+	/** Create persistent mapping of shared memory on current HART (Optional) */
+	int (*map_shmem)(struct sbi_scratch *scratch,
+			 unsigned long base, unsigned long size);
+
+	/** Destroy persistent mapping of shared memory on current HART (Optional) */
+	void (*unmap_shmem)(struct sbi_scratch *scratch,
+			    unsigned long base, unsigned long size);
 };
 
 /**
@@ -77,6 +91,22 @@ int sbi_hart_protection_configure(struct sbi_scratch *scratch);
  */
 void sbi_hart_protection_unconfigure(struct sbi_scratch *scratch);
 
+/**
+ * Re-configure protection for current HART after a domain change
+ *
+ * @param scratch pointer to scratch space of current HART
+ * @param fence flush address translation caches even if the
+ * protection settings did not change
+ *
+ * @return 0 on success and negative error code on failure
+ *
+ * Note: If the hart protection mechanism does not provide reconfigure()
+ * then it is unconfigured and configured again. The reconfigure() and
+ * configure() callbacks must flush address translation caches whenever
+ * any protection setting changed.
+ */
+int sbi_hart_protection_reconfigure(struct sbi_scratch *scratch, bool fence);
+
 /**
  * Create temporary mapping to access address range on current HART
  *
@@ -97,4 +127,31 @@ int sbi_hart_protection_map_range(unsigned long base, unsigned long size);
  */
 int sbi_hart_protection_unmap_range(unsigned long base, unsigned long size);
 
+/**
+ * Create persistent mapping of shared memory on current HART
+ *
+ * The mapping is only a hint for the hart protection mechanism to
+ * avoid re-programming protection on every access of a shared memory
+ * registered by S/U-mode. The map_range()/unmap_range() pair must
+ * still be used around each access of the shared memory. S/U-mode
+ * can't execute from the shared memory while it is mapped, so the
+ * mapping is refused if the shared memory contains a smaller S/U-mode
+ * executable region of the domain. The mapping is not in effect while
+ * another domain runs.
+ *
+ * @param base base address of the shared memory
+ * @param size size of the shared memory
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_hart_protection_map_shmem(unsigned long base, unsigned long size);
+
+/**
+ * Destroy persistent mapping of shared memory on current HART
+ *
+ * @param base base address of the shared memory
+ * @param size size of the shared memory
+ */
+void sbi_hart_protection_unmap_shmem(unsigned long base, unsigned long size);
+
 #endif /* __SBI_HART_PROTECTION_H__ */
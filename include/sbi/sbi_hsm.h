@@ -10,9 +10,34 @@
 #ifndef __SBI_HSM_H__
 #define __SBI_HSM_H__
 
+#include <sbi/sbi_error.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_types.h>
 
+/** Maximum number of suspend types with idle statistics per hart */
+#define SBI_HSM_SUSPEND_STATS_MAX	8
+
+/**
+ * Idle statistics of a hart for one suspend type
+ *
+ * Times are in timer ticks. The same layout (little-endian) is used
+ * when returning the statistics to S-mode.
+ */
+struct sbi_hsm_suspend_stat {
+	/** Suspend type */
+	u32 suspend_type;
+	/** Number of requests for this type demoted to a retentive type */
+	u32 demoted;
+	/** Number of times the hart resumed from this suspend type */
+	u64 count;
+	/** Total time from suspend entry to the wake-up event */
+	u64 residency;
+	/** Total time from the wake-up event to resuming the caller */
+	u64 wake_latency;
+	/** Maximum time from the wake-up event to resuming the caller */
+	u64 wake_latency_max;
+};
+
 /** Hart state managment device */
 struct sbi_hsm_device {
 	/** Name of the hart state managment device */
@@ -54,6 +79,21 @@ struct sbi_hsm_device {
 	 * non-retentive suspend.
 	 */
 	void (*hart_resume)(void);
+
+	/**
+	 * Select the suspend type to enter for a non-retentive suspend
+	 * request of the current hart.
+	 *
+	 * Return the requested suspend type or a retentive suspend type
+	 * to demote the request, for example when the measured residency
+	 * does not reach the break-even time of the requested type. The
+	 * idle statistics of the current hart are passed as input.
+	 *
+	 * NOTE: Only called when CONFIG_SBI_HSM_SUSPEND_STATS is enabled.
+	 */
+	u32 (*hart_suspend_demote)(u32 suspend_type,
+				   const struct sbi_hsm_suspend_stat *stats,
+				   u32 stat_count);
 };
 
 struct sbi_domain;
@@ -85,4 +125,17 @@ void __sbi_hsm_suspend_non_ret_save(struct sbi_scratch *scratch);
 void __noreturn sbi_hsm_hart_start_finish(struct sbi_scratch *scratch,
 					  u32 hartid);
 
+#ifdef CONFIG_SBI_HSM_SUSPEND_STATS
+void sbi_hsm_hart_wakeup_event(struct sbi_scratch *scratch);
+int sbi_hsm_read_suspend_stats(u32 hartid, unsigned long addr, u32 count,
+			       u32 *out_count);
+#else
+static inline void sbi_hsm_hart_wakeup_event(struct sbi_scratch *scratch) { }
+static inline int sbi_hsm_read_suspend_stats(u32 hartid, unsigned long addr,
+					     u32 count, u32 *out_count)
+{
+	return SBI_ENOTSUPP;
+}
+#endif
+
 #endif
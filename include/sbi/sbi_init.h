@@ -22,6 +22,8 @@ unsigned long sbi_entry_count(u32 hartindex);
 
 unsigned long sbi_init_count(u32 hartindex);
 
+void sbi_init_mark_protection_lost(struct sbi_scratch *scratch);
+
 void __noreturn sbi_exit(struct sbi_scratch *scratch);
 
 #endif
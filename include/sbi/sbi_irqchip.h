@@ -156,6 +156,9 @@ struct sbi_irqchip_device *sbi_irqchip_find_device(u32 id);
 /** Register an irqchip device to receive callbacks */
 int sbi_irqchip_add_device(struct sbi_irqchip_device *chip);
 
+/** Unregister an irqchip device which has no handlers registered */
+int sbi_irqchip_remove_device(struct sbi_irqchip_device *chip);
+
 /** Initialize interrupt controllers */
 int sbi_irqchip_init(struct sbi_scratch *scratch, bool cold_boot);
 
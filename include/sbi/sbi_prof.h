@@ -0,0 +1,86 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef __SBI_PROF_H__
+#define __SBI_PROF_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+/** Maximum length of a trace point name (including NUL) */
+#define SBI_PROF_NAME_LEN		16
+
+/** Trace point record in the format returned to S-mode (little-endian) */
+struct sbi_prof_record {
+	/** Name of the trace point */
+	char name[SBI_PROF_NAME_LEN];
+	/** Hart ID of the HART which recorded the trace point */
+	u32 hartid;
+	/** Reserved for future use (zero) */
+	u32 reserved;
+	/** Cycle counter of the HART at the start of the traced step */
+	u64 start;
+	/** Number of cycles spent in the traced step */
+	u64 cycles;
+};
+
+#ifdef CONFIG_SBI_PROF
+
+/**
+ * Start profiling on current HART
+ *
+ * The cycle counter value at this point is used as start of the
+ * step recorded by the next sbi_prof_trace() on current HART.
+ */
+void sbi_prof_start(void);
+
+/**
+ * Record a trace point on current HART
+ *
+ * The recorded step covers the time since the previous trace point
+ * (or sbi_prof_start()) on current HART. Records are dropped once
+ * the record buffer is full.
+ *
+ * @param name name of the step which just completed
+ */
+void sbi_prof_trace(const char *name);
+
+/**
+ * Print trace points recorded by a HART in a table
+ *
+ * @param hartindex index of the HART
+ */
+void sbi_prof_print(u32 hartindex);
+
+/** Get the number of trace points recorded so far */
+u32 sbi_prof_record_count(void);
+
+/**
+ * Copy recorded trace points to S-mode memory
+ *
+ * @param start index of the first record to copy
+ * @param count maximum number of records to copy
+ * @param addr physical address of the S-mode buffer
+ * @param out_count number of records copied
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_prof_read_records(u32 start, u32 count, unsigned long addr,
+			  u32 *out_count);
+
+#else
+
+static inline void sbi_prof_start(void) { }
+static inline void sbi_prof_trace(const char *name) { }
+static inline void sbi_prof_print(u32 hartindex) { }
+static inline u32 sbi_prof_record_count(void) { return 0; }
+static inline int sbi_prof_read_records(u32 start, u32 count,
+					unsigned long addr, u32 *out_count)
+{
+	return SBI_ENOTSUPP;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Queued (MCS) spinlock where each waiting HART spins on its own
+ * node in scratch space instead of the shared lock word.
+ */
+
+#ifndef __SBI_QSPINLOCK_H__
+#define __SBI_QSPINLOCK_H__
+
+#include <sbi/riscv_atomic.h>
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Maximum number of queued spinlocks held or waited on by a HART */
+#define QSPIN_NODES_PER_HART	4
+
+/** Per-HART queue node (private) */
+struct qspin_node {
+	struct qspin_node *next;
+	unsigned long locked;
+};
+
+/** Contention statistics of a queued spinlock */
+struct qspin_lock_stats {
+	/** Number of times the lock was acquired */
+	unsigned long acquisitions;
+	/** Number of acquisitions which had to wait */
+	unsigned long contended;
+	/** Total number of spin iterations of all waiters */
+	unsigned long spins;
+	/** Longest wait of a single acquisition (cycles) */
+	unsigned long max_wait;
+};
+
+typedef struct {
+	/** Last queued node (NULL when unlocked) */
+	atomic_t tail;
+	/** Node of the current owner (private) */
+	struct qspin_node *owner;
+#ifdef CONFIG_SBI_LOCK_STATS
+	struct qspin_lock_stats stats;
+#endif
+} qspinlock_t;
+
+#define __QSPIN_LOCK_UNLOCKED	\
+	(qspinlock_t) { .tail = ATOMIC_INITIALIZER(0) }
+
+#define QSPIN_LOCK_INIT(x)	\
+	x = __QSPIN_LOCK_UNLOCKED
+
+#define QSPIN_LOCK_INITIALIZER	\
+	__QSPIN_LOCK_UNLOCKED
+
+#define DEFINE_QSPIN_LOCK(x)	\
+	qspinlock_t QSPIN_LOCK_INIT(x)
+
+bool qspin_lock_check(qspinlock_t *lock);
+
+bool qspin_trylock(qspinlock_t *lock);
+
+void qspin_lock(qspinlock_t *lock);
+
+void qspin_unlock(qspinlock_t *lock);
+
+/**
+ * Get contention statistics of a queued spinlock
+ *
+ * @return SBI_ENOTSUPP if CONFIG_SBI_LOCK_STATS is not enabled
+ */
+int qspin_lock_get_stats(qspinlock_t *lock, struct qspin_lock_stats *out);
+
+/** Reset contention statistics of a queued spinlock */
+void qspin_lock_reset_stats(qspinlock_t *lock);
+
+/** Print contention statistics of a queued spinlock */
+void qspin_lock_dump_stats(qspinlock_t *lock, const char *name);
+
+/** Allocate per-HART queue nodes (called once by the coldboot HART) */
+int sbi_qspinlock_init(struct sbi_scratch *scratch);
+
+#ifdef CONFIG_SBI_LOCK_BENCH
+/** Ticket and queued spinlock benchmark across all booting HARTs */
+void sbi_lock_bench(struct sbi_scratch *scratch, bool cold_boot);
+#else
+static inline void sbi_lock_bench(struct sbi_scratch *scratch, bool cold_boot) { }
+#endif
+
+#endif
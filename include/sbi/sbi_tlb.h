@@ -58,6 +58,9 @@ void __sbi_sfence_vma_all();
 
 int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo);
 
+/** Number of times a request found the TLB FIFO of a remote HART full */
+unsigned long sbi_tlb_fifo_full_count(void);
+
 int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot);
 
 #endif
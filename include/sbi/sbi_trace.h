@@ -0,0 +1,150 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef __SBI_TRACE_H__
+#define __SBI_TRACE_H__
+
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+struct sbi_scratch;
+
+/** Maximum number of arguments of a trace event */
+#define SBI_TRACE_MAX_ARGS		4
+
+/** Trace events and their arguments */
+enum sbi_trace_event {
+	/** Trap entry: mcause, mepc, mtval */
+	SBI_TRACE_TRAP_ENTRY = 0,
+	/** Trap exit: mcause, mepc, handler return value */
+	SBI_TRACE_TRAP_EXIT,
+	/** Ecall dispatch: extension ID, function ID, error, value */
+	SBI_TRACE_ECALL,
+	/** IPI send: target hart ID, IPI event */
+	SBI_TRACE_IPI_SEND,
+	/** IPI receive: pending IPI event mask */
+	SBI_TRACE_IPI_RECV,
+	/** TLB request enqueue: target hart ID, TLB type, start, size */
+	SBI_TRACE_TLB_ENQUEUE,
+	/** TLB request process: TLB type, start, size */
+	SBI_TRACE_TLB_PROCESS,
+	/** HSM state change: hart ID, old state, new state */
+	SBI_TRACE_HSM_STATE,
+	/** SSE event injected into S-mode: event ID, interrupted sepc */
+	SBI_TRACE_SSE_INJECT,
+	/** SSE event completed by S-mode: event ID */
+	SBI_TRACE_SSE_COMPLETE,
+	/** Domain context switch: current domain index, target domain index */
+	SBI_TRACE_DOMAIN_SWITCH,
+	SBI_TRACE_EVENT_MAX,
+};
+
+/** Mask of all valid trace events */
+#define SBI_TRACE_EVENT_ALL		(BIT(SBI_TRACE_EVENT_MAX) - 1)
+
+/** Event ID of a record which was overwritten while being read */
+#define SBI_TRACE_EVENT_LOST		0xffffffff
+
+/** Trace record in the format returned to S-mode (little-endian) */
+struct sbi_trace_record {
+	/** Sequence number of the record in the ring of its HART */
+	u64 seq;
+	/** Timer value when the event was recorded */
+	u64 time;
+	/** Event ID from enum sbi_trace_event */
+	u32 event;
+	/** Hart ID of the HART which recorded the event */
+	u32 hartid;
+	/** Event specific arguments (unused ones are zero) */
+	u64 args[SBI_TRACE_MAX_ARGS];
+};
+
+#ifdef CONFIG_SBI_TRACE
+
+/** Mask of enabled trace events */
+extern unsigned long sbi_trace_events;
+
+/**
+ * Record a trace event in the ring of current HART
+ *
+ * Use sbi_trace() instead which only calls this function when the
+ * event is enabled.
+ */
+void __sbi_trace(u32 event, unsigned long arg0, unsigned long arg1,
+		 unsigned long arg2, unsigned long arg3);
+
+/**
+ * Record a trace event if it is enabled
+ *
+ * A disabled event costs one load and one branch and the arguments
+ * are only evaluated for enabled events.
+ */
+#define sbi_trace(__event, __arg0, __arg1, __arg2, __arg3)		\
+do {									\
+	if (unlikely(sbi_trace_events & BIT(__event)))			\
+		__sbi_trace((__event), (__arg0), (__arg1),		\
+			    (__arg2), (__arg3));			\
+} while (0)
+
+/**
+ * Change the set of enabled trace events
+ *
+ * @param events mask of trace events to enable
+ * @param prev_events mask of trace events enabled before
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_trace_set_events(unsigned long events, unsigned long *prev_events);
+
+/**
+ * Copy trace records of a HART to S-mode memory
+ *
+ * Records which were already overwritten are skipped so the sequence
+ * number of the first copied record can be larger than start. The
+ * next read should start after the sequence number of the last copied
+ * record.
+ *
+ * @param hartid hart ID of the HART whose records are read
+ * @param start sequence number of the first record to copy
+ * @param count maximum number of records to copy
+ * @param addr physical address of the S-mode buffer
+ * @param out_count number of records copied
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_trace_read_records(u32 hartid, unsigned long start, u32 count,
+			   unsigned long addr, u32 *out_count);
+
+/**
+ * Initialize tracing
+ *
+ * The rings of all HARTs are allocated when tracing is enabled for the
+ * first time.
+ */
+int sbi_trace_init(struct sbi_scratch *scratch);
+
+#else
+
+#define sbi_trace(__event, __arg0, __arg1, __arg2, __arg3)		\
+do { } while (0)
+
+static inline int sbi_trace_set_events(unsigned long events,
+				       unsigned long *prev_events)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline int sbi_trace_read_records(u32 hartid, unsigned long start,
+					 u32 count, unsigned long addr,
+					 u32 *out_count)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline int sbi_trace_init(struct sbi_scratch *scratch) { return 0; }
+
+#endif
+
+#endif
@@ -66,7 +66,8 @@ struct sbiunit_test_suite {
 #define SBIUNIT_EXPECT_STREQ(test, a, b, len) SBIUNIT_EXPECT(test, !sbi_strncmp(a, b, len))
 #define SBIUNIT_ASSERT_STREQ(test, a, b, len) SBIUNIT_ASSERT(test, !sbi_strncmp(a, b, len))
 
-void run_all_tests(void);
+/** Run all registered test suites and return the number of failed cases */
+u32 run_all_tests(void);
 #endif
 #else
 #define run_all_tests()
@@ -29,6 +29,7 @@ struct sbi_vector_context {
 #ifdef OPENSBI_CC_SUPPORT_VECTOR
 void sbi_vector_save(struct sbi_vector_context *dst);
 void sbi_vector_restore(const struct sbi_vector_context *src);
+void sbi_vector_clear(void);
 size_t sbi_vector_context_size(void);
 #else
 static inline void sbi_vector_save(struct sbi_vector_context *dst)
@@ -37,6 +38,9 @@ static inline void sbi_vector_save(struct sbi_vector_context *dst)
 static inline void sbi_vector_restore(const struct sbi_vector_context *src)
 {
 }
+static inline void sbi_vector_clear(void)
+{
+}
 static inline size_t sbi_vector_context_size(void)
 {
 	return 0;
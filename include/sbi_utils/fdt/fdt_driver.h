@@ -60,4 +60,7 @@ int fdt_driver_init_all(const void *fdt,
 int fdt_driver_init_one(const void *fdt,
 			const struct fdt_driver *const *drivers);
 
+/** Drop the compatible string index after the devicetree was modified */
+void fdt_driver_index_invalidate(void);
+
 #endif /* __FDT_DRIVER_H__ */
@@ -10,6 +10,7 @@
 #define __FDT_FIXUP_H__
 
 #include <sbi/sbi_list.h>
+#include <sbi/sbi_string.h>
 
 struct sbi_cpu_idle_state {
 	const char *name;
@@ -34,6 +35,74 @@ struct sbi_cpu_idle_state {
  */
 int fdt_add_cpu_idle_states(void *fdt, const struct sbi_cpu_idle_state *state);
 
+/**
+ * Start collecting DT property edits done using fdt_fixup_setprop() and
+ * fdt_fixup_appendprop() instead of applying them immediately
+ *
+ * Calls can be nested and the collected edits are applied by the
+ * outermost fdt_fixup_plan_end(). DT node offsets don't change until
+ * the collected edits are applied so callers must not add or resize
+ * DT nodes and properties directly using libfdt before that.
+ */
+void fdt_fixup_plan_begin(void);
+
+/**
+ * Apply collected DT property edits in a single sweep
+ *
+ * @param fdt: device tree blob
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_plan_apply(void *fdt);
+
+/**
+ * Stop collecting DT property edits and apply them if outermost
+ *
+ * @param fdt: device tree blob
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_plan_end(void *fdt);
+
+/**
+ * Set a DT property, expanding the device tree if required
+ *
+ * @param fdt: device tree blob
+ * @param nodeoff: offset of the DT node
+ * @param name: name of the DT property
+ * @param val: value of the DT property (copied if edit is collected)
+ * @param len: length of the value
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_setprop(void *fdt, int nodeoff, const char *name,
+		      const void *val, int len);
+
+static inline int fdt_fixup_setprop_string(void *fdt, int nodeoff,
+					   const char *name, const char *str)
+{
+	return fdt_fixup_setprop(fdt, nodeoff, name, str,
+				 sbi_strlen(str) + 1);
+}
+
+/**
+ * Append to a DT property, expanding the device tree if required
+ *
+ * @param fdt: device tree blob
+ * @param nodeoff: offset of the DT node
+ * @param name: name of the DT property
+ * @param val: value to append (copied if edit is collected)
+ * @param len: length of the value to append
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_appendprop(void *fdt, int nodeoff, const char *name,
+			 const void *val, int len);
+
+static inline int fdt_fixup_appendprop_string(void *fdt, int nodeoff,
+					      const char *name,
+					      const char *str)
+{
+	return fdt_fixup_appendprop(fdt, nodeoff, name, str,
+				    sbi_strlen(str) + 1);
+}
+
 /**
  * Fix up the CPU node in the device tree
  *
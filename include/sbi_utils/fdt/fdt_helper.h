@@ -34,6 +34,15 @@ struct platform_uart_data {
 	unsigned long reg_offset;
 };
 
+/** Same as fdt_node_offset_by_phandle() but uses a lookup cache */
+int fdt_node_offset_by_phandle_cached(const void *fdt, u32 phandle);
+
+/** Same as fdt_parent_offset() but uses a lookup cache */
+int fdt_parent_offset_cached(const void *fdt, int nodeoffset);
+
+/** Drop the lookup cache after the devicetree was modified */
+void fdt_lookup_cache_invalidate(void);
+
 int fdt_parse_phandle_with_args(const void *fdt, int nodeoff,
 				const char *prop, const char *cells_prop,
 				int index, struct fdt_phandle_args *out_args);
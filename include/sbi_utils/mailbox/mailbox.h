@@ -143,6 +143,15 @@ struct mbox_controller {
 			  struct mbox_chan *chan);
 	/** Transfer data over mailbox channel */
 	int (*xfer)(struct mbox_chan *chan, struct mbox_xfer *xfer);
+	/**
+	 * Transfer a batch of data over mailbox channel (optional)
+	 *
+	 * All transfers of the batch are sent before waiting for any
+	 * of the responses so the remote side can process them back
+	 * to back.
+	 */
+	int (*xfer_batch)(struct mbox_chan *chan, struct mbox_xfer *xfers,
+			  u32 count);
 	/** Get an attribute of mailbox channel */
 	int (*get_attribute)(struct mbox_chan *chan, int attr_id, void *out_value);
 	/** Set an attribute of mailbox channel */
@@ -171,6 +180,15 @@ void mbox_controller_free_chan(struct mbox_chan *chan);
 /** Data transfer over mailbox channel */
 int mbox_chan_xfer(struct mbox_chan *chan, struct mbox_xfer *xfer);
 
+/**
+ * Batch of data transfers over mailbox channel
+ *
+ * Falls back to individual mbox_chan_xfer() calls when the mailbox
+ * controller does not support batched transfers.
+ */
+int mbox_chan_xfer_batch(struct mbox_chan *chan,
+			 struct mbox_xfer *xfers, u32 count);
+
 /** Get an attribute of mailbox channel */
 int mbox_chan_get_attribute(struct mbox_chan *chan, int attr_id, void *out_value);
 
@@ -16,6 +16,17 @@
 
 #define rpmi_u32_count(__var)	(sizeof(__var) / sizeof(u32))
 
+/** RPMI normal request description used for batched requests */
+struct rpmi_normal_request {
+	u32 service_id;
+	void *req;
+	u32 req_words;
+	u32 req_endian_words;
+	void *resp;
+	u32 resp_words;
+	u32 resp_endian_words;
+};
+
 /** Convert RPMI error to SBI error */
 int rpmi_xlate_error(enum rpmi_error error);
 
@@ -25,9 +36,23 @@ int rpmi_normal_request_with_status(
 			void *req, u32 req_words, u32 req_endian_words,
 			void *resp, u32 resp_words, u32 resp_endian_words);
 
+/**
+ * Batch of typical RPMI normal requests with at least status code in
+ * each response. Returns the first error encountered.
+ */
+int rpmi_normal_requests_with_status(struct mbox_chan *chan,
+				     struct rpmi_normal_request *reqs,
+				     u32 count);
+
 /* RPMI posted request which is without any response*/
 int rpmi_posted_request(
 		struct mbox_chan *chan, u32 service_id,
 		void *req, u32 req_words, u32 req_endian_words);
 
+/**
+ * Measure latency and throughput of RPMI requests for each service
+ * group available on a mailbox controller and print the results.
+ */
+void rpmi_mailbox_bench(struct mbox_controller *mbox, u32 iterations);
+
 #endif /* !__RPMI_MAILBOX_H__ */
@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Software stand-in for an RPMI platform microcontroller (PuC)
+ * serving the RPMI shared memory transport from plain memory.
+ */
+
+#ifndef __RPMI_SOFT_PUC_H__
+#define __RPMI_SOFT_PUC_H__
+
+#include <sbi/sbi_types.h>
+#include <sbi/riscv_locks.h>
+#include <sbi_utils/mailbox/rpmi_msgprot.h>
+
+/** Number of shared memory queues laid out by the software PuC */
+#define RPMI_SOFT_PUC_QUEUE_COUNT	4
+
+/** Number of clocks, performance domains and system MSIs emulated */
+#define RPMI_SOFT_PUC_NUM_CLOCKS	4
+#define RPMI_SOFT_PUC_NUM_PERF_DOMAINS	2
+#define RPMI_SOFT_PUC_NUM_PERF_LEVELS	4
+#define RPMI_SOFT_PUC_NUM_SYSMSI	4
+
+/** Software PuC view of one shared memory queue */
+struct rpmi_soft_puc_queue {
+	volatile le32_t *headptr;
+	volatile le32_t *tailptr;
+	volatile u8 *buffer;
+	u32 num_slots;
+};
+
+/** Software PuC instance */
+struct rpmi_soft_puc {
+	/** Slot size in bytes */
+	u32 slot_size;
+	/** Shared memory queues in RPMI shared memory transport order */
+	struct rpmi_soft_puc_queue queues[RPMI_SOFT_PUC_QUEUE_COUNT];
+	/** Lock serializing request processing */
+	spinlock_t lock;
+	/** Response scratch buffer (one slot worth of data) */
+	u32 *resp;
+	/** System MSI used as P2A doorbell (-1U if not used) */
+	u32 p2a_doorbell_sysmsi_index;
+	/** HSM state of each HART (indexed by HART index) */
+	u32 *hart_state;
+	/** Emulated clocks */
+	struct {
+		u32 config;
+		u64 rate;
+	} clocks[RPMI_SOFT_PUC_NUM_CLOCKS];
+	/** Emulated performance domains */
+	struct {
+		u32 level;
+		u32 limit_max;
+		u32 limit_min;
+	} perf[RPMI_SOFT_PUC_NUM_PERF_DOMAINS];
+	/** Emulated system MSIs */
+	struct {
+		u32 state;
+		u64 addr;
+		u32 data;
+	} sysmsi[RPMI_SOFT_PUC_NUM_SYSMSI];
+	/** Number of requests served per service group */
+	unsigned long served[RPMI_SRVGRP_ID_MAX_COUNT];
+};
+
+/**
+ * Initialize a software PuC
+ *
+ * The queues are laid out back to back starting at base, each of
+ * queue_size bytes, in the order A2P REQ, P2A ACK, P2A REQ and A2P ACK.
+ */
+int rpmi_soft_puc_init(struct rpmi_soft_puc *puc, void *base,
+		       unsigned long queue_size, u32 slot_size);
+
+/** Serve all pending A2P requests and return the number served */
+u32 rpmi_soft_puc_poll(struct rpmi_soft_puc *puc);
+
+/** Serve A2P requests forever (for a HART dedicated to the PuC) */
+void __noreturn rpmi_soft_puc_run(struct rpmi_soft_puc *puc);
+
+#endif
@@ -11,6 +11,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
 
 #if !defined(__riscv_atomic) && !defined(__riscv_zaamo) && !defined(__riscv_zalrsc)
 #error "opensbi strongly relies on the Zaamo or Zalrsc extensions of RISC-V"
@@ -141,9 +142,56 @@ long atomic_sub_return(atomic_t *atom, long value)
 		(__typeof__(*(ptr))) __axchg((ptr), _x_, sizeof(*(ptr)));	\
 	})
 
+/*
+ * With Zacas a compare and exchange is a single amocas instruction,
+ * otherwise the compiler expands the builtin into an LR/SC loop.
+ */
+static inline unsigned int __cmpxchg_w(volatile unsigned int *ptr,
+				       unsigned int oldval,
+				       unsigned int newval)
+{
+#if defined(__riscv_zacas)
+	/* Words are compared and returned sign-extended on RV64 */
+	long ret = (int)oldval;
+
+	__asm__ __volatile__("	amocas.w.aqrl %0, %2, %1\n"
+			     : "+r"(ret), "+A"(*ptr)
+			     : "r"((long)(int)newval)
+			     : "memory");
+	return ret;
+#else
+	return __sync_val_compare_and_swap(ptr, oldval, newval);
+#endif
+}
+
+static inline unsigned long __cmpxchg_l(volatile unsigned long *ptr,
+					unsigned long oldval,
+					unsigned long newval)
+{
+#if defined(__riscv_zacas)
+	unsigned long ret = oldval;
+
+#if __SIZEOF_LONG__ == 4
+	__asm__ __volatile__("	amocas.w.aqrl %0, %2, %1\n"
+			     : "+r"(ret), "+A"(*ptr)
+			     : "r"(newval)
+			     : "memory");
+#elif __SIZEOF_LONG__ == 8
+	__asm__ __volatile__("	amocas.d.aqrl %0, %2, %1\n"
+			     : "+r"(ret), "+A"(*ptr)
+			     : "r"(newval)
+			     : "memory");
+#endif
+	return ret;
+#else
+	return __sync_val_compare_and_swap(ptr, oldval, newval);
+#endif
+}
+
 long atomic_cmpxchg(atomic_t *atom, long oldval, long newval)
 {
-	return __sync_val_compare_and_swap(&atom->counter, oldval, newval);
+	return __cmpxchg_l((volatile unsigned long *)&atom->counter,
+			   oldval, newval);
 }
 
 long atomic_xchg(atomic_t *atom, long newval)
@@ -166,6 +214,202 @@ unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
 	return axchg(ptr, newval);
 }
 
+unsigned int atomic_raw_cmpxchg_uint(volatile unsigned int *ptr,
+				     unsigned int oldval, unsigned int newval)
+{
+	return __cmpxchg_w(ptr, oldval, newval);
+}
+
+unsigned long atomic_raw_cmpxchg_ulong(volatile unsigned long *ptr,
+				       unsigned long oldval,
+				       unsigned long newval)
+{
+	return __cmpxchg_l(ptr, oldval, newval);
+}
+
+#if !defined(__riscv_zabha) || !defined(__riscv_zacas)
+/*
+ * Byte and halfword update emulated with a CAS loop on the aligned
+ * word containing it. Returns the previous value of the sub-word.
+ */
+static unsigned int __cmpxchg_subword(volatile void *ptr, unsigned int bits,
+				      unsigned int oldval,
+				      unsigned int newval, bool always)
+{
+	volatile unsigned int *word = (void *)((unsigned long)ptr & ~0x3UL);
+	unsigned int shift = ((unsigned long)ptr & 0x3) * 8;
+	unsigned int mask = ((1U << bits) - 1) << shift;
+	unsigned int cur, prev, val;
+
+	cur = *word;
+	do {
+		val = (cur & mask) >> shift;
+		if (!always && val != oldval)
+			break;
+		prev = cur;
+		cur = __cmpxchg_w(word, prev,
+				  (prev & ~mask) | ((newval << shift) & mask));
+	} while (cur != prev);
+
+	return val;
+}
+#endif
+
+u8 atomic_raw_xchg_u8(volatile u8 *ptr, u8 newval)
+{
+#if defined(__riscv_zabha)
+	u8 ret;
+
+	__asm__ __volatile__("	amoswap.b.aqrl %0, %2, %1\n"
+			     : "=r"(ret), "+A"(*ptr)
+			     : "r"(newval)
+			     : "memory");
+	return ret;
+#else
+	return __cmpxchg_subword(ptr, 8, 0, newval, true);
+#endif
+}
+
+u16 atomic_raw_xchg_u16(volatile u16 *ptr, u16 newval)
+{
+#if defined(__riscv_zabha)
+	u16 ret;
+
+	__asm__ __volatile__("	amoswap.h.aqrl %0, %2, %1\n"
+			     : "=r"(ret), "+A"(*ptr)
+			     : "r"(newval)
+			     : "memory");
+	return ret;
+#else
+	return __cmpxchg_subword(ptr, 16, 0, newval, true);
+#endif
+}
+
+u8 atomic_raw_cmpxchg_u8(volatile u8 *ptr, u8 oldval, u8 newval)
+{
+#if defined(__riscv_zabha) && defined(__riscv_zacas)
+	long ret = (s8)oldval;
+
+	__asm__ __volatile__("	amocas.b.aqrl %0, %2, %1\n"
+			     : "+r"(ret), "+A"(*ptr)
+			     : "r"((long)(s8)newval)
+			     : "memory");
+	return ret;
+#else
+	return __cmpxchg_subword(ptr, 8, oldval, newval, false);
+#endif
+}
+
+u16 atomic_raw_cmpxchg_u16(volatile u16 *ptr, u16 oldval, u16 newval)
+{
+#if defined(__riscv_zabha) && defined(__riscv_zacas)
+	long ret = (s16)oldval;
+
+	__asm__ __volatile__("	amocas.h.aqrl %0, %2, %1\n"
+			     : "+r"(ret), "+A"(*ptr)
+			     : "r"((long)(s16)newval)
+			     : "memory");
+	return ret;
+#else
+	return __cmpxchg_subword(ptr, 16, oldval, newval, false);
+#endif
+}
+
+#if defined(__riscv_zacas)
+bool atomic_double_cmpxchg(atomic_double_t *atom,
+			   unsigned long *oldlo, unsigned long *oldhi,
+			   unsigned long newlo, unsigned long newhi)
+{
+	/* amocas.d (RV32) and amocas.q (RV64) operate on even register pairs */
+	register unsigned long cmplo __asm__("t3") = *oldlo;
+	register unsigned long cmphi __asm__("t4") = *oldhi;
+	register unsigned long lo __asm__("t5") = newlo;
+	register unsigned long hi __asm__("t6") = newhi;
+
+#if __SIZEOF_LONG__ == 4
+	__asm__ __volatile__("	amocas.d.aqrl %0, %3, %2\n"
+			     : "+r"(cmplo), "+r"(cmphi), "+A"(atom->lo)
+			     : "r"(lo), "r"(hi)
+			     : "memory");
+#elif __SIZEOF_LONG__ == 8
+	__asm__ __volatile__("	amocas.q.aqrl %0, %3, %2\n"
+			     : "+r"(cmplo), "+r"(cmphi), "+A"(atom->lo)
+			     : "r"(lo), "r"(hi)
+			     : "memory");
+#endif
+
+	if (cmplo == *oldlo && cmphi == *oldhi)
+		return true;
+
+	*oldlo = cmplo;
+	*oldhi = cmphi;
+	return false;
+}
+
+void atomic_double_read(atomic_double_t *atom,
+			unsigned long *lo, unsigned long *hi)
+{
+	/* Swapping zero with zero leaves the value unchanged */
+	*lo = 0;
+	*hi = 0;
+	atomic_double_cmpxchg(atom, lo, hi, 0, 0);
+}
+#else
+/* Without Zacas double word updates are serialized by hashed locks */
+#define ATOMIC_DOUBLE_LOCKS	16
+
+static spinlock_t atomic_double_locks[ATOMIC_DOUBLE_LOCKS];
+
+static spinlock_t *atomic_double_lock(atomic_double_t *atom)
+{
+	unsigned long idx = (unsigned long)atom / sizeof(*atom);
+
+	return &atomic_double_locks[idx % ATOMIC_DOUBLE_LOCKS];
+}
+
+bool atomic_double_cmpxchg(atomic_double_t *atom,
+			   unsigned long *oldlo, unsigned long *oldhi,
+			   unsigned long newlo, unsigned long newhi)
+{
+	spinlock_t *lock = atomic_double_lock(atom);
+	bool ret = false;
+
+	spin_lock(lock);
+	if (atom->lo == *oldlo && atom->hi == *oldhi) {
+		atom->lo = newlo;
+		atom->hi = newhi;
+		ret = true;
+	} else {
+		*oldlo = atom->lo;
+		*oldhi = atom->hi;
+	}
+	spin_unlock(lock);
+
+	return ret;
+}
+
+void atomic_double_read(atomic_double_t *atom,
+			unsigned long *lo, unsigned long *hi)
+{
+	spinlock_t *lock = atomic_double_lock(atom);
+
+	spin_lock(lock);
+	*lo = atom->lo;
+	*hi = atom->hi;
+	spin_unlock(lock);
+}
+#endif
+
+void atomic_double_write(atomic_double_t *atom,
+			 unsigned long lo, unsigned long hi)
+{
+	unsigned long oldlo, oldhi;
+
+	atomic_double_read(atom, &oldlo, &oldhi);
+	while (!atomic_double_cmpxchg(atom, &oldlo, &oldhi, lo, hi))
+		;
+}
+
 int atomic_raw_set_bit(int nr, volatile unsigned long *addr)
 {
 	unsigned long res, mask = BIT_MASK(nr);
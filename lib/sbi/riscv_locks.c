@@ -88,3 +88,57 @@ void spin_unlock(spinlock_t *lock)
 {
 	__smp_store_release(&lock->owner, lock->owner + 1);
 }
+
+void write_seqlock(seqlock_t *sl)
+{
+	spin_lock(&sl->lock);
+	sl->sequence++;
+	RISCV_FENCE(w, w);
+}
+
+void write_sequnlock(seqlock_t *sl)
+{
+	RISCV_FENCE(w, w);
+	sl->sequence++;
+	spin_unlock(&sl->lock);
+}
+
+bool read_trylock(rwlock_t *lock)
+{
+	long count = atomic_read(&lock->count);
+
+	while (0 <= count) {
+		if (atomic_cmpxchg(&lock->count, count, count + 1) == count)
+			return true;
+		count = atomic_read(&lock->count);
+	}
+
+	return false;
+}
+
+void read_lock(rwlock_t *lock)
+{
+	while (!read_trylock(lock))
+		cpu_relax();
+}
+
+void read_unlock(rwlock_t *lock)
+{
+	atomic_sub_return(&lock->count, 1);
+}
+
+bool write_trylock(rwlock_t *lock)
+{
+	return atomic_cmpxchg(&lock->count, 0, -1) == 0;
+}
+
+void write_lock(rwlock_t *lock)
+{
+	while (!write_trylock(lock))
+		cpu_relax();
+}
+
+void write_unlock(rwlock_t *lock)
+{
+	__smp_store_release(&lock->count.counter, 0);
+}
@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Batched SBI calls submitted through a per-HART command ring.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_byteorder.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trap.h>
+
+#define INVALID_ADDR		(-1UL)
+
+struct batch_state {
+	/* Domain which registered the ring (NULL when disabled) */
+	const struct sbi_domain *dom;
+	unsigned long base;
+	unsigned long num_entries;
+};
+
+static unsigned long batch_state_offset;
+
+static inline struct batch_state *batch_state_thishart_ptr(void)
+{
+	return sbi_scratch_thishart_offset_ptr(batch_state_offset);
+}
+
+static inline unsigned long batch_ring_size(struct batch_state *bs)
+{
+	return bs->num_entries * sizeof(struct sbi_batch_entry);
+}
+
+static void batch_disable(struct batch_state *bs)
+{
+	if (bs->dom)
+		sbi_hart_protection_unmap_shmem(bs->base, batch_ring_size(bs));
+
+	bs->dom = NULL;
+	bs->base = 0;
+	bs->num_entries = 0;
+}
+
+/*
+ * Run one queued call with the handler of its extension. Only the
+ * argument registers of regs are valid, which is why extensions have
+ * to opt in with the batchable flag.
+ */
+static int batch_call(unsigned long extid, unsigned long funcid,
+		      struct sbi_trap_regs *regs, unsigned long *out_value)
+{
+	struct sbi_ecall_extension *ext = sbi_ecall_find_extension(extid);
+	struct sbi_ecall_return out = {0};
+	int ret;
+
+	if (!ext || !ext->batchable || !ext->handle)
+		ret = SBI_ENOTSUPP;
+	else
+		ret = ext->handle(extid, funcid, regs, &out);
+
+	if (ret < SBI_LAST_ERR || SBI_SUCCESS < ret)
+		ret = SBI_ERR_FAILED;
+
+	sbi_trace(SBI_TRACE_ECALL, extid, funcid, ret, out.value);
+
+	*out_value = out.value;
+	return ret;
+}
+
+static void batch_entry_process(struct sbi_batch_entry *ent)
+{
+	struct sbi_trap_regs regs;
+	unsigned long extid, funcid, value;
+	int ret;
+
+	sbi_memset(&regs, 0, sizeof(regs));
+
+	sbi_hart_protection_map_range((unsigned long)ent, sizeof(*ent));
+	extid = le32_to_cpu(ent->extid);
+	funcid = le32_to_cpu(ent->funcid);
+	regs.a0 = le64_to_cpu(ent->args[0]);
+	regs.a1 = le64_to_cpu(ent->args[1]);
+	regs.a2 = le64_to_cpu(ent->args[2]);
+	regs.a3 = le64_to_cpu(ent->args[3]);
+	regs.a4 = le64_to_cpu(ent->args[4]);
+	regs.a5 = le64_to_cpu(ent->args[5]);
+	sbi_hart_protection_unmap_range((unsigned long)ent, sizeof(*ent));
+
+	/* Handlers may map S-mode memory of their own */
+	ret = batch_call(extid, funcid, &regs, &value);
+
+	sbi_hart_protection_map_range((unsigned long)ent, sizeof(*ent));
+	ent->error = cpu_to_le64(ret);
+	ent->value = cpu_to_le64(value);
+	sbi_hart_protection_unmap_range((unsigned long)ent, sizeof(*ent));
+}
+
+int sbi_batch_set_shmem(unsigned long shmem_phys_lo,
+			unsigned long shmem_phys_hi,
+			unsigned long num_entries)
+{
+	struct batch_state *bs = batch_state_thishart_ptr();
+	const struct sbi_domain *dom = sbi_domain_thishart_ptr();
+
+	if (!batch_state_offset)
+		return SBI_ENOTSUPP;
+
+	if (shmem_phys_lo == INVALID_ADDR && shmem_phys_hi == INVALID_ADDR) {
+		batch_disable(bs);
+		return SBI_SUCCESS;
+	}
+
+	if (!num_entries || SBI_BATCH_MAX_ENTRIES < num_entries)
+		return SBI_EINVAL;
+
+	if (shmem_phys_lo & (sizeof(u64) - 1))
+		return SBI_EINVAL;
+
+	/* M-mode can only access the lower XLEN bits of the address space */
+	if (shmem_phys_hi)
+		return SBI_EINVALID_ADDR;
+
+	if (!sbi_domain_check_addr_range(dom, shmem_phys_lo,
+					 num_entries * sizeof(struct sbi_batch_entry),
+					 PRV_S, SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	batch_disable(bs);
+
+	bs->dom = dom;
+	bs->base = shmem_phys_lo;
+	bs->num_entries = num_entries;
+
+	/* Keep the ring mapped for M-mode when possible */
+	sbi_hart_protection_map_shmem(bs->base, batch_ring_size(bs));
+
+	return SBI_SUCCESS;
+}
+
+int sbi_batch_doorbell(unsigned long start, unsigned long count,
+		       unsigned long *out_count)
+{
+	struct batch_state *bs = batch_state_thishart_ptr();
+	struct sbi_batch_entry *ring;
+	unsigned long i;
+
+	if (!batch_state_offset)
+		return SBI_ENOTSUPP;
+
+	/* The ring was checked against the domain which registered it */
+	if (!bs->dom || bs->dom != sbi_domain_thishart_ptr())
+		return SBI_ENO_SHMEM;
+
+	if (bs->num_entries <= start || bs->num_entries < count)
+		return SBI_EINVAL;
+
+	ring = (struct sbi_batch_entry *)bs->base;
+	for (i = 0; i < count; i++)
+		batch_entry_process(&ring[(start + i) % bs->num_entries]);
+
+	*out_count = count;
+	return SBI_SUCCESS;
+}
+
+int sbi_batch_init(struct sbi_scratch *scratch)
+{
+	batch_state_offset = sbi_scratch_alloc_type_offset(struct batch_state);
+	if (!batch_state_offset)
+		return SBI_ENOMEM;
+
+	return 0;
+}
@@ -7,11 +7,11 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
-#include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_fifo.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_qspinlock.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
 
@@ -20,7 +20,7 @@
 static const struct sbi_console_device *console_dev = NULL;
 static char console_tbuf[CONSOLE_TBUF_MAX];
 static u32 console_tbuf_len;
-static spinlock_t console_out_lock	       = SPIN_LOCK_INITIALIZER;
+static qspinlock_t console_out_lock	       = QSPIN_LOCK_INITIALIZER;
 
 #ifdef CONFIG_CONSOLE_EARLY_BUFFER_SIZE
 #define CONSOLE_EARLY_BUFFER_SIZE	CONFIG_CONSOLE_EARLY_BUFFER_SIZE
@@ -88,18 +88,18 @@ void sbi_puts(const char *str)
 {
 	unsigned long len = sbi_strlen(str);
 
-	spin_lock(&console_out_lock);
+	qspin_lock(&console_out_lock);
 	nputs_all(str, len);
-	spin_unlock(&console_out_lock);
+	qspin_unlock(&console_out_lock);
 }
 
 unsigned long sbi_nputs(const char *str, unsigned long len)
 {
 	unsigned long ret;
 
-	spin_lock(&console_out_lock);
+	qspin_lock(&console_out_lock);
 	ret = nputs(str, len);
-	spin_unlock(&console_out_lock);
+	qspin_unlock(&console_out_lock);
 
 	return ret;
 }
@@ -442,11 +442,11 @@ int sbi_printf(const char *format, ...)
 	va_list args;
 	int retval;
 
-	spin_lock(&console_out_lock);
+	qspin_lock(&console_out_lock);
 	va_start(args, format);
 	retval = print(NULL, NULL, format, args);
 	va_end(args);
-	spin_unlock(&console_out_lock);
+	qspin_unlock(&console_out_lock);
 
 	return retval;
 }
@@ -459,9 +459,9 @@ int sbi_dprintf(const char *format, ...)
 
 	va_start(args, format);
 	if (scratch->options & SBI_SCRATCH_DEBUG_PRINTS) {
-		spin_lock(&console_out_lock);
+		qspin_lock(&console_out_lock);
 		retval = print(NULL, NULL, format, args);
-		spin_unlock(&console_out_lock);
+		qspin_unlock(&console_out_lock);
 	}
 	va_end(args);
 
@@ -472,11 +472,11 @@ void sbi_panic(const char *format, ...)
 {
 	va_list args;
 
-	spin_lock(&console_out_lock);
+	qspin_lock(&console_out_lock);
 	va_start(args, format);
 	print(NULL, NULL, format, args);
 	va_end(args);
-	spin_unlock(&console_out_lock);
+	qspin_unlock(&console_out_lock);
 
 	sbi_hart_hang();
 }
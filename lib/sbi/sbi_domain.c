@@ -36,6 +36,7 @@ struct sbi_domain root = {
 };
 
 static unsigned long domain_hart_ptr_offset;
+static unsigned long domain_addr_hint_offset;
 
 struct sbi_domain *sbi_hartindex_to_domain(u32 hartindex)
 {
@@ -62,14 +63,15 @@ void sbi_update_hartindex_to_domain(u32 hartindex, struct sbi_domain *dom)
 bool sbi_domain_is_assigned_hart(const struct sbi_domain *dom, u32 hartindex)
 {
 	bool ret;
-	struct sbi_domain *tdom = (struct sbi_domain *)dom;
+	u32 seq;
 
 	if (!dom)
 		return false;
 
-	spin_lock(&tdom->assigned_harts_lock);
-	ret = sbi_hartmask_test_hartindex(hartindex, &tdom->assigned_harts);
-	spin_unlock(&tdom->assigned_harts_lock);
+	do {
+		seq = read_seqbegin(&dom->assigned_harts_lock);
+		ret = sbi_hartmask_test_hartindex(hartindex, &dom->assigned_harts);
+	} while (read_seqretry(&dom->assigned_harts_lock, seq));
 
 	return ret;
 }
@@ -78,16 +80,17 @@ int sbi_domain_get_assigned_hartmask(const struct sbi_domain *dom,
 				     struct sbi_hartmask *mask)
 {
 	ulong ret = 0;
-	struct sbi_domain *tdom = (struct sbi_domain *)dom;
+	u32 seq;
 
 	if (!dom) {
 		sbi_hartmask_clear_all(mask);
 		return 0;
 	}
 
-	spin_lock(&tdom->assigned_harts_lock);
-	sbi_hartmask_copy(mask, &tdom->assigned_harts);
-	spin_unlock(&tdom->assigned_harts_lock);
+	do {
+		seq = read_seqbegin(&dom->assigned_harts_lock);
+		sbi_hartmask_copy(mask, &dom->assigned_harts);
+	} while (read_seqretry(&dom->assigned_harts_lock, seq));
 
 	return ret;
 }
@@ -217,16 +220,12 @@ unsigned int sbi_domain_get_smepmp_flags(struct sbi_domain_memregion *reg)
 	return pmp_flags;
 }
 
-bool sbi_domain_check_addr(const struct sbi_domain *dom,
-			   unsigned long addr, unsigned long mode,
-			   unsigned long access_flags)
+/** Check access permissions of a region which matched an address */
+static bool region_check_access(const struct sbi_domain_memregion *reg,
+				unsigned long mode, unsigned long access_flags)
 {
 	bool rmmio, mmio = false;
-	struct sbi_domain_memregion *reg;
-	unsigned long rstart, rend, rflags, rwx = 0, rrwx = 0;
-
-	if (!dom)
-		return false;
+	unsigned long rflags, rwx = 0, rrwx = 0;
 
 	/*
 	 * Use M_{R/W/X} bits because the SU-bits are at the
@@ -245,28 +244,77 @@ bool sbi_domain_check_addr(const struct sbi_domain *dom,
 	if (access_flags & SBI_DOMAIN_MMIO)
 		mmio = true;
 
-	sbi_domain_for_each_memregion(dom, reg) {
-		rflags = reg->flags;
-		rrwx = (mode == PRV_M ?
-			(rflags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
-			(rflags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK)
-			>> SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
+	rflags = reg->flags;
+	rrwx = (mode == PRV_M ?
+		(rflags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
+		(rflags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK)
+		>> SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
 
-		rstart = reg->base;
-		rend = (reg->order < __riscv_xlen) ?
-			rstart + ((1UL << reg->order) - 1) : -1UL;
-		if (rstart <= addr && addr <= rend) {
-			rmmio = (rflags & SBI_DOMAIN_MEMREGION_MMIO) ? true : false;
-			/*
-			 * MMIO devices may appear in regions without the flag set (such as the
-			 * default region), but MMIO device regions should not be used as memory.
-			 */
-			if (!mmio && rmmio)
-				return false;
-			return ((rrwx & rwx) == rwx) ? true : false;
-		}
+	rmmio = (rflags & SBI_DOMAIN_MEMREGION_MMIO) ? true : false;
+	/*
+	 * MMIO devices may appear in regions without the flag set (such as the
+	 * default region), but MMIO device regions should not be used as memory.
+	 */
+	if (!mmio && rmmio)
+		return false;
+
+	return ((rrwx & rwx) == rwx) ? true : false;
+}
+
+static const struct sbi_domain_memregion *find_region(
+						const struct sbi_domain *dom,
+						unsigned long addr);
+
+/** Find the address interval containing given address */
+static const struct sbi_domain_addr_interval *find_interval(
+						const struct sbi_domain *dom,
+						unsigned long addr)
+{
+	const struct sbi_domain_addr_interval *iv = dom->addr_intervals;
+	u32 *hint = NULL, lo = 0, hi = dom->addr_interval_count - 1, mid;
+
+	/* Try the last interval hit by this HART first */
+	if (domain_addr_hint_offset) {
+		hint = sbi_scratch_offset_ptr(sbi_scratch_thishart_ptr(),
+					      domain_addr_hint_offset);
+		mid = *hint;
+		if (mid < dom->addr_interval_count &&
+		    iv[mid].start <= addr && addr <= iv[mid].end)
+			return &iv[mid];
+	}
+
+	/* Intervals are sorted, contiguous and start from address zero */
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1) / 2;
+		if (iv[mid].start <= addr)
+			lo = mid;
+		else
+			hi = mid - 1;
 	}
 
+	if (hint)
+		*hint = lo;
+
+	return &iv[lo];
+}
+
+bool sbi_domain_check_addr(const struct sbi_domain *dom,
+			   unsigned long addr, unsigned long mode,
+			   unsigned long access_flags)
+{
+	const struct sbi_domain_memregion *reg;
+
+	if (!dom)
+		return false;
+
+	if (dom->addr_intervals)
+		reg = find_interval(dom, addr)->reg;
+	else
+		reg = find_region(dom, addr);
+
+	if (reg)
+		return region_check_access(reg, mode, access_flags);
+
 	return (mode == PRV_M) ? true : false;
 }
 
@@ -508,6 +556,23 @@ bool sbi_domain_check_addr_range(const struct sbi_domain *dom,
 	if (size && max <= addr)
 		return false;
 
+	if (dom->addr_intervals) {
+		const struct sbi_domain_addr_interval *iv;
+
+		iv = find_interval(dom, addr);
+		while (addr < max) {
+			if (!iv->reg ||
+			    !region_check_access(iv->reg, mode, access_flags))
+				return false;
+			if (iv->end == -1UL)
+				break;
+			addr = iv->end + 1;
+			iv++;
+		}
+
+		return true;
+	}
+
 	while (addr < max) {
 		reg = find_region(dom, addr);
 		if (!reg)
@@ -519,7 +584,8 @@ bool sbi_domain_check_addr_range(const struct sbi_domain *dom,
 		sreg = find_next_subset_region(dom, reg, addr);
 		if (sreg)
 			addr = sreg->base;
-		else if (reg->order < __riscv_xlen)
+		else if (reg->order < __riscv_xlen &&
+			 (reg->base + (1UL << reg->order)) != 0)
 			addr = reg->base + (1UL << reg->order);
 		else
 			break;
@@ -657,8 +723,8 @@ int sbi_domain_register(struct sbi_domain *dom,
 	/* Assign index to domain */
 	dom->index = domain_count++;
 
-	/* Initialize spinlock for dom->assigned_harts */
-	SPIN_LOCK_INIT(dom->assigned_harts_lock);
+	/* Initialize sequence lock for dom->assigned_harts */
+	SEQLOCK_INIT(dom->assigned_harts_lock);
 
 	/* Clear assigned HARTs of domain */
 	sbi_hartmask_clear_all(&dom->assigned_harts);
@@ -669,11 +735,16 @@ int sbi_domain_register(struct sbi_domain *dom,
 			continue;
 
 		tdom = sbi_hartindex_to_domain(i);
-		if (tdom)
+		if (tdom) {
+			write_seqlock(&tdom->assigned_harts_lock);
 			sbi_hartmask_clear_hartindex(i,
 					&tdom->assigned_harts);
+			write_sequnlock(&tdom->assigned_harts_lock);
+		}
 		sbi_update_hartindex_to_domain(i, dom);
+		write_seqlock(&dom->assigned_harts_lock);
 		sbi_hartmask_set_hartindex(i, &dom->assigned_harts);
+		write_sequnlock(&dom->assigned_harts_lock);
 
 		/*
 		 * If cold boot HART is assigned to this domain then
@@ -813,10 +884,7 @@ int sbi_domain_startup(struct sbi_scratch *scratch, u32 cold_hartid)
 			continue;
 
 		/* Ignore if boot HART is not part of the assigned HARTs */
-		spin_lock(&dom->assigned_harts_lock);
-		rc = sbi_hartmask_test_hartindex(dhart, &dom->assigned_harts);
-		spin_unlock(&dom->assigned_harts_lock);
-		if (!rc)
+		if (!sbi_domain_is_assigned_hart(dom, dhart))
 			continue;
 
 		/* Startup boot HART of domain */
@@ -842,9 +910,84 @@ int sbi_domain_startup(struct sbi_scratch *scratch, u32 cold_hartid)
 	return 0;
 }
 
+int sbi_domain_build_addr_lookup(struct sbi_domain *dom)
+{
+	const struct sbi_domain_memregion *reg;
+	struct sbi_domain_addr_interval *iv;
+	unsigned long *bounds, tmp;
+	u32 i, j, nbounds = 0, count = 0;
+
+	if (!dom || !dom->regions)
+		return SBI_EINVAL;
+
+	sbi_domain_for_each_memregion(dom, reg)
+		count++;
+
+	/* Collect start and (exclusive) end address of each region */
+	bounds = sbi_calloc(sizeof(*bounds), 2 * count + 1);
+	if (!bounds)
+		return SBI_ENOMEM;
+
+	bounds[nbounds++] = 0;
+	sbi_domain_for_each_memregion(dom, reg) {
+		bounds[nbounds++] = reg->base;
+		if (reg->order < __riscv_xlen &&
+		    (reg->base + BIT(reg->order)) != 0)
+			bounds[nbounds++] = reg->base + BIT(reg->order);
+	}
+
+	/* Sort boundaries and drop duplicates */
+	for (i = 1; i < nbounds; i++) {
+		tmp = bounds[i];
+		for (j = i; j > 0 && bounds[j - 1] > tmp; j--)
+			bounds[j] = bounds[j - 1];
+		bounds[j] = tmp;
+	}
+	for (i = 1, j = 1; i < nbounds; i++) {
+		if (bounds[i] != bounds[j - 1])
+			bounds[j++] = bounds[i];
+	}
+	nbounds = j;
+
+	iv = sbi_calloc(sizeof(*iv), nbounds);
+	if (!iv) {
+		sbi_free(bounds);
+		return SBI_ENOMEM;
+	}
+
+	/*
+	 * The set of regions covering an address does not change between
+	 * two consecutive boundaries so the first matching region of the
+	 * interval start applies to the whole interval. Adjacent intervals
+	 * resolving to the same region are merged.
+	 */
+	for (i = 0, j = 0; i < nbounds; i++) {
+		reg = find_region(dom, bounds[i]);
+		if (j && iv[j - 1].reg == reg) {
+			iv[j - 1].end = (i + 1 < nbounds) ?
+					bounds[i + 1] - 1 : -1UL;
+			continue;
+		}
+		iv[j].start = bounds[i];
+		iv[j].end = (i + 1 < nbounds) ? bounds[i + 1] - 1 : -1UL;
+		iv[j].reg = reg;
+		j++;
+	}
+
+	sbi_free(bounds);
+
+	if (dom->addr_intervals)
+		sbi_free(dom->addr_intervals);
+	dom->addr_intervals = iv;
+	dom->addr_interval_count = j;
+
+	return 0;
+}
+
 int sbi_domain_finalize(struct sbi_scratch *scratch)
 {
 	int rc;
+	struct sbi_domain *dom;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
 	/* Sanity checks */
@@ -865,6 +1008,16 @@ int sbi_domain_finalize(struct sbi_scratch *scratch)
 	 */
 	domain_finalized = true;
 
+	/* Memory regions are now fixed so build address lookup tables */
+	sbi_domain_for_each(dom) {
+		rc = sbi_domain_build_addr_lookup(dom);
+		if (rc) {
+			sbi_printf("%s: address lookup setup failed for %s "
+				   "(error %d)\n", __func__, dom->name, rc);
+			return rc;
+		}
+	}
+
 	return 0;
 }
 
@@ -897,10 +1050,16 @@ int sbi_domain_init(struct sbi_scratch *scratch, u32 cold_hartid)
 	if (!domain_hart_ptr_offset)
 		return SBI_ENOMEM;
 
+	domain_addr_hint_offset = sbi_scratch_alloc_type_offset(u32);
+	if (!domain_addr_hint_offset) {
+		rc = SBI_ENOMEM;
+		goto fail_free_domain_hart_ptr_offset;
+	}
+
 	/* Initialize domain context support */
 	rc = sbi_domain_context_init();
 	if (rc)
-		goto fail_free_domain_hart_ptr_offset;
+		goto fail_free_domain_addr_hint_offset;
 
 	root_memregs = sbi_calloc(sizeof(*root_memregs), ROOT_REGION_MAX + 1);
 	if (!root_memregs) {
@@ -987,6 +1146,9 @@ fail_free_root_memregs:
 	sbi_free(root_memregs);
 fail_deinit_context:
 	sbi_domain_context_deinit();
+fail_free_domain_addr_hint_offset:
+	sbi_scratch_free_offset(domain_addr_hint_offset);
+	domain_addr_hint_offset = 0;
 fail_free_domain_hart_ptr_offset:
 	sbi_scratch_free_offset(domain_hart_ptr_offset);
 	return rc;
@@ -14,6 +14,7 @@
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_domain_context.h>
 #include <sbi/sbi_platform.h>
@@ -50,11 +51,17 @@ struct hart_context {
 	unsigned long senvcfg;
 	/** Supervisor resource management configuration register */
 	unsigned long srmcfg;
+	/** Virtual supervisor address translation and protection register */
+	unsigned long vsatp;
+	/** Hypervisor guest address translation and protection register */
+	unsigned long hgatp;
 
 	/** Float context state */
 	struct sbi_fp_context fp_ctx;
 	/** Vector context state */
 	struct sbi_vector_context *vec_ctx;
+	/** mstatus FS and VS values hidden until the first FP or vector use */
+	unsigned long lazy_status;
 
 	/** Reference to the owning domain */
 	struct sbi_domain *dom;
@@ -64,7 +71,21 @@ struct hart_context {
 	bool initialized;
 };
 
+/**
+ * Per-hart owners of the live FP and vector register state
+ *
+ * A NULL owner means the registers were cleared and hold no state
+ * of any context.
+ */
+struct hart_ext_owner {
+	/** Context whose FP state is live in the FP registers */
+	struct hart_context *fp;
+	/** Context whose vector state is live in the vector registers */
+	struct hart_context *vec;
+};
+
 static struct sbi_domain_data dcpriv;
+static unsigned long ext_owner_offset;
 
 static inline struct hart_context *hart_context_get(struct sbi_domain *dom,
 						    u32 hartindex)
@@ -95,6 +116,80 @@ static void hart_context_set(struct sbi_domain *dom, u32 hartindex,
 	hart_context_get(sbi_domain_thishart_ptr(),			\
 			 current_hartindex())
 
+static void fp_switch(struct hart_context **owner, struct hart_context *ctx,
+		      struct hart_context *dom_ctx)
+{
+	unsigned long *mstatus = &ctx->trap_ctx.regs.mstatus;
+
+	/*
+	 * The registers hold state of the current context unless its FP
+	 * status is still hidden and Off. In that case it did not use FP
+	 * since it was switched in and only its status is un-hidden.
+	 * Otherwise save even when FS is Off or Clean because S-mode may
+	 * keep live state with FS Off and Clean does not mean equal to
+	 * the saved copy.
+	 */
+	if ((ctx->lazy_status & MSTATUS_FS) && !(*mstatus & MSTATUS_FS)) {
+		*mstatus |= ctx->lazy_status & MSTATUS_FS;
+	} else {
+		sbi_fp_save(&ctx->fp_ctx);
+		*owner = ctx;
+	}
+	ctx->lazy_status &= ~MSTATUS_FS;
+
+	/*
+	 * With FS Off the target context can turn FP on by itself without
+	 * trapping so nothing can be hidden. Restore its state right away.
+	 */
+	mstatus = &dom_ctx->trap_ctx.regs.mstatus;
+	if (!(*mstatus & MSTATUS_FS)) {
+		sbi_fp_restore(&dom_ctx->fp_ctx);
+		*owner = dom_ctx;
+		return;
+	}
+
+	/* Never let the target context see FP state of other contexts */
+	if (*owner) {
+		sbi_fp_clear();
+		*owner = NULL;
+	}
+
+	/* Hide FP from the target context so that its first use traps */
+	dom_ctx->lazy_status |= *mstatus & MSTATUS_FS;
+	*mstatus &= ~MSTATUS_FS;
+}
+
+static void vector_switch(struct hart_context **owner,
+			  struct hart_context *ctx,
+			  struct hart_context *dom_ctx)
+{
+	unsigned long *mstatus = &ctx->trap_ctx.regs.mstatus;
+
+	/* Same as fp_switch() but for the vector register state */
+	if ((ctx->lazy_status & MSTATUS_VS) && !(*mstatus & MSTATUS_VS)) {
+		*mstatus |= ctx->lazy_status & MSTATUS_VS;
+	} else {
+		sbi_vector_save(ctx->vec_ctx);
+		*owner = ctx;
+	}
+	ctx->lazy_status &= ~MSTATUS_VS;
+
+	mstatus = &dom_ctx->trap_ctx.regs.mstatus;
+	if (!(*mstatus & MSTATUS_VS)) {
+		sbi_vector_restore(dom_ctx->vec_ctx);
+		*owner = dom_ctx;
+		return;
+	}
+
+	if (*owner) {
+		sbi_vector_clear();
+		*owner = NULL;
+	}
+
+	dom_ctx->lazy_status |= *mstatus & MSTATUS_VS;
+	*mstatus &= ~MSTATUS_VS;
+}
+
 /**
  * Switches the HART context from the current domain to the target domain.
  * This includes changing domain assignments and reconfiguring PMP, as well
@@ -112,22 +207,28 @@ static int switch_to_next_domain_context(struct hart_context *ctx,
 	struct sbi_trap_context *trap_ctx;
 	struct sbi_domain *current_dom, *target_dom;
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct hart_ext_owner *owner = sbi_scratch_offset_ptr(scratch,
+							ext_owner_offset);
+	bool fence;
 
 	if (!ctx || !dom_ctx || ctx == dom_ctx)
 		return SBI_EINVAL;
 
 	current_dom = ctx->dom;
 	target_dom = dom_ctx->dom;
+	sbi_trace(SBI_TRACE_DOMAIN_SWITCH, current_dom->index,
+		  target_dom->index, 0, 0);
+
 	/* Assign current hart to target domain */
-	spin_lock(&current_dom->assigned_harts_lock);
+	write_seqlock(&current_dom->assigned_harts_lock);
 	sbi_hartmask_clear_hartindex(hartindex, &current_dom->assigned_harts);
-	spin_unlock(&current_dom->assigned_harts_lock);
+	write_sequnlock(&current_dom->assigned_harts_lock);
 
 	sbi_update_hartindex_to_domain(hartindex, target_dom);
 
-	spin_lock(&target_dom->assigned_harts_lock);
+	write_seqlock(&target_dom->assigned_harts_lock);
 	sbi_hartmask_set_hartindex(hartindex, &target_dom->assigned_harts);
-	spin_unlock(&target_dom->assigned_harts_lock);
+	write_sequnlock(&target_dom->assigned_harts_lock);
 
 	/* Save current CSR context and restore target domain's CSR context */
 	ctx->sstatus	= csr_swap(CSR_SSTATUS, dom_ctx->sstatus);
@@ -145,34 +246,40 @@ static int switch_to_next_domain_context(struct hart_context *ctx,
 		ctx->senvcfg	= csr_swap(CSR_SENVCFG, dom_ctx->senvcfg);
 	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSQOSID))
 		ctx->srmcfg	= csr_swap(CSR_SRMCFG, dom_ctx->srmcfg);
-
-	/* Eager context switch for float */
-	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_F) ||
-	    sbi_hart_has_extension(scratch, SBI_HART_EXT_D)) {
-		sbi_fp_save(&ctx->fp_ctx);
-		sbi_fp_restore(&dom_ctx->fp_ctx);
-	}
-
-	/* Eager context switch for vector */
-	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_V)) {
-		sbi_vector_save(ctx->vec_ctx);
-		sbi_vector_restore(dom_ctx->vec_ctx);
+	if (misa_extension('H')) {
+		ctx->vsatp	= csr_swap(CSR_VSATP, dom_ctx->vsatp);
+		ctx->hgatp	= csr_swap(CSR_HGATP, dom_ctx->hgatp);
 	}
 
-	/* Save current trap state and restore target domain's trap state */
+	/* Save current trap state */
 	trap_ctx = sbi_trap_get_context(scratch);
 	sbi_memcpy(&ctx->trap_ctx, trap_ctx, sizeof(*trap_ctx));
+
+	/* Lazy context switch for float */
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_F) ||
+	    sbi_hart_has_extension(scratch, SBI_HART_EXT_D))
+		fp_switch(&owner->fp, ctx, dom_ctx);
+
+	/* Lazy context switch for vector */
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_V))
+		vector_switch(&owner->vec, ctx, dom_ctx);
+
+	/* Restore target domain's trap state */
 	sbi_memcpy(trap_ctx, &dom_ctx->trap_ctx, sizeof(*trap_ctx));
 
 	/*
 	 * Re-configure PMP settings for the new domain
 	 *
-	 * This will internally perform full SFENCE / HFENCE which
-	 * is also required for some of the above CSR updates (such
-	 * as satp CSR).
+	 * Only the PMP entries which differ between the two domains
+	 * are re-programmed and full SFENCE / HFENCE is always done when
+	 * some entry changed. The fence is also required when any address
+	 * translation CSR changes so request it explicitly in that case.
 	 */
-	sbi_hart_protection_unconfigure(scratch);
-	sbi_hart_protection_configure(scratch);
+	fence = ctx->satp != dom_ctx->satp;
+	if (misa_extension('H'))
+		fence = fence || ctx->vsatp != dom_ctx->vsatp ||
+			ctx->hgatp != dom_ctx->hgatp;
+	sbi_hart_protection_reconfigure(scratch, fence);
 
 	/* Mark current context structure initialized because context saved */
 	ctx->initialized = true;
@@ -310,8 +417,114 @@ int sbi_domain_context_exit(void)
 	return switch_to_next_domain_context(ctx, dom_ctx);
 }
 
+static bool insn_uses_fp(ulong insn)
+{
+	ulong funct3 = (insn >> 12) & 0x7;
+
+	/* Compressed FP loads and stores */
+	if ((insn & 0x3) != 0x3) {
+		funct3 = (insn >> 13) & 0x7;
+		if ((insn & 0x3) == 0x1)
+			return false;
+#if __riscv_xlen == 32
+		if (funct3 == 0x3 || funct3 == 0x7)
+			return true;
+#endif
+		return funct3 == 0x1 || funct3 == 0x5;
+	}
+
+	switch (insn & 0x7f) {
+	case 0x07: /* LOAD-FP */
+	case 0x27: /* STORE-FP */
+		return 0x1 <= funct3 && funct3 <= 0x4;
+	case 0x43: /* MADD */
+	case 0x47: /* MSUB */
+	case 0x4b: /* NMSUB */
+	case 0x4f: /* NMADD */
+	case 0x53: /* OP-FP */
+		return true;
+	case 0x57: /* OP-V with a scalar FP operand */
+		return funct3 == 0x1 || funct3 == 0x5;
+	case 0x73: /* SYSTEM */
+		return funct3 && CSR_FFLAGS <= (insn >> 20) &&
+		       (insn >> 20) <= CSR_FCSR;
+	default:
+		return false;
+	}
+}
+
+static bool insn_uses_vector(ulong insn)
+{
+	ulong funct3 = (insn >> 12) & 0x7;
+
+	if ((insn & 0x3) != 0x3)
+		return false;
+
+	switch (insn & 0x7f) {
+	case 0x07: /* LOAD-FP */
+	case 0x27: /* STORE-FP */
+		return funct3 == 0x0 || funct3 >= 0x5;
+	case 0x57: /* OP-V */
+		return true;
+	case 0x73: /* SYSTEM */
+		switch (insn >> 20) {
+		case CSR_VSTART:
+		case CSR_VXSAT:
+		case CSR_VXRM:
+		case CSR_VCSR:
+		case CSR_VL:
+		case CSR_VTYPE:
+		case CSR_VLENB:
+			return funct3 != 0;
+		default:
+			return false;
+		}
+	default:
+		return false;
+	}
+}
+
+bool sbi_domain_context_lazy_restore(ulong insn, struct sbi_trap_regs *regs)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct hart_context *ctx;
+	struct hart_ext_owner *owner;
+	bool restored = false;
+
+	if ((regs->mstatus & MSTATUS_FS) && (regs->mstatus & MSTATUS_VS))
+		return false;
+
+	ctx = hart_context_thishart_get();
+	if (!ctx || !ctx->lazy_status)
+		return false;
+
+	owner = sbi_scratch_offset_ptr(scratch, ext_owner_offset);
+
+	if ((ctx->lazy_status & MSTATUS_FS) &&
+	    !(regs->mstatus & MSTATUS_FS) && insn_uses_fp(insn)) {
+		sbi_fp_restore(&ctx->fp_ctx);
+		owner->fp = ctx;
+		regs->mstatus |= ctx->lazy_status & MSTATUS_FS;
+		ctx->lazy_status &= ~MSTATUS_FS;
+		restored = true;
+	}
+
+	if ((ctx->lazy_status & MSTATUS_VS) &&
+	    !(regs->mstatus & MSTATUS_VS) && insn_uses_vector(insn)) {
+		sbi_vector_restore(ctx->vec_ctx);
+		owner->vec = ctx;
+		regs->mstatus |= ctx->lazy_status & MSTATUS_VS;
+		ctx->lazy_status &= ~MSTATUS_VS;
+		restored = true;
+	}
+
+	return restored;
+}
+
 int sbi_domain_context_init(void)
 {
+	int rc;
+
 	/**
 	 * Allocate per-domain and per-hart context data.
 	 * The data type is "struct hart_context **" whose memory space will be
@@ -320,10 +533,24 @@ int sbi_domain_context_init(void)
 	 */
 	dcpriv.data_size = sizeof(struct hart_context *) * sbi_hart_count();
 
-	return sbi_domain_register_data(&dcpriv);
+	ext_owner_offset = sbi_scratch_alloc_type_offset(struct hart_ext_owner);
+	if (!ext_owner_offset)
+		return SBI_ENOMEM;
+
+	rc = sbi_domain_register_data(&dcpriv);
+	if (rc) {
+		sbi_scratch_free_offset(ext_owner_offset);
+		ext_owner_offset = 0;
+	}
+
+	return rc;
 }
 
 void sbi_domain_context_deinit(void)
 {
 	sbi_domain_unregister_data(&dcpriv);
+	if (ext_owner_offset) {
+		sbi_scratch_free_offset(ext_owner_offset);
+		ext_owner_offset = 0;
+	}
 }
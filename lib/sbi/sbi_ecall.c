@@ -7,11 +7,14 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 
 extern struct sbi_ecall_extension *const sbi_ecall_exts[];
@@ -39,17 +42,34 @@ void sbi_ecall_set_impid(unsigned long impid)
 }
 
 static SBI_LIST_HEAD(ecall_exts_list);
+static seqlock_t ecall_exts_lock = SEQLOCK_INITIALIZER;
+static u32 ecall_exts_count;
 
+/*
+ * Readers walk the list without barriers and check the sequence only
+ * once at the end. The links of a node under update always point to
+ * a registered extension, the list head or the node itself, and the
+ * walk is bounded by the number of extensions so that it ends even
+ * while following a node being removed.
+ */
 struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
 {
-	struct sbi_ecall_extension *t, *ret = NULL;
-
-	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
-		if (t->extid_start <= extid && extid <= t->extid_end) {
-			ret = t;
-			break;
+	struct sbi_ecall_extension *t, *ret;
+	u32 seq, count;
+
+	do {
+		seq = read_seqbegin(&ecall_exts_lock);
+		count = ecall_exts_count;
+		ret = NULL;
+		sbi_list_for_each_entry(t, &ecall_exts_list, head) {
+			if (!count--)
+				break;
+			if (t->extid_start <= extid && extid <= t->extid_end) {
+				ret = t;
+				break;
+			}
 		}
-	}
+	} while (read_seqretry(&ecall_exts_lock, seq));
 
 	return ret;
 }
@@ -57,19 +77,27 @@ struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
 void sbi_ecall_get_extensions_str(char *exts_str, int exts_str_size, bool experimental)
 {
 	struct sbi_ecall_extension *t;
-	int offset = 0;
+	int offset;
+	u32 seq, count;
 
 	if (!exts_str || exts_str_size <= 0)
 		return;
-	sbi_memset(exts_str, 0, exts_str_size);
 
-	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
-		if (experimental != t->experimental)
-			continue;
-		sbi_snprintf(exts_str + offset, exts_str_size - offset,
-			     "%s,", t->name);
-		offset = offset + sbi_strlen(t->name) + 1;
-	}
+	do {
+		seq = read_seqbegin(&ecall_exts_lock);
+		count = ecall_exts_count;
+		offset = 0;
+		sbi_memset(exts_str, 0, exts_str_size);
+		sbi_list_for_each_entry(t, &ecall_exts_list, head) {
+			if (!count--)
+				break;
+			if (experimental != t->experimental)
+				continue;
+			sbi_snprintf(exts_str + offset, exts_str_size - offset,
+				     "%s,", t->name);
+			offset = offset + sbi_strlen(t->name) + 1;
+		}
+	} while (read_seqretry(&ecall_exts_lock, seq));
 
 	if (offset)
 		exts_str[offset - 1] = '\0';
@@ -84,16 +112,27 @@ int sbi_ecall_register_extension(struct sbi_ecall_extension *ext)
 	if (!ext || (ext->extid_end < ext->extid_start) || !ext->handle)
 		return SBI_EINVAL;
 
+	write_seqlock(&ecall_exts_lock);
+
 	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
 		unsigned long start = t->extid_start;
 		unsigned long end = t->extid_end;
 		if (end < ext->extid_start || ext->extid_end < start)
 			/* no overlap */;
-		else
+		else {
+			write_sequnlock(&ecall_exts_lock);
 			return SBI_EINVAL;
+		}
 	}
 
+	/* Readers may see the new node before the stores linking it */
+	ext->head.next = &ecall_exts_list;
+	ext->head.prev = ecall_exts_list.prev;
+	smp_wmb();
 	sbi_list_add_tail(&ext->head, &ecall_exts_list);
+	ecall_exts_count++;
+
+	write_sequnlock(&ecall_exts_lock);
 
 	return 0;
 }
@@ -106,6 +145,8 @@ void sbi_ecall_unregister_extension(struct sbi_ecall_extension *ext)
 	if (!ext)
 		return;
 
+	write_seqlock(&ecall_exts_lock);
+
 	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
 		if (t == ext) {
 			found = true;
@@ -113,8 +154,12 @@ void sbi_ecall_unregister_extension(struct sbi_ecall_extension *ext)
 		}
 	}
 
-	if (found)
+	if (found) {
 		sbi_list_del_init(&ext->head);
+		ecall_exts_count--;
+	}
+
+	write_sequnlock(&ecall_exts_lock);
 }
 
 int sbi_ecall_handler(struct sbi_trap_context *tcntx)
@@ -137,6 +182,8 @@ int sbi_ecall_handler(struct sbi_trap_context *tcntx)
 		ret = SBI_ENOTSUPP;
 	}
 
+	sbi_trace(SBI_TRACE_ECALL, extension_id, func_id, ret, out.value);
+
 	if (!out.skip_regs_update) {
 		if (ret < SBI_LAST_ERR ||
 		    (extension_id != SBI_EXT_0_1_CONSOLE_GETCHAR &&
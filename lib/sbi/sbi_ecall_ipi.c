@@ -39,6 +39,7 @@ struct sbi_ecall_extension ecall_ipi = {
 	.name			= "ipi",
 	.extid_start		= SBI_EXT_IPI,
 	.extid_end		= SBI_EXT_IPI,
+	.batchable		= true,
 	.register_extensions	= sbi_ecall_ipi_register_extensions,
 	.handle			= sbi_ecall_ipi_handler,
 };
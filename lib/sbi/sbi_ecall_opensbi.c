@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hsm.h>
+#include <sbi/sbi_prof.h>
+#include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trap.h>
+
+static int sbi_ecall_opensbi_handler(unsigned long extid, unsigned long funcid,
+				     struct sbi_trap_regs *regs,
+				     struct sbi_ecall_return *out)
+{
+	u32 count = 0;
+	int ret = 0;
+
+	switch (funcid) {
+	case SBI_EXT_OPENSBI_PROF_NUM_RECORDS:
+		out->value = sbi_prof_record_count();
+		break;
+	case SBI_EXT_OPENSBI_PROF_READ_RECORDS:
+		/*
+		 * M-mode can only access the lower XLEN bits of the
+		 * physical address space so fail if upper bits are set.
+		 */
+		if (regs->a3)
+			return SBI_EINVALID_ADDR;
+		ret = sbi_prof_read_records(regs->a0, regs->a1, regs->a2,
+					    &count);
+		out->value = count;
+		break;
+	case SBI_EXT_OPENSBI_HSM_SUSPEND_STATS:
+		if (regs->a3)
+			return SBI_EINVALID_ADDR;
+		ret = sbi_hsm_read_suspend_stats(regs->a0, regs->a2, regs->a1,
+						 &count);
+		out->value = count;
+		break;
+	case SBI_EXT_OPENSBI_TLB_FIFO_FULL_COUNT:
+		out->value = sbi_tlb_fifo_full_count();
+		break;
+	case SBI_EXT_OPENSBI_TRACE_SET_EVENTS:
+		/* Trace records show activity of all domains */
+		if (sbi_domain_thishart_ptr() != &root)
+			return SBI_EDENIED;
+		ret = sbi_trace_set_events(regs->a0, &out->value);
+		break;
+	case SBI_EXT_OPENSBI_TRACE_READ_RECORDS:
+		if (sbi_domain_thishart_ptr() != &root)
+			return SBI_EDENIED;
+		if (regs->a4)
+			return SBI_EINVALID_ADDR;
+		ret = sbi_trace_read_records(regs->a0, regs->a1, regs->a2,
+					     regs->a3, &count);
+		out->value = count;
+		break;
+	case SBI_EXT_OPENSBI_BATCH_SET_SHMEM:
+		ret = sbi_batch_set_shmem(regs->a0, regs->a1, regs->a2);
+		break;
+	case SBI_EXT_OPENSBI_BATCH_DOORBELL:
+		ret = sbi_batch_doorbell(regs->a0, regs->a1, &out->value);
+		break;
+	default:
+		ret = SBI_ENOTSUPP;
+	}
+
+	return ret;
+}
+
+struct sbi_ecall_extension ecall_opensbi;
+
+static int sbi_ecall_opensbi_register_extensions(void)
+{
+	return sbi_ecall_register_extension(&ecall_opensbi);
+}
+
+struct sbi_ecall_extension ecall_opensbi = {
+	.name			= "opensbi",
+	.extid_start		= SBI_EXT_OPENSBI,
+	.extid_end		= SBI_EXT_OPENSBI,
+	.register_extensions	= sbi_ecall_opensbi_register_extensions,
+	.handle			= sbi_ecall_opensbi_handler,
+};
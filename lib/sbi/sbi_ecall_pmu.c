@@ -96,6 +96,7 @@ struct sbi_ecall_extension ecall_pmu = {
 	.name			= "pmu",
 	.extid_start		= SBI_EXT_PMU,
 	.extid_end		= SBI_EXT_PMU,
+	.batchable		= true,
 	.register_extensions	= sbi_ecall_pmu_register_extensions,
 	.handle			= sbi_ecall_pmu_handler,
 };
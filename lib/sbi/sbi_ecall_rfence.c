@@ -87,6 +87,7 @@ struct sbi_ecall_extension ecall_rfence = {
 	.name			= "rfnc",
 	.extid_start		= SBI_EXT_RFENCE,
 	.extid_end		= SBI_EXT_RFENCE,
+	.batchable		= true,
 	.register_extensions	= sbi_ecall_rfence_register_extensions,
 	.handle			= sbi_ecall_rfence_handler,
 };
@@ -43,6 +43,7 @@ struct sbi_ecall_extension ecall_time = {
 	.name			= "time",
 	.extid_start		= SBI_EXT_TIME,
 	.extid_end		= SBI_EXT_TIME,
+	.batchable		= true,
 	.register_extensions	= sbi_ecall_time_register_extensions,
 	.handle			= sbi_ecall_time_handler,
 };
@@ -20,7 +20,7 @@ void sbi_fp_save(struct sbi_fp_context *dst)
 	if (!dst)
 		return;
 
-	mstatus_orig = csr_read_set(CSR_MSTATUS, MSTATUS_VS);
+	mstatus_orig = csr_read_set(CSR_MSTATUS, MSTATUS_FS);
 
 	asm volatile(
 #if defined(__riscv_d)
@@ -189,4 +189,86 @@ void sbi_fp_restore(const struct sbi_fp_context *src)
 	/* Restore original mstatus LAST */
 	csr_write(CSR_MSTATUS, mstatus_orig);
 }
+
+void sbi_fp_clear(void)
+{
+	unsigned long mstatus_orig;
+
+	mstatus_orig = csr_read_set(CSR_MSTATUS, MSTATUS_FS);
+
+	asm volatile(
+#if defined(__riscv_d)
+		"fcvt.d.w f0, zero\n"
+		"fcvt.d.w f1, zero\n"
+		"fcvt.d.w f2, zero\n"
+		"fcvt.d.w f3, zero\n"
+		"fcvt.d.w f4, zero\n"
+		"fcvt.d.w f5, zero\n"
+		"fcvt.d.w f6, zero\n"
+		"fcvt.d.w f7, zero\n"
+		"fcvt.d.w f8, zero\n"
+		"fcvt.d.w f9, zero\n"
+		"fcvt.d.w f10, zero\n"
+		"fcvt.d.w f11, zero\n"
+		"fcvt.d.w f12, zero\n"
+		"fcvt.d.w f13, zero\n"
+		"fcvt.d.w f14, zero\n"
+		"fcvt.d.w f15, zero\n"
+		"fcvt.d.w f16, zero\n"
+		"fcvt.d.w f17, zero\n"
+		"fcvt.d.w f18, zero\n"
+		"fcvt.d.w f19, zero\n"
+		"fcvt.d.w f20, zero\n"
+		"fcvt.d.w f21, zero\n"
+		"fcvt.d.w f22, zero\n"
+		"fcvt.d.w f23, zero\n"
+		"fcvt.d.w f24, zero\n"
+		"fcvt.d.w f25, zero\n"
+		"fcvt.d.w f26, zero\n"
+		"fcvt.d.w f27, zero\n"
+		"fcvt.d.w f28, zero\n"
+		"fcvt.d.w f29, zero\n"
+		"fcvt.d.w f30, zero\n"
+		"fcvt.d.w f31, zero\n"
+#else
+		"fmv.w.x f0, zero\n"
+		"fmv.w.x f1, zero\n"
+		"fmv.w.x f2, zero\n"
+		"fmv.w.x f3, zero\n"
+		"fmv.w.x f4, zero\n"
+		"fmv.w.x f5, zero\n"
+		"fmv.w.x f6, zero\n"
+		"fmv.w.x f7, zero\n"
+		"fmv.w.x f8, zero\n"
+		"fmv.w.x f9, zero\n"
+		"fmv.w.x f10, zero\n"
+		"fmv.w.x f11, zero\n"
+		"fmv.w.x f12, zero\n"
+		"fmv.w.x f13, zero\n"
+		"fmv.w.x f14, zero\n"
+		"fmv.w.x f15, zero\n"
+		"fmv.w.x f16, zero\n"
+		"fmv.w.x f17, zero\n"
+		"fmv.w.x f18, zero\n"
+		"fmv.w.x f19, zero\n"
+		"fmv.w.x f20, zero\n"
+		"fmv.w.x f21, zero\n"
+		"fmv.w.x f22, zero\n"
+		"fmv.w.x f23, zero\n"
+		"fmv.w.x f24, zero\n"
+		"fmv.w.x f25, zero\n"
+		"fmv.w.x f26, zero\n"
+		"fmv.w.x f27, zero\n"
+		"fmv.w.x f28, zero\n"
+		"fmv.w.x f29, zero\n"
+		"fmv.w.x f30, zero\n"
+		"fmv.w.x f31, zero\n"
+#endif
+	);
+
+	csr_write(CSR_FCSR, 0);
+
+	/* Restore original mstatus LAST */
+	csr_write(CSR_MSTATUS, mstatus_orig);
+}
 #endif /* __riscv_f || __riscv_d */
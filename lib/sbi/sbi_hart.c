@@ -508,6 +508,86 @@ static int hart_mhpm_get_allowed_bits(void)
 	return num_bits;
 }
 
+#ifdef CONFIG_SBI_HART_FEATURES_SHARE
+
+/* HART features detected by the coldboot HART along with its identity */
+static struct {
+	bool valid;
+	unsigned long mvendorid;
+	unsigned long marchid;
+	unsigned long mimpid;
+	unsigned long misa;
+	unsigned long pmp_allowed_addr;
+	unsigned long fdt_extensions[BITS_TO_LONGS(SBI_HART_EXT_MAX)];
+	struct sbi_hart_features features;
+} hart_shared_features;
+
+static void hart_shared_features_prepare(struct sbi_hart_features *hfeatures)
+{
+	hart_shared_features.valid = false;
+	hart_shared_features.mvendorid = csr_read(CSR_MVENDORID);
+	hart_shared_features.marchid = csr_read(CSR_MARCHID);
+	hart_shared_features.mimpid = csr_read(CSR_MIMPID);
+	hart_shared_features.misa = csr_read(CSR_MISA);
+	hart_shared_features.pmp_allowed_addr = hart_pmp_get_allowed_addr();
+	/* Only extensions from the platform (ISA string) before probing */
+	sbi_memcpy(hart_shared_features.fdt_extensions, hfeatures->extensions,
+		   sizeof(hart_shared_features.fdt_extensions));
+}
+
+static void hart_shared_features_publish(struct sbi_hart_features *hfeatures)
+{
+	sbi_memcpy(&hart_shared_features.features, hfeatures,
+		   sizeof(hart_shared_features.features));
+	hart_shared_features.valid = true;
+}
+
+static bool hart_shared_features_copy(struct sbi_hart_features *hfeatures)
+{
+	if (!hart_shared_features.valid)
+		return false;
+
+	/*
+	 * A HART can reuse features of the coldboot HART only if it is
+	 * the same implementation and platform reports same extensions.
+	 * The allowed PMP address bits are also compared as a cheap check
+	 * since it is the only probed feature which needs one CSR write.
+	 */
+	if (csr_read(CSR_MVENDORID) != hart_shared_features.mvendorid ||
+	    csr_read(CSR_MARCHID) != hart_shared_features.marchid ||
+	    csr_read(CSR_MIMPID) != hart_shared_features.mimpid ||
+	    csr_read(CSR_MISA) != hart_shared_features.misa)
+		return false;
+	if (sbi_memcmp(hfeatures->extensions,
+		       hart_shared_features.fdt_extensions,
+		       sizeof(hart_shared_features.fdt_extensions)))
+		return false;
+	if (hart_pmp_get_allowed_addr() !=
+	    hart_shared_features.pmp_allowed_addr)
+		return false;
+
+	sbi_memcpy(hfeatures, &hart_shared_features.features,
+		   sizeof(*hfeatures));
+	return true;
+}
+
+#else
+
+static void hart_shared_features_prepare(struct sbi_hart_features *hfeatures)
+{
+}
+
+static void hart_shared_features_publish(struct sbi_hart_features *hfeatures)
+{
+}
+
+static bool hart_shared_features_copy(struct sbi_hart_features *hfeatures)
+{
+	return false;
+}
+
+#endif
+
 static int hart_detect_features(struct sbi_scratch *scratch, bool cold_boot)
 {
 	struct sbi_trap_info trap = {0};
@@ -549,6 +629,15 @@ static int hart_detect_features(struct sbi_scratch *scratch, bool cold_boot)
 		csr_set(CSR_MNSTATUS, MNSTATUS_NMIE);
 	}
 
+	/*
+	 * Reuse features of the coldboot HART on identical HARTs and
+	 * fallback to probing for heterogeneous HARTs.
+	 */
+	if (cold_boot)
+		hart_shared_features_prepare(hfeatures);
+	else if (hart_shared_features_copy(hfeatures))
+		goto __detected;
+
 #define __check_hpm_csr(__csr, __mask) 					  \
 	oldval = csr_read_allowed(__csr, &trap);			  \
 	if (!trap.cause) {						  \
@@ -714,6 +803,10 @@ __pmp_skip:
 		__sbi_hart_update_extension(hfeatures,
 					SBI_HART_EXT_ZIHPM, true);
 
+	if (cold_boot)
+		hart_shared_features_publish(hfeatures);
+
+__detected:
 	/* Mark hart feature detection done */
 	hfeatures->detected = true;
 
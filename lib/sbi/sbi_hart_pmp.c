@@ -7,8 +7,10 @@
 #include <sbi/sbi_bitmap.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_data.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_hfence.h>
 #include <sbi/sbi_math.h>
 #include <sbi/sbi_platform.h>
@@ -140,9 +142,89 @@ int sbi_hart_pmp_get(unsigned int n, unsigned long *prot_out, unsigned long *add
  */
 #define SBI_SMEPMP_RESV_ENTRY		0
 
+/*
+ * Shared memory registered by S/U-mode (such as MPXY shared memory) is
+ * accessed by M-mode on almost every SBI call of the extension. To avoid
+ * re-programming the reserved entry twice per SBI call, a few PMP entries
+ * after the reserved entry are used as per-HART persistent shared memory
+ * windows. A window stays mapped until the shared memory is re-registered,
+ * is evicted by another window, or the HART switches domain. The windows
+ * are only a cache so M-mode falls back to the reserved entry on a miss.
+ */
+#ifndef CONFIG_SBI_SMEPMP_SHMEM_WINDOWS
+#define CONFIG_SBI_SMEPMP_SHMEM_WINDOWS	0
+#endif
+#define SBI_SMEPMP_SHMEM_WINDOWS	CONFIG_SBI_SMEPMP_SHMEM_WINDOWS
+#define SBI_SMEPMP_WINDOW_ENTRY(__i)	(SBI_SMEPMP_RESV_ENTRY + 1 + (__i))
+#define SBI_SMEPMP_REGION_ENTRY		\
+		SBI_SMEPMP_WINDOW_ENTRY(SBI_SMEPMP_SHMEM_WINDOWS)
+
+struct smepmp_shmem_window {
+	/* Domain which registered the window (NULL for free window) */
+	struct sbi_domain *dom;
+	unsigned long base;
+	unsigned long order;
+	/* Whether the window is currently programmed in its PMP entry */
+	bool mapped;
+};
+
+struct smepmp_shmem_windows {
+	struct smepmp_shmem_window win[SBI_SMEPMP_SHMEM_WINDOWS];
+	/* Next window to evict when all windows are in use */
+	unsigned int victim;
+};
+
+static unsigned long smepmp_windows_offset;
+
 static DECLARE_BITMAP(fw_smepmp_ids, PMP_COUNT);
 static bool fw_smepmp_ids_inited;
 
+/*
+ * Pre-computed PMP image of a domain
+ *
+ * The image holds the PMP entries which sbi_hart_smepmp_configure() or
+ * sbi_hart_oldpmp_configure() programs for a domain. It is computed once
+ * for all domains after the domains are finalized and allows a domain
+ * context switch to only re-program the PMP entries which differ between
+ * the two domains. The image is only usable on HARTs having the same PMP
+ * parameters as the HART which computed it.
+ */
+struct hart_pmp_image_entry {
+	/* PMP entry encoding (cfg is zero for disabled entry) */
+	pmp_t pmp;
+	/* PMP permissions of the entry */
+	unsigned long prot;
+	/* Memory region of the entry (NULL for disabled entry) */
+	const struct sbi_domain_memregion *reg;
+};
+
+struct hart_pmp_image {
+	bool valid;
+	unsigned int pmp_count;
+	unsigned int pmp_log2gran;
+	unsigned int pmp_addr_bits;
+	struct hart_pmp_image_entry *entries;
+};
+
+static bool pmp_images_inited;
+
+static void hart_pmp_image_cleanup(struct sbi_domain *dom,
+				   struct sbi_domain_data *data,
+				   void *data_ptr)
+{
+	struct hart_pmp_image *img = data_ptr;
+
+	sbi_free(img->entries);
+}
+
+static struct sbi_domain_data pmp_image_data = {
+	.data_size = sizeof(struct hart_pmp_image),
+	.data_cleanup = hart_pmp_image_cleanup,
+};
+
+/* Offset of pointer to the PMP image currently programmed on a HART */
+static unsigned long pmp_cur_image_offset;
+
 unsigned int sbi_hart_pmp_count(struct sbi_scratch *scratch)
 {
 	struct sbi_hart_features *hfeatures = sbi_hart_features_ptr(scratch);
@@ -191,8 +273,10 @@ void sbi_hart_pmp_fence(void)
 		 * If hypervisor mode is supported, flush caching
 		 * structures in guest mode too.
 		 */
-		if (misa_extension('H'))
+		if (misa_extension('H')) {
 			__sbi_hfence_gvma_all();
+			__sbi_hfence_vvma_all();
+		}
 	}
 }
 
@@ -228,6 +312,312 @@ static bool is_valid_pmp_idx(unsigned int pmp_count, unsigned int pmp_idx)
 	return false;
 }
 
+static int hart_pmp_image_set(struct hart_pmp_image *img, unsigned int pmp_idx,
+			      const struct sbi_domain_memregion *reg,
+			      unsigned long prot)
+{
+	struct hart_pmp_image_entry *ent = &img->entries[pmp_idx];
+	unsigned long pmp_bits = img->pmp_addr_bits - 1;
+	unsigned long pmp_addr_max = (1UL << pmp_bits) | ((1UL << pmp_bits) - 1);
+
+	/* Regions which can not be programmed are reported by configure() */
+	if (reg->order < img->pmp_log2gran ||
+	    (reg->base >> PMP_SHIFT) >= pmp_addr_max)
+		return SBI_EINVAL;
+
+	ent->reg = reg;
+	ent->prot = prot;
+	return sbi_pmp_encode(&ent->pmp, prot, reg->base, reg->order);
+}
+
+static int hart_pmp_image_build(struct hart_pmp_image *img,
+				struct sbi_domain *dom, bool smepmp)
+{
+	struct sbi_domain_memregion *reg;
+	unsigned int pmp_idx = 0;
+	int rc;
+
+	sbi_domain_for_each_memregion(dom, reg) {
+		/* Skip reserved entry and shared memory windows */
+		if (smepmp && pmp_idx < SBI_SMEPMP_REGION_ENTRY)
+			pmp_idx = SBI_SMEPMP_REGION_ENTRY;
+		if (pmp_idx >= img->pmp_count)
+			return SBI_EFAIL;
+
+		if (smepmp && SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags) &&
+		    SBI_DOMAIN_MEMREGION_IS_FIRMWARE(reg->flags) &&
+		    !sbi_hart_smepmp_is_fw_region(pmp_idx))
+			return SBI_EINVAL;
+
+		rc = hart_pmp_image_set(img, pmp_idx++, reg, smepmp ?
+					sbi_domain_get_smepmp_flags(reg) :
+					sbi_domain_get_oldpmp_flags(reg));
+		if (rc)
+			return rc;
+	}
+
+	return 0;
+}
+
+static void hart_pmp_images_init(struct sbi_scratch *scratch, bool smepmp)
+{
+	unsigned int pmp_count = sbi_hart_pmp_count(scratch);
+	struct hart_pmp_image *img;
+	struct sbi_domain *dom;
+
+	sbi_domain_for_each(dom) {
+		img = sbi_domain_data_ptr(dom, &pmp_image_data);
+		if (!img)
+			continue;
+
+		img->entries = sbi_calloc(pmp_count, sizeof(*img->entries));
+		if (!img->entries)
+			continue;
+
+		img->pmp_count = pmp_count;
+		img->pmp_log2gran = sbi_hart_pmp_log2gran(scratch);
+		img->pmp_addr_bits = sbi_hart_pmp_addrbits(scratch);
+		img->valid = !hart_pmp_image_build(img, dom, smepmp);
+	}
+
+	pmp_images_inited = true;
+}
+
+static struct hart_pmp_image *hart_pmp_image_get(struct sbi_scratch *scratch,
+						 struct sbi_domain *dom)
+{
+	struct hart_pmp_image *img;
+
+	if (!pmp_images_inited)
+		return NULL;
+
+	img = sbi_domain_data_ptr(dom, &pmp_image_data);
+	if (!img || !img->valid ||
+	    img->pmp_count != sbi_hart_pmp_count(scratch) ||
+	    img->pmp_log2gran != sbi_hart_pmp_log2gran(scratch) ||
+	    img->pmp_addr_bits != sbi_hart_pmp_addrbits(scratch))
+		return NULL;
+
+	return img;
+}
+
+/* Track the PMP image programmed by configure() on current HART */
+static void hart_pmp_image_track(struct sbi_scratch *scratch,
+				 struct sbi_domain *dom, bool smepmp)
+{
+	if (!pmp_images_inited)
+		hart_pmp_images_init(scratch, smepmp);
+
+	sbi_scratch_write_type(scratch, struct hart_pmp_image *,
+			       pmp_cur_image_offset,
+			       hart_pmp_image_get(scratch, dom));
+}
+
+static bool hart_pmp_image_entry_same(const struct hart_pmp_image_entry *a,
+				      const struct hart_pmp_image_entry *b)
+{
+	if (a->pmp.cfg != b->pmp.cfg)
+		return false;
+	if (!a->pmp.cfg)
+		return true;
+
+	return a->pmp.addr == b->pmp.addr && a->reg->flags == b->reg->flags;
+}
+
+static struct smepmp_shmem_windows *smepmp_windows_ptr(
+					struct sbi_scratch *scratch)
+{
+	if (!smepmp_windows_offset)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(scratch, smepmp_windows_offset);
+}
+
+static bool smepmp_window_covers(const struct smepmp_shmem_window *w,
+				 unsigned long addr, unsigned long size)
+{
+	unsigned long mask = BIT(w->order) - 1UL;
+
+	return w->dom && (addr & ~mask) == w->base &&
+	       ((addr + size - 1UL) & ~mask) == w->base;
+}
+
+/*
+ * Smepmp has no encoding for S/U-mode execute together with M-mode
+ * read/write access so S/U-mode can't execute from the shared memory
+ * while its window is mapped. This is accepted for the region which
+ * grants S/U-mode access to the whole window, usually RAM given to
+ * S-mode as RWX or the default region of the root domain, but a window
+ * must not hide a higher priority S/U-mode executable region within.
+ */
+static bool smepmp_window_allowed(struct sbi_domain *dom,
+				  unsigned long addr, unsigned long order)
+{
+	struct sbi_domain_memregion *reg;
+	unsigned long shift;
+
+	sbi_domain_for_each_memregion(dom, reg) {
+		/* Naturally aligned regions overlap only if one covers the other */
+		shift = (reg->order > order) ? reg->order : order;
+		if (shift < __riscv_xlen &&
+		    (reg->base >> shift) != (addr >> shift))
+			continue;
+
+		/* Regions after the one covering the window don't matter */
+		if (reg->order >= order)
+			return true;
+
+		if (reg->flags & SBI_DOMAIN_MEMREGION_SU_EXECUTABLE)
+			return false;
+	}
+
+	return true;
+}
+
+static void smepmp_window_unmap(struct sbi_scratch *scratch,
+				struct smepmp_shmem_window *w, unsigned int i)
+{
+	sbi_platform_pmp_disable(sbi_platform_ptr(scratch),
+				 SBI_SMEPMP_WINDOW_ENTRY(i));
+	sbi_hart_pmp_disable(SBI_SMEPMP_WINDOW_ENTRY(i));
+	w->mapped = false;
+}
+
+static void smepmp_window_map(struct sbi_scratch *scratch,
+			      struct smepmp_shmem_window *w, unsigned int i)
+{
+	/* shared R/W access for M and S/U mode */
+	unsigned int pmp_flags = (PMP_W | PMP_X);
+
+	sbi_platform_pmp_set(sbi_platform_ptr(scratch),
+			     SBI_SMEPMP_WINDOW_ENTRY(i),
+			     SBI_DOMAIN_MEMREGION_SHARED_SURW_MRW,
+			     pmp_flags, w->base, w->order);
+	sbi_hart_pmp_set(SBI_SMEPMP_WINDOW_ENTRY(i), pmp_flags,
+			 w->base, w->order);
+	w->mapped = true;
+}
+
+/*
+ * Unmap all shared memory windows of current HART. The windows are kept
+ * registered so that these are mapped again when accessed after the HART
+ * comes back to the domain which registered them.
+ */
+static bool smepmp_windows_unmap_all(struct sbi_scratch *scratch, bool force)
+{
+	struct smepmp_shmem_windows *sw = smepmp_windows_ptr(scratch);
+	bool changed = false;
+	unsigned int i;
+
+	if (!sw)
+		return false;
+
+	for (i = 0; i < SBI_SMEPMP_SHMEM_WINDOWS; i++) {
+		if (!force && !sw->win[i].mapped)
+			continue;
+		smepmp_window_unmap(scratch, &sw->win[i], i);
+		changed = true;
+	}
+
+	return changed;
+}
+
+/* Find a window of current domain covering the range and make sure it is mapped */
+static bool smepmp_windows_lookup(struct sbi_scratch *scratch,
+				  unsigned long addr, unsigned long size)
+{
+	struct smepmp_shmem_windows *sw = smepmp_windows_ptr(scratch);
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	struct smepmp_shmem_window *w;
+	unsigned int i;
+
+	if (!sw || !size)
+		return false;
+
+	for (i = 0; i < SBI_SMEPMP_SHMEM_WINDOWS; i++) {
+		w = &sw->win[i];
+		if (w->dom != dom || !smepmp_window_covers(w, addr, size))
+			continue;
+		if (!w->mapped)
+			smepmp_window_map(scratch, w, i);
+		return true;
+	}
+
+	return false;
+}
+
+static int sbi_hart_smepmp_map_shmem(struct sbi_scratch *scratch,
+				     unsigned long addr, unsigned long size)
+{
+	struct smepmp_shmem_windows *sw = smepmp_windows_ptr(scratch);
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	struct smepmp_shmem_window *w = NULL;
+	unsigned long order;
+	unsigned int i;
+
+	if (!sw)
+		return SBI_ENOTSUPP;
+
+	/*
+	 * Only naturally aligned power-of-2 sized shared memory gets a
+	 * window so that S/U-mode access permissions outside the shared
+	 * memory are never changed by the window.
+	 */
+	order = log2roundup(size);
+	if (!size || order >= __riscv_xlen || BIT(order) != size ||
+	    (addr & (size - 1UL)) || order < sbi_hart_pmp_log2gran(scratch))
+		return SBI_EINVAL;
+	if (!sbi_domain_check_addr_range(dom, addr, size, PRV_S,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+	if (!smepmp_window_allowed(dom, addr, order))
+		return SBI_ENOTSUPP;
+
+	for (i = 0; i < SBI_SMEPMP_SHMEM_WINDOWS; i++) {
+		if (sw->win[i].dom == dom && sw->win[i].base == addr &&
+		    sw->win[i].order == order)
+			return SBI_OK;
+		if (!w && !sw->win[i].dom)
+			w = &sw->win[i];
+	}
+
+	if (!w) {
+		w = &sw->win[sw->victim];
+		if (w->mapped)
+			smepmp_window_unmap(scratch, w, sw->victim);
+		if (++sw->victim >= SBI_SMEPMP_SHMEM_WINDOWS)
+			sw->victim = 0;
+	}
+
+	w->dom = dom;
+	w->base = addr;
+	w->order = order;
+	smepmp_window_map(scratch, w, w - sw->win);
+
+	return SBI_OK;
+}
+
+static void sbi_hart_smepmp_unmap_shmem(struct sbi_scratch *scratch,
+					unsigned long addr, unsigned long size)
+{
+	struct smepmp_shmem_windows *sw = smepmp_windows_ptr(scratch);
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	struct smepmp_shmem_window *w;
+	unsigned int i;
+
+	if (!sw)
+		return;
+
+	for (i = 0; i < SBI_SMEPMP_SHMEM_WINDOWS; i++) {
+		w = &sw->win[i];
+		if (w->dom != dom || w->base != addr || BIT(w->order) != size)
+			continue;
+		if (w->mapped)
+			smepmp_window_unmap(scratch, w, i);
+		w->dom = NULL;
+	}
+}
+
 static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch)
 {
 	struct sbi_domain_memregion *reg;
@@ -248,15 +638,16 @@ static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch)
 	 */
 	csr_set(CSR_MSECCFG, MSECCFG_RLB);
 
-	/* Disable the reserved entry */
+	/* Disable the reserved entry and shared memory windows */
 	sbi_hart_pmp_disable(SBI_SMEPMP_RESV_ENTRY);
+	smepmp_windows_unmap_all(scratch, true);
 
 	/* Program M-only regions when MML is not set. */
 	pmp_idx = 0;
 	sbi_domain_for_each_memregion(dom, reg) {
-		/* Skip reserved entry */
-		if (pmp_idx == SBI_SMEPMP_RESV_ENTRY)
-			pmp_idx++;
+		/* Skip reserved entry and shared memory windows */
+		if (pmp_idx < SBI_SMEPMP_REGION_ENTRY)
+			pmp_idx = SBI_SMEPMP_REGION_ENTRY;
 		if (!is_valid_pmp_idx(pmp_count, pmp_idx))
 			return SBI_EFAIL;
 
@@ -297,9 +688,9 @@ static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch)
 	/* Program shared and SU-only regions */
 	pmp_idx = 0;
 	sbi_domain_for_each_memregion(dom, reg) {
-		/* Skip reserved entry */
-		if (pmp_idx == SBI_SMEPMP_RESV_ENTRY)
-			pmp_idx++;
+		/* Skip reserved entry and shared memory windows */
+		if (pmp_idx < SBI_SMEPMP_REGION_ENTRY)
+			pmp_idx = SBI_SMEPMP_REGION_ENTRY;
 		if (!is_valid_pmp_idx(pmp_count, pmp_idx))
 			return SBI_EFAIL;
 
@@ -323,6 +714,8 @@ static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch)
 	 * Keep the RLB bit so that dynamic mappings can be done.
 	 */
 
+	hart_pmp_image_track(scratch, dom, true);
+
 	sbi_hart_pmp_fence();
 	return 0;
 }
@@ -334,6 +727,9 @@ static int sbi_hart_smepmp_map_range(struct sbi_scratch *scratch,
 	unsigned int pmp_flags = (PMP_W | PMP_X);
 	unsigned long order, base = 0;
 
+	if (smepmp_windows_lookup(scratch, addr, size))
+		return SBI_OK;
+
 	if (sbi_hart_is_pmp_enabled(SBI_SMEPMP_RESV_ENTRY))
 		return SBI_ENOSPC;
 
@@ -362,6 +758,10 @@ static int sbi_hart_smepmp_map_range(struct sbi_scratch *scratch,
 static int sbi_hart_smepmp_unmap_range(struct sbi_scratch *scratch,
 				       unsigned long addr, unsigned long size)
 {
+	/* Nothing to do if the range was accessed through a window */
+	if (!sbi_hart_is_pmp_enabled(SBI_SMEPMP_RESV_ENTRY))
+		return SBI_OK;
+
 	sbi_platform_pmp_disable(sbi_platform_ptr(scratch), SBI_SMEPMP_RESV_ENTRY);
 	return sbi_hart_pmp_disable(SBI_SMEPMP_RESV_ENTRY);
 }
@@ -403,6 +803,8 @@ static int sbi_hart_oldpmp_configure(struct sbi_scratch *scratch)
 	for(; pmp_idx < pmp_count; pmp_idx++)
 		sbi_hart_pmp_disable(pmp_idx);
 
+	hart_pmp_image_track(scratch, dom, false);
+
 	sbi_hart_pmp_fence();
 	return 0;
 }
@@ -411,6 +813,10 @@ static void sbi_hart_pmp_unconfigure(struct sbi_scratch *scratch)
 {
 	int i, pmp_count = sbi_hart_pmp_count(scratch);
 
+	sbi_scratch_write_type(scratch, struct hart_pmp_image *,
+			       pmp_cur_image_offset, NULL);
+	smepmp_windows_unmap_all(scratch, false);
+
 	for (i = 0; i < pmp_count; i++) {
 		/* Don't revoke firmware access permissions */
 		if (sbi_hart_smepmp_is_fw_region(i))
@@ -421,11 +827,65 @@ static void sbi_hart_pmp_unconfigure(struct sbi_scratch *scratch)
 	}
 }
 
+static int sbi_hart_pmp_reconfigure(struct sbi_scratch *scratch, bool fence)
+{
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+	bool smepmp = sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP);
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	struct hart_pmp_image_entry *cur_ent, *next_ent;
+	struct hart_pmp_image *cur, *next;
+	bool changed = false;
+	unsigned int i;
+
+	cur = sbi_scratch_read_type(scratch, struct hart_pmp_image *,
+				    pmp_cur_image_offset);
+	next = hart_pmp_image_get(scratch, dom);
+	if (!cur || !next) {
+		sbi_hart_pmp_unconfigure(scratch);
+		return smepmp ? sbi_hart_smepmp_configure(scratch) :
+				sbi_hart_oldpmp_configure(scratch);
+	}
+
+	/*
+	 * Entries can be re-programmed in any order because the MML
+	 * and RLB bits are already set for Smepmp. The firmware entries
+	 * are same across domains so these are never touched.
+	 */
+	/* Shared memory windows belong to the previous domain */
+	changed = smepmp_windows_unmap_all(scratch, false);
+
+	for (i = 0; i < next->pmp_count; i++) {
+		cur_ent = &cur->entries[i];
+		next_ent = &next->entries[i];
+		if (hart_pmp_image_entry_same(cur_ent, next_ent))
+			continue;
+
+		if (next_ent->pmp.cfg) {
+			sbi_platform_pmp_set(plat, i, next_ent->reg->flags,
+					     next_ent->prot, next_ent->reg->base,
+					     next_ent->reg->order);
+			hart_pmp_write(&next_ent->pmp, i);
+		} else {
+			sbi_platform_pmp_disable(plat, i);
+			sbi_hart_pmp_disable(i);
+		}
+		changed = true;
+	}
+
+	sbi_scratch_write_type(scratch, struct hart_pmp_image *,
+			       pmp_cur_image_offset, next);
+
+	if (changed || fence)
+		sbi_hart_pmp_fence();
+	return 0;
+}
+
 static struct sbi_hart_protection pmp_protection = {
 	.name = "pmp",
 	.rating = 100,
 	.configure = sbi_hart_oldpmp_configure,
 	.unconfigure = sbi_hart_pmp_unconfigure,
+	.reconfigure = sbi_hart_pmp_reconfigure,
 };
 
 static struct sbi_hart_protection epmp_protection = {
@@ -433,8 +893,11 @@ static struct sbi_hart_protection epmp_protection = {
 	.rating = 200,
 	.configure = sbi_hart_smepmp_configure,
 	.unconfigure = sbi_hart_pmp_unconfigure,
+	.reconfigure = sbi_hart_pmp_reconfigure,
 	.map_range = sbi_hart_smepmp_map_range,
 	.unmap_range = sbi_hart_smepmp_unmap_range,
+	.map_shmem = sbi_hart_smepmp_map_shmem,
+	.unmap_shmem = sbi_hart_smepmp_unmap_shmem,
 };
 
 int sbi_hart_pmp_init(struct sbi_scratch *scratch)
@@ -442,7 +905,23 @@ int sbi_hart_pmp_init(struct sbi_scratch *scratch)
 	int rc;
 
 	if (sbi_hart_pmp_count(scratch)) {
+		pmp_cur_image_offset =
+			sbi_scratch_alloc_type_offset(struct hart_pmp_image *);
+		if (!pmp_cur_image_offset)
+			return SBI_ENOMEM;
+
+		rc = sbi_domain_register_data(&pmp_image_data);
+		if (rc)
+			return rc;
+
 		if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP)) {
+			if (SBI_SMEPMP_SHMEM_WINDOWS) {
+				smepmp_windows_offset = sbi_scratch_alloc_type_offset(
+						struct smepmp_shmem_windows);
+				if (!smepmp_windows_offset)
+					return SBI_ENOMEM;
+			}
+
 			rc = sbi_hart_protection_register(&epmp_protection);
 			if (rc)
 				return rc;
@@ -5,6 +5,7 @@
  */
 
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_hart_pmp.h>
 #include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_scratch.h>
 
@@ -71,6 +72,30 @@ void sbi_hart_protection_unconfigure(struct sbi_scratch *scratch)
 	hprot->unconfigure(scratch);
 }
 
+int sbi_hart_protection_reconfigure(struct sbi_scratch *scratch, bool fence)
+{
+	struct sbi_hart_protection *hprot = sbi_hart_protection_best();
+	int rc;
+
+	if (hprot && hprot->reconfigure)
+		return hprot->reconfigure(scratch, fence);
+
+	if (hprot) {
+		if (hprot->unconfigure)
+			hprot->unconfigure(scratch);
+		if (!hprot->configure)
+			return SBI_ENOSYS;
+
+		rc = hprot->configure(scratch);
+		if (rc)
+			return rc;
+	}
+
+	if (fence)
+		sbi_hart_pmp_fence();
+	return 0;
+}
+
 int sbi_hart_protection_map_range(unsigned long base, unsigned long size)
 {
 	struct sbi_hart_protection *hprot = sbi_hart_protection_best();
@@ -90,3 +115,23 @@ int sbi_hart_protection_unmap_range(unsigned long base, unsigned long size)
 
 	return hprot->unmap_range(sbi_scratch_thishart_ptr(), base, size);
 }
+
+int sbi_hart_protection_map_shmem(unsigned long base, unsigned long size)
+{
+	struct sbi_hart_protection *hprot = sbi_hart_protection_best();
+
+	if (!hprot || !hprot->map_shmem)
+		return 0;
+
+	return hprot->map_shmem(sbi_scratch_thishart_ptr(), base, size);
+}
+
+void sbi_hart_protection_unmap_shmem(unsigned long base, unsigned long size)
+{
+	struct sbi_hart_protection *hprot = sbi_hart_protection_best();
+
+	if (!hprot || !hprot->unmap_shmem)
+		return;
+
+	hprot->unmap_shmem(sbi_scratch_thishart_ptr(), base, size);
+}
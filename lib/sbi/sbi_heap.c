@@ -7,10 +7,10 @@
  *   Anup Patel<apatel@ventanamicro.com>
  */
 
-#include <sbi/riscv_locks.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_list.h>
+#include <sbi/sbi_qspinlock.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
 
@@ -27,7 +27,7 @@ struct heap_node {
 };
 
 struct sbi_heap_control {
-	spinlock_t lock;
+	qspinlock_t lock;
 	unsigned long base;
 	unsigned long size;
 	unsigned long resv;
@@ -80,10 +80,14 @@ static void *alloc_with_align(struct sbi_heap_control *hpctrl,
 	if (!size)
 		return NULL;
 
+	/* Heap is not initialized yet */
+	if (!hpctrl->size)
+		return NULL;
+
 	size += align - 1;
 	size &= ~((unsigned long)align - 1);
 
-	spin_lock(&hpctrl->lock);
+	qspin_lock(&hpctrl->lock);
 
 	/* Ensure at least two free nodes are available for use below */
 	if (!alloc_nodes(hpctrl))
@@ -132,7 +136,7 @@ static void *alloc_with_align(struct sbi_heap_control *hpctrl,
 	ret = (void *)np->addr;
 
 out:
-	spin_unlock(&hpctrl->lock);
+	qspin_unlock(&hpctrl->lock);
 
 	return ret;
 }
@@ -175,7 +179,7 @@ void sbi_free_from(struct sbi_heap_control *hpctrl, void *ptr)
 	if (!ptr)
 		return;
 
-	spin_lock(&hpctrl->lock);
+	qspin_lock(&hpctrl->lock);
 
 	np = NULL;
 	sbi_list_for_each_entry(n, &hpctrl->used_space_list, head) {
@@ -186,34 +190,38 @@ void sbi_free_from(struct sbi_heap_control *hpctrl, void *ptr)
 		}
 	}
 	if (!np) {
-		spin_unlock(&hpctrl->lock);
+		qspin_unlock(&hpctrl->lock);
 		return;
 	}
 
 	sbi_list_del(&np->head);
 
+	/* Keep the free space list sorted by address */
 	sbi_list_for_each_entry(n, &hpctrl->free_space_list, head) {
-		if ((np->addr + np->size) == n->addr) {
-			n->addr = np->addr;
-			n->size += np->size;
-			sbi_list_add_tail(&np->head, &hpctrl->free_node_list);
-			np = NULL;
+		if (np->addr < n->addr)
 			break;
-		} else if (np->addr == (n->addr + n->size)) {
+	}
+	sbi_list_add_tail(&np->head, &n->head);
+
+	/* Merge with the following free space */
+	if (&n->head != &hpctrl->free_space_list &&
+	    (np->addr + np->size) == n->addr) {
+		np->size += n->size;
+		sbi_list_del(&n->head);
+		sbi_list_add_tail(&n->head, &hpctrl->free_node_list);
+	}
+
+	/* Merge with the preceding free space */
+	if (np->head.prev != &hpctrl->free_space_list) {
+		n = sbi_list_entry(np->head.prev, struct heap_node, head);
+		if ((n->addr + n->size) == np->addr) {
 			n->size += np->size;
+			sbi_list_del(&np->head);
 			sbi_list_add_tail(&np->head, &hpctrl->free_node_list);
-			np = NULL;
-			break;
-		} else if ((n->addr + n->size) < np->addr) {
-			sbi_list_add(&np->head, &n->head);
-			np = NULL;
-			break;
 		}
 	}
-	if (np)
-		sbi_list_add_tail(&np->head, &hpctrl->free_space_list);
 
-	spin_unlock(&hpctrl->lock);
+	qspin_unlock(&hpctrl->lock);
 }
 
 unsigned long sbi_heap_free_space_from(struct sbi_heap_control *hpctrl)
@@ -221,17 +229,21 @@ unsigned long sbi_heap_free_space_from(struct sbi_heap_control *hpctrl)
 	struct heap_node *n;
 	unsigned long ret = 0;
 
-	spin_lock(&hpctrl->lock);
+	/* Heap is not initialized yet */
+	if (!hpctrl->size)
+		return 0;
+
+	qspin_lock(&hpctrl->lock);
 	sbi_list_for_each_entry(n, &hpctrl->free_space_list, head)
 		ret += n->size;
-	spin_unlock(&hpctrl->lock);
+	qspin_unlock(&hpctrl->lock);
 
 	return ret;
 }
 
 unsigned long sbi_heap_used_space_from(struct sbi_heap_control *hpctrl)
 {
-	return hpctrl->size - hpctrl->resv - sbi_heap_free_space();
+	return hpctrl->size - hpctrl->resv - sbi_heap_free_space_from(hpctrl);
 }
 
 unsigned long sbi_heap_reserved_space_from(struct sbi_heap_control *hpctrl)
@@ -245,7 +257,7 @@ int sbi_heap_init_new(struct sbi_heap_control *hpctrl, unsigned long base,
 	struct heap_node *n;
 
 	/* Initialize heap control */
-	SPIN_LOCK_INIT(hpctrl->lock);
+	QSPIN_LOCK_INIT(hpctrl->lock);
 	hpctrl->base = base;
 	hpctrl->size = size;
 	hpctrl->resv = 0;
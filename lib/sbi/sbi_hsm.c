@@ -12,18 +12,22 @@
 #include <sbi/riscv_encoding.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/sbi_bitops.h>
+#include <sbi/sbi_byteorder.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_init.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_console.h>
 
 #define __sbi_hsm_hart_change_state(hdata, oldstate, newstate)		\
@@ -32,6 +36,9 @@
 	if (state != (oldstate))					\
 		sbi_printf("%s: ERR: The hart is in invalid state [%lu]\n", \
 			   __func__, state);				\
+	else								\
+		sbi_trace(SBI_TRACE_HSM_STATE, hsm_data_hartid(hdata),	\
+			  oldstate, newstate, 0);			\
 	state == (oldstate);						\
 })
 
@@ -40,6 +47,18 @@ static unsigned long hart_data_offset;
 static bool hsm_device_has_hart_hotplug(void);
 static int hsm_device_hart_stop(void);
 
+/** Per hart idle statistics */
+struct hsm_suspend_stats {
+	/* Time of suspend entry (zero when not tracking a suspend) */
+	u64 suspend_time;
+	/* Time of the first wake-up event (zero if not seen yet) */
+	u64 wake_time;
+	/* Suspend type entered by the hart */
+	u32 suspend_type;
+	u32 count;
+	struct sbi_hsm_suspend_stat stat[SBI_HSM_SUSPEND_STATS_MAX];
+};
+
 /** Per hart specific data to manage state transition **/
 struct sbi_hsm_data {
 	atomic_t state;
@@ -50,8 +69,19 @@ struct sbi_hsm_data {
 	unsigned long saved_mideleg;
 	u64 saved_menvcfg;
 	atomic_t start_ticket;
+#ifdef CONFIG_SBI_HSM_SUSPEND_STATS
+	struct hsm_suspend_stats *stats;
+#endif
 };
 
+static inline u32 hsm_data_hartid(struct sbi_hsm_data *hdata)
+{
+	struct sbi_scratch *scratch =
+		(struct sbi_scratch *)((unsigned long)hdata - hart_data_offset);
+
+	return sbi_hartindex_to_hartid(scratch->hartindex);
+}
+
 bool sbi_hsm_hart_change_state(struct sbi_scratch *scratch, long oldstate,
 			       long newstate)
 {
@@ -136,6 +166,184 @@ int sbi_hsm_hart_interruptible_mask(const struct sbi_domain *dom,
 	return 0;
 }
 
+#ifdef CONFIG_SBI_HSM_SUSPEND_STATS
+
+static struct sbi_hsm_suspend_stat *hsm_suspend_stat(
+					struct hsm_suspend_stats *stats,
+					u32 suspend_type)
+{
+	u32 i;
+
+	for (i = 0; i < stats->count; i++) {
+		if (stats->stat[i].suspend_type == suspend_type)
+			return &stats->stat[i];
+	}
+
+	if (stats->count == SBI_HSM_SUSPEND_STATS_MAX)
+		return NULL;
+
+	stats->stat[stats->count].suspend_type = suspend_type;
+	return &stats->stat[stats->count++];
+}
+
+static u32 hsm_suspend_demote(struct sbi_hsm_data *hdata, u32 suspend_type)
+{
+	struct sbi_hsm_suspend_stat *stat;
+	u32 type;
+
+	if (!(suspend_type & SBI_HSM_SUSP_NON_RET_BIT) ||
+	    !hsm_dev || !hsm_dev->hart_suspend_demote)
+		return suspend_type;
+
+	type = hsm_dev->hart_suspend_demote(suspend_type, hdata->stats->stat,
+					    hdata->stats->count);
+	if (type == suspend_type)
+		return suspend_type;
+
+	/* Only demotion to a valid retentive suspend type is allowed */
+	if ((type & SBI_HSM_SUSP_NON_RET_BIT) ||
+	    (SBI_HSM_SUSPEND_RET_DEFAULT < type &&
+	     type < SBI_HSM_SUSPEND_RET_PLATFORM))
+		return suspend_type;
+
+	stat = hsm_suspend_stat(hdata->stats, suspend_type);
+	if (stat)
+		stat->demoted++;
+
+	return type;
+}
+
+static void hsm_suspend_stats_enter(struct sbi_hsm_data *hdata,
+				    u32 suspend_type)
+{
+	hdata->stats->suspend_type = suspend_type;
+	hdata->stats->wake_time = 0;
+	hdata->stats->suspend_time = sbi_timer_value();
+}
+
+static void hsm_suspend_stats_wakeup(struct sbi_hsm_data *hdata)
+{
+	if (hdata->stats->suspend_time && !hdata->stats->wake_time)
+		hdata->stats->wake_time = sbi_timer_value();
+}
+
+static void hsm_suspend_stats_exit(struct sbi_hsm_data *hdata)
+{
+	struct hsm_suspend_stats *stats = hdata->stats;
+	struct sbi_hsm_suspend_stat *stat;
+	u64 now = sbi_timer_value(), wake, latency;
+
+	if (!stats->suspend_time)
+		return;
+
+	wake = stats->wake_time ? stats->wake_time : now;
+	if (wake < stats->suspend_time)
+		wake = stats->suspend_time;
+	if (wake > now)
+		wake = now;
+	latency = now - wake;
+
+	stat = hsm_suspend_stat(stats, stats->suspend_type);
+	if (stat) {
+		stat->count++;
+		stat->residency += wake - stats->suspend_time;
+		stat->wake_latency += latency;
+		if (stat->wake_latency_max < latency)
+			stat->wake_latency_max = latency;
+	}
+
+	stats->suspend_time = 0;
+}
+
+static void hsm_suspend_stats_cancel(struct sbi_hsm_data *hdata)
+{
+	hdata->stats->suspend_time = 0;
+}
+
+/**
+ * Record a wake-up event (such as an IPI) sent to a hart
+ *
+ * Only the first wake-up event of a suspended hart is recorded and
+ * used as the end of its idle residency.
+ *
+ * @param scratch pointer to sbi_scratch of the target hart
+ */
+void sbi_hsm_hart_wakeup_event(struct sbi_scratch *scratch)
+{
+	struct sbi_hsm_data *hdata = sbi_scratch_offset_ptr(scratch,
+							    hart_data_offset);
+
+	if (atomic_read(&hdata->state) == SBI_HSM_STATE_SUSPENDED &&
+	    hdata->stats)
+		hsm_suspend_stats_wakeup(hdata);
+}
+
+int sbi_hsm_read_suspend_stats(u32 hartid, unsigned long addr, u32 count,
+			       u32 *out_count)
+{
+	const struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	u32 i, hartindex = sbi_hartid_to_hartindex(hartid);
+	struct sbi_hsm_suspend_stat *out, *stat;
+	struct hsm_suspend_stats *stats;
+	struct sbi_scratch *rscratch;
+	struct sbi_hsm_data *hdata;
+
+	if (!sbi_domain_is_assigned_hart(dom, hartindex))
+		return SBI_EINVAL;
+
+	rscratch = sbi_hartindex_to_scratch(hartindex);
+	if (!rscratch)
+		return SBI_EINVAL;
+	hdata = sbi_scratch_offset_ptr(rscratch, hart_data_offset);
+	stats = hdata->stats;
+
+	if (count > stats->count)
+		count = stats->count;
+	if (!count) {
+		*out_count = 0;
+		return 0;
+	}
+
+	if (!sbi_domain_check_addr_range(dom, addr, count * sizeof(*out),
+					 PRV_S, SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	sbi_hart_protection_map_range(addr, count * sizeof(*out));
+
+	/* Statistics of other harts may change while being copied */
+	out = (struct sbi_hsm_suspend_stat *)addr;
+	for (i = 0; i < count; i++) {
+		stat = &stats->stat[i];
+		out[i].suspend_type = cpu_to_le32(stat->suspend_type);
+		out[i].demoted = cpu_to_le32(stat->demoted);
+		out[i].count = cpu_to_le64(stat->count);
+		out[i].residency = cpu_to_le64(stat->residency);
+		out[i].wake_latency = cpu_to_le64(stat->wake_latency);
+		out[i].wake_latency_max = cpu_to_le64(stat->wake_latency_max);
+	}
+
+	sbi_hart_protection_unmap_range(addr, count * sizeof(*out));
+
+	*out_count = count;
+	return 0;
+}
+
+#else
+
+static inline u32 hsm_suspend_demote(struct sbi_hsm_data *hdata,
+				     u32 suspend_type)
+{
+	return suspend_type;
+}
+
+static inline void hsm_suspend_stats_enter(struct sbi_hsm_data *hdata,
+					   u32 suspend_type) { }
+static inline void hsm_suspend_stats_wakeup(struct sbi_hsm_data *hdata) { }
+static inline void hsm_suspend_stats_exit(struct sbi_hsm_data *hdata) { }
+static inline void hsm_suspend_stats_cancel(struct sbi_hsm_data *hdata) { }
+
+#endif
+
 void __noreturn sbi_hsm_hart_start_finish(struct sbi_scratch *scratch,
 					  u32 hartid)
 {
@@ -227,15 +435,22 @@ static int hsm_device_hart_start(u32 hartid, ulong saddr)
 
 static int hsm_device_hart_stop(void)
 {
-	if (hsm_dev && hsm_dev->hart_stop)
+	if (hsm_dev && hsm_dev->hart_stop) {
+		/* HART may be powered down so its PMP setup is lost */
+		sbi_init_mark_protection_lost(sbi_scratch_thishart_ptr());
 		return hsm_dev->hart_stop();
+	}
 	return SBI_ENOTSUPP;
 }
 
 static int hsm_device_hart_suspend(u32 suspend_type, ulong mmode_resume_addr)
 {
-	if (hsm_dev && hsm_dev->hart_suspend)
+	if (hsm_dev && hsm_dev->hart_suspend) {
+		if (suspend_type & SBI_HSM_SUSP_NON_RET_BIT)
+			sbi_init_mark_protection_lost(
+						sbi_scratch_thishart_ptr());
 		return hsm_dev->hart_suspend(suspend_type, mmode_resume_addr);
+	}
 	return SBI_ENOTSUPP;
 }
 
@@ -268,6 +483,11 @@ int sbi_hsm_init(struct sbi_scratch *scratch, bool cold_boot)
 				    SBI_HSM_STATE_START_PENDING :
 				    SBI_HSM_STATE_STOPPED);
 			ATOMIC_INIT(&hdata->start_ticket, 0);
+#ifdef CONFIG_SBI_HSM_SUSPEND_STATS
+			hdata->stats = sbi_zalloc(sizeof(*hdata->stats));
+			if (!hdata->stats)
+				return SBI_ENOMEM;
+#endif
 		}
 	} else {
 		sbi_hsm_hart_wait(scratch);
@@ -455,6 +675,8 @@ void sbi_hsm_hart_resume_start(struct sbi_scratch *scratch)
 					 SBI_HSM_STATE_RESUME_PENDING))
 		sbi_hart_hang();
 
+	hsm_suspend_stats_wakeup(hdata);
+
 	if (sbi_system_is_suspended())
 		sbi_system_resume();
 	else
@@ -478,6 +700,8 @@ void __noreturn sbi_hsm_hart_resume_finish(struct sbi_scratch *scratch,
 	 */
 	__sbi_hsm_suspend_non_ret_restore(scratch);
 
+	hsm_suspend_stats_exit(hdata);
+
 	sbi_hart_switch_mode(hartid, scratch->next_arg1,
 			     scratch->next_addr,
 			     scratch->next_mode, false);
@@ -487,6 +711,7 @@ int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 			 ulong raddr, ulong rmode, ulong arg1)
 {
 	int ret;
+	u32 enter_type;
 	const struct sbi_domain *dom = sbi_domain_thishart_ptr();
 	struct sbi_hsm_data *hdata = sbi_scratch_offset_ptr(scratch,
 							    hart_data_offset);
@@ -521,10 +746,19 @@ int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 	scratch->next_addr = raddr;
 	scratch->next_mode = rmode;
 
+	/*
+	 * Let the platform demote a non-retentive suspend to a retentive
+	 * one. The caller still resumes as if from a non-retentive suspend.
+	 */
+	enter_type = hsm_suspend_demote(hdata, suspend_type);
+	hsm_suspend_stats_enter(hdata, enter_type);
+
 	/* Directly move from STARTED to SUSPENDED state */
 	if (!__sbi_hsm_hart_change_state(hdata, SBI_HSM_STATE_STARTED,
-					 SBI_HSM_STATE_SUSPENDED))
+					 SBI_HSM_STATE_SUSPENDED)) {
+		hsm_suspend_stats_cancel(hdata);
 		return SBI_EFAIL;
+	}
 
 	/* Save the suspend type */
 	hdata->suspend_type = suspend_type;
@@ -537,14 +771,16 @@ int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 		__sbi_hsm_suspend_non_ret_save(scratch);
 
 	/* Try platform specific suspend */
-	ret = hsm_device_hart_suspend(suspend_type, scratch->warmboot_addr);
+	ret = hsm_device_hart_suspend(enter_type, scratch->warmboot_addr);
 	if (ret == SBI_ENOTSUPP) {
 		/* Try generic implementation of default suspend types */
-		if (suspend_type == SBI_HSM_SUSPEND_RET_DEFAULT ||
-		    suspend_type == SBI_HSM_SUSPEND_NON_RET_DEFAULT) {
+		if (enter_type == SBI_HSM_SUSPEND_RET_DEFAULT ||
+		    enter_type == SBI_HSM_SUSPEND_NON_RET_DEFAULT) {
 			ret = __sbi_hsm_suspend_default(scratch);
 		}
 	}
+	if (ret == 0)
+		hsm_suspend_stats_wakeup(hdata);
 
 	/*
 	 * The platform may have coordinated a retentive suspend, or it may
@@ -563,6 +799,10 @@ int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 	 * We might have successfully resumed from retentive suspend
 	 * or suspend failed. In both cases, we restore state of hart.
 	 */
+	if (ret == 0)
+		hsm_suspend_stats_exit(hdata);
+	else
+		hsm_suspend_stats_cancel(hdata);
 	if (!__sbi_hsm_hart_change_state(hdata, SBI_HSM_STATE_SUSPENDED,
 					 SBI_HSM_STATE_STARTED))
 		sbi_hart_hang();
@@ -11,6 +11,7 @@
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_bitops.h>
+#include <sbi/sbi_domain_context.h>
 #include <sbi/sbi_emulate_csr.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_illegal_atomic.h>
@@ -167,9 +168,14 @@ int sbi_illegal_insn_handler(struct sbi_trap_context *tcntx)
 		insn = sbi_get_insn(regs->mepc, &uptrap);
 		if (uptrap.cause)
 			return sbi_trap_redirect(regs, &uptrap);
-		if ((insn & 3) != 3)
-			return truly_illegal_insn(insn, regs);
 	}
 
+	/* First FP or vector use after a domain context switch */
+	if (sbi_domain_context_lazy_restore(insn, regs))
+		return 0;
+
+	if (unlikely((insn & 3) != 3))
+		return truly_illegal_insn(insn, regs);
+
 	return illegal_insn_table[(insn & 0x7c) >> 2](insn, regs);
 }
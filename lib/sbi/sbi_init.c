@@ -10,6 +10,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/sbi_batch.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_cppc.h>
 #include <sbi/sbi_domain.h>
@@ -22,10 +23,13 @@
 #include <sbi/sbi_hart_protection.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_hsm.h>
+#include <sbi/sbi_init.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_prof.h>
+#include <sbi/sbi_qspinlock.h>
 #include <sbi/sbi_dbtr.h>
 #include <sbi/sbi_mpxy.h>
 #include <sbi/sbi_sse.h>
@@ -33,6 +37,7 @@
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_version.h>
 #include <sbi/sbi_unit_test.h>
 
@@ -203,25 +208,77 @@ static void sbi_boot_print_hart(struct sbi_scratch *scratch, u32 hartid)
 	sbi_hart_delegation_dump(scratch, "Boot HART ", "           ");
 }
 
-static unsigned long coldboot_done;
+/* Coldboot stages which warmboot stages can depend upon */
+enum coldboot_stage {
+	COLDBOOT_STAGE_NONE = 0,
+	COLDBOOT_STAGE_HSM,
+	COLDBOOT_STAGE_HART,
+	COLDBOOT_STAGE_TIMER,
+	COLDBOOT_STAGE_PLATFORM_EARLY,
+	COLDBOOT_STAGE_PMU,
+	COLDBOOT_STAGE_DBTR,
+	COLDBOOT_STAGE_IRQCHIP,
+};
+
+static unsigned long coldboot_stage;
+
+static void coldboot_stage_done(enum coldboot_stage stage)
+{
+	__smp_store_release(&coldboot_stage, stage);
+}
 
-static void wait_for_coldboot(struct sbi_scratch *scratch)
+static void wait_for_coldboot_stage(enum coldboot_stage stage)
 {
-	/* Wait for coldboot to finish */
-	while (!__smp_load_acquire(&coldboot_done))
+	while (__smp_load_acquire(&coldboot_stage) < stage)
 		cpu_relax();
 }
 
+static void wait_for_coldboot(struct sbi_scratch *scratch)
+{
+	/* Wait for coldboot to initialize HSM */
+	wait_for_coldboot_stage(COLDBOOT_STAGE_HSM);
+}
+
 static void wake_coldboot_harts(struct sbi_scratch *scratch)
 {
-	/* Mark coldboot done */
-	__smp_store_release(&coldboot_done, 1);
+	/* Mark coldboot HSM initialization done */
+	coldboot_stage_done(COLDBOOT_STAGE_HSM);
 }
 
 unsigned long __attribute__((weak)) __stack_chk_guard = 0x95B5FF5A;
 
 static unsigned long entry_count_offset;
 static unsigned long init_count_offset;
+static unsigned long protection_lost_offset;
+
+static bool init_protection_lost(struct sbi_scratch *scratch)
+{
+#ifdef CONFIG_SBI_INIT_HOT_RESTART
+	bool *lost = sbi_scratch_offset_ptr(scratch, protection_lost_offset);
+
+	return *lost;
+#else
+	return true;
+#endif
+}
+
+static void init_hart_protection(struct sbi_scratch *scratch)
+{
+	bool *lost = sbi_scratch_offset_ptr(scratch, protection_lost_offset);
+	int rc;
+
+	if (!init_protection_lost(scratch))
+		return;
+
+	rc = sbi_hart_protection_configure(scratch);
+	if (rc) {
+		sbi_printf("%s: hart isolation configure failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+	*lost = false;
+	sbi_prof_trace("hart_protection");
+}
 
 static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 {
@@ -229,18 +286,40 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	unsigned long *count;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
+	sbi_prof_start();
+
 	/* Note: This has to be first thing in coldboot init sequence */
 	rc = sbi_scratch_init(scratch);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("scratch");
 
 	/* Note: This has to be second thing in coldboot init sequence */
 	rc = sbi_heap_init(scratch);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("heap");
 
 	/* Note: This has to be the third thing in coldboot init sequence */
 	rc = sbi_domain_init(scratch, hartid);
+	if (rc)
+		sbi_hart_hang();
+	sbi_prof_trace("domain");
+
+	/*
+	 * Note: Queued spinlocks use per-HART nodes in scratch space
+	 * from here on so this must be done before waking up HARTs
+	 */
+	rc = sbi_qspinlock_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	/* Trace points may be hit by any HART once they are woken up */
+	rc = sbi_trace_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_batch_init(scratch);
 	if (rc)
 		sbi_hart_hang();
 
@@ -252,12 +331,25 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	if (!init_count_offset)
 		sbi_hart_hang();
 
+	protection_lost_offset = sbi_scratch_alloc_offset(sizeof(bool));
+	if (!protection_lost_offset)
+		sbi_hart_hang();
+
+	/* No HART has configured its hart protection yet */
+	sbi_for_each_hartindex(i) {
+		struct sbi_scratch *rscratch = sbi_hartindex_to_scratch(i);
+
+		if (rscratch)
+			sbi_init_mark_protection_lost(rscratch);
+	}
+
 	count = sbi_scratch_offset_ptr(scratch, entry_count_offset);
 	(*count)++;
 
 	rc = sbi_hsm_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("hsm");
 
 	/*
 	 * All non-coldboot HARTs do HSM initialization (i.e. enter HSM state
@@ -270,6 +362,7 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	rc = sbi_hart_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("hart");
 
 	/*
 	 * Initialize stack guard via Zkr entropy source if Zkr is
@@ -309,13 +402,23 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			__stack_chk_guard = guard_val;
 	}
 
+	/*
+	 * Note: Secondary HARTs start calling functions only after this
+	 * so the stack guard must be updated before marking HART stage.
+	 */
+	coldboot_stage_done(COLDBOOT_STAGE_HART);
+
 	rc = sbi_timer_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("timer");
+	coldboot_stage_done(COLDBOOT_STAGE_TIMER);
 
 	rc = sbi_platform_early_init(plat, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("platform_early");
+	coldboot_stage_done(COLDBOOT_STAGE_PLATFORM_EARLY);
 
 	rc = sbi_pmu_init(scratch, true);
 	if (rc) {
@@ -323,12 +426,17 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("pmu");
+	coldboot_stage_done(COLDBOOT_STAGE_PMU);
 
 	rc = sbi_dbtr_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("dbtr");
+	coldboot_stage_done(COLDBOOT_STAGE_DBTR);
 
 	sbi_boot_print_banner(scratch);
+	sbi_prof_trace("banner");
 
 	sbi_double_trap_init(scratch);
 
@@ -338,30 +446,36 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("irqchip");
+	coldboot_stage_done(COLDBOOT_STAGE_IRQCHIP);
 
 	rc = sbi_ipi_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: ipi init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("ipi");
 
 	rc = sbi_tlb_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: tlb init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("tlb");
 
 	rc = sbi_fwft_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: fwft init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("fwft");
 
 	rc = sbi_mpxy_init(scratch);
 	if (rc) {
 		sbi_printf("%s: mpxy init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("mpxy");
 
 	/*
 	 * Note: Finalize domains after HSM initialization
@@ -374,6 +488,7 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("domain_finalize");
 
 	/*
 	 * Note: Platform final initialization should be after finalizing
@@ -386,6 +501,7 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("platform_final");
 
 	/*
 	 * Note: SSE events callbacks can be registered by other drivers so
@@ -396,6 +512,7 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_printf("%s: sse init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("sse");
 
 	/*
 	 * Note: Ecall initialization should be after platform final
@@ -407,6 +524,7 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_printf("%s: ecall init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("ecall");
 
 	sbi_boot_print_general(scratch);
 
@@ -416,6 +534,9 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 
 	run_all_tests();
 
+	sbi_lock_bench(scratch, true);
+	sbi_prof_trace("boot_print");
+
 	/*
 	 * Note: Startup domains after all initialization are done
 	 * otherwise boot HART of non-root domain can crash.
@@ -426,93 +547,120 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_prof_trace("domain_startup");
 
 	/*
 	 * Configure hart isolation at last because if SMEPMP is,
 	 * detected, M-mode access to the S/U space will be rescinded.
 	 */
-	rc = sbi_hart_protection_configure(scratch);
-	if (rc) {
-		sbi_printf("%s: hart isolation configure failed (error %d)\n",
-			   __func__, rc);
-		sbi_hart_hang();
-	}
+	init_hart_protection(scratch);
 
 	count = sbi_scratch_offset_ptr(scratch, init_count_offset);
 	(*count)++;
 
+	sbi_prof_print(current_hartindex());
+
 	sbi_hsm_hart_start_finish(scratch, hartid);
 }
 
+static int init_warm_platform_early(struct sbi_scratch *scratch,
+				    bool cold_boot)
+{
+	return sbi_platform_early_init(sbi_platform_ptr(scratch), cold_boot);
+}
+
+static int init_warm_platform_final(struct sbi_scratch *scratch,
+				    bool cold_boot)
+{
+	return sbi_platform_final_init(sbi_platform_ptr(scratch), cold_boot);
+}
+
+struct warm_stage {
+	const char *name;
+	int (*init)(struct sbi_scratch *scratch, bool cold_boot);
+	enum coldboot_stage depends;
+};
+
+/* Warmboot stages which don't depend on the HART being started */
+static const struct warm_stage warm_prestart_stages[] = {
+	{ "hart", sbi_hart_init, COLDBOOT_STAGE_HART },
+	{ "timer", sbi_timer_init, COLDBOOT_STAGE_TIMER },
+	{ "platform_early", init_warm_platform_early,
+	  COLDBOOT_STAGE_PLATFORM_EARLY },
+	{ "pmu", sbi_pmu_init, COLDBOOT_STAGE_PMU },
+	{ "dbtr", sbi_dbtr_init, COLDBOOT_STAGE_DBTR },
+	{ "irqchip", sbi_irqchip_init, COLDBOOT_STAGE_IRQCHIP },
+};
+
+/* Warmboot stages which need the HART to be started */
+static const struct warm_stage warm_start_stages[] = {
+	{ "ipi", sbi_ipi_init, COLDBOOT_STAGE_NONE },
+	{ "tlb", sbi_tlb_init, COLDBOOT_STAGE_NONE },
+	{ "fwft", sbi_fwft_init, COLDBOOT_STAGE_NONE },
+	{ "platform_final", init_warm_platform_final, COLDBOOT_STAGE_NONE },
+	{ "sse", sbi_sse_init, COLDBOOT_STAGE_NONE },
+};
+
+static void init_warm_stages(struct sbi_scratch *scratch,
+			     const struct warm_stage *stages, u32 start, u32 end)
+{
+	u32 i;
+
+	for (i = start; i < end; i++) {
+		wait_for_coldboot_stage(stages[i].depends);
+		if (stages[i].init(scratch, false))
+			sbi_hart_hang();
+		sbi_prof_trace(stages[i].name);
+	}
+}
+
 static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 					 u32 hartid)
 {
 	int rc;
+	u32 prestart_done = 0;
 	unsigned long *count;
-	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
-	if (!entry_count_offset || !init_count_offset)
+	if (!entry_count_offset || !init_count_offset ||
+	    !protection_lost_offset)
 		sbi_hart_hang();
 
 	count = sbi_scratch_offset_ptr(scratch, entry_count_offset);
 	(*count)++;
 
-	/* Note: This has to be first thing in warmboot init sequence */
-	rc = sbi_hsm_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
-
-	rc = sbi_hart_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
-
-	rc = sbi_timer_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
-
-	rc = sbi_platform_early_init(plat, false);
-	if (rc)
-		sbi_hart_hang();
-
-	rc = sbi_pmu_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
+	sbi_prof_start();
 
-	rc = sbi_dbtr_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
-
-	rc = sbi_irqchip_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
-
-	rc = sbi_ipi_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
+#ifdef CONFIG_SBI_INIT_PARALLEL
+	/*
+	 * Initialize per-HART state while coldboot HART is still busy
+	 * probing drivers and waiting for the HART to be started.
+	 */
+	prestart_done = array_size(warm_prestart_stages);
+	init_warm_stages(scratch, warm_prestart_stages, 0, prestart_done);
 
-	rc = sbi_tlb_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
+	sbi_lock_bench(scratch, false);
+#endif
 
-	rc = sbi_fwft_init(scratch, false);
+	/*
+	 * Note: This has to be first thing in warmboot init sequence
+	 * apart from the stages which don't need the HART to be started.
+	 */
+	rc = sbi_hsm_init(scratch, false);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("hsm_wait");
 
-	rc = sbi_platform_final_init(plat, false);
-	if (rc)
-		sbi_hart_hang();
+	init_warm_stages(scratch, warm_prestart_stages, prestart_done,
+			 array_size(warm_prestart_stages));
 
-	rc = sbi_sse_init(scratch, false);
-	if (rc)
-		sbi_hart_hang();
+	init_warm_stages(scratch, warm_start_stages, 0,
+			 array_size(warm_start_stages));
 
 	/*
 	 * Configure hart isolation at last because if SMEPMP is,
 	 * detected, M-mode access to the S/U space will be rescinded.
 	 */
-	rc = sbi_hart_protection_configure(scratch);
-	if (rc)
-		sbi_hart_hang();
+	init_hart_protection(scratch);
 
 	count = sbi_scratch_offset_ptr(scratch, init_count_offset);
 	(*count)++;
@@ -525,15 +673,17 @@ static void __noreturn init_warm_resume(struct sbi_scratch *scratch,
 {
 	int rc;
 
+	sbi_prof_start();
+
 	sbi_hsm_hart_resume_start(scratch);
+	sbi_prof_trace("hsm_resume");
 
 	rc = sbi_hart_reinit(scratch);
 	if (rc)
 		sbi_hart_hang();
+	sbi_prof_trace("hart_reinit");
 
-	rc = sbi_hart_protection_configure(scratch);
-	if (rc)
-		sbi_hart_hang();
+	init_hart_protection(scratch);
 
 	sbi_hsm_hart_resume_finish(scratch, hartid);
 }
@@ -636,6 +786,30 @@ void sbi_revert_entry_count(struct sbi_scratch *scratch)
 	*entry_count = *init_count;
 }
 
+/**
+ * Mark the hart protection (PMP/Smepmp) setup of a HART as lost
+ *
+ * This has to be called on the HART owning the scratch space or while
+ * that HART is stopped, whenever the HART may lose its M-mode only CSR
+ * state (such as being powered down). All other per-HART state is always
+ * re-initialized on warmboot because it is either torn down by sbi_exit()
+ * or can be modified by S-mode. With CONFIG_SBI_INIT_HOT_RESTART, the hart
+ * protection setup is only reprogrammed on HART start or resume if it
+ * was marked as lost.
+ *
+ * @param scratch pointer to sbi_scratch of the HART
+ */
+void sbi_init_mark_protection_lost(struct sbi_scratch *scratch)
+{
+	bool *lost;
+
+	if (!protection_lost_offset)
+		return;
+
+	lost = sbi_scratch_offset_ptr(scratch, protection_lost_offset);
+	*lost = true;
+}
+
 unsigned long sbi_entry_count(u32 hartindex)
 {
 	struct sbi_scratch *scratch;
@@ -11,6 +11,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_error.h>
@@ -24,6 +25,7 @@
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 
 struct sbi_ipi_data {
 	unsigned long ipi_type;
@@ -43,6 +45,16 @@ static unsigned long ipi_data_off;
 static const struct sbi_ipi_device *ipi_dev = NULL;
 static SBI_LIST_HEAD(ipi_dev_node_list);
 static const struct sbi_ipi_event_ops *ipi_ops_array[SBI_IPI_EVENT_MAX];
+static spinlock_t ipi_ops_lock = SPIN_LOCK_INITIALIZER;
+
+/* Lockless lookup of IPI event ops (NULL if event is not created) */
+static const struct sbi_ipi_event_ops *sbi_ipi_event_ops(u32 event)
+{
+	if (SBI_IPI_EVENT_MAX <= event)
+		return NULL;
+
+	return *(const struct sbi_ipi_event_ops * volatile *)&ipi_ops_array[event];
+}
 
 static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartindex,
 			u32 event, void *data)
@@ -52,10 +64,9 @@ static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartindex,
 	struct sbi_ipi_data *ipi_data;
 	const struct sbi_ipi_event_ops *ipi_ops;
 
-	if ((SBI_IPI_EVENT_MAX <= event) ||
-	    !ipi_ops_array[event])
+	ipi_ops = sbi_ipi_event_ops(event);
+	if (!ipi_ops)
 		return SBI_EINVAL;
-	ipi_ops = ipi_ops_array[event];
 
 	remote_scratch = sbi_hartindex_to_scratch(remote_hartindex);
 	if (!remote_scratch)
@@ -87,10 +98,14 @@ static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartindex,
 	 * the ipi_type was previously zero.
 	 */
 	if (!__atomic_fetch_or(&ipi_data->ipi_type,
-				BIT(event), __ATOMIC_RELAXED))
+				BIT(event), __ATOMIC_RELAXED)) {
+		sbi_hsm_hart_wakeup_event(remote_scratch);
 		ret = sbi_ipi_raw_send(remote_hartindex, false);
+	}
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_IPI_SENT);
+	sbi_trace(SBI_TRACE_IPI_SEND, sbi_hartindex_to_hartid(remote_hartindex),
+		  event, 0, 0);
 
 	return ret;
 }
@@ -99,10 +114,9 @@ static int sbi_ipi_sync(struct sbi_scratch *scratch, u32 event)
 {
 	const struct sbi_ipi_event_ops *ipi_ops;
 
-	if ((SBI_IPI_EVENT_MAX <= event) ||
-	    !ipi_ops_array[event])
+	ipi_ops = sbi_ipi_event_ops(event);
+	if (!ipi_ops)
 		return SBI_EINVAL;
-	ipi_ops = ipi_ops_array[event];
 
 	if (ipi_ops->sync)
 		ipi_ops->sync(scratch);
@@ -178,13 +192,15 @@ int sbi_ipi_event_create(const struct sbi_ipi_event_ops *ops)
 	if (!ops || !ops->process)
 		return SBI_EINVAL;
 
+	spin_lock(&ipi_ops_lock);
 	for (i = 0; i < SBI_IPI_EVENT_MAX; i++) {
 		if (!ipi_ops_array[i]) {
 			ret = i;
-			ipi_ops_array[i] = ops;
+			__smp_store_release(&ipi_ops_array[i], ops);
 			break;
 		}
 	}
+	spin_unlock(&ipi_ops_lock);
 
 	return ret;
 }
@@ -194,7 +210,9 @@ void sbi_ipi_event_destroy(u32 event)
 	if (SBI_IPI_EVENT_MAX <= event)
 		return;
 
+	spin_lock(&ipi_ops_lock);
 	ipi_ops_array[event] = NULL;
+	spin_unlock(&ipi_ops_lock);
 }
 
 static void sbi_ipi_process_smode(struct sbi_scratch *scratch)
@@ -259,10 +277,11 @@ void sbi_ipi_process(void)
 	sbi_ipi_raw_clear(false);
 
 	ipi_type = atomic_raw_xchg_ulong(&ipi_data->ipi_type, 0);
+	sbi_trace(SBI_TRACE_IPI_RECV, ipi_type, 0, 0, 0);
 	ipi_event = 0;
 	while (ipi_type) {
 		if (ipi_type & 1UL) {
-			ipi_ops = ipi_ops_array[ipi_event];
+			ipi_ops = sbi_ipi_event_ops(ipi_event);
 			if (ipi_ops)
 				ipi_ops->process(scratch);
 		}
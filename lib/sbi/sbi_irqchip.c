@@ -15,11 +15,16 @@
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_scratch.h>
 
+struct sbi_irqchip_handler;
+
 /** Internal irqchip hardware interrupt data */
 struct sbi_irqchip_hwirq_data {
 	/** raw hardware interrupt handler */
 	int (*raw_handler)(struct sbi_irqchip_device *chip, u32 hwirq);
 
+	/** interrupt handler registered for this hwirq (NULL if none) */
+	struct sbi_irqchip_handler *handler;
+
 	/** target hart index */
 	u32 hart_index;
 };
@@ -100,17 +105,20 @@ int sbi_irqchip_mask_hwirq(struct sbi_irqchip_device *chip, u32 hwirq)
 static struct sbi_irqchip_handler *sbi_irqchip_find_handler(struct sbi_irqchip_device *chip,
 							    u32 hwirq)
 {
-	struct sbi_irqchip_handler *h;
-
 	if (!chip || chip->num_hwirq <= hwirq)
 		return NULL;
 
-	sbi_list_for_each_entry(h, &chip->handler_list, node) {
-		if (h->first_hwirq <= hwirq && hwirq < (h->first_hwirq + h->num_hwirq))
-			return h;
-	}
+	return chip->hwirqs[hwirq].handler;
+}
 
-	return NULL;
+static void sbi_irqchip_set_handler(struct sbi_irqchip_device *chip,
+				    u32 first_hwirq, u32 num_hwirq,
+				    struct sbi_irqchip_handler *h)
+{
+	u32 i;
+
+	for (i = first_hwirq; i < (first_hwirq + num_hwirq); i++)
+		chip->hwirqs[i].handler = h;
 }
 
 int sbi_irqchip_raw_handler_default(struct sbi_irqchip_device *chip, u32 hwirq)
@@ -121,8 +129,10 @@ int sbi_irqchip_raw_handler_default(struct sbi_irqchip_device *chip, u32 hwirq)
 	if (!chip || chip->num_hwirq <= hwirq)
 		return SBI_EINVAL;
 
-	h = sbi_irqchip_find_handler(chip, hwirq);
-	if (h->callback)
+	h = chip->hwirqs[hwirq].handler;
+	if (!h)
+		rc = SBI_ENOENT;
+	else if (h->callback)
 		rc = h->callback(hwirq, h->priv);
 
 	if (chip->hwirq_eoi)
@@ -271,6 +281,7 @@ static int __sbi_irqchip_register_handler(struct sbi_irqchip_device *chip,
 		sbi_list_add(&h->node, &nh->node);
 	else
 		sbi_list_add_tail(&h->node, &chip->handler_list);
+	sbi_irqchip_set_handler(chip, h->first_hwirq, h->num_hwirq, h);
 
 	if (chip->hwirq_setup) {
 		for (i = 0; i < h->num_hwirq; i++) {
@@ -280,6 +291,8 @@ static int __sbi_irqchip_register_handler(struct sbi_irqchip_device *chip,
 					for (j = 0; j < i; j++)
 						chip->hwirq_cleanup(chip, h->first_hwirq + j);
 				}
+				sbi_irqchip_set_handler(chip, h->first_hwirq,
+							h->num_hwirq, NULL);
 				sbi_list_del(&h->node);
 				sbi_free(h);
 				return rc;
@@ -293,6 +306,7 @@ static int __sbi_irqchip_register_handler(struct sbi_irqchip_device *chip,
 			for (i = 0; i < h->num_hwirq; i++)
 				chip->hwirq_cleanup(chip, h->first_hwirq + i);
 		}
+		sbi_irqchip_set_handler(chip, h->first_hwirq, h->num_hwirq, NULL);
 		sbi_list_del(&h->node);
 		sbi_free(h);
 		return rc;
@@ -313,9 +327,7 @@ int sbi_irqchip_register_msi(struct sbi_irqchip_device *chip, u32 num_hwirq,
 			     int (*callback)(u32 hwirq, void *priv), void *priv,
 			     u32 *out_first_hwirq)
 {
-	struct sbi_irqchip_handler *h;
-	bool found;
-	u32 hwirq;
+	u32 hwirq, count;
 
 	if (!chip || !chip->hwirq_set_affinity || !num_hwirq ||
 	    !write_msi || !callback || !out_first_hwirq)
@@ -323,24 +335,13 @@ int sbi_irqchip_register_msi(struct sbi_irqchip_device *chip, u32 num_hwirq,
 	if (chip->num_hwirq < num_hwirq)
 		return SBI_EBAD_RANGE;
 
-	hwirq = 0;
-	found = false;
-	sbi_list_for_each_entry(h, &chip->handler_list, node) {
-		if (h->first_hwirq <= hwirq && hwirq < (h->first_hwirq + h->num_hwirq)) {
-			hwirq = h->first_hwirq + h->num_hwirq;
-		} else if (hwirq < h->first_hwirq) {
-			if (h->first_hwirq - hwirq < num_hwirq) {
-				found = true;
-				break;
-			} else {
-				hwirq = h->first_hwirq + h->num_hwirq;
-			}
-		}
-	}
-	if (!found && !hwirq)
-		found = true;
-	if (!found)
+	/* Find the first range of num_hwirq consecutive free hwirqs */
+	count = 0;
+	for (hwirq = 0; hwirq < chip->num_hwirq && count < num_hwirq; hwirq++)
+		count = chip->hwirqs[hwirq].handler ? 0 : count + 1;
+	if (count < num_hwirq)
 		return SBI_ENOSPC;
+	hwirq -= num_hwirq;
 	*out_first_hwirq = hwirq;
 
 	return __sbi_irqchip_register_handler(chip, *out_first_hwirq,
@@ -404,7 +405,9 @@ int sbi_irqchip_unregister_handler(struct sbi_irqchip_device *chip,
 			chip->hwirq_cleanup(chip, fh->first_hwirq + i);
 	}
 
+	sbi_irqchip_set_handler(chip, fh->first_hwirq, fh->num_hwirq, NULL);
 	sbi_list_del(&fh->node);
+	sbi_free(fh);
 	return 0;
 }
 
@@ -480,6 +483,36 @@ int sbi_irqchip_add_device(struct sbi_irqchip_device *chip)
 	return 0;
 }
 
+int sbi_irqchip_remove_device(struct sbi_irqchip_device *chip)
+{
+	struct sbi_irqchip_hart_data *hd;
+	struct sbi_scratch *scratch;
+	u32 h;
+
+	if (!chip || sbi_irqchip_find_device(chip->id) != chip)
+		return SBI_EINVAL;
+
+	if (!sbi_list_empty(&chip->handler_list))
+		return SBI_EINVALID_STATE;
+
+	if (chip->process_hwirqs) {
+		sbi_hartmask_for_each_hartindex(h, &chip->target_harts) {
+			scratch = sbi_hartindex_to_scratch(h);
+			if (!scratch)
+				continue;
+
+			hd = sbi_scratch_offset_ptr(scratch, irqchip_hart_data_off);
+			if (hd->chip == chip)
+				hd->chip = NULL;
+		}
+	}
+
+	sbi_list_del(&chip->node);
+	sbi_free(chip->hwirqs);
+	chip->hwirqs = NULL;
+	return 0;
+}
+
 int sbi_irqchip_init(struct sbi_scratch *scratch, bool cold_boot)
 {
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
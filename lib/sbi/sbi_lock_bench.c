@@ -0,0 +1,130 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Ticket and queued spinlock benchmark across all booting HARTs.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_qspinlock.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
+
+/** Lock acquisitions per HART for each lock type */
+#define LOCK_BENCH_ITERATIONS	2000
+
+/** Time given to secondary HARTs to join the benchmark */
+#define LOCK_BENCH_JOIN_MS	100
+
+enum lock_bench_phase {
+	LOCK_BENCH_TICKET_START = 0,
+	LOCK_BENCH_TICKET_END,
+	LOCK_BENCH_QUEUED_START,
+	LOCK_BENCH_QUEUED_END,
+	LOCK_BENCH_PHASE_MAX,
+};
+
+static spinlock_t bench_join_lock = SPIN_LOCK_INITIALIZER;
+static u32 bench_joined;
+static bool bench_closed;
+static volatile u32 bench_participants;
+
+static atomic_t bench_barrier[LOCK_BENCH_PHASE_MAX];
+static spinlock_t bench_ticket_lock = SPIN_LOCK_INITIALIZER;
+static qspinlock_t bench_queued_lock = QSPIN_LOCK_INITIALIZER;
+static unsigned long bench_counter;
+
+static void lock_bench_barrier(enum lock_bench_phase phase)
+{
+	atomic_add_return(&bench_barrier[phase], 1);
+	while (atomic_read(&bench_barrier[phase]) < bench_participants)
+		cpu_relax();
+}
+
+/* Returns the cycles taken by all HARTs for each lock type */
+static void lock_bench_run(unsigned long *ticket, unsigned long *queued)
+{
+	unsigned long start;
+	u32 i;
+
+	lock_bench_barrier(LOCK_BENCH_TICKET_START);
+	start = csr_read(CSR_MCYCLE);
+	for (i = 0; i < LOCK_BENCH_ITERATIONS; i++) {
+		spin_lock(&bench_ticket_lock);
+		bench_counter++;
+		spin_unlock(&bench_ticket_lock);
+	}
+	lock_bench_barrier(LOCK_BENCH_TICKET_END);
+	*ticket = csr_read(CSR_MCYCLE) - start;
+
+	lock_bench_barrier(LOCK_BENCH_QUEUED_START);
+	start = csr_read(CSR_MCYCLE);
+	for (i = 0; i < LOCK_BENCH_ITERATIONS; i++) {
+		qspin_lock(&bench_queued_lock);
+		bench_counter++;
+		qspin_unlock(&bench_queued_lock);
+	}
+	lock_bench_barrier(LOCK_BENCH_QUEUED_END);
+	*queued = csr_read(CSR_MCYCLE) - start;
+}
+
+static void lock_bench_secondary(void)
+{
+	unsigned long ticket, queued;
+	bool joined = false;
+
+	spin_lock(&bench_join_lock);
+	if (!bench_closed) {
+		bench_joined++;
+		joined = true;
+	}
+	spin_unlock(&bench_join_lock);
+
+	if (!joined)
+		return;
+
+	while (!bench_participants)
+		cpu_relax();
+
+	lock_bench_run(&ticket, &queued);
+}
+
+static void lock_bench_primary(void)
+{
+	unsigned long ticket, queued, total;
+	u32 i, expected = sbi_hart_count() - 1;
+
+	for (i = 0; i < LOCK_BENCH_JOIN_MS; i++) {
+		if (__smp_load_acquire(&bench_joined) >= expected)
+			break;
+		sbi_timer_mdelay(1);
+	}
+
+	spin_lock(&bench_join_lock);
+	bench_closed = true;
+	bench_participants = bench_joined + 1;
+	spin_unlock(&bench_join_lock);
+
+	qspin_lock_reset_stats(&bench_queued_lock);
+
+	lock_bench_run(&ticket, &queued);
+
+	total = (unsigned long)bench_participants * LOCK_BENCH_ITERATIONS;
+	sbi_printf("Lock bench: %u HARTs x %u acquisitions%s\n",
+		   bench_participants, LOCK_BENCH_ITERATIONS,
+		   (bench_counter == 2 * total) ? "" : " (COUNT MISMATCH)");
+	sbi_printf("Lock bench: ticket %lu cycles, queued %lu cycles "
+		   "per acquisition\n", ticket / total, queued / total);
+	qspin_lock_dump_stats(&bench_queued_lock, "Lock bench queued");
+}
+
+void sbi_lock_bench(struct sbi_scratch *scratch, bool cold_boot)
+{
+	if (cold_boot)
+		lock_bench_primary();
+	else
+		lock_bench_secondary();
+}
@@ -8,6 +8,7 @@
  */
 
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_locks.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
@@ -28,6 +29,9 @@ static unsigned long mpxy_shmem_size = PAGE_SIZE;
 /** List of MPXY proxy channels */
 static SBI_LIST_HEAD(mpxy_channel_list);
 
+/** Lock for updating the list of MPXY proxy channels */
+static seqlock_t mpxy_channel_lock = SEQLOCK_INITIALIZER;
+
 /** Invalid Physical Address(all bits 1) */
 #define INVALID_ADDR		(-1UL)
 
@@ -145,18 +149,40 @@ static inline bool mpxy_is_std_attr(u32 attr_id)
 	return (attr_id >> 31) ? false : true;
 }
 
-/** Find channel_id in registered channels list */
-static struct sbi_mpxy_channel *mpxy_find_channel(u32 channel_id)
+/**
+ * Find channel_id in registered channels list. Readers pass the sequence
+ * returned by read_seqbegin() and writers pass NULL.
+ */
+static struct sbi_mpxy_channel *__mpxy_find_channel(u32 channel_id,
+						     const u32 *seq)
 {
 	struct sbi_mpxy_channel *channel;
 
-	sbi_list_for_each_entry(channel, &mpxy_channel_list, head)
+	sbi_list_for_each_entry(channel, &mpxy_channel_list, head) {
+		/* Don't follow links which may be under update */
+		if (seq && read_seqretry(&mpxy_channel_lock, *seq))
+			break;
 		if (channel->channel_id == channel_id)
 			return channel;
+	}
 
 	return NULL;
 }
 
+/** Find channel_id in registered channels list */
+static struct sbi_mpxy_channel *mpxy_find_channel(u32 channel_id)
+{
+	struct sbi_mpxy_channel *channel;
+	u32 seq;
+
+	do {
+		seq = read_seqbegin(&mpxy_channel_lock);
+		channel = __mpxy_find_channel(channel_id, &seq);
+	} while (read_seqretry(&mpxy_channel_lock, seq));
+
+	return channel;
+}
+
 /** Copy attributes word size */
 static void mpxy_copy_std_attrs(u32 *outmem, u32 *inmem, u32 count)
 {
@@ -224,8 +250,12 @@ int sbi_mpxy_register_channel(struct sbi_mpxy_channel *channel)
 	if (!channel)
 		return SBI_EINVAL;
 
-	if (mpxy_find_channel(channel->channel_id))
+	write_seqlock(&mpxy_channel_lock);
+
+	if (__mpxy_find_channel(channel->channel_id, NULL)) {
+		write_sequnlock(&mpxy_channel_lock);
 		return SBI_EALREADY;
+	}
 
 	/* Initialize channel specific attributes */
 	mpxy_std_attrs_init(channel);
@@ -238,6 +268,8 @@ int sbi_mpxy_register_channel(struct sbi_mpxy_channel *channel)
 
 	sbi_list_add_tail(&channel->head, &mpxy_channel_list);
 
+	write_sequnlock(&mpxy_channel_lock);
+
 	return SBI_OK;
 }
 
@@ -341,6 +373,10 @@ int sbi_mpxy_set_shmem(unsigned long shmem_phys_lo,
 	/** Disable shared memory if both hi and lo have all bit 1s */
 	if (shmem_phys_lo == INVALID_ADDR &&
 	    shmem_phys_hi == INVALID_ADDR) {
+		if (mpxy_shmem_enabled(ms))
+			sbi_hart_protection_unmap_shmem(
+				(unsigned long)hart_shmem_base(ms),
+				mpxy_shmem_size);
 		sbi_mpxy_shmem_disable(ms);
 		return SBI_SUCCESS;
 	}
@@ -382,10 +418,19 @@ int sbi_mpxy_set_shmem(unsigned long shmem_phys_lo,
 		sbi_hart_protection_unmap_range((unsigned long)ret_buf, mpxy_shmem_size);
 	}
 
+	/** Release the persistent mapping of old shared memory */
+	if (mpxy_shmem_enabled(ms))
+		sbi_hart_protection_unmap_shmem(
+			(unsigned long)hart_shmem_base(ms), mpxy_shmem_size);
+
 	/** Setup the new shared memory */
 	ms->shmem.shmem_addr_lo = shmem_phys_lo;
 	ms->shmem.shmem_addr_hi = shmem_phys_hi;
 
+	/** Keep the new shared memory mapped for M-mode when possible */
+	sbi_hart_protection_map_shmem((unsigned long)hart_shmem_base(ms),
+				      mpxy_shmem_size);
+
 	return SBI_SUCCESS;
 }
 
@@ -393,51 +438,67 @@ int sbi_mpxy_get_channel_ids(u32 start_index)
 {
 	struct mpxy_state *ms = sbi_domain_mpxy_state_thishart_ptr();
 	u32 remaining, returned, max_channelids;
-	u32 node_index = 0, node_ret = 0;
+	u32 node_index, node_ret, seq;
 	struct sbi_mpxy_channel *channel;
-	u32 channels_count = 0;
+	u32 channels_count;
 	u32 *shmem_base;
+	int ret = SBI_SUCCESS;
 
 	if (!mpxy_shmem_enabled(ms))
 		return SBI_ERR_NO_SHMEM;
 
-	sbi_list_for_each_entry(channel, &mpxy_channel_list, head)
-		channels_count += 1;
-
-	if (start_index > channels_count)
-		return SBI_ERR_INVALID_PARAM;
-
 	shmem_base = hart_shmem_base(ms);
 	sbi_hart_protection_map_range((unsigned long)hart_shmem_base(ms), mpxy_shmem_size);
 
-	/** number of channel ids which can be stored in shmem adjusting
-	 * for remaining and returned fields */
-	max_channelids = (mpxy_shmem_size / sizeof(u32)) - 2;
-	/* total remaining from the start index */
-	remaining = channels_count - start_index;
-	/* how many can be returned */
-	returned = (remaining > max_channelids)? max_channelids : remaining;
+	do {
+		seq = read_seqbegin(&mpxy_channel_lock);
 
-	// Iterate over the list of channels to get the channel ids.
-	sbi_list_for_each_entry(channel, &mpxy_channel_list, head) {
-		if (node_index >= start_index &&
-			node_index < (start_index + returned)) {
-			shmem_base[2 + node_ret] = cpu_to_le32(channel->channel_id);
-			node_ret += 1;
+		channels_count = 0;
+		sbi_list_for_each_entry(channel, &mpxy_channel_list, head) {
+			if (read_seqretry(&mpxy_channel_lock, seq))
+				break;
+			channels_count += 1;
 		}
 
-		node_index += 1;
-	}
+		if (start_index > channels_count) {
+			ret = SBI_ERR_INVALID_PARAM;
+			continue;
+		}
+		ret = SBI_SUCCESS;
 
-	/* final remaininig channel ids */
-	remaining = channels_count - (start_index + returned);
+		/** number of channel ids which can be stored in shmem adjusting
+		 * for remaining and returned fields */
+		max_channelids = (mpxy_shmem_size / sizeof(u32)) - 2;
+		/* total remaining from the start index */
+		remaining = channels_count - start_index;
+		/* how many can be returned */
+		returned = (remaining > max_channelids)? max_channelids : remaining;
+
+		// Iterate over the list of channels to get the channel ids.
+		node_index = 0;
+		node_ret = 0;
+		sbi_list_for_each_entry(channel, &mpxy_channel_list, head) {
+			if (read_seqretry(&mpxy_channel_lock, seq))
+				break;
+			if (node_index >= start_index &&
+				node_index < (start_index + returned)) {
+				shmem_base[2 + node_ret] = cpu_to_le32(channel->channel_id);
+				node_ret += 1;
+			}
+
+			node_index += 1;
+		}
+
+		/* final remaininig channel ids */
+		remaining = channels_count - (start_index + returned);
 
-	shmem_base[0] = cpu_to_le32(remaining);
-	shmem_base[1] = cpu_to_le32(returned);
+		shmem_base[0] = cpu_to_le32(remaining);
+		shmem_base[1] = cpu_to_le32(returned);
+	} while (read_seqretry(&mpxy_channel_lock, seq));
 
 	sbi_hart_protection_unmap_range((unsigned long)hart_shmem_base(ms), mpxy_shmem_size);
 
-	return SBI_SUCCESS;
+	return ret;
 }
 
 int sbi_mpxy_read_attrs(u32 channel_id, u32 base_attr_id, u32 attr_count)
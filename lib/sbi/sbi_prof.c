@@ -0,0 +1,156 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_byteorder.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_prof.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+
+#ifndef CONFIG_SBI_PROF_MAX_RECORDS
+#define CONFIG_SBI_PROF_MAX_RECORDS	256
+#endif
+
+struct prof_record {
+	const char *name;
+	u32 hartindex;
+	u64 start;
+	u64 cycles;
+};
+
+/*
+ * Records are kept in a static buffer because trace points are used
+ * before the heap is initialized. A record is published by setting its
+ * name after all other fields have been written.
+ */
+static struct prof_record prof_records[CONFIG_SBI_PROF_MAX_RECORDS];
+static atomic_t prof_record_alloc = ATOMIC_INITIALIZER(0);
+
+/* Cycle counter value of the previous trace point of each HART */
+static u64 prof_last_cycle[SBI_HARTMASK_MAX_BITS];
+
+static u64 prof_read_cycle(void)
+{
+#if __riscv_xlen == 32
+	u32 hi, lo;
+
+	do {
+		hi = csr_read(CSR_MCYCLEH);
+		lo = csr_read(CSR_MCYCLE);
+	} while (hi != csr_read(CSR_MCYCLEH));
+
+	return ((u64)hi << 32) | lo;
+#else
+	return csr_read(CSR_MCYCLE);
+#endif
+}
+
+void sbi_prof_start(void)
+{
+	u32 hartindex = current_hartindex();
+
+	if (hartindex < SBI_HARTMASK_MAX_BITS)
+		prof_last_cycle[hartindex] = prof_read_cycle();
+}
+
+void sbi_prof_trace(const char *name)
+{
+	u32 hartindex = current_hartindex();
+	struct prof_record *rec;
+	u64 now = prof_read_cycle();
+	long idx;
+
+	if (hartindex >= SBI_HARTMASK_MAX_BITS)
+		return;
+
+	idx = atomic_add_return(&prof_record_alloc, 1) - 1;
+	if (idx < CONFIG_SBI_PROF_MAX_RECORDS) {
+		rec = &prof_records[idx];
+		rec->hartindex = hartindex;
+		rec->start = prof_last_cycle[hartindex];
+		rec->cycles = now - rec->start;
+		smp_wmb();
+		rec->name = name;
+	}
+
+	prof_last_cycle[hartindex] = prof_read_cycle();
+}
+
+u32 sbi_prof_record_count(void)
+{
+	long count = atomic_read(&prof_record_alloc);
+
+	return (count < CONFIG_SBI_PROF_MAX_RECORDS) ?
+		count : CONFIG_SBI_PROF_MAX_RECORDS;
+}
+
+void sbi_prof_print(u32 hartindex)
+{
+	u32 i, count = sbi_prof_record_count();
+	struct prof_record *rec;
+	u64 total = 0;
+
+	sbi_printf("Boot Profile HART %u  : %-16s %20s\n",
+		   sbi_hartindex_to_hartid(hartindex), "Stage", "Cycles");
+	for (i = 0; i < count; i++) {
+		rec = &prof_records[i];
+		if (!rec->name || rec->hartindex != hartindex)
+			continue;
+		sbi_printf("Boot Profile HART %u  : %-16s %20lu\n",
+			   sbi_hartindex_to_hartid(hartindex), rec->name,
+			   (unsigned long)rec->cycles);
+		total += rec->cycles;
+	}
+	sbi_printf("Boot Profile HART %u  : %-16s %20lu\n",
+		   sbi_hartindex_to_hartid(hartindex), "total",
+		   (unsigned long)total);
+}
+
+int sbi_prof_read_records(u32 start, u32 count, unsigned long addr,
+			  u32 *out_count)
+{
+	u32 i, avail = sbi_prof_record_count();
+	struct sbi_prof_record *out;
+	struct prof_record *rec;
+
+	if (start > avail)
+		return SBI_EINVAL;
+	if (count > avail - start)
+		count = avail - start;
+	if (!count) {
+		*out_count = 0;
+		return 0;
+	}
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(), addr,
+					 count * sizeof(*out), PRV_S,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	sbi_hart_protection_map_range(addr, count * sizeof(*out));
+
+	out = (struct sbi_prof_record *)addr;
+	for (i = 0; i < count; i++) {
+		rec = &prof_records[start + i];
+		sbi_memset(&out[i], 0, sizeof(out[i]));
+		if (!rec->name)
+			continue;
+		smp_rmb();
+		sbi_strncpy(out[i].name, rec->name, SBI_PROF_NAME_LEN - 1);
+		out[i].hartid = cpu_to_le32(sbi_hartindex_to_hartid(rec->hartindex));
+		out[i].start = cpu_to_le64(rec->start);
+		out[i].cycles = cpu_to_le64(rec->cycles);
+	}
+
+	sbi_hart_protection_unmap_range(addr, count * sizeof(*out));
+
+	*out_count = count;
+	return 0;
+}
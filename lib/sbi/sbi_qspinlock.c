@@ -0,0 +1,196 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Queued (MCS) spinlock implementation.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_qspinlock.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+
+struct qspin_hart {
+	/** Bitmap of nodes in use */
+	unsigned long used;
+	struct qspin_node nodes[QSPIN_NODES_PER_HART];
+};
+
+static unsigned long qspin_hart_offset;
+
+/*
+ * Nodes used before sbi_qspinlock_init(). Only the coldboot HART
+ * runs C code at that point so a single set of nodes is enough.
+ */
+static struct qspin_hart qspin_boot_hart;
+
+static struct qspin_node *qspin_node_get(void)
+{
+	struct qspin_hart *qh;
+	u32 i;
+
+	qh = (qspin_hart_offset) ?
+	     sbi_scratch_thishart_offset_ptr(qspin_hart_offset) :
+	     &qspin_boot_hart;
+
+	for (i = 0; i < QSPIN_NODES_PER_HART; i++) {
+		if (!(qh->used & BIT(i))) {
+			qh->used |= BIT(i);
+			qh->nodes[i].next = NULL;
+			qh->nodes[i].locked = 0;
+			return &qh->nodes[i];
+		}
+	}
+
+	/* Locks are nested deeper than supported */
+	sbi_hart_hang();
+	return NULL;
+}
+
+static void qspin_node_put(struct qspin_node *node)
+{
+	struct qspin_hart *qh;
+
+	qh = (qspin_hart_offset) ?
+	     sbi_scratch_thishart_offset_ptr(qspin_hart_offset) :
+	     &qspin_boot_hart;
+
+	qh->used &= ~BIT(node - qh->nodes);
+}
+
+#ifdef CONFIG_SBI_LOCK_STATS
+static void qspin_lock_account(qspinlock_t *lock, unsigned long spins,
+			       unsigned long wait)
+{
+	/* Only the lock owner updates the statistics */
+	lock->stats.acquisitions++;
+	if (spins) {
+		lock->stats.contended++;
+		lock->stats.spins += spins;
+		if (lock->stats.max_wait < wait)
+			lock->stats.max_wait = wait;
+	}
+}
+#else
+static inline void qspin_lock_account(qspinlock_t *lock, unsigned long spins,
+				      unsigned long wait)
+{
+}
+#endif
+
+bool qspin_lock_check(qspinlock_t *lock)
+{
+	RISCV_FENCE(r, rw);
+	return atomic_read(&lock->tail) != 0;
+}
+
+bool qspin_trylock(qspinlock_t *lock)
+{
+	struct qspin_node *node = qspin_node_get();
+
+	if (atomic_cmpxchg(&lock->tail, 0, (long)node) != 0) {
+		qspin_node_put(node);
+		return false;
+	}
+
+	lock->owner = node;
+	qspin_lock_account(lock, 0, 0);
+	return true;
+}
+
+void qspin_lock(qspinlock_t *lock)
+{
+	struct qspin_node *prev, *node = qspin_node_get();
+	unsigned long spins = 0, start = 0;
+
+	prev = (struct qspin_node *)atomic_xchg(&lock->tail, (long)node);
+	if (prev) {
+#ifdef CONFIG_SBI_LOCK_STATS
+		start = csr_read(CSR_MCYCLE);
+#endif
+
+		/* Queue behind the previous waiter and spin on our own node */
+		__smp_store_release(&prev->next, node);
+		while (!*(volatile unsigned long *)&node->locked) {
+			cpu_relax();
+			spins++;
+		}
+		RISCV_FENCE(r, rw);
+
+#ifdef CONFIG_SBI_LOCK_STATS
+		start = csr_read(CSR_MCYCLE) - start;
+#endif
+		if (!spins)
+			spins = 1;
+	}
+
+	lock->owner = node;
+	qspin_lock_account(lock, spins, start);
+}
+
+void qspin_unlock(qspinlock_t *lock)
+{
+	struct qspin_node *next, *node = lock->owner;
+
+	next = *(struct qspin_node * volatile *)&node->next;
+	if (!next) {
+		/* No waiter so try to release the lock directly */
+		if (atomic_cmpxchg(&lock->tail, (long)node, 0) == (long)node)
+			goto done;
+
+		/* A waiter is queueing so wait for it to link itself */
+		while (!(next = *(struct qspin_node * volatile *)&node->next))
+			cpu_relax();
+	}
+
+	__smp_store_release(&next->locked, 1);
+done:
+	qspin_node_put(node);
+}
+
+int qspin_lock_get_stats(qspinlock_t *lock, struct qspin_lock_stats *out)
+{
+#ifdef CONFIG_SBI_LOCK_STATS
+	if (!lock || !out)
+		return SBI_EINVAL;
+
+	/* Statistics are informational so read them without the lock */
+	sbi_memcpy(out, &lock->stats, sizeof(*out));
+	return 0;
+#else
+	return SBI_ENOTSUPP;
+#endif
+}
+
+void qspin_lock_reset_stats(qspinlock_t *lock)
+{
+#ifdef CONFIG_SBI_LOCK_STATS
+	qspin_lock(lock);
+	sbi_memset(&lock->stats, 0, sizeof(lock->stats));
+	qspin_unlock(lock);
+#endif
+}
+
+void qspin_lock_dump_stats(qspinlock_t *lock, const char *name)
+{
+	struct qspin_lock_stats stats;
+
+	if (qspin_lock_get_stats(lock, &stats))
+		return;
+
+	sbi_printf("%-16s: acquisitions %lu contended %lu spins %lu "
+		   "max wait %lu cycles\n", name, stats.acquisitions,
+		   stats.contended, stats.spins, stats.max_wait);
+}
+
+int sbi_qspinlock_init(struct sbi_scratch *scratch)
+{
+	qspin_hart_offset = sbi_scratch_alloc_type_offset(struct qspin_hart);
+	if (!qspin_hart_offset)
+		return SBI_ENOMEM;
+
+	return 0;
+}
@@ -6,6 +6,7 @@
  */
 
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/riscv_locks.h>
@@ -20,12 +21,14 @@
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_list.h>
+#include <sbi/sbi_math.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_sse.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_slist.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 
 #include <sbi/sbi_console.h>
@@ -131,6 +134,13 @@ struct sse_hart_state {
 	 */
 	spinlock_t enabled_event_lock;
 
+	/**
+	 * Number of events in enabled_event_list which have their pending
+	 * bit set. This allows the trap exit path to bail out with a single
+	 * load when nothing is pending on this hart.
+	 */
+	atomic_t pending_count;
+
 	/**
 	 * List of local events allocated at boot time.
 	 */
@@ -165,10 +175,26 @@ struct sse_event_info {
 	SBI_SLIST_NODE(sse_event_info);
 };
 
+/** Event ID to event slot mapping entry */
+struct sse_event_slot {
+	uint32_t event_id;
+	/** Index in global_events[] or sse_hart_state.local_events[] */
+	u16 index;
+	bool used;
+};
+
 static unsigned int local_event_count;
 static unsigned int global_event_count;
 static struct sse_global_event *global_events;
 
+/*
+ * Open addressing hash table mapping event IDs to event slots. It is
+ * built once at cold boot after all supported events have been added
+ * and is read-only afterwards.
+ */
+static struct sse_event_slot *event_slots;
+static unsigned int event_slots_mask;
+
 static unsigned long sse_inject_fifo_off;
 static unsigned long sse_inject_fifo_mem_off;
 /* Offset of pointer to SSE HART state in scratch space */
@@ -294,33 +320,100 @@ static void sse_event_set_state(struct sbi_sse_event *e,
 	e->attrs.status |= new_state;
 }
 
-static int sse_event_get(uint32_t event_id, struct sbi_sse_event **eret)
+static unsigned int sse_event_slot_hash(uint32_t event_id)
+{
+	/* Fibonacci hashing spreads the sparse SSE event ID ranges */
+	return (uint32_t)(event_id * 0x9e3779b1U) >> 16;
+}
+
+static struct sse_event_slot *sse_event_slot_find(uint32_t event_id)
 {
+	struct sse_event_slot *slot;
 	unsigned int i;
-	struct sbi_sse_event *e;
+
+	if (!event_slots)
+		return NULL;
+
+	i = sse_event_slot_hash(event_id) & event_slots_mask;
+	while (1) {
+		slot = &event_slots[i];
+		if (!slot->used)
+			return NULL;
+		if (slot->event_id == event_id)
+			return slot;
+		i = (i + 1) & event_slots_mask;
+	}
+}
+
+static int sse_event_slot_add(uint32_t event_id, unsigned int index)
+{
+	struct sse_event_slot *slot;
+	unsigned int i;
+
+	i = sse_event_slot_hash(event_id) & event_slots_mask;
+	while (event_slots[i].used) {
+		if (event_slots[i].event_id == event_id)
+			return SBI_EALREADY;
+		i = (i + 1) & event_slots_mask;
+	}
+
+	slot = &event_slots[i];
+	slot->event_id = event_id;
+	slot->index = index;
+	slot->used = true;
+
+	return SBI_OK;
+}
+
+static int sse_event_slots_init(void)
+{
+	unsigned int local = 0, global = 0, count;
+	struct sse_event_info *info;
+	int ret;
+
+	/* Keep the load factor at or below 50% so probe chains stay short */
+	count = 1UL << log2roundup(2 * (global_event_count +
+					 local_event_count));
+	if (count < 8)
+		count = 8;
+
+	event_slots = sbi_zalloc(sizeof(*event_slots) * count);
+	if (!event_slots)
+		return SBI_ENOMEM;
+	event_slots_mask = count - 1;
+
+	SBI_SLIST_FOR_EACH_ENTRY(info, supported_events) {
+		if (EVENT_IS_GLOBAL(info->event_id))
+			ret = sse_event_slot_add(info->event_id, global++);
+		else
+			ret = sse_event_slot_add(info->event_id, local++);
+		if (ret)
+			return ret;
+	}
+
+	return SBI_OK;
+}
+
+static int sse_event_get(uint32_t event_id, struct sbi_sse_event **eret)
+{
+	struct sse_event_slot *slot;
+	struct sse_global_event *ge;
 	struct sse_hart_state *shs;
 
 	if (!eret)
 		return SBI_EINVAL;
 
-	if (EVENT_IS_GLOBAL(event_id)) {
-		for (i = 0; i < global_event_count; i++) {
-			e = &global_events[i].event;
-			if (e->event_id == event_id) {
-				spin_lock(&global_events[i].lock);
-				*eret = e;
-				return SBI_SUCCESS;
-			}
-		}
-	} else {
-		shs = sse_thishart_state_ptr();
-		for (i = 0; i < local_event_count; i++) {
-			e = &shs->local_events[i];
-			if (e->event_id == event_id) {
-				*eret = e;
-				return SBI_SUCCESS;
-			}
+	slot = sse_event_slot_find(event_id);
+	if (slot) {
+		if (EVENT_IS_GLOBAL(event_id)) {
+			ge = &global_events[slot->index];
+			spin_lock(&ge->lock);
+			*eret = &ge->event;
+		} else {
+			shs = sse_thishart_state_ptr();
+			*eret = &shs->local_events[slot->index];
 		}
+		return SBI_SUCCESS;
 	}
 
 	/* Check if the event is a standard one but not supported */
@@ -342,9 +435,16 @@ static void sse_event_put(struct sbi_sse_event *e)
 	spin_unlock(&ge->lock);
 }
 
+/**
+ * Must be called under owner hart lock
+ */
 static void sse_event_remove_from_list(struct sbi_sse_event *e)
 {
+	struct sse_hart_state *state = sse_get_hart_state(e);
+
 	sbi_list_del(&e->node);
+	if (sse_event_pending(e))
+		atomic_sub_return(&state->pending_count, 1);
 }
 
 /**
@@ -363,6 +463,8 @@ static void sse_event_add_to_list(struct sbi_sse_event *e)
 			break;
 	}
 	sbi_list_add_tail(&e->node, &tmp->node);
+	if (sse_event_pending(e))
+		atomic_add_return(&state->pending_count, 1);
 }
 
 /**
@@ -545,16 +647,20 @@ static void sse_event_inject(struct sbi_sse_event *e,
 			     struct sbi_trap_regs *regs)
 {
 	struct sse_interrupted_state *i_ctx = &e->attrs.interrupted;
+	struct sse_hart_state *state = sse_get_hart_state(e);
 
 	sse_event_set_state(e, SBI_SSE_STATE_RUNNING);
 
 	e->attrs.status &= ~BIT(SBI_SSE_ATTR_STATUS_PENDING_OFFSET);
+	atomic_sub_return(&state->pending_count, 1);
 
 	i_ctx->a6 = regs->a6;
 	i_ctx->a7 = regs->a7;
 	i_ctx->flags = sse_interrupted_flags(regs->mstatus);
 	i_ctx->sepc = csr_read(CSR_SEPC);
 
+	sbi_trace(SBI_TRACE_SSE_INJECT, e->event_id, i_ctx->sepc, 0, 0);
+
 	regs->mstatus &= ~(MSTATUS_SPP | SSTATUS_SPIE);
 	if (regs->mstatus & MSTATUS_MPP)
 		regs->mstatus |= MSTATUS_SPP;
@@ -702,6 +808,10 @@ void sbi_sse_process_pending_events(struct sbi_trap_regs *regs)
 	struct sbi_sse_event *e;
 	struct sse_hart_state *state = sse_thishart_state_ptr();
 
+	/* Fast path: nothing pending on this hart */
+	if (!atomic_read(&state->pending_count))
+		return;
+
 	/* if sse is masked on this hart, do nothing */
 	if (state->masked)
 		return;
@@ -720,11 +830,21 @@ out:
 
 static int sse_event_set_pending(struct sbi_sse_event *e)
 {
+	struct sse_hart_state *state;
+
 	if (sse_event_state(e) != SBI_SSE_STATE_RUNNING &&
 	    sse_event_state(e) != SBI_SSE_STATE_ENABLED)
 		return SBI_EINVALID_STATE;
 
+	if (sse_event_pending(e))
+		return SBI_OK;
+
+	/* Event is in enabled_event_list so account it as pending there */
+	state = sse_get_hart_state(e);
+	spin_lock(&state->enabled_event_lock);
 	e->attrs.status |= BIT(SBI_SSE_ATTR_STATUS_PENDING_OFFSET);
+	atomic_add_return(&state->pending_count, 1);
+	spin_unlock(&state->enabled_event_lock);
 
 	return SBI_OK;
 }
@@ -832,6 +952,8 @@ static int sse_event_complete(struct sbi_sse_event *e,
 	if (e->attrs.hartid != current_hartid())
 		return SBI_EINVAL;
 
+	sbi_trace(SBI_TRACE_SSE_COMPLETE, e->event_id, 0, 0, 0);
+
 	sse_event_set_state(e, SBI_SSE_STATE_ENABLED);
 	if (e->attrs.config & SBI_SSE_ATTR_CONFIG_ONESHOT)
 		sse_event_disable(e);
@@ -1201,6 +1323,7 @@ static void sse_local_init(struct sse_hart_state *shs)
 
 	SBI_INIT_LIST_HEAD(&shs->enabled_event_list);
 	SPIN_LOCK_INIT(shs->enabled_event_lock);
+	ATOMIC_INIT(&shs->pending_count, 0);
 
 	SBI_SLIST_FOR_EACH_ENTRY(info, supported_events) {
 		if (EVENT_IS_GLOBAL(info->event_id))
@@ -1223,6 +1346,10 @@ int sbi_sse_init(struct sbi_scratch *scratch, bool cold_boot)
 		if (ret)
 			return ret;
 
+		ret = sse_event_slots_init();
+		if (ret)
+			return ret;
+
 		shs_ptr_off = sbi_scratch_alloc_offset(sizeof(void *));
 		if (!shs_ptr_off)
 			return SBI_ENOMEM;
@@ -157,6 +157,7 @@ int sbi_system_suspend(u32 sleep_type, ulong resume_addr, ulong opaque)
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 	void (*jump_warmboot)(void) = (void (*)(void))scratch->warmboot_addr;
 	unsigned int hartindex = current_hartindex();
+	struct sbi_hartmask assigned;
 	unsigned long prev_mode;
 	unsigned long i;
 	int ret;
@@ -176,16 +177,13 @@ int sbi_system_suspend(u32 sleep_type, ulong resume_addr, ulong opaque)
 	if (prev_mode != PRV_S && prev_mode != PRV_U)
 		return SBI_EFAIL;
 
-	spin_lock(&dom->assigned_harts_lock);
-	sbi_hartmask_for_each_hartindex(i, &dom->assigned_harts) {
+	sbi_domain_get_assigned_hartmask(dom, &assigned);
+	sbi_hartmask_for_each_hartindex(i, &assigned) {
 		if (i == hartindex)
 			continue;
-		if (__sbi_hsm_hart_get_state(i) != SBI_HSM_STATE_STOPPED) {
-			spin_unlock(&dom->assigned_harts_lock);
+		if (__sbi_hsm_hart_get_state(i) != SBI_HSM_STATE_STOPPED)
 			return SBI_ERR_DENIED;
-		}
 	}
-	spin_unlock(&dom->assigned_harts_lock);
 
 	if (!sbi_domain_check_addr(dom, resume_addr, prev_mode,
 				   SBI_DOMAIN_EXECUTE))
@@ -204,6 +202,15 @@ int sbi_system_suspend(u32 sleep_type, ulong resume_addr, ulong opaque)
 
 	/* Suspend */
 	system_suspended = true;
+
+	/* All HARTs lose their PMP setup when the system suspends */
+	sbi_for_each_hartindex(i) {
+		struct sbi_scratch *rscratch = sbi_hartindex_to_scratch(i);
+
+		if (rscratch)
+			sbi_init_mark_protection_lost(rscratch);
+	}
+
 	ret = suspend_dev->system_suspend(sleep_type, scratch->warmboot_addr);
 	if (ret != SBI_OK) {
 		if (!sbi_hsm_hart_change_state(scratch, SBI_HSM_STATE_SUSPENDED,
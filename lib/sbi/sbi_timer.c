@@ -46,10 +46,7 @@ static u64 get_ticks(void)
 #else
 static u64 get_ticks(void)
 {
-	unsigned long n;
-
-	__asm__ __volatile__("rdtime %0" : "=r"(n));
-	return n;
+	return csr_read(CSR_TIME);
 }
 #endif
 
@@ -191,7 +188,7 @@ static void __sbi_timer_event_start(struct timer_state *tstate,
 	ev->hart_index = current_hartindex();
 	ev->time_stamp = next_event;
 	if (next_ev)
-		sbi_list_add(&ev->head, &next_ev->head);
+		sbi_list_add_tail(&ev->head, &next_ev->head);
 	else
 		sbi_list_add_tail(&ev->head, &tstate->event_list);
 }
@@ -312,7 +309,7 @@ void sbi_timer_process(void)
 	}
 
 	while (!sbi_list_empty(&restart_list)) {
-		ev = sbi_list_first_entry(&tstate->event_list, struct sbi_timer_event, head);
+		ev = sbi_list_first_entry(&restart_list, struct sbi_timer_event, head);
 		sbi_list_del(&ev->head);
 		__sbi_timer_event_start(tstate, ev, ev->time_stamp);
 	}
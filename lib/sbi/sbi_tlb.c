@@ -18,6 +18,7 @@
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_hfence.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_console.h>
@@ -28,6 +29,7 @@ static unsigned long tlb_sync_off;
 static unsigned long tlb_fifo_off;
 static unsigned long tlb_fifo_mem_off;
 static unsigned long tlb_range_flush_limit;
+static atomic_t tlb_fifo_full_count = ATOMIC_INITIALIZER(0);
 
 void __sbi_sfence_vma_all(void)
 {
@@ -214,6 +216,8 @@ static void tlb_entry_process(struct sbi_tlb_info *tinfo)
 	struct sbi_scratch *rscratch = NULL;
 	atomic_t *rtlb_sync = NULL;
 
+	sbi_trace(SBI_TRACE_TLB_PROCESS, tinfo->type, tinfo->start,
+		  tinfo->size, 0);
 	tlb_entry_local_process(tinfo);
 
 	sbi_hartmask_for_each_hartindex(rindex, &tinfo->smask) {
@@ -362,6 +366,7 @@ static int tlb_update(struct sbi_scratch *scratch,
 		 * this properly.
 		 */
 		tlb_process_once(scratch);
+		atomic_add_return(&tlb_fifo_full_count, 1);
 		sbi_dprintf("hart%d: hart%d tlb fifo full\n", curr_hartid,
 			    sbi_hartindex_to_hartid(remote_hartindex));
 		return SBI_IPI_UPDATE_RETRY;
@@ -369,6 +374,9 @@ static int tlb_update(struct sbi_scratch *scratch,
 
 	tlb_sync = sbi_scratch_offset_ptr(scratch, tlb_sync_off);
 	atomic_add_return(tlb_sync, 1);
+	sbi_trace(SBI_TRACE_TLB_ENQUEUE,
+		  sbi_hartindex_to_hartid(remote_hartindex), tinfo->type,
+		  tinfo->start, tinfo->size);
 
 	return SBI_IPI_UPDATE_SUCCESS;
 }
@@ -392,6 +400,11 @@ static const u32 tlb_type_to_pmu_fw_event[SBI_TLB_TYPE_MAX] = {
 	[SBI_TLB_HFENCE_VVMA] = SBI_PMU_FW_HFENCE_VVMA_SENT,
 };
 
+unsigned long sbi_tlb_fifo_full_count(void)
+{
+	return atomic_read(&tlb_fifo_full_count);
+}
+
 int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo)
 {
 	if (tinfo->type < 0 || tinfo->type >= SBI_TLB_TYPE_MAX)
@@ -0,0 +1,239 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Per-HART rings of binary trace records.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_byteorder.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
+
+#ifndef CONFIG_SBI_TRACE_RING_ENTRIES
+#define CONFIG_SBI_TRACE_RING_ENTRIES	64
+#endif
+
+#define TRACE_RING_MASK		(CONFIG_SBI_TRACE_RING_ENTRIES - 1)
+
+_Static_assert((CONFIG_SBI_TRACE_RING_ENTRIES & TRACE_RING_MASK) == 0,
+	       "CONFIG_SBI_TRACE_RING_ENTRIES must be a power of two");
+
+/* Sequence number of an entry which is being written */
+#define TRACE_SEQ_BUSY		-1UL
+
+struct trace_entry {
+	unsigned long seq;
+	u64 time;
+	unsigned long event;
+	unsigned long args[SBI_TRACE_MAX_ARGS];
+};
+
+/*
+ * Only the owner HART writes to its ring but a nested trap can record
+ * an event in the middle of another one so slots are taken with an
+ * atomic increment. Readers on other HARTs detect entries which were
+ * overwritten while being copied using the sequence number.
+ */
+struct trace_ring {
+	atomic_t head;
+	struct trace_entry entries[CONFIG_SBI_TRACE_RING_ENTRIES];
+};
+
+unsigned long sbi_trace_events;
+
+static unsigned long trace_ring_offset;
+static spinlock_t trace_alloc_lock = SPIN_LOCK_INITIALIZER;
+static bool trace_rings_allocated;
+
+static struct trace_ring *trace_ring_ptr(struct sbi_scratch *scratch)
+{
+	if (!trace_ring_offset || !scratch)
+		return NULL;
+
+	return *(struct trace_ring **)sbi_scratch_offset_ptr(scratch,
+							    trace_ring_offset);
+}
+
+static void trace_ring_add(struct trace_ring *ring, u32 event, u64 time,
+			   const unsigned long *args)
+{
+	struct trace_entry *ent;
+	unsigned long seq;
+	u32 i;
+
+	seq = atomic_add_return(&ring->head, 1) - 1;
+	ent = &ring->entries[seq & TRACE_RING_MASK];
+
+	ent->seq = TRACE_SEQ_BUSY;
+	smp_wmb();
+	ent->time = time;
+	ent->event = event;
+	for (i = 0; i < SBI_TRACE_MAX_ARGS; i++)
+		ent->args[i] = args[i];
+	smp_wmb();
+	ent->seq = seq;
+}
+
+static int trace_ring_copy(struct trace_ring *ring, u32 hartid,
+			   unsigned long start, u32 count,
+			   struct sbi_trace_record *out, u32 *out_count)
+{
+	unsigned long head = atomic_read(&ring->head), seq;
+	struct trace_entry *ent;
+	u32 i, j;
+
+	if (start > head)
+		return SBI_EINVAL;
+
+	/* Skip records which were already overwritten */
+	if (head - start > CONFIG_SBI_TRACE_RING_ENTRIES)
+		start = head - CONFIG_SBI_TRACE_RING_ENTRIES;
+	if (count > head - start)
+		count = head - start;
+
+	for (i = 0; i < count; i++) {
+		ent = &ring->entries[(start + i) & TRACE_RING_MASK];
+		sbi_memset(&out[i], 0, sizeof(out[i]));
+		out[i].seq = cpu_to_le64(start + i);
+		out[i].hartid = cpu_to_le32(hartid);
+
+		seq = ent->seq;
+		smp_rmb();
+		out[i].time = cpu_to_le64(ent->time);
+		out[i].event = cpu_to_le32(ent->event);
+		for (j = 0; j < SBI_TRACE_MAX_ARGS; j++)
+			out[i].args[j] = cpu_to_le64(ent->args[j]);
+		smp_rmb();
+
+		if (seq != start + i || ent->seq != seq) {
+			sbi_memset(out[i].args, 0, sizeof(out[i].args));
+			out[i].time = 0;
+			out[i].event = cpu_to_le32(SBI_TRACE_EVENT_LOST);
+		}
+	}
+
+	*out_count = count;
+	return 0;
+}
+
+void __sbi_trace(u32 event, unsigned long arg0, unsigned long arg1,
+		 unsigned long arg2, unsigned long arg3)
+{
+	struct trace_ring *ring = trace_ring_ptr(sbi_scratch_thishart_ptr());
+	unsigned long args[SBI_TRACE_MAX_ARGS] = { arg0, arg1, arg2, arg3 };
+
+	if (ring)
+		trace_ring_add(ring, event, sbi_timer_value(), args);
+}
+
+/*
+ * Rings are only allocated when tracing is enabled for the first time
+ * so that firmware which never traces does not spend heap on them.
+ */
+static int trace_rings_alloc(void)
+{
+	struct sbi_scratch *rscratch;
+	struct trace_ring **ring;
+	int rc = 0;
+
+	spin_lock(&trace_alloc_lock);
+
+	if (trace_rings_allocated)
+		goto done;
+
+	sbi_for_each_hartindex(i) {
+		rscratch = sbi_hartindex_to_scratch(i);
+		if (!rscratch)
+			continue;
+
+		ring = sbi_scratch_offset_ptr(rscratch, trace_ring_offset);
+		if (*ring)
+			continue;
+		*ring = sbi_zalloc(sizeof(**ring));
+		if (!*ring) {
+			rc = SBI_ENOMEM;
+			goto done;
+		}
+	}
+
+	/* Rings must be visible before any event gets enabled */
+	smp_wmb();
+	trace_rings_allocated = true;
+
+done:
+	spin_unlock(&trace_alloc_lock);
+	return rc;
+}
+
+int sbi_trace_set_events(unsigned long events, unsigned long *prev_events)
+{
+	int rc;
+
+	if (events & ~SBI_TRACE_EVENT_ALL)
+		return SBI_EINVAL;
+	if (!trace_ring_offset)
+		return SBI_ENOTSUPP;
+
+	if (events) {
+		rc = trace_rings_alloc();
+		if (rc)
+			return rc;
+	}
+
+	*prev_events = atomic_raw_xchg_ulong(&sbi_trace_events, events);
+	return 0;
+}
+
+int sbi_trace_read_records(u32 hartid, unsigned long start, u32 count,
+			   unsigned long addr, u32 *out_count)
+{
+	struct sbi_trace_record *out = (struct sbi_trace_record *)addr;
+	struct sbi_scratch *scratch = sbi_hartid_to_scratch(hartid);
+	struct trace_ring *ring;
+	unsigned long size;
+	int rc;
+
+	if (!trace_ring_offset)
+		return SBI_ENOTSUPP;
+	if (!scratch)
+		return SBI_EINVAL;
+
+	/* Nothing was recorded if tracing was never enabled */
+	ring = trace_ring_ptr(scratch);
+	if (count > CONFIG_SBI_TRACE_RING_ENTRIES)
+		count = CONFIG_SBI_TRACE_RING_ENTRIES;
+	if (!ring || !count) {
+		*out_count = 0;
+		return 0;
+	}
+
+	size = count * sizeof(*out);
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(), addr, size,
+					 PRV_S,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	sbi_hart_protection_map_range(addr, size);
+	rc = trace_ring_copy(ring, hartid, start, count, out, out_count);
+	sbi_hart_protection_unmap_range(addr, size);
+
+	return rc;
+}
+
+int sbi_trace_init(struct sbi_scratch *scratch)
+{
+	trace_ring_offset = sbi_scratch_alloc_type_offset(struct trace_ring *);
+	if (!trace_ring_offset)
+		return SBI_ENOMEM;
+
+	return 0;
+}
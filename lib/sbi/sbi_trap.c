@@ -24,6 +24,7 @@
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_sse.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 
 static void sbi_trap_error_one(const struct sbi_trap_context *tcntx,
@@ -315,6 +316,8 @@ struct sbi_trap_context *sbi_trap_handler(struct sbi_trap_context *tcntx)
 	tcntx->prev_context = sbi_trap_get_context(scratch);
 	sbi_trap_set_context(scratch, tcntx);
 
+	sbi_trace(SBI_TRACE_TRAP_ENTRY, mcause, regs->mepc, trap->tval, 0);
+
 	if (mcause & MCAUSE_IRQ_MASK) {
 		if (sbi_hart_has_extension(sbi_scratch_thishart_ptr(),
 					   SBI_HART_EXT_SMAIA))
@@ -373,6 +376,8 @@ trap_done:
 	if (sbi_mstatus_prev_mode(regs->mstatus) != PRV_M)
 		sbi_sse_process_pending_events(regs);
 
+	sbi_trace(SBI_TRACE_TRAP_EXIT, mcause, regs->mepc, rc, 0);
+
 	sbi_trap_set_context(scratch, tcntx->prev_context);
 	return tcntx;
 }
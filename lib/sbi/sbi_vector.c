@@ -92,3 +92,30 @@ void sbi_vector_restore(const struct sbi_vector_context *src)
 	/* Step 4. Restore original mstatus LAST */
 	csr_write(CSR_MSTATUS, mstatus_orig);
 }
+
+void sbi_vector_clear(void)
+{
+	unsigned long vl, mstatus_orig;
+
+	/* Step 1. Save original mstatus and Enable VS */
+	mstatus_orig = csr_read_set(CSR_MSTATUS, MSTATUS_VS);
+
+	/* Step 2: Zero vector registers with the widest register groups */
+	asm volatile(
+		"	.option push\n\t"
+		"	.option arch, +v\n\t"
+		"	vsetvli %0, zero, e8, m8, ta, ma\n\t"
+		"	vmv.v.i v0, 0\n\t"
+		"	vmv.v.i v8, 0\n\t"
+		"	vmv.v.i v16, 0\n\t"
+		"	vmv.v.i v24, 0\n\t"
+		"	.option pop\n\t"
+		: "=r"(vl) : : "memory");
+
+	/* Step 3: Clear CSRs */
+	csr_write(vcsr, 0);
+	csr_write(vstart, 0);
+
+	/* Step 4. Restore original mstatus LAST */
+	csr_write(CSR_MSTATUS, mstatus_orig);
+}
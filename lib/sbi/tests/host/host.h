@@ -0,0 +1,45 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host build of the portable parts of libsbi.
+ *
+ * This header is shared between the code built against the OpenSBI
+ * headers and the code built against the C library so it must not
+ * include either of them.
+ */
+
+#ifndef __HOST_H__
+#define __HOST_H__
+
+/** Number of fake HARTs described by the host platform */
+#define HOST_HART_COUNT		4
+
+/** Size of the heap backing sbi_malloc() and friends */
+#define HOST_HEAP_SIZE		(1UL << 20)
+
+/** Frequency of the fake timer device */
+#define HOST_TIMER_FREQ		10000000UL
+
+/* Provided by host_libc.c */
+void host_putc(char ch);
+void __attribute__((noreturn)) host_exit(int status);
+unsigned long host_clock_ns(void);
+
+/* Provided by host_platform.c */
+
+/** Set up scratch space, heap, console, timer and PMU of HART 0 */
+int host_init(void);
+
+/** Make the given HART index the current one for per-HART state */
+void host_set_hartindex(unsigned int hartindex);
+
+/** Current value of the fake timer device */
+unsigned long long host_timer_get(void);
+
+/** Move the fake timer device forward */
+void host_timer_advance(unsigned long long ticks);
+
+/** Deadline last programmed into the fake timer device or -1 if stopped */
+unsigned long long host_timer_deadline(void);
+
+#endif
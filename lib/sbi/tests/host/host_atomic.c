@@ -0,0 +1,222 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host shim: atomics and locks on top of the compiler __atomic builtins.
+ */
+
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_bitops.h>
+
+long atomic_read(atomic_t *atom)
+{
+	return __atomic_load_n(&atom->counter, __ATOMIC_ACQUIRE);
+}
+
+void atomic_write(atomic_t *atom, long value)
+{
+	__atomic_store_n(&atom->counter, value, __ATOMIC_RELEASE);
+}
+
+long atomic_add_return(atomic_t *atom, long value)
+{
+	return __atomic_add_fetch(&atom->counter, value, __ATOMIC_SEQ_CST);
+}
+
+long atomic_sub_return(atomic_t *atom, long value)
+{
+	return __atomic_sub_fetch(&atom->counter, value, __ATOMIC_SEQ_CST);
+}
+
+long atomic_cmpxchg(atomic_t *atom, long oldval, long newval)
+{
+	__atomic_compare_exchange_n(&atom->counter, &oldval, newval, false,
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return oldval;
+}
+
+long atomic_xchg(atomic_t *atom, long newval)
+{
+	return __atomic_exchange_n(&atom->counter, newval, __ATOMIC_SEQ_CST);
+}
+
+#define HOST_RAW_XCHG(__name, __type)					\
+__type atomic_raw_xchg_##__name(volatile __type *ptr, __type newval)	\
+{									\
+	return __atomic_exchange_n(ptr, newval, __ATOMIC_SEQ_CST);	\
+}
+
+#define HOST_RAW_CMPXCHG(__name, __type)				\
+__type atomic_raw_cmpxchg_##__name(volatile __type *ptr,		\
+				   __type oldval, __type newval)	\
+{									\
+	__atomic_compare_exchange_n(ptr, &oldval, newval, false,	\
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);\
+	return oldval;							\
+}
+
+HOST_RAW_XCHG(uint, unsigned int)
+HOST_RAW_XCHG(ulong, unsigned long)
+HOST_RAW_XCHG(u8, u8)
+HOST_RAW_XCHG(u16, u16)
+HOST_RAW_CMPXCHG(uint, unsigned int)
+HOST_RAW_CMPXCHG(ulong, unsigned long)
+HOST_RAW_CMPXCHG(u8, u8)
+HOST_RAW_CMPXCHG(u16, u16)
+
+/* One lock is enough, the double word helpers are not hot on the host */
+static spinlock_t host_double_lock = SPIN_LOCK_INITIALIZER;
+
+bool atomic_double_cmpxchg(atomic_double_t *atom,
+			   unsigned long *oldlo, unsigned long *oldhi,
+			   unsigned long newlo, unsigned long newhi)
+{
+	bool ret = false;
+
+	spin_lock(&host_double_lock);
+	if (atom->lo == *oldlo && atom->hi == *oldhi) {
+		atom->lo = newlo;
+		atom->hi = newhi;
+		ret = true;
+	} else {
+		*oldlo = atom->lo;
+		*oldhi = atom->hi;
+	}
+	spin_unlock(&host_double_lock);
+
+	return ret;
+}
+
+void atomic_double_read(atomic_double_t *atom,
+			unsigned long *lo, unsigned long *hi)
+{
+	spin_lock(&host_double_lock);
+	*lo = atom->lo;
+	*hi = atom->hi;
+	spin_unlock(&host_double_lock);
+}
+
+void atomic_double_write(atomic_double_t *atom,
+			 unsigned long lo, unsigned long hi)
+{
+	spin_lock(&host_double_lock);
+	atom->lo = lo;
+	atom->hi = hi;
+	spin_unlock(&host_double_lock);
+}
+
+int atomic_raw_set_bit(int nr, volatile unsigned long *addr)
+{
+	unsigned long mask = BIT_MASK(nr);
+
+	addr += BIT_WORD(nr);
+	return (__atomic_fetch_or(addr, mask, __ATOMIC_SEQ_CST) & mask) ? 1 : 0;
+}
+
+int atomic_raw_clear_bit(int nr, volatile unsigned long *addr)
+{
+	unsigned long mask = BIT_MASK(nr);
+
+	addr += BIT_WORD(nr);
+	return (__atomic_fetch_and(addr, ~mask, __ATOMIC_SEQ_CST) & mask) ? 1 : 0;
+}
+
+int atomic_set_bit(int nr, atomic_t *atom)
+{
+	return atomic_raw_set_bit(nr, (unsigned long *)&atom->counter);
+}
+
+int atomic_clear_bit(int nr, atomic_t *atom)
+{
+	return atomic_raw_clear_bit(nr, (unsigned long *)&atom->counter);
+}
+
+bool spin_lock_check(spinlock_t *lock)
+{
+	spinlock_t snap;
+
+	__atomic_load(lock, &snap, __ATOMIC_ACQUIRE);
+	return snap.owner != snap.next;
+}
+
+bool spin_trylock(spinlock_t *lock)
+{
+	spinlock_t oldval, newval;
+
+	__atomic_load(lock, &oldval, __ATOMIC_RELAXED);
+	if (oldval.owner != oldval.next)
+		return false;
+
+	newval = oldval;
+	newval.next++;
+	return __atomic_compare_exchange(lock, &oldval, &newval, false,
+					 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void spin_lock(spinlock_t *lock)
+{
+	u16 ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+
+	while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+		;
+}
+
+void spin_unlock(spinlock_t *lock)
+{
+	__atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+void write_seqlock(seqlock_t *sl)
+{
+	spin_lock(&sl->lock);
+	sl->sequence++;
+	RISCV_FENCE(w, w);
+}
+
+void write_sequnlock(seqlock_t *sl)
+{
+	RISCV_FENCE(w, w);
+	sl->sequence++;
+	spin_unlock(&sl->lock);
+}
+
+bool read_trylock(rwlock_t *lock)
+{
+	long count = atomic_read(&lock->count);
+
+	while (0 <= count) {
+		if (atomic_cmpxchg(&lock->count, count, count + 1) == count)
+			return true;
+		count = atomic_read(&lock->count);
+	}
+
+	return false;
+}
+
+void read_lock(rwlock_t *lock)
+{
+	while (!read_trylock(lock))
+		;
+}
+
+void read_unlock(rwlock_t *lock)
+{
+	atomic_sub_return(&lock->count, 1);
+}
+
+bool write_trylock(rwlock_t *lock)
+{
+	return atomic_cmpxchg(&lock->count, 0, -1) == 0;
+}
+
+void write_lock(rwlock_t *lock)
+{
+	while (!write_trylock(lock))
+		;
+}
+
+void write_unlock(rwlock_t *lock)
+{
+	atomic_write(&lock->count, 0);
+}
@@ -0,0 +1,284 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Single threaded micro benchmarks of libsbi data structures on the
+ * host. The numbers are only meaningful relative to each other and to
+ * earlier runs on the same machine.
+ *
+ * Usage: sbi_host_bench [iterations]
+ */
+
+#include <sbi/riscv_encoding.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_fifo.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_irqchip.h>
+#include <sbi/sbi_qspinlock.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+
+#include "host.h"
+
+#define BENCH_DEFAULT_ITERATIONS	1000000
+#define BENCH_FIFO_ENTRIES		16
+#define BENCH_TIMER_EVENTS		8
+#define BENCH_IRQCHIP_ID		0xfffffff0U
+#define BENCH_IRQCHIP_NUM_HWIRQ		256
+#define BENCH_IRQCHIP_HANDLERS		64
+
+struct host_bench {
+	const char *name;
+	void (*run)(unsigned long iterations);
+};
+
+static volatile unsigned long bench_sink;
+
+static u8 bench_fifo_mem[BENCH_FIFO_ENTRIES * 16] __aligned(8);
+
+static void bench_fifo(unsigned long iterations)
+{
+	u8 in[16] = { 0 }, out[16];
+	struct sbi_fifo fifo;
+	unsigned long i;
+
+	sbi_fifo_init(&fifo, bench_fifo_mem, BENCH_FIFO_ENTRIES, sizeof(in));
+
+	/* Keep the queue half full so head and tail both wrap */
+	for (i = 0; i < BENCH_FIFO_ENTRIES / 2; i++)
+		sbi_fifo_enqueue(&fifo, in, false);
+
+	for (i = 0; i < iterations; i++) {
+		in[0] = i;
+		sbi_fifo_enqueue(&fifo, in, false);
+		sbi_fifo_dequeue(&fifo, out);
+		bench_sink += out[0];
+	}
+}
+
+static void bench_heap(unsigned long iterations)
+{
+	void *ptrs[4];
+	unsigned long i;
+	u32 j;
+
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < array_size(ptrs); j++)
+			ptrs[j] = sbi_malloc(32 + 64 * j);
+		for (j = 0; j < array_size(ptrs); j++)
+			sbi_free(ptrs[j]);
+	}
+}
+
+static struct sbi_domain_memregion bench_regions[] = {
+	{ .order = 19, .base = 0x80000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_EXECUTABLE |
+		   SBI_DOMAIN_MEMREGION_FW },
+	{ .order = 19, .base = 0x80080000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_WRITABLE |
+		   SBI_DOMAIN_MEMREGION_FW },
+	{ .order = 12, .base = 0x02000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_MMIO |
+		   SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_WRITABLE },
+	{ .order = 22, .base = 0x0c000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_MMIO |
+		   SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_WRITABLE },
+	{ .order = 12, .base = 0x10000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_MMIO |
+		   SBI_DOMAIN_MEMREGION_SHARED_SURW_MRW },
+	{ .order = __riscv_xlen, .base = 0,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_RWX },
+	{ .order = 0 },
+};
+
+static void bench_domain_check(unsigned long iterations, bool indexed)
+{
+	struct sbi_domain dom;
+	unsigned long i;
+
+	sbi_memset(&dom, 0, sizeof(dom));
+	dom.regions = bench_regions;
+	if (indexed && sbi_domain_build_addr_lookup(&dom))
+		return;
+
+	/* Addresses in the last region are the worst case for a linear walk */
+	for (i = 0; i < iterations; i++)
+		bench_sink += sbi_domain_check_addr(&dom,
+					0x80200000UL + (i & 0xfff) * 8,
+					PRV_S, SBI_DOMAIN_READ);
+
+	sbi_free(dom.addr_intervals);
+}
+
+static void bench_domain_linear(unsigned long iterations)
+{
+	bench_domain_check(iterations, false);
+}
+
+static void bench_domain_indexed(unsigned long iterations)
+{
+	bench_domain_check(iterations, true);
+}
+
+static void bench_timer_callback(struct sbi_timer_event *ev,
+				 struct sbi_timer_event_restart *restart)
+{
+}
+
+static void bench_timer_event(unsigned long iterations)
+{
+	struct sbi_timer_event events[BENCH_TIMER_EVENTS + 1];
+	u64 now = host_timer_get();
+	unsigned long i;
+	u32 j;
+
+	for (j = 0; j <= BENCH_TIMER_EVENTS; j++)
+		SBI_INIT_TIMER_EVENT(&events[j], bench_timer_callback,
+				     NULL, NULL);
+
+	/* Insert into the middle of a queue of pending events */
+	for (j = 0; j < BENCH_TIMER_EVENTS; j++)
+		sbi_timer_event_start(&events[j], now + 1000 * (j + 1));
+
+	for (i = 0; i < iterations; i++) {
+		sbi_timer_event_start(&events[BENCH_TIMER_EVENTS],
+				      now + 500 * BENCH_TIMER_EVENTS);
+		sbi_timer_event_stop(&events[BENCH_TIMER_EVENTS]);
+	}
+
+	for (j = 0; j < BENCH_TIMER_EVENTS; j++)
+		sbi_timer_event_stop(&events[j]);
+}
+
+static int bench_irqchip_callback(u32 hwirq, void *priv)
+{
+	bench_sink += hwirq;
+	return 0;
+}
+
+static int bench_irqchip_set_affinity(struct sbi_irqchip_device *chip,
+				      u32 hwirq, u32 hart_index)
+{
+	return 0;
+}
+
+static struct sbi_irqchip_device bench_chip = {
+	.id			= BENCH_IRQCHIP_ID,
+	.num_hwirq		= BENCH_IRQCHIP_NUM_HWIRQ,
+	.hwirq_set_affinity	= bench_irqchip_set_affinity,
+};
+
+static void bench_irqchip_dispatch(unsigned long iterations, u32 hwirq)
+{
+	u32 j, step = BENCH_IRQCHIP_NUM_HWIRQ / BENCH_IRQCHIP_HANDLERS;
+	unsigned long i;
+
+	sbi_hartmask_set_hartindex(0, &bench_chip.target_harts);
+	if (sbi_irqchip_add_device(&bench_chip))
+		return;
+
+	for (j = 0; j < BENCH_IRQCHIP_HANDLERS; j++)
+		sbi_irqchip_register_handler(&bench_chip, j * step, step,
+					     SBI_HWIRQ_FLAGS_NONE,
+					     bench_irqchip_callback, NULL);
+
+	for (i = 0; i < iterations; i++)
+		bench_sink += sbi_irqchip_process_hwirq(&bench_chip, hwirq);
+
+	for (j = 0; j < BENCH_IRQCHIP_HANDLERS; j++)
+		sbi_irqchip_unregister_handler(&bench_chip, j * step, step);
+	sbi_irqchip_remove_device(&bench_chip);
+}
+
+/* Both lookups cost the same when handlers are found through the table */
+static void bench_irqchip_first(unsigned long iterations)
+{
+	bench_irqchip_dispatch(iterations, 0);
+}
+
+static void bench_irqchip_last(unsigned long iterations)
+{
+	bench_irqchip_dispatch(iterations, BENCH_IRQCHIP_NUM_HWIRQ - 1);
+}
+
+static spinlock_t bench_ticket_lock = SPIN_LOCK_INITIALIZER;
+static qspinlock_t bench_queued_lock = QSPIN_LOCK_INITIALIZER;
+
+static void bench_ticket_lock_run(unsigned long iterations)
+{
+	unsigned long i;
+
+	for (i = 0; i < iterations; i++) {
+		spin_lock(&bench_ticket_lock);
+		bench_sink++;
+		spin_unlock(&bench_ticket_lock);
+	}
+}
+
+static void bench_queued_lock_run(unsigned long iterations)
+{
+	unsigned long i;
+
+	for (i = 0; i < iterations; i++) {
+		qspin_lock(&bench_queued_lock);
+		bench_sink++;
+		qspin_unlock(&bench_queued_lock);
+	}
+}
+
+static const struct host_bench host_benches[] = {
+	{ "fifo enqueue+dequeue", bench_fifo },
+	{ "heap 4x malloc+free", bench_heap },
+	{ "domain check linear", bench_domain_linear },
+	{ "domain check indexed", bench_domain_indexed },
+	{ "timer event start+stop", bench_timer_event },
+	{ "irqchip dispatch first", bench_irqchip_first },
+	{ "irqchip dispatch last", bench_irqchip_last },
+	{ "ticket lock+unlock", bench_ticket_lock_run },
+	{ "queued lock+unlock", bench_queued_lock_run },
+};
+
+static unsigned long bench_parse_ulong(const char *str)
+{
+	unsigned long val = 0;
+
+	while (*str >= '0' && *str <= '9')
+		val = val * 10 + (*str++ - '0');
+
+	return val;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long iterations = BENCH_DEFAULT_ITERATIONS, start, ns;
+	u32 i;
+	int rc;
+
+	rc = host_init();
+	if (rc) {
+		sbi_printf("host: init failed (error %d)\n", rc);
+		return 1;
+	}
+
+	if (argc > 1)
+		iterations = bench_parse_ulong(argv[1]);
+	if (!iterations)
+		iterations = BENCH_DEFAULT_ITERATIONS;
+
+	sbi_printf("Host bench: %lu iterations\n", iterations);
+	for (i = 0; i < array_size(host_benches); i++) {
+		start = host_clock_ns();
+		host_benches[i].run(iterations);
+		ns = host_clock_ns() - start;
+		sbi_printf("%-24s %8lu ns total %6lu.%02lu ns/iter\n",
+			   host_benches[i].name, ns, ns / iterations,
+			   (ns % iterations) * 100 / iterations);
+	}
+
+	return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Fuzz target checking the indexed domain address lookup against the
+ * linear first-match walk over the memory regions.
+ *
+ * Each region takes 10 bytes of input: an 8 byte base, one byte of
+ * order and one byte of flags. Bases are aligned down to the order so
+ * that every region is naturally aligned like the ones built by
+ * sbi_domain_root_add_memrange().
+ */
+
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_string.h>
+
+#include "host.h"
+
+#define FUZZ_REGION_BYTES	10
+#define FUZZ_MAX_REGIONS	16
+
+static const unsigned long fuzz_modes[] = {
+	PRV_M, PRV_S, PRV_U,
+};
+
+static const unsigned long fuzz_access[] = {
+	SBI_DOMAIN_READ,
+	SBI_DOMAIN_WRITE,
+	SBI_DOMAIN_EXECUTE,
+	SBI_DOMAIN_READ | SBI_DOMAIN_MMIO,
+	SBI_DOMAIN_WRITE | SBI_DOMAIN_MMIO,
+};
+
+static struct sbi_domain_memregion fuzz_regions[FUZZ_MAX_REGIONS + 1];
+static struct sbi_domain fuzz_dom;
+
+static unsigned long fuzz_get_ulong(const u8 *data)
+{
+	unsigned long val = 0;
+	u32 i;
+
+	for (i = 0; i < sizeof(val); i++)
+		val |= (unsigned long)data[i] << (8 * i);
+
+	return val;
+}
+
+static void fuzz_check_addr(unsigned long addr)
+{
+	struct sbi_domain_addr_interval *iv = fuzz_dom.addr_intervals;
+	unsigned long size;
+	bool linear, indexed;
+	u32 m, a;
+
+	for (m = 0; m < array_size(fuzz_modes); m++) {
+		for (a = 0; a < array_size(fuzz_access); a++) {
+			fuzz_dom.addr_intervals = NULL;
+			linear = sbi_domain_check_addr(&fuzz_dom, addr,
+					fuzz_modes[m], fuzz_access[a]);
+			fuzz_dom.addr_intervals = iv;
+			indexed = sbi_domain_check_addr(&fuzz_dom, addr,
+					fuzz_modes[m], fuzz_access[a]);
+			if (linear != indexed)
+				__builtin_trap();
+
+			/* Ranges up to the end of the address space */
+			size = -addr < 0x10000 ? -addr : 0x10000;
+			if (!size)
+				continue;
+			fuzz_dom.addr_intervals = NULL;
+			linear = sbi_domain_check_addr_range(&fuzz_dom, addr,
+					size, fuzz_modes[m], fuzz_access[a]);
+			fuzz_dom.addr_intervals = iv;
+			indexed = sbi_domain_check_addr_range(&fuzz_dom, addr,
+					size, fuzz_modes[m], fuzz_access[a]);
+			if (linear != indexed)
+				__builtin_trap();
+		}
+	}
+}
+
+int LLVMFuzzerTestOneInput(const u8 *data, size_t size)
+{
+	static bool initialized;
+	struct sbi_domain_memregion *reg;
+	unsigned long order, end;
+	u32 i, count;
+
+	if (!initialized) {
+		if (host_init())
+			__builtin_trap();
+		initialized = true;
+	}
+
+	count = size / FUZZ_REGION_BYTES;
+	if (!count)
+		return 0;
+	if (count > FUZZ_MAX_REGIONS)
+		count = FUZZ_MAX_REGIONS;
+
+	for (i = 0; i < count; i++, data += FUZZ_REGION_BYTES) {
+		reg = &fuzz_regions[i];
+		order = 3 + data[8] % (__riscv_xlen - 2);
+		reg->order = order;
+		reg->base = (order < __riscv_xlen) ?
+			    fuzz_get_ulong(data) & ~(BIT(order) - 1) : 0;
+		reg->flags = data[9] & (SBI_DOMAIN_MEMREGION_ACCESS_MASK |
+					SBI_DOMAIN_MEMREGION_ENF_PERMISSIONS);
+		if (data[9] & BIT(7))
+			reg->flags |= SBI_DOMAIN_MEMREGION_MMIO;
+	}
+	sbi_memset(&fuzz_regions[count], 0, sizeof(fuzz_regions[count]));
+
+	sbi_memset(&fuzz_dom, 0, sizeof(fuzz_dom));
+	fuzz_dom.regions = fuzz_regions;
+	if (sbi_domain_build_addr_lookup(&fuzz_dom))
+		__builtin_trap();
+
+	/* Lookups only change at region boundaries so probe around them */
+	fuzz_check_addr(0);
+	fuzz_check_addr(-1UL);
+	sbi_domain_for_each_memregion(&fuzz_dom, reg) {
+		end = (reg->order < __riscv_xlen) ?
+		      reg->base + (BIT(reg->order) - 1) : -1UL;
+		fuzz_check_addr(reg->base - 1);
+		fuzz_check_addr(reg->base);
+		fuzz_check_addr(end);
+		fuzz_check_addr(end + 1);
+	}
+
+	sbi_free(fuzz_dom.addr_intervals);
+	return 0;
+}
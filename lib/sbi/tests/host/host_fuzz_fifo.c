@@ -0,0 +1,131 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Fuzz target running a sequence of FIFO operations against a simple
+ * reference model.
+ *
+ * The first input byte selects the number of entries, every following
+ * pair of bytes is one operation and its argument.
+ */
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fifo.h>
+
+#define FUZZ_FIFO_MAX_ENTRIES	16
+
+enum fuzz_fifo_op {
+	FUZZ_FIFO_ENQUEUE = 0,
+	FUZZ_FIFO_ENQUEUE_FORCE,
+	FUZZ_FIFO_DEQUEUE,
+	FUZZ_FIFO_UPDATE,
+	FUZZ_FIFO_OP_MAX,
+};
+
+static u32 fuzz_fifo_mem[FUZZ_FIFO_MAX_ENTRIES];
+static struct sbi_fifo fuzz_fifo;
+
+/* Reference model, entry i is the i-th oldest one */
+static u32 model[FUZZ_FIFO_MAX_ENTRIES];
+static u32 model_count;
+
+static void model_push(u32 val)
+{
+	model[model_count++] = val;
+}
+
+static u32 model_pop(void)
+{
+	u32 i, val = model[0];
+
+	for (i = 1; i < model_count; i++)
+		model[i - 1] = model[i];
+	model_count--;
+
+	return val;
+}
+
+/* Replace the oldest entry with the same low byte as the input */
+static int fuzz_fifo_update(void *in, void *data)
+{
+	u32 *val = in, *entry = data;
+
+	if ((*entry & 0xff) != (*val & 0xff))
+		return SBI_FIFO_UNCHANGED;
+
+	*entry = *val;
+	return SBI_FIFO_UPDATED;
+}
+
+int LLVMFuzzerTestOneInput(const u8 *data, size_t size)
+{
+	u32 i, val, out, entries;
+	int rc, expected;
+
+	if (!size)
+		return 0;
+
+	entries = 1 + data[0] % FUZZ_FIFO_MAX_ENTRIES;
+	sbi_fifo_init(&fuzz_fifo, fuzz_fifo_mem, entries, sizeof(u32));
+	model_count = 0;
+
+	for (i = 1; i + 1 < size; i += 2) {
+		val = ((u32)i << 8) | data[i + 1];
+
+		switch (data[i] % FUZZ_FIFO_OP_MAX) {
+		case FUZZ_FIFO_ENQUEUE:
+			rc = sbi_fifo_enqueue(&fuzz_fifo, &val, false);
+			expected = (model_count == entries) ? SBI_ENOSPC : 0;
+			if (rc != expected)
+				__builtin_trap();
+			if (!rc)
+				model_push(val);
+			break;
+		case FUZZ_FIFO_ENQUEUE_FORCE:
+			if (sbi_fifo_enqueue(&fuzz_fifo, &val, true))
+				__builtin_trap();
+			if (model_count == entries)
+				model_pop();
+			model_push(val);
+			break;
+		case FUZZ_FIFO_DEQUEUE:
+			rc = sbi_fifo_dequeue(&fuzz_fifo, &out);
+			if (!model_count) {
+				if (rc != SBI_ENOENT)
+					__builtin_trap();
+				break;
+			}
+			if (rc || out != model_pop())
+				__builtin_trap();
+			break;
+		case FUZZ_FIFO_UPDATE:
+			rc = sbi_fifo_inplace_update(&fuzz_fifo, &val,
+						     fuzz_fifo_update);
+			expected = SBI_FIFO_UNCHANGED;
+			for (out = 0; out < model_count; out++) {
+				if ((model[out] & 0xff) == (val & 0xff)) {
+					model[out] = val;
+					expected = SBI_FIFO_UPDATED;
+					break;
+				}
+			}
+			if (rc != expected)
+				__builtin_trap();
+			break;
+		}
+
+		if (sbi_fifo_avail(&fuzz_fifo) != model_count ||
+		    !sbi_fifo_is_empty(&fuzz_fifo) != !!model_count ||
+		    !sbi_fifo_is_full(&fuzz_fifo) != (model_count != entries))
+			__builtin_trap();
+	}
+
+	/* Drain and compare whatever is left */
+	while (model_count) {
+		if (sbi_fifo_dequeue(&fuzz_fifo, &out) || out != model_pop())
+			__builtin_trap();
+	}
+	if (sbi_fifo_dequeue(&fuzz_fifo, &out) != SBI_ENOENT)
+		__builtin_trap();
+
+	return 0;
+}
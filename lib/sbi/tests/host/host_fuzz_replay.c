@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Stand-alone driver for the fuzz targets when libFuzzer is not
+ * available. It replays the input files given on the command line and
+ * then runs a number of pseudo random inputs.
+ *
+ * Usage: sbi_host_fuzz_<name>_replay [-n <runs>] [-s <seed>] [files...]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAX_INPUT	4096
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint8_t replay_buf[REPLAY_MAX_INPUT];
+
+static int replay_file(const char *path)
+{
+	size_t size;
+	FILE *f;
+
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	size = fread(replay_buf, 1, sizeof(replay_buf), f);
+	fclose(f);
+
+	LLVMFuzzerTestOneInput(replay_buf, size);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long runs = 100000, seed = 1, i, j;
+	size_t size;
+	int files = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			runs = strtoul(argv[++i], NULL, 0);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			seed = strtoul(argv[++i], NULL, 0);
+		} else {
+			if (replay_file(argv[i]))
+				return 1;
+			files++;
+		}
+	}
+
+	srand(seed);
+	for (i = 0; i < runs; i++) {
+		size = rand() % 256;
+		for (j = 0; j < size; j++)
+			replay_buf[j] = rand();
+		LLVMFuzzerTestOneInput(replay_buf, size);
+	}
+
+	printf("%s: %d files, %lu random inputs (seed %lu) passed\n",
+	       argv[0], files, runs, seed);
+	return 0;
+}
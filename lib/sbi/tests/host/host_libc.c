@@ -0,0 +1,32 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host shim: the only file built against the C library.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "host.h"
+
+void host_putc(char ch)
+{
+	putchar(ch);
+	if (ch == '\n')
+		fflush(stdout);
+}
+
+void host_exit(int status)
+{
+	fflush(stdout);
+	exit(status);
+}
+
+unsigned long host_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
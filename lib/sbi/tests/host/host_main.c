@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Run the SBIUNIT test suites as a host program.
+ */
+
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_unit_test.h>
+
+#include "host.h"
+
+int main(void)
+{
+	int rc;
+
+	rc = host_init();
+	if (rc) {
+		sbi_printf("host: init failed (error %d)\n", rc);
+		return 1;
+	}
+
+	return run_all_tests() ? 1 : 0;
+}
@@ -0,0 +1,319 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host shim: fake platform, CSR file and stubs for the parts of libsbi
+ * which are not built for the host.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_domain_data.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_hsm.h>
+#include <sbi/sbi_platform.h>
+#include <sbi/sbi_pmu.h>
+#include <sbi/sbi_qspinlock.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_sse.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_version.h>
+
+#include "host.h"
+
+#define HOST_CSR_COUNT		4096
+
+/* Programmable HPM counters 3 to 18 */
+#define HOST_MHPM_MASK		0x7fff8
+
+static unsigned int host_hartindex;
+static unsigned long host_csrs[HOST_HART_COUNT][HOST_CSR_COUNT];
+
+static u8 host_scratch_mem[HOST_HART_COUNT][SBI_SCRATCH_SIZE]
+				__aligned(SBI_SCRATCH_SIZE);
+static u8 host_heap_mem[HOST_HEAP_SIZE] __aligned(HEAP_BASE_ALIGN);
+
+static u64 host_timer_value;
+static u64 host_timer_next = -1ULL;
+
+unsigned long host_csr_rmw(int csr, unsigned long set, unsigned long clear,
+			   int write)
+{
+	unsigned long *val, ret;
+
+	switch (csr) {
+	case CSR_CYCLE:
+	case CSR_MCYCLE:
+	case CSR_INSTRET:
+	case CSR_MINSTRET:
+		return host_clock_ns();
+	case CSR_TIME:
+		return host_timer_value;
+	default:
+		break;
+	}
+
+	val = &host_csrs[host_hartindex][csr & (HOST_CSR_COUNT - 1)];
+	ret = *val;
+	if (write)
+		*val = (ret & ~clear) | set;
+
+	return ret;
+}
+
+unsigned long csr_read_num(int csr_num)
+{
+	return csr_read(csr_num);
+}
+
+void csr_write_num(int csr_num, unsigned long val)
+{
+	csr_write(csr_num, val);
+}
+
+static void host_console_putc(char ch)
+{
+	host_putc(ch);
+}
+
+static struct sbi_console_device host_console = {
+	.name = "host",
+	.console_putc = host_console_putc,
+};
+
+static u64 host_timer_device_value(void)
+{
+	return host_timer_value;
+}
+
+static void host_timer_event_start(u64 next_event)
+{
+	host_timer_next = next_event;
+}
+
+static void host_timer_event_stop(void)
+{
+	host_timer_next = -1ULL;
+}
+
+static struct sbi_timer_device host_timer = {
+	.name = "host",
+	.timer_freq = HOST_TIMER_FREQ,
+	.timer_value = host_timer_device_value,
+	.timer_event_start = host_timer_event_start,
+	.timer_event_stop = host_timer_event_stop,
+};
+
+unsigned long long host_timer_get(void)
+{
+	return host_timer_value;
+}
+
+void host_timer_advance(unsigned long long ticks)
+{
+	host_timer_value += ticks;
+}
+
+unsigned long long host_timer_deadline(void)
+{
+	return host_timer_next;
+}
+
+static u64 host_pmu_xlate_to_mhpmevent(u32 event_idx, u64 data)
+{
+	/* Raw events carry the selector, everything else uses the index */
+	return data ? data : event_idx;
+}
+
+static bool host_single_fw_region(void)
+{
+	/* The heap stands in for the whole firmware */
+	return true;
+}
+
+static const struct sbi_platform_operations host_platform_ops = {
+	.single_fw_region = host_single_fw_region,
+	.pmu_xlate_to_mhpmevent = host_pmu_xlate_to_mhpmevent,
+};
+
+static const struct sbi_platform host_platform = {
+	.opensbi_version = OPENSBI_VERSION,
+	.name = "Host",
+	.hart_count = HOST_HART_COUNT,
+	.hart_stack_size = SBI_SCRATCH_SIZE,
+	.platform_ops_addr = (unsigned long)&host_platform_ops,
+};
+
+static struct sbi_scratch *host_hartid_to_scratch(ulong hartid, ulong hartindex)
+{
+	return (struct sbi_scratch *)host_scratch_mem[hartindex];
+}
+
+void host_set_hartindex(unsigned int hartindex)
+{
+	host_hartindex = hartindex;
+}
+
+int host_init(void)
+{
+	struct sbi_scratch *scratch;
+	unsigned int i;
+	int rc;
+
+	for (i = 0; i < HOST_HART_COUNT; i++) {
+		scratch = host_hartid_to_scratch(i, i);
+		scratch->fw_start = (unsigned long)host_heap_mem;
+		scratch->fw_size = sizeof(host_heap_mem);
+		scratch->fw_heap_size = sizeof(host_heap_mem);
+		scratch->platform_addr = (unsigned long)&host_platform;
+		scratch->hartid_to_scratch = (unsigned long)host_hartid_to_scratch;
+		scratch->hartindex = i;
+		host_csrs[i][CSR_MHARTID] = i;
+		host_csrs[i][CSR_MSCRATCH] = (unsigned long)scratch;
+		host_csrs[i][CSR_MCOUNTINHIBIT] = 0xFFFFFFF8;
+	}
+
+	host_set_hartindex(0);
+	scratch = sbi_scratch_thishart_ptr();
+
+	rc = sbi_scratch_init(scratch);
+	if (rc)
+		return rc;
+
+	rc = sbi_heap_init(scratch);
+	if (rc)
+		return rc;
+
+	rc = sbi_qspinlock_init(scratch);
+	if (rc)
+		return rc;
+
+	sbi_console_set_device(&host_console);
+	sbi_timer_set_device(&host_timer);
+
+	rc = sbi_domain_init(scratch, 0);
+	if (rc)
+		return rc;
+
+	rc = sbi_trace_init(scratch);
+	if (rc)
+		return rc;
+
+	rc = sbi_batch_init(scratch);
+	if (rc)
+		return rc;
+
+	for (i = 0; i < HOST_HART_COUNT; i++) {
+		host_set_hartindex(i);
+		scratch = sbi_scratch_thishart_ptr();
+
+		rc = sbi_timer_init(scratch, !i);
+		if (rc)
+			return rc;
+
+		rc = sbi_pmu_init(scratch, !i);
+		if (rc)
+			return rc;
+	}
+
+	host_set_hartindex(0);
+	return 0;
+}
+
+void sbi_hart_hang(void)
+{
+	host_exit(1);
+}
+
+bool sbi_hart_has_extension(struct sbi_scratch *scratch,
+			    enum sbi_hart_extensions ext)
+{
+	return false;
+}
+
+bool sbi_hart_has_csr(struct sbi_scratch *scratch, enum sbi_hart_csrs csr)
+{
+	/* Time is read through the fake timer device instead */
+	return false;
+}
+
+unsigned int sbi_hart_mhpm_mask(struct sbi_scratch *scratch)
+{
+	return HOST_MHPM_MASK;
+}
+
+unsigned int sbi_hart_mhpm_bits(struct sbi_scratch *scratch)
+{
+	return 64;
+}
+
+int sbi_hart_priv_version(struct sbi_scratch *scratch)
+{
+	return SBI_HART_PRIV_VER_1_12;
+}
+
+int sbi_hart_protection_map_range(unsigned long base, unsigned long size)
+{
+	return 0;
+}
+
+int sbi_hart_protection_unmap_range(unsigned long base, unsigned long size)
+{
+	return 0;
+}
+
+int sbi_hart_protection_map_shmem(unsigned long base, unsigned long size)
+{
+	return SBI_ENOTSUPP;
+}
+
+void sbi_hart_protection_unmap_shmem(unsigned long base, unsigned long size)
+{
+}
+
+/* Only extensions registered by the tests exist on the host */
+struct sbi_ecall_extension *const sbi_ecall_exts[] = { NULL };
+
+int sbi_sse_add_event(uint32_t event_id, const struct sbi_sse_cb_ops *cb_ops)
+{
+	return 0;
+}
+
+int sbi_sse_inject_event(uint32_t event_id)
+{
+	return SBI_ENOTSUPP;
+}
+
+int sbi_domain_context_init(void)
+{
+	return 0;
+}
+
+void sbi_domain_context_deinit(void)
+{
+}
+
+int sbi_domain_setup_data(struct sbi_domain *dom)
+{
+	return 0;
+}
+
+int __sbi_hsm_hart_get_state(u32 hartindex)
+{
+	return SBI_HSM_STATE_STARTED;
+}
+
+int sbi_hsm_hart_start(struct sbi_scratch *scratch,
+		       const struct sbi_domain *dom,
+		       u32 hartid, ulong saddr, ulong smode, ulong arg1)
+{
+	return SBI_ENOTSUPP;
+}
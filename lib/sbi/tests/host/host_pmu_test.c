@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * PMU event to counter map tests. The map is global and can not be
+ * reset so the cases below build on each other and must run in order.
+ */
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_pmu.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_HW_EVENT(__code)						\
+	((SBI_PMU_EVENT_TYPE_HW << SBI_PMU_EVENT_IDX_TYPE_OFFSET) | (__code))
+#define TEST_RAW_EVENT							\
+	(SBI_PMU_EVENT_TYPE_HW_RAW << SBI_PMU_EVENT_IDX_TYPE_OFFSET)
+#define TEST_FW_EVENT(__code)						\
+	((SBI_PMU_EVENT_TYPE_FW << SBI_PMU_EVENT_IDX_TYPE_OFFSET) | (__code))
+
+#define TEST_CACHE_CTRS		(BIT(3) | BIT(4))
+#define TEST_BRANCH_CTRS	(BIT(4) | BIT(5) | BIT(6))
+#define TEST_RAW_CTRS		(BIT(7) | BIT(8))
+#define TEST_RAW_SELECT		0x1234
+#define TEST_RAW_SELECT_MASK	0xffff
+
+/* Every hardware and firmware counter */
+#define TEST_ALL_CTRS		((1UL << sbi_pmu_num_ctr()) - 1)
+
+static void pmu_release_all(void)
+{
+	sbi_pmu_ctr_stop(0, TEST_ALL_CTRS, SBI_PMU_STOP_FLAG_RESET);
+}
+
+static void pmu_event_map_test(struct sbiunit_test_case *test)
+{
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_hw_event_counter_map(
+				SBI_PMU_HW_CACHE_REFERENCES,
+				SBI_PMU_HW_CACHE_MISSES, TEST_CACHE_CTRS), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_hw_event_counter_map(
+				SBI_PMU_HW_BRANCH_INSTRUCTIONS,
+				SBI_PMU_HW_BRANCH_INSTRUCTIONS,
+				TEST_BRANCH_CTRS), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_raw_event_counter_map(
+				TEST_RAW_SELECT, TEST_RAW_SELECT_MASK,
+				TEST_RAW_CTRS), 0);
+
+	/* Overlapping ranges and selectors are rejected */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_hw_event_counter_map(
+				SBI_PMU_HW_CACHE_MISSES,
+				SBI_PMU_HW_BRANCH_MISSES, TEST_CACHE_CTRS),
+			  SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_raw_event_counter_map(
+				TEST_RAW_SELECT, TEST_RAW_SELECT_MASK,
+				TEST_CACHE_CTRS), SBI_EINVAL);
+
+	/* Malformed ranges and fixed counters are rejected */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_hw_event_counter_map(
+				SBI_PMU_HW_BUS_CYCLES,
+				SBI_PMU_HW_CACHE_REFERENCES, TEST_CACHE_CTRS),
+			  SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_add_hw_event_counter_map(
+				SBI_PMU_HW_BUS_CYCLES, SBI_PMU_HW_BUS_CYCLES,
+				BIT(0) | BIT(3)), SBI_EDENIED);
+}
+
+static void pmu_cfg_match_test(struct sbiunit_test_case *test)
+{
+	unsigned long event = TEST_HW_EVENT(SBI_PMU_HW_CACHE_MISSES);
+
+	/* Counters are handed out in order until the mapped ones run out */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+						      event, 0), 3);
+	SBIUNIT_EXPECT_EQ(test, csr_read_num(CSR_MHPMEVENT3), event);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+						      event, 0), 4);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+						      event, 0),
+			  SBI_ENOTSUPP);
+
+	/* Shared counter 4 is taken so branches start at counter 5 */
+	event = TEST_HW_EVENT(SBI_PMU_HW_BRANCH_INSTRUCTIONS);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+						      event, 0), 5);
+
+	/* The counter mask limits the search */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, BIT(5), 0,
+						      event, 0),
+			  SBI_ENOTSUPP);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(6, 1, 0, event, 0), 6);
+
+	/* Events without a map entry are not supported */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+				TEST_HW_EVENT(SBI_PMU_HW_BUS_CYCLES), 0),
+			  SBI_ENOTSUPP);
+
+	pmu_release_all();
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+				TEST_HW_EVENT(SBI_PMU_HW_CACHE_REFERENCES), 0),
+			  3);
+	pmu_release_all();
+}
+
+static void pmu_raw_match_test(struct sbiunit_test_case *test)
+{
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+						      TEST_RAW_EVENT,
+						      0xab0000 | TEST_RAW_SELECT),
+			  7);
+	SBIUNIT_EXPECT_EQ(test, csr_read_num(CSR_MHPMEVENT3 + 4),
+			  0xab0000 | TEST_RAW_SELECT);
+
+	/* The selector bits must match the map entry */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+						      TEST_RAW_EVENT, 0x4321),
+			  SBI_ENOTSUPP);
+	pmu_release_all();
+}
+
+static void pmu_fixed_and_fw_test(struct sbiunit_test_case *test)
+{
+	unsigned long fw_event = TEST_FW_EVENT(SBI_PMU_FW_SET_TIMER);
+	uint64_t val;
+	int cidx;
+
+	/* Cycle and instret always map to the fixed counters */
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+				TEST_HW_EVENT(SBI_PMU_HW_CPU_CYCLES), 0), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS, 0,
+				TEST_HW_EVENT(SBI_PMU_HW_INSTRUCTIONS), 0), 2);
+
+	/* Firmware events use the counters after the hardware ones */
+	cidx = sbi_pmu_ctr_cfg_match(0, TEST_ALL_CTRS,
+				     SBI_PMU_CFG_FLAG_CLEAR_VALUE |
+				     SBI_PMU_CFG_FLAG_AUTO_START,
+				     fw_event, 0);
+	SBIUNIT_ASSERT(test, cidx >= (int)(sbi_pmu_num_ctr() -
+					   SBI_PMU_FW_CTR_MAX));
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_incr_fw(SBI_PMU_FW_SET_TIMER), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_incr_fw(SBI_PMU_FW_SET_TIMER), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_pmu_ctr_fw_read(cidx, &val, false), 0);
+	SBIUNIT_EXPECT_EQ(test, val, 2);
+	pmu_release_all();
+}
+
+static struct sbiunit_test_case host_pmu_test_cases[] = {
+	SBIUNIT_TEST_CASE(pmu_event_map_test),
+	SBIUNIT_TEST_CASE(pmu_cfg_match_test),
+	SBIUNIT_TEST_CASE(pmu_raw_match_test),
+	SBIUNIT_TEST_CASE(pmu_fixed_and_fw_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(host_pmu_test_suite, host_pmu_test_cases);
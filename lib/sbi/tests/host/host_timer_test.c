@@ -0,0 +1,187 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Timer event queue tests driven by the fake host timer device.
+ */
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_unit_test.h>
+
+#include "host.h"
+
+#define TEST_TIMER_EVENTS	4
+
+struct test_timer_event {
+	struct sbi_timer_event ev;
+	u32 fired;
+	u32 restarts;
+	u64 period;
+};
+
+static struct test_timer_event test_events[TEST_TIMER_EVENTS];
+static u32 test_fire_order[4 * TEST_TIMER_EVENTS];
+static u32 test_fire_count;
+
+static void test_event_callback(struct sbi_timer_event *ev,
+				struct sbi_timer_event_restart *restart)
+{
+	struct test_timer_event *tev = ev->priv;
+
+	tev->fired++;
+	if (test_fire_count < array_size(test_fire_order))
+		test_fire_order[test_fire_count++] = tev - test_events;
+
+	if (tev->restarts) {
+		tev->restarts--;
+		restart->required = true;
+		restart->next_event = ev->time_stamp + tev->period;
+	}
+}
+
+static void test_events_init(void)
+{
+	u32 i;
+
+	sbi_memset(test_events, 0, sizeof(test_events));
+	for (i = 0; i < TEST_TIMER_EVENTS; i++)
+		SBI_INIT_TIMER_EVENT(&test_events[i].ev, test_event_callback,
+				     NULL, &test_events[i]);
+	test_fire_count = 0;
+}
+
+static void test_events_stop(void)
+{
+	u32 i;
+
+	for (i = 0; i < TEST_TIMER_EVENTS; i++)
+		sbi_timer_event_stop(&test_events[i].ev);
+}
+
+static void timer_event_order_test(struct sbiunit_test_case *test)
+{
+	u64 now = host_timer_get();
+
+	test_events_init();
+
+	/* Started out of order, the earliest deadline must be programmed */
+	sbi_timer_event_start(&test_events[0].ev, now + 300);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), now + 300);
+	sbi_timer_event_start(&test_events[1].ev, now + 100);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), now + 100);
+	sbi_timer_event_start(&test_events[2].ev, now + 200);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), now + 100);
+
+	host_timer_advance(150);
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_fire_count, 1);
+	SBIUNIT_EXPECT_EQ(test, test_fire_order[0], 1);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), now + 200);
+
+	/* Stopping the head event reprograms the next deadline */
+	sbi_timer_event_stop(&test_events[2].ev);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), now + 300);
+
+	host_timer_advance(1000);
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_fire_count, 2);
+	SBIUNIT_EXPECT_EQ(test, test_fire_order[1], 0);
+	SBIUNIT_EXPECT_EQ(test, test_events[2].fired, 0);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), -1ULL);
+}
+
+static void timer_event_same_deadline_test(struct sbiunit_test_case *test)
+{
+	u64 now = host_timer_get();
+	u32 i;
+
+	test_events_init();
+
+	/* Events with equal deadlines fire in the order they were started */
+	for (i = 0; i < TEST_TIMER_EVENTS; i++)
+		sbi_timer_event_start(&test_events[i].ev, now + 50);
+
+	host_timer_advance(50);
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_fire_count, TEST_TIMER_EVENTS);
+	for (i = 0; i < TEST_TIMER_EVENTS; i++)
+		SBIUNIT_EXPECT_EQ(test, test_fire_order[i], i);
+}
+
+static void timer_event_restart_test(struct sbiunit_test_case *test)
+{
+	u64 now = host_timer_get();
+	u32 i;
+
+	test_events_init();
+
+	test_events[0].restarts = 3;
+	test_events[0].period = 100;
+	sbi_timer_event_start(&test_events[0].ev, now + 100);
+	sbi_timer_event_start(&test_events[1].ev, now + 250);
+
+	for (i = 0; i < 5; i++) {
+		host_timer_advance(100);
+		sbi_timer_process();
+	}
+
+	SBIUNIT_EXPECT_EQ(test, test_events[0].fired, 4);
+	SBIUNIT_EXPECT_EQ(test, test_events[1].fired, 1);
+	SBIUNIT_EXPECT_EQ(test, test_fire_count, 5);
+	SBIUNIT_EXPECT_EQ(test, test_fire_order[2], 1);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), -1ULL);
+
+	test_events_stop();
+}
+
+static void timer_event_restart_only_test(struct sbiunit_test_case *test)
+{
+	u64 now = host_timer_get();
+
+	test_events_init();
+
+	/* The only pending event restarts itself from its own callback */
+	test_events[0].restarts = 1;
+	test_events[0].period = 10;
+	sbi_timer_event_start(&test_events[0].ev, now + 10);
+
+	host_timer_advance(10);
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_events[0].fired, 1);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), now + 20);
+
+	host_timer_advance(10);
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_events[0].fired, 2);
+	SBIUNIT_EXPECT_EQ(test, host_timer_deadline(), -1ULL);
+}
+
+static void timer_event_other_hart_test(struct sbiunit_test_case *test)
+{
+	u64 now = host_timer_get();
+
+	test_events_init();
+
+	/* Events are queued on the HART which starts them */
+	host_set_hartindex(1);
+	sbi_timer_event_start(&test_events[0].ev, now + 10);
+	host_set_hartindex(0);
+
+	host_timer_advance(10);
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_events[0].fired, 0);
+
+	host_set_hartindex(1);
+	sbi_timer_process();
+	host_set_hartindex(0);
+	SBIUNIT_EXPECT_EQ(test, test_events[0].fired, 1);
+}
+
+static struct sbiunit_test_case host_timer_test_cases[] = {
+	SBIUNIT_TEST_CASE(timer_event_order_test),
+	SBIUNIT_TEST_CASE(timer_event_same_deadline_test),
+	SBIUNIT_TEST_CASE(timer_event_restart_test),
+	SBIUNIT_TEST_CASE(timer_event_restart_only_test),
+	SBIUNIT_TEST_CASE(timer_event_other_hart_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(host_timer_test_suite, host_timer_test_cases);
@@ -0,0 +1,42 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host shim: CSR accesses go to an array instead of the hardware.
+ */
+
+#ifndef __HOST_RISCV_ASM_H__
+#define __HOST_RISCV_ASM_H__
+
+#include_next <sbi/riscv_asm.h>
+
+#ifndef __ASSEMBLER__
+
+unsigned long host_csr_rmw(int csr, unsigned long set, unsigned long clear,
+			   int write);
+
+#undef csr_swap
+#undef csr_read
+#undef csr_read_relaxed
+#undef csr_write
+#undef csr_read_set
+#undef csr_set
+#undef csr_read_clear
+#undef csr_clear
+#undef wfi
+#undef ebreak
+
+#define csr_swap(csr, val)	host_csr_rmw(csr, (val), -1UL, 1)
+#define csr_read(csr)		host_csr_rmw(csr, 0, 0, 0)
+#define csr_read_relaxed(csr)	host_csr_rmw(csr, 0, 0, 0)
+#define csr_write(csr, val)	((void)host_csr_rmw(csr, (val), -1UL, 1))
+#define csr_read_set(csr, val)	host_csr_rmw(csr, (val), 0, 1)
+#define csr_set(csr, val)	((void)host_csr_rmw(csr, (val), 0, 1))
+#define csr_read_clear(csr, val) host_csr_rmw(csr, 0, (val), 1)
+#define csr_clear(csr, val)	((void)host_csr_rmw(csr, 0, (val), 1))
+
+#define wfi()			do { } while (0)
+#define ebreak()		do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host shim: RISC-V fences become compiler builtins.
+ */
+
+#ifndef __HOST_RISCV_BARRIER_H__
+#define __HOST_RISCV_BARRIER_H__
+
+#include_next <sbi/riscv_barrier.h>
+
+#undef RISCV_FENCE
+#undef RISCV_FENCE_I
+#undef cpu_relax
+
+#define RISCV_FENCE(p, s)	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define RISCV_FENCE_I		do { } while (0)
+#define cpu_relax()		do { } while (0)
+
+#endif
@@ -25,6 +25,31 @@ libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_bitops_test.o
 carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += string_test_suite
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_string_test.o
 
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += domain_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_domain_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += hart_pmp_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_hart_pmp_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += fifo_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_fifo_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += heap_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_heap_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += irqchip_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_irqchip_test.o
+
+ifeq ($(CONFIG_SBI_TRACE),y)
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += trace_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_trace_test.o
+endif
+
+ifeq ($(CONFIG_SBI_BATCH),y)
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += batch_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_batch_test.o
+endif
+
 ifeq ($(UBSAN),y)
 carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += ubsan_test_suite
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_ubsan_test.o
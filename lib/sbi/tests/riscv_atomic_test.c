@@ -1,4 +1,5 @@
 #include <sbi/sbi_unit_test.h>
+#include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/sbi_bitops.h>
 
@@ -11,6 +12,8 @@
 #define ATOMIC_TEST_RAW_BIT_CELL 1
 #define ATOMIC_TEST_RAW_BIT_NUM 15
 
+#define ATOMIC_TEST_BENCH_ITERATIONS 1024
+
 static atomic_t test_atomic;
 
 static void atomic_test_suite_init(void)
@@ -123,6 +126,125 @@ static void atomic_clear_bit_test(struct sbiunit_test_case *test)
 	SBIUNIT_EXPECT_EQ(test, atomic_read(&test_atomic), 0);
 }
 
+static void atomic_raw_cmpxchg_test(struct sbiunit_test_case *test)
+{
+	unsigned long ul = ATOMIC_TEST_VAL1;
+	unsigned int ui = ~0U;
+
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_ulong(&ul, ATOMIC_TEST_VAL2,
+							 ATOMIC_TEST_VAL3),
+			  ATOMIC_TEST_VAL1);
+	SBIUNIT_EXPECT_EQ(test, ul, ATOMIC_TEST_VAL1);
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_ulong(&ul, ATOMIC_TEST_VAL1,
+							 ATOMIC_TEST_VAL3),
+			  ATOMIC_TEST_VAL1);
+	SBIUNIT_EXPECT_EQ(test, ul, ATOMIC_TEST_VAL3);
+
+	/* Values with the top bit set must compare equal on RV64 as well */
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_uint(&ui, ~0U, 0x80000000U),
+			  ~0U);
+	SBIUNIT_EXPECT_EQ(test, ui, 0x80000000U);
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_uint(&ui, 0, 1), 0x80000000U);
+	SBIUNIT_EXPECT_EQ(test, ui, 0x80000000U);
+}
+
+static void atomic_subword_test(struct sbiunit_test_case *test)
+{
+	union {
+		unsigned int word;
+		u8 b[4];
+		u16 h[2];
+	} data = { .word = 0x44332211 };
+
+	/* Byte updates must leave the rest of the word untouched */
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_xchg_u8(&data.b[1], 0xaa), 0x22);
+	SBIUNIT_EXPECT_EQ(test, data.word, 0x4433aa11);
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_u8(&data.b[3], 0x00, 0xbb), 0x44);
+	SBIUNIT_EXPECT_EQ(test, data.word, 0x4433aa11);
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_u8(&data.b[3], 0x44, 0xbb), 0x44);
+	SBIUNIT_EXPECT_EQ(test, data.word, 0xbb33aa11);
+
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_xchg_u16(&data.h[0], 0x1234), 0xaa11);
+	SBIUNIT_EXPECT_EQ(test, data.word, 0xbb331234);
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_u16(&data.h[1], 0x1234, 0xffff),
+			  0xbb33);
+	SBIUNIT_EXPECT_EQ(test, data.word, 0xbb331234);
+	SBIUNIT_EXPECT_EQ(test, atomic_raw_cmpxchg_u16(&data.h[1], 0xbb33, 0xffff),
+			  0xbb33);
+	SBIUNIT_EXPECT_EQ(test, data.word, 0xffff1234);
+}
+
+static void atomic_double_cmpxchg_test(struct sbiunit_test_case *test)
+{
+	atomic_double_t atom = ATOMIC_DOUBLE_INITIALIZER(ATOMIC_TEST_VAL1, 0);
+	unsigned long lo, hi;
+
+	atomic_double_read(&atom, &lo, &hi);
+	SBIUNIT_EXPECT_EQ(test, lo, ATOMIC_TEST_VAL1);
+	SBIUNIT_EXPECT_EQ(test, hi, 0);
+
+	/* A stale high word fails even if the low word matches */
+	lo = ATOMIC_TEST_VAL1;
+	hi = 1;
+	SBIUNIT_EXPECT(test, !atomic_double_cmpxchg(&atom, &lo, &hi,
+						    ATOMIC_TEST_VAL2, 1));
+	SBIUNIT_EXPECT_EQ(test, lo, ATOMIC_TEST_VAL1);
+	SBIUNIT_EXPECT_EQ(test, hi, 0);
+
+	/* The failed attempt returned the current value for the retry */
+	SBIUNIT_EXPECT(test, atomic_double_cmpxchg(&atom, &lo, &hi,
+						   ATOMIC_TEST_VAL2, 1));
+	atomic_double_read(&atom, &lo, &hi);
+	SBIUNIT_EXPECT_EQ(test, lo, ATOMIC_TEST_VAL2);
+	SBIUNIT_EXPECT_EQ(test, hi, 1);
+
+	atomic_double_write(&atom, ATOMIC_TEST_VAL3, ~0UL);
+	atomic_double_read(&atom, &lo, &hi);
+	SBIUNIT_EXPECT_EQ(test, lo, ATOMIC_TEST_VAL3);
+	SBIUNIT_EXPECT_EQ(test, hi, ~0UL);
+}
+
+static void atomic_bench_test(struct sbiunit_test_case *test)
+{
+	atomic_double_t atom = ATOMIC_DOUBLE_INITIALIZER(0, 0);
+	unsigned long start, cas, cas8, dcas, lo, hi;
+	u8 byte = 0;
+	long i;
+
+	atomic_write(&test_atomic, 0);
+	start = csr_read(CSR_MCYCLE);
+	for (i = 0; i < ATOMIC_TEST_BENCH_ITERATIONS; i++)
+		atomic_cmpxchg(&test_atomic, i, i + 1);
+	cas = csr_read(CSR_MCYCLE) - start;
+	SBIUNIT_EXPECT_EQ(test, atomic_read(&test_atomic),
+			  ATOMIC_TEST_BENCH_ITERATIONS);
+
+	start = csr_read(CSR_MCYCLE);
+	for (i = 0; i < ATOMIC_TEST_BENCH_ITERATIONS; i++)
+		atomic_raw_cmpxchg_u8(&byte, (u8)i, (u8)(i + 1));
+	cas8 = csr_read(CSR_MCYCLE) - start;
+	SBIUNIT_EXPECT_EQ(test, byte, (u8)ATOMIC_TEST_BENCH_ITERATIONS);
+
+	lo = hi = 0;
+	start = csr_read(CSR_MCYCLE);
+	for (i = 0; i < ATOMIC_TEST_BENCH_ITERATIONS; i++) {
+		if (atomic_double_cmpxchg(&atom, &lo, &hi, lo + 1, hi + 1)) {
+			lo++;
+			hi++;
+		}
+	}
+	dcas = csr_read(CSR_MCYCLE) - start;
+	atomic_double_read(&atom, &lo, &hi);
+	SBIUNIT_EXPECT_EQ(test, lo, ATOMIC_TEST_BENCH_ITERATIONS);
+	SBIUNIT_EXPECT_EQ(test, hi, ATOMIC_TEST_BENCH_ITERATIONS);
+
+	sbi_printf("[SBIUnit] atomic cmpxchg %lu cycles, byte cmpxchg %lu "
+		   "cycles, double cmpxchg %lu cycles\n",
+		   cas / ATOMIC_TEST_BENCH_ITERATIONS,
+		   cas8 / ATOMIC_TEST_BENCH_ITERATIONS,
+		   dcas / ATOMIC_TEST_BENCH_ITERATIONS);
+}
+
 static struct sbiunit_test_case atomic_test_cases[] = {
 	SBIUNIT_TEST_CASE(atomic_rw_test),
 	SBIUNIT_TEST_CASE(add_return_test),
@@ -133,6 +255,10 @@ static struct sbiunit_test_case atomic_test_cases[] = {
 	SBIUNIT_TEST_CASE(atomic_raw_clear_bit_test),
 	SBIUNIT_TEST_CASE(atomic_set_bit_test),
 	SBIUNIT_TEST_CASE(atomic_clear_bit_test),
+	SBIUNIT_TEST_CASE(atomic_raw_cmpxchg_test),
+	SBIUNIT_TEST_CASE(atomic_subword_test),
+	SBIUNIT_TEST_CASE(atomic_double_cmpxchg_test),
+	SBIUNIT_TEST_CASE(atomic_bench_test),
 	SBIUNIT_END_CASE,
 };
 
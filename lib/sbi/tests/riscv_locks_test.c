@@ -1,7 +1,12 @@
 #include <sbi/sbi_unit_test.h>
 #include <sbi/riscv_locks.h>
+#include <sbi/sbi_qspinlock.h>
 
 static spinlock_t test_lock = SPIN_LOCK_INITIALIZER;
+static qspinlock_t test_qlock = QSPIN_LOCK_INITIALIZER;
+static qspinlock_t test_qlock_nested = QSPIN_LOCK_INITIALIZER;
+static seqlock_t test_seqlock = SEQLOCK_INITIALIZER;
+static rwlock_t test_rwlock = RW_LOCK_INITIALIZER;
 
 static void spin_lock_test(struct sbiunit_test_case *test)
 {
@@ -31,10 +36,102 @@ static void spin_trylock_success(struct sbiunit_test_case *test)
 	spin_unlock(&test_lock);
 }
 
+static void qspin_lock_test(struct sbiunit_test_case *test)
+{
+	SBIUNIT_ASSERT(test, !qspin_lock_check(&test_qlock));
+
+	qspin_lock(&test_qlock);
+	SBIUNIT_EXPECT(test, qspin_lock_check(&test_qlock));
+	SBIUNIT_EXPECT(test, !qspin_trylock(&test_qlock));
+	qspin_unlock(&test_qlock);
+
+	SBIUNIT_ASSERT(test, !qspin_lock_check(&test_qlock));
+
+	SBIUNIT_EXPECT(test, qspin_trylock(&test_qlock));
+	qspin_unlock(&test_qlock);
+}
+
+static void qspin_lock_nested_test(struct sbiunit_test_case *test)
+{
+	/* Nodes must be reusable when locks are released out of order */
+	qspin_lock(&test_qlock);
+	qspin_lock(&test_qlock_nested);
+	qspin_unlock(&test_qlock);
+	qspin_lock(&test_qlock);
+	SBIUNIT_EXPECT(test, qspin_lock_check(&test_qlock_nested));
+	qspin_unlock(&test_qlock_nested);
+	qspin_unlock(&test_qlock);
+
+	SBIUNIT_EXPECT(test, !qspin_lock_check(&test_qlock));
+	SBIUNIT_EXPECT(test, !qspin_lock_check(&test_qlock_nested));
+}
+
+static void qspin_lock_stats_test(struct sbiunit_test_case *test)
+{
+	struct qspin_lock_stats stats;
+	u32 i;
+
+	qspin_lock_reset_stats(&test_qlock);
+	for (i = 0; i < 4; i++) {
+		qspin_lock(&test_qlock);
+		qspin_unlock(&test_qlock);
+	}
+
+	if (qspin_lock_get_stats(&test_qlock, &stats))
+		return;
+
+	/* A single HART never has to wait */
+	SBIUNIT_EXPECT_EQ(test, stats.acquisitions, 4);
+	SBIUNIT_EXPECT_EQ(test, stats.contended, 0);
+	SBIUNIT_EXPECT_EQ(test, stats.spins, 0);
+}
+
+static void seqlock_test(struct sbiunit_test_case *test)
+{
+	u32 seq;
+
+	seq = read_seqbegin(&test_seqlock);
+	SBIUNIT_EXPECT(test, !read_seqretry(&test_seqlock, seq));
+
+	/* Readers overlapping a writer must retry */
+	write_seqlock(&test_seqlock);
+	SBIUNIT_EXPECT(test, spin_lock_check(&test_seqlock.lock));
+	write_sequnlock(&test_seqlock);
+	SBIUNIT_EXPECT(test, read_seqretry(&test_seqlock, seq));
+
+	seq = read_seqbegin(&test_seqlock);
+	SBIUNIT_EXPECT(test, !read_seqretry(&test_seqlock, seq));
+	SBIUNIT_EXPECT(test, !spin_lock_check(&test_seqlock.lock));
+}
+
+static void rwlock_test(struct sbiunit_test_case *test)
+{
+	/* Readers share the lock and exclude writers */
+	read_lock(&test_rwlock);
+	SBIUNIT_EXPECT(test, read_trylock(&test_rwlock));
+	SBIUNIT_EXPECT(test, !write_trylock(&test_rwlock));
+	read_unlock(&test_rwlock);
+	read_unlock(&test_rwlock);
+
+	/* Writers exclude both readers and writers */
+	write_lock(&test_rwlock);
+	SBIUNIT_EXPECT(test, !read_trylock(&test_rwlock));
+	SBIUNIT_EXPECT(test, !write_trylock(&test_rwlock));
+	write_unlock(&test_rwlock);
+
+	SBIUNIT_EXPECT(test, write_trylock(&test_rwlock));
+	write_unlock(&test_rwlock);
+}
+
 static struct sbiunit_test_case locks_test_cases[] = {
 	SBIUNIT_TEST_CASE(spin_lock_test),
 	SBIUNIT_TEST_CASE(spin_trylock_fail),
 	SBIUNIT_TEST_CASE(spin_trylock_success),
+	SBIUNIT_TEST_CASE(qspin_lock_test),
+	SBIUNIT_TEST_CASE(qspin_lock_nested_test),
+	SBIUNIT_TEST_CASE(qspin_lock_stats_test),
+	SBIUNIT_TEST_CASE(seqlock_test),
+	SBIUNIT_TEST_CASE(rwlock_test),
 	SBIUNIT_END_CASE,
 };
 
@@ -0,0 +1,224 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_byteorder.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_trap.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_BATCH_ENTRIES		4
+#define TEST_BATCH_RING_ORDER		9
+#define TEST_BATCH_SENTINEL		0x5a5a5a5aULL
+
+#define TEST_BATCH_EXTID		SBI_EXT_EXPERIMENTAL_END
+#define TEST_BATCH_DENIED_EXTID		(SBI_EXT_EXPERIMENTAL_END - 1)
+
+#define TEST_BATCH_FUNC_SUM		0
+#define TEST_BATCH_FUNC_ERROR		1
+#define TEST_BATCH_FUNC_BOGUS		2
+
+_Static_assert(TEST_BATCH_ENTRIES * sizeof(struct sbi_batch_entry) <=
+	       (1UL << TEST_BATCH_RING_ORDER), "batch test ring too small");
+
+/* The ring lives in memory which S-mode of the test domain owns */
+static struct sbi_batch_entry test_batch_ring[TEST_BATCH_ENTRIES]
+				__aligned(1UL << TEST_BATCH_RING_ORDER);
+static struct sbi_batch_entry test_batch_noring[TEST_BATCH_ENTRIES]
+				__aligned(1UL << TEST_BATCH_RING_ORDER);
+
+static struct sbi_domain_memregion test_batch_regions[2];
+
+static struct sbi_domain test_batch_dom = {
+	.name = "batch_test",
+	.regions = test_batch_regions,
+};
+
+static struct sbi_domain *test_batch_prev_dom;
+
+static int test_batch_handler(unsigned long extid, unsigned long funcid,
+			      struct sbi_trap_regs *regs,
+			      struct sbi_ecall_return *out)
+{
+	switch (funcid) {
+	case TEST_BATCH_FUNC_SUM:
+		out->value = regs->a0 + regs->a1 + regs->a2 +
+			     regs->a3 + regs->a4 + regs->a5;
+		return 0;
+	case TEST_BATCH_FUNC_ERROR:
+		return SBI_EINVAL;
+	case TEST_BATCH_FUNC_BOGUS:
+		/* Not an SBI error code */
+		return 1;
+	default:
+		return SBI_ENOTSUPP;
+	}
+}
+
+static struct sbi_ecall_extension test_batch_ext = {
+	.name			= "tbatch",
+	.extid_start		= TEST_BATCH_EXTID,
+	.extid_end		= TEST_BATCH_EXTID,
+	.batchable		= true,
+	.handle			= test_batch_handler,
+};
+
+static struct sbi_ecall_extension test_batch_denied_ext = {
+	.name			= "tbdeny",
+	.extid_start		= TEST_BATCH_DENIED_EXTID,
+	.extid_end		= TEST_BATCH_DENIED_EXTID,
+	.handle			= test_batch_handler,
+};
+
+static void batch_test_enter(struct sbiunit_test_case *test)
+{
+	test_batch_regions[0].base = (unsigned long)test_batch_ring;
+	test_batch_regions[0].order = TEST_BATCH_RING_ORDER;
+	test_batch_regions[0].flags = SBI_DOMAIN_MEMREGION_SU_READABLE |
+				      SBI_DOMAIN_MEMREGION_SU_WRITABLE;
+
+	SBIUNIT_ASSERT_EQ(test, sbi_ecall_register_extension(&test_batch_ext),
+			  0);
+	SBIUNIT_ASSERT_EQ(test,
+		sbi_ecall_register_extension(&test_batch_denied_ext), 0);
+
+	test_batch_prev_dom = sbi_domain_thishart_ptr();
+	sbi_update_hartindex_to_domain(current_hartindex(), &test_batch_dom);
+}
+
+static void batch_test_exit(struct sbiunit_test_case *test)
+{
+	/* Disabling the ring also drops its M-mode mapping */
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(-1UL, -1UL, 0), 0);
+
+	sbi_update_hartindex_to_domain(current_hartindex(),
+				       test_batch_prev_dom);
+
+	sbi_ecall_unregister_extension(&test_batch_denied_ext);
+	sbi_ecall_unregister_extension(&test_batch_ext);
+}
+
+static void batch_test_fill(unsigned long i, unsigned long extid,
+			    unsigned long funcid)
+{
+	struct sbi_batch_entry *ent = &test_batch_ring[i];
+	u64 j;
+
+	sbi_memset(ent, 0, sizeof(*ent));
+	ent->extid = cpu_to_le32(extid);
+	ent->funcid = cpu_to_le32(funcid);
+	for (j = 0; j < SBI_BATCH_MAX_ARGS; j++)
+		ent->args[j] = cpu_to_le64(i + j + 1);
+	ent->error = cpu_to_le64(TEST_BATCH_SENTINEL);
+	ent->value = cpu_to_le64(TEST_BATCH_SENTINEL);
+}
+
+#define BATCH_EXPECT_RESULT(test, i, err, val)				\
+	do {								\
+		SBIUNIT_EXPECT_EQ(test,					\
+			(s64)le64_to_cpu(test_batch_ring[i].error),	\
+			(s64)(err));					\
+		SBIUNIT_EXPECT_EQ(test,					\
+			le64_to_cpu(test_batch_ring[i].value),		\
+			(u64)(val));					\
+	} while (0)
+
+static void batch_set_shmem_test(struct sbiunit_test_case *test)
+{
+	unsigned long ring = (unsigned long)test_batch_ring;
+	unsigned long count = 0;
+
+	batch_test_enter(test);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(ring + 4, 0,
+				TEST_BATCH_ENTRIES), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(ring, 0, 0), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(ring, 0,
+				SBI_BATCH_MAX_ENTRIES + 1), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(ring, 1,
+				TEST_BATCH_ENTRIES), SBI_EINVALID_ADDR);
+
+	/* Ring outside or crossing the end of the memory of the domain */
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(
+				(unsigned long)test_batch_noring, 0,
+				TEST_BATCH_ENTRIES), SBI_EINVALID_ADDR);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(ring, 0,
+				SBI_BATCH_MAX_ENTRIES), SBI_EINVALID_ADDR);
+
+	/* Failed attempts leave the ring disabled */
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(0, 1, &count),
+			  SBI_ENO_SHMEM);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(ring, 0,
+				TEST_BATCH_ENTRIES), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_set_shmem(-1UL, -1UL, 0), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(0, 1, &count),
+			  SBI_ENO_SHMEM);
+	SBIUNIT_EXPECT_EQ(test, count, 0);
+
+	batch_test_exit(test);
+}
+
+static void batch_doorbell_test(struct sbiunit_test_case *test)
+{
+	unsigned long count = 0;
+
+	batch_test_enter(test);
+	SBIUNIT_ASSERT_EQ(test, sbi_batch_set_shmem(
+				(unsigned long)test_batch_ring, 0,
+				TEST_BATCH_ENTRIES), 0);
+
+	batch_test_fill(0, TEST_BATCH_EXTID, TEST_BATCH_FUNC_SUM);
+	batch_test_fill(1, TEST_BATCH_EXTID, TEST_BATCH_FUNC_ERROR);
+	batch_test_fill(2, TEST_BATCH_EXTID, TEST_BATCH_FUNC_BOGUS);
+	batch_test_fill(3, TEST_BATCH_DENIED_EXTID, TEST_BATCH_FUNC_SUM);
+
+	/* A failing call does not stop the following ones */
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(0, TEST_BATCH_ENTRIES,
+						   &count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, TEST_BATCH_ENTRIES);
+	BATCH_EXPECT_RESULT(test, 0, 0, 1 + 2 + 3 + 4 + 5 + 6);
+	BATCH_EXPECT_RESULT(test, 1, SBI_EINVAL, 0);
+	BATCH_EXPECT_RESULT(test, 2, SBI_ERR_FAILED, 0);
+	/* Extensions which did not opt in are never called */
+	BATCH_EXPECT_RESULT(test, 3, SBI_ENOTSUPP, 0);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(TEST_BATCH_ENTRIES, 1,
+						   &count), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(0, TEST_BATCH_ENTRIES + 1,
+						   &count), SBI_EINVAL);
+
+	/* Entries wrap around the end of the ring */
+	batch_test_fill(3, TEST_BATCH_EXTID, TEST_BATCH_FUNC_SUM);
+	batch_test_fill(0, SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_DOORBELL);
+	batch_test_fill(1, TEST_BATCH_EXTID, TEST_BATCH_FUNC_SUM);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(TEST_BATCH_ENTRIES - 1, 2,
+						   &count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, 2);
+	BATCH_EXPECT_RESULT(test, 3, 0, 4 + 5 + 6 + 7 + 8 + 9);
+	/* The doorbell itself can not be queued */
+	BATCH_EXPECT_RESULT(test, 0, SBI_ENOTSUPP, 0);
+	BATCH_EXPECT_RESULT(test, 1, TEST_BATCH_SENTINEL, TEST_BATCH_SENTINEL);
+
+	/* Only the domain which registered the ring can ring the doorbell */
+	sbi_update_hartindex_to_domain(current_hartindex(),
+				       test_batch_prev_dom);
+	SBIUNIT_EXPECT_EQ(test, sbi_batch_doorbell(1, 1, &count),
+			  SBI_ENO_SHMEM);
+	sbi_update_hartindex_to_domain(current_hartindex(), &test_batch_dom);
+	BATCH_EXPECT_RESULT(test, 1, TEST_BATCH_SENTINEL, TEST_BATCH_SENTINEL);
+
+	batch_test_exit(test);
+}
+
+static struct sbiunit_test_case batch_test_cases[] = {
+	SBIUNIT_TEST_CASE(batch_set_shmem_test),
+	SBIUNIT_TEST_CASE(batch_doorbell_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(batch_test_suite, batch_test_cases);
@@ -0,0 +1,237 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_MAX_PROBES		128
+
+/* Regions are intentionally not sorted to exercise first-match semantics */
+static struct sbi_domain_memregion test_regions_default[] = {
+	{ .order = 19, .base = 0x80000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_EXECUTABLE |
+		   SBI_DOMAIN_MEMREGION_FW },
+	{ .order = 19, .base = 0x80080000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_WRITABLE |
+		   SBI_DOMAIN_MEMREGION_FW },
+	{ .order = 12, .base = 0x10000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_MMIO |
+		   SBI_DOMAIN_MEMREGION_SHARED_SURW_MRW },
+	{ .order = 20, .base = 0x82100000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_READABLE },
+	{ .order = 25, .base = 0x82000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_RWX },
+	/* Shadowed by the bigger region above which comes first */
+	{ .order = 16, .base = 0x82100000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_RWX },
+	{ .order = 16, .base = 0x82ff0000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_ENF_READABLE },
+	{ .order = __riscv_xlen, .base = 0,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_RWX },
+	{ .order = 0 },
+};
+
+/* Same as above but without the default region so gaps are present */
+static struct sbi_domain_memregion test_regions_gaps[] = {
+	{ .order = 19, .base = 0x80000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_M_READABLE |
+		   SBI_DOMAIN_MEMREGION_M_EXECUTABLE |
+		   SBI_DOMAIN_MEMREGION_FW },
+	{ .order = 12, .base = 0x10000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_MMIO |
+		   SBI_DOMAIN_MEMREGION_SHARED_SURW_MRW },
+	{ .order = 12, .base = 0x10001000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_SHARED_SURW_MRW },
+	{ .order = 20, .base = 0x82100000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_READABLE },
+	{ .order = 25, .base = 0x82000000UL,
+	  .flags = SBI_DOMAIN_MEMREGION_SU_RWX },
+	{ .order = 0 },
+};
+
+static const unsigned long test_modes[] = { PRV_M, PRV_S, PRV_U };
+
+static const unsigned long test_access[] = {
+	SBI_DOMAIN_READ,
+	SBI_DOMAIN_WRITE,
+	SBI_DOMAIN_EXECUTE,
+	SBI_DOMAIN_READ | SBI_DOMAIN_WRITE,
+	SBI_DOMAIN_READ | SBI_DOMAIN_WRITE | SBI_DOMAIN_EXECUTE,
+	SBI_DOMAIN_READ | SBI_DOMAIN_MMIO,
+	SBI_DOMAIN_WRITE | SBI_DOMAIN_MMIO,
+};
+
+static unsigned long test_probes[TEST_MAX_PROBES];
+static u32 test_probe_count;
+
+static void add_probe(unsigned long addr)
+{
+	if (test_probe_count < TEST_MAX_PROBES)
+		test_probes[test_probe_count++] = addr;
+}
+
+/* Probe region boundaries and their neighbours */
+static void setup_probes(const struct sbi_domain *dom)
+{
+	const struct sbi_domain_memregion *reg;
+	unsigned long end;
+
+	test_probe_count = 0;
+	add_probe(0);
+	add_probe(-1UL);
+	sbi_domain_for_each_memregion(dom, reg) {
+		end = (reg->order < __riscv_xlen) ?
+		      reg->base + (BIT(reg->order) - 1) : -1UL;
+		add_probe(reg->base - 1);
+		add_probe(reg->base);
+		add_probe(reg->base + 8);
+		add_probe(end - 8);
+		add_probe(end);
+		add_probe(end + 1);
+	}
+}
+
+static void setup_domain(struct sbi_domain *dom,
+			 struct sbi_domain_memregion *regions)
+{
+	sbi_memset(dom, 0, sizeof(*dom));
+	dom->regions = regions;
+	setup_probes(dom);
+}
+
+static void cleanup_domain(struct sbi_domain *dom)
+{
+	sbi_free(dom->addr_intervals);
+	dom->addr_intervals = NULL;
+	dom->addr_interval_count = 0;
+}
+
+/* Compare indexed lookup against linear first-match lookup */
+static bool check_addr_matches(struct sbi_domain *dom, unsigned long addr,
+			       unsigned long mode, unsigned long access)
+{
+	struct sbi_domain_addr_interval *iv = dom->addr_intervals;
+	bool linear, indexed;
+
+	dom->addr_intervals = NULL;
+	linear = sbi_domain_check_addr(dom, addr, mode, access);
+	dom->addr_intervals = iv;
+	indexed = sbi_domain_check_addr(dom, addr, mode, access);
+
+	return linear == indexed;
+}
+
+static bool check_range_matches(struct sbi_domain *dom, unsigned long addr,
+				unsigned long size, unsigned long mode,
+				unsigned long access)
+{
+	struct sbi_domain_addr_interval *iv = dom->addr_intervals;
+	bool linear, indexed;
+
+	dom->addr_intervals = NULL;
+	linear = sbi_domain_check_addr_range(dom, addr, size, mode, access);
+	dom->addr_intervals = iv;
+	indexed = sbi_domain_check_addr_range(dom, addr, size, mode, access);
+
+	return linear == indexed;
+}
+
+static void do_check_addr_test(struct sbiunit_test_case *test,
+			       struct sbi_domain_memregion *regions)
+{
+	struct sbi_domain dom;
+	u32 i, m, a;
+
+	setup_domain(&dom, regions);
+	SBIUNIT_ASSERT_EQ(test, sbi_domain_build_addr_lookup(&dom), 0);
+
+	for (i = 0; i < test_probe_count; i++) {
+		for (m = 0; m < array_size(test_modes); m++) {
+			for (a = 0; a < array_size(test_access); a++) {
+				SBIUNIT_EXPECT(test, check_addr_matches(&dom,
+						test_probes[i], test_modes[m],
+						test_access[a]));
+			}
+		}
+	}
+
+	cleanup_domain(&dom);
+}
+
+static void do_check_addr_range_test(struct sbiunit_test_case *test,
+				     struct sbi_domain_memregion *regions)
+{
+	struct sbi_domain dom;
+	unsigned long start, end;
+	u32 i, j, m, a;
+
+	setup_domain(&dom, regions);
+	SBIUNIT_ASSERT_EQ(test, sbi_domain_build_addr_lookup(&dom), 0);
+
+	for (i = 0; i < test_probe_count; i++) {
+		start = test_probes[i];
+		for (j = 0; j < test_probe_count; j++) {
+			end = test_probes[j];
+			if (end < start)
+				continue;
+			for (m = 0; m < array_size(test_modes); m++) {
+				for (a = 0; a < array_size(test_access); a++) {
+					SBIUNIT_EXPECT(test, check_range_matches(
+						&dom, start, end - start + 1,
+						test_modes[m], test_access[a]));
+					SBIUNIT_EXPECT(test, check_range_matches(
+						&dom, start, 0,
+						test_modes[m], test_access[a]));
+				}
+			}
+		}
+	}
+
+	cleanup_domain(&dom);
+}
+
+static void domain_check_addr_test(struct sbiunit_test_case *test)
+{
+	do_check_addr_test(test, test_regions_default);
+	do_check_addr_test(test, test_regions_gaps);
+}
+
+static void domain_check_addr_range_test(struct sbiunit_test_case *test)
+{
+	do_check_addr_range_test(test, test_regions_default);
+	do_check_addr_range_test(test, test_regions_gaps);
+}
+
+static void domain_addr_lookup_layout_test(struct sbiunit_test_case *test)
+{
+	struct sbi_domain dom;
+	u32 i;
+
+	setup_domain(&dom, test_regions_gaps);
+	SBIUNIT_ASSERT_EQ(test, sbi_domain_build_addr_lookup(&dom), 0);
+
+	/* Intervals must be contiguous and cover the whole address space */
+	SBIUNIT_EXPECT_EQ(test, dom.addr_intervals[0].start, 0);
+	for (i = 1; i < dom.addr_interval_count; i++) {
+		SBIUNIT_EXPECT_EQ(test, dom.addr_intervals[i].start,
+				  dom.addr_intervals[i - 1].end + 1);
+		SBIUNIT_EXPECT_NE(test, dom.addr_intervals[i].reg,
+				  dom.addr_intervals[i - 1].reg);
+	}
+	SBIUNIT_EXPECT_EQ(test, dom.addr_intervals[i - 1].end, -1UL);
+
+	cleanup_domain(&dom);
+}
+
+static struct sbiunit_test_case domain_test_cases[] = {
+	SBIUNIT_TEST_CASE(domain_addr_lookup_layout_test),
+	SBIUNIT_TEST_CASE(domain_check_addr_test),
+	SBIUNIT_TEST_CASE(domain_check_addr_range_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(domain_test_suite, domain_test_cases);
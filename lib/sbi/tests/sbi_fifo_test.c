@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fifo.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_FIFO_ENTRIES	4
+#define TEST_FIFO_MAX_ENTRY	12
+
+static u8 test_fifo_mem[TEST_FIFO_ENTRIES * TEST_FIFO_MAX_ENTRY] __aligned(8);
+
+/* Fill an entry with a pattern derived from its sequence number */
+static void make_entry(u8 *entry, u16 entry_size, u32 seq)
+{
+	u16 i;
+
+	for (i = 0; i < entry_size; i++)
+		entry[i] = (u8)(seq * 31 + i);
+}
+
+static void fifo_basic_test(struct sbiunit_test_case *test)
+{
+	struct sbi_fifo fifo;
+	u32 i, data;
+
+	sbi_fifo_init(&fifo, test_fifo_mem, TEST_FIFO_ENTRIES, sizeof(u32));
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_is_empty(&fifo), true);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(&fifo, &data), SBI_ENOENT);
+
+	for (i = 0; i < TEST_FIFO_ENTRIES; i++) {
+		data = 0x100 + i;
+		SBIUNIT_EXPECT_EQ(test, sbi_fifo_enqueue(&fifo, &data, false), 0);
+	}
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_is_full(&fifo), true);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_avail(&fifo), TEST_FIFO_ENTRIES);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_enqueue(&fifo, &data, false),
+			  SBI_ENOSPC);
+
+	for (i = 0; i < TEST_FIFO_ENTRIES; i++) {
+		SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(&fifo, &data), 0);
+		SBIUNIT_EXPECT_EQ(test, data, 0x100 + i);
+	}
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_is_empty(&fifo), true);
+}
+
+static void fifo_force_test(struct sbiunit_test_case *test)
+{
+	struct sbi_fifo fifo;
+	u32 i, data;
+
+	sbi_fifo_init(&fifo, test_fifo_mem, TEST_FIFO_ENTRIES, sizeof(u32));
+	for (i = 0; i < TEST_FIFO_ENTRIES + 2; i++) {
+		data = i;
+		SBIUNIT_EXPECT_EQ(test, sbi_fifo_enqueue(&fifo, &data, true), 0);
+	}
+
+	/* The two oldest entries are dropped to make room */
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_avail(&fifo), TEST_FIFO_ENTRIES);
+	for (i = 2; i < TEST_FIFO_ENTRIES + 2; i++) {
+		SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(&fifo, &data), 0);
+		SBIUNIT_EXPECT_EQ(test, data, i);
+	}
+}
+
+/* Wrap around several times with every entry size the FIFO special cases */
+static void fifo_wrap_test(struct sbiunit_test_case *test)
+{
+	static const u16 sizes[] = { 1, 2, 4, 8, TEST_FIFO_MAX_ENTRY };
+	u8 in[TEST_FIFO_MAX_ENTRY], out[TEST_FIFO_MAX_ENTRY];
+	u32 s, i, head, tail;
+	struct sbi_fifo fifo;
+
+	for (s = 0; s < array_size(sizes); s++) {
+		sbi_fifo_init(&fifo, test_fifo_mem, TEST_FIFO_ENTRIES, sizes[s]);
+		head = tail = 0;
+
+		for (i = 0; i < 5 * TEST_FIFO_ENTRIES; i++) {
+			make_entry(in, sizes[s], head);
+			SBIUNIT_EXPECT_EQ(test,
+				sbi_fifo_enqueue(&fifo, in, false), 0);
+			head++;
+
+			/* Keep two or three entries queued so head and tail keep moving */
+			if (head - tail < TEST_FIFO_ENTRIES / 2 + (i & 1))
+				continue;
+
+			make_entry(in, sizes[s], tail);
+			SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(&fifo, out), 0);
+			SBIUNIT_EXPECT_MEMEQ(test, in, out, sizes[s]);
+			tail++;
+		}
+
+		SBIUNIT_EXPECT_EQ(test, sbi_fifo_avail(&fifo), head - tail);
+	}
+}
+
+static int fifo_update_fn(void *in, void *data)
+{
+	u32 *match = in, *entry = data;
+
+	if (*entry != *match)
+		return SBI_FIFO_UNCHANGED;
+
+	*entry = ~*entry;
+	return SBI_FIFO_UPDATED;
+}
+
+static void fifo_inplace_update_test(struct sbiunit_test_case *test)
+{
+	struct sbi_fifo fifo;
+	u32 i, data;
+
+	sbi_fifo_init(&fifo, test_fifo_mem, TEST_FIFO_ENTRIES, sizeof(u32));
+	data = 1;
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_inplace_update(&fifo, &data,
+							fifo_update_fn),
+			  SBI_FIFO_UNCHANGED);
+
+	/* Start in the middle of the queue so the walk wraps around */
+	for (i = 0; i < TEST_FIFO_ENTRIES + 2; i++) {
+		data = i;
+		sbi_fifo_enqueue(&fifo, &data, true);
+	}
+
+	data = 1;
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_inplace_update(&fifo, &data,
+							fifo_update_fn),
+			  SBI_FIFO_UNCHANGED);
+	data = 4;
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_inplace_update(&fifo, &data,
+							fifo_update_fn),
+			  SBI_FIFO_UPDATED);
+
+	for (i = 2; i < TEST_FIFO_ENTRIES + 2; i++) {
+		SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(&fifo, &data), 0);
+		SBIUNIT_EXPECT_EQ(test, data, (i == 4) ? ~i : i);
+	}
+}
+
+static void fifo_invalid_test(struct sbiunit_test_case *test)
+{
+	struct sbi_fifo fifo;
+	u32 data = 0;
+
+	sbi_fifo_init(&fifo, test_fifo_mem, TEST_FIFO_ENTRIES, sizeof(u32));
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_enqueue(NULL, &data, false),
+			  SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_enqueue(&fifo, NULL, false),
+			  SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(NULL, &data), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_dequeue(&fifo, NULL), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_is_empty(NULL), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_is_full(NULL), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_fifo_avail(NULL), 0);
+}
+
+static struct sbiunit_test_case fifo_test_cases[] = {
+	SBIUNIT_TEST_CASE(fifo_basic_test),
+	SBIUNIT_TEST_CASE(fifo_force_test),
+	SBIUNIT_TEST_CASE(fifo_wrap_test),
+	SBIUNIT_TEST_CASE(fifo_inplace_update_test),
+	SBIUNIT_TEST_CASE(fifo_invalid_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(fifo_test_suite, fifo_test_cases);
@@ -0,0 +1,105 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hart_pmp.h>
+#include <sbi/sbi_hart_protection.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_unit_test.h>
+
+#ifndef CONFIG_SBI_SMEPMP_SHMEM_WINDOWS
+#define CONFIG_SBI_SMEPMP_SHMEM_WINDOWS	0
+#endif
+
+#define TEST_SHMEM_ORDER	8
+#define TEST_SHMEM_SIZE		(1UL << TEST_SHMEM_ORDER)
+#define TEST_SHMEM_RAM_ORDER	(TEST_SHMEM_ORDER + 1)
+#define TEST_SHMEM_CODE_ORDER	(TEST_SHMEM_ORDER - 2)
+
+/* Stands in for S-mode RAM of the test domains */
+static u8 test_shmem_ram[1UL << TEST_SHMEM_RAM_ORDER]
+				__aligned(1UL << TEST_SHMEM_RAM_ORDER);
+
+static struct sbi_domain_memregion test_shmem_regions[3];
+
+static struct sbi_domain test_shmem_dom = {
+	.name = "shmem_test",
+	.regions = test_shmem_regions,
+};
+
+static void test_shmem_region_set(unsigned int i, unsigned long base,
+				  unsigned long order, unsigned long flags)
+{
+	test_shmem_regions[i].base = base;
+	test_shmem_regions[i].order = order;
+	test_shmem_regions[i].flags = flags;
+	test_shmem_regions[i + 1].order = 0;
+}
+
+/* Try to map the shared memory while current HART runs the test domain */
+static int test_shmem_map(void)
+{
+	unsigned long base = (unsigned long)test_shmem_ram;
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	int ret;
+
+	sbi_update_hartindex_to_domain(current_hartindex(), &test_shmem_dom);
+	ret = sbi_hart_protection_map_shmem(base, TEST_SHMEM_SIZE);
+	if (!ret) {
+		/* Mapping the same shared memory again reuses the window */
+		ret = sbi_hart_protection_map_shmem(base, TEST_SHMEM_SIZE);
+		sbi_hart_protection_unmap_shmem(base, TEST_SHMEM_SIZE);
+	}
+	sbi_update_hartindex_to_domain(current_hartindex(), dom);
+
+	return ret;
+}
+
+static bool test_shmem_windows_supported(void)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+
+	return CONFIG_SBI_SMEPMP_SHMEM_WINDOWS &&
+	       sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP) &&
+	       sbi_hart_pmp_log2gran(scratch) <= TEST_SHMEM_ORDER;
+}
+
+static void smepmp_window_test(struct sbiunit_test_case *test)
+{
+	unsigned long ram = (unsigned long)test_shmem_ram;
+
+	if (!test_shmem_windows_supported())
+		return;
+
+	/* Default region of the root domain */
+	test_shmem_region_set(0, 0, __riscv_xlen, SBI_DOMAIN_MEMREGION_SU_RWX);
+	SBIUNIT_EXPECT_EQ(test, test_shmem_map(), 0);
+
+	/* RAM given to S-mode as RWX */
+	test_shmem_region_set(0, ram, TEST_SHMEM_RAM_ORDER,
+			      SBI_DOMAIN_MEMREGION_SU_RWX);
+	SBIUNIT_EXPECT_EQ(test, test_shmem_map(), 0);
+
+	/* Executable region within the shared memory */
+	test_shmem_region_set(0, ram, TEST_SHMEM_CODE_ORDER,
+			      SBI_DOMAIN_MEMREGION_SU_RWX);
+	test_shmem_region_set(1, ram, TEST_SHMEM_RAM_ORDER,
+			      SBI_DOMAIN_MEMREGION_SU_READABLE |
+			      SBI_DOMAIN_MEMREGION_SU_WRITABLE);
+	SBIUNIT_EXPECT_EQ(test, test_shmem_map(), SBI_ENOTSUPP);
+
+	/* Executable region next to the shared memory */
+	test_shmem_region_set(0, ram + TEST_SHMEM_SIZE, TEST_SHMEM_CODE_ORDER,
+			      SBI_DOMAIN_MEMREGION_SU_RWX);
+	SBIUNIT_EXPECT_EQ(test, test_shmem_map(), 0);
+}
+
+static struct sbiunit_test_case hart_pmp_test_cases[] = {
+	SBIUNIT_TEST_CASE(smepmp_window_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(hart_pmp_test_suite, hart_pmp_test_cases);
@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_HEAP_ALLOCS	8
+#define TEST_HEAP_SIZE		(4 * HEAP_BASE_ALIGN)
+
+/* Heap space which is not handed out to callers */
+static unsigned long heap_unused_space(struct sbi_heap_control *hpctrl)
+{
+	return sbi_heap_free_space_from(hpctrl) +
+	       sbi_heap_reserved_space_from(hpctrl);
+}
+
+static void heap_alloc_free_test(struct sbiunit_test_case *test)
+{
+	unsigned long before = heap_unused_space(&global_hpctrl);
+	void *ptrs[TEST_HEAP_ALLOCS];
+	u32 i, j;
+
+	for (i = 0; i < TEST_HEAP_ALLOCS; i++) {
+		ptrs[i] = sbi_malloc(24 + 40 * i);
+		SBIUNIT_ASSERT_NE(test, ptrs[i], NULL);
+		sbi_memset(ptrs[i], i, 24 + 40 * i);
+	}
+
+	/* Allocations must not overlap */
+	for (i = 0; i < TEST_HEAP_ALLOCS; i++) {
+		for (j = i + 1; j < TEST_HEAP_ALLOCS; j++)
+			SBIUNIT_EXPECT_NE(test, ptrs[i], ptrs[j]);
+		SBIUNIT_EXPECT_EQ(test, ((u8 *)ptrs[i])[23], i);
+	}
+
+	/* Free every other block first to exercise merging */
+	for (i = 0; i < TEST_HEAP_ALLOCS; i += 2)
+		sbi_free(ptrs[i]);
+	for (i = 1; i < TEST_HEAP_ALLOCS; i += 2)
+		sbi_free(ptrs[i]);
+
+	SBIUNIT_EXPECT_EQ(test, heap_unused_space(&global_hpctrl), before);
+}
+
+static void heap_aligned_alloc_test(struct sbiunit_test_case *test)
+{
+	unsigned long align;
+	void *ptr;
+
+	for (align = 64; align <= 4096; align <<= 1) {
+		ptr = sbi_aligned_alloc(align, align);
+		SBIUNIT_ASSERT_NE(test, ptr, NULL);
+		SBIUNIT_EXPECT_EQ(test, (unsigned long)ptr & (align - 1), 0);
+		sbi_free(ptr);
+	}
+
+	/* Alignment must be a power of two */
+	SBIUNIT_EXPECT_EQ(test, sbi_aligned_alloc(96, 96), NULL);
+}
+
+static void heap_zalloc_test(struct sbiunit_test_case *test)
+{
+	u8 *ptr;
+	u32 i;
+
+	ptr = sbi_malloc(256);
+	SBIUNIT_ASSERT_NE(test, ptr, NULL);
+	sbi_memset(ptr, 0xa5, 256);
+	sbi_free(ptr);
+
+	ptr = sbi_zalloc(256);
+	SBIUNIT_ASSERT_NE(test, ptr, NULL);
+	for (i = 0; i < 256; i++)
+		SBIUNIT_EXPECT_EQ(test, ptr[i], 0);
+	sbi_free(ptr);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_malloc(0), NULL);
+}
+
+/* A private heap carved out of the global one */
+static void heap_private_test(struct sbiunit_test_case *test)
+{
+	struct sbi_heap_control *hpctrl;
+	void *base, *ptr, *last = NULL;
+	unsigned long free;
+	u32 count = 0;
+
+	base = sbi_aligned_alloc(HEAP_BASE_ALIGN, TEST_HEAP_SIZE);
+	SBIUNIT_ASSERT_NE(test, base, NULL);
+	SBIUNIT_ASSERT_EQ(test, sbi_heap_alloc_new(&hpctrl), 0);
+	SBIUNIT_ASSERT_NE(test, hpctrl, NULL);
+	SBIUNIT_ASSERT_EQ(test, sbi_heap_init_new(hpctrl, (unsigned long)base,
+						  TEST_HEAP_SIZE), 0);
+
+	/* Exhaust the private heap without touching the global one */
+	while ((ptr = sbi_malloc_from(hpctrl, 64))) {
+		SBIUNIT_EXPECT(test, (unsigned long)ptr >= (unsigned long)base);
+		SBIUNIT_EXPECT(test, (unsigned long)ptr + 64 <=
+			       (unsigned long)base + TEST_HEAP_SIZE);
+		last = ptr;
+		count++;
+	}
+	SBIUNIT_EXPECT(test, count > 0);
+	free = sbi_heap_free_space_from(hpctrl);
+	SBIUNIT_EXPECT_EQ(test, sbi_heap_used_space_from(hpctrl),
+			  TEST_HEAP_SIZE - free -
+			  sbi_heap_reserved_space_from(hpctrl));
+
+	sbi_free_from(hpctrl, last);
+	SBIUNIT_EXPECT_EQ(test, sbi_heap_free_space_from(hpctrl), free + 64);
+	SBIUNIT_EXPECT_EQ(test, sbi_malloc_from(hpctrl, 64), last);
+
+	sbi_free(hpctrl);
+	sbi_free(base);
+}
+
+/* Freed blocks must merge with both neighbours whatever the free order */
+static void heap_coalesce_test(struct sbiunit_test_case *test)
+{
+	void *ptrs[TEST_HEAP_SIZE / 64];
+	struct sbi_heap_control *hpctrl;
+	unsigned long free;
+	u32 i, count = 0;
+	void *base;
+
+	base = sbi_aligned_alloc(HEAP_BASE_ALIGN, TEST_HEAP_SIZE);
+	SBIUNIT_ASSERT_NE(test, base, NULL);
+	SBIUNIT_ASSERT_EQ(test, sbi_heap_alloc_new(&hpctrl), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_heap_init_new(hpctrl, (unsigned long)base,
+						  TEST_HEAP_SIZE), 0);
+
+	while (count < array_size(ptrs) &&
+	       (ptrs[count] = sbi_malloc_from(hpctrl, 64)))
+		count++;
+	SBIUNIT_EXPECT(test, count > 4);
+
+	/* Free every third block of the upper half, then the even and odd ones */
+	for (i = count / 2; i < count; i += 3)
+		sbi_free_from(hpctrl, ptrs[i]);
+	for (i = 0; i < count; i += 2) {
+		if ((i < count / 2) || ((i - count / 2) % 3))
+			sbi_free_from(hpctrl, ptrs[i]);
+	}
+	for (i = 1; i < count; i += 2) {
+		if ((i < count / 2) || ((i - count / 2) % 3))
+			sbi_free_from(hpctrl, ptrs[i]);
+	}
+
+	/* All of the free space is one block again */
+	free = sbi_heap_free_space_from(hpctrl);
+	SBIUNIT_EXPECT_EQ(test, free, count * 64);
+	SBIUNIT_EXPECT_EQ(test, sbi_malloc_from(hpctrl, free), ptrs[0]);
+
+	sbi_free(hpctrl);
+	sbi_free(base);
+}
+
+static struct sbiunit_test_case heap_test_cases[] = {
+	SBIUNIT_TEST_CASE(heap_alloc_free_test),
+	SBIUNIT_TEST_CASE(heap_aligned_alloc_test),
+	SBIUNIT_TEST_CASE(heap_zalloc_test),
+	SBIUNIT_TEST_CASE(heap_private_test),
+	SBIUNIT_TEST_CASE(heap_coalesce_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(heap_test_suite, heap_test_cases);
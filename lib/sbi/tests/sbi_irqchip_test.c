@@ -0,0 +1,212 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_irqchip.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_CHIP_ID		0xfffffff0U
+#define TEST_CHIP_NUM_HWIRQ	256
+
+#define TEST_HWIRQ_FREE		0
+#define TEST_HWIRQ_HANDLED	1
+#define TEST_HWIRQ_RESERVED	2
+
+static u32 test_last_hwirq;
+static u32 test_callback_count;
+static u32 test_eoi_count;
+static u32 test_msi_count;
+
+static int test_callback(u32 hwirq, void *priv)
+{
+	test_last_hwirq = hwirq;
+	test_callback_count++;
+	return (int)(unsigned long)priv;
+}
+
+static void test_write_msi(u32 hwirq, const struct sbi_irqchip_msi_msg *msg,
+			   void *priv)
+{
+	test_msi_count++;
+}
+
+static void test_hwirq_eoi(struct sbi_irqchip_device *chip, u32 hwirq)
+{
+	test_eoi_count++;
+}
+
+static int test_hwirq_set_affinity(struct sbi_irqchip_device *chip, u32 hwirq,
+				   u32 hart_index)
+{
+	return 0;
+}
+
+static struct sbi_irqchip_device test_chip = {
+	.id			= TEST_CHIP_ID,
+	.num_hwirq		= TEST_CHIP_NUM_HWIRQ,
+	.hwirq_eoi		= test_hwirq_eoi,
+	.hwirq_set_affinity	= test_hwirq_set_affinity,
+};
+
+static void setup_chip(struct sbiunit_test_case *test)
+{
+	sbi_hartmask_set_hartindex(current_hartindex(), &test_chip.target_harts);
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_add_device(&test_chip), 0);
+}
+
+static void teardown_chip(struct sbiunit_test_case *test)
+{
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_remove_device(&test_chip), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_find_device(TEST_CHIP_ID), NULL);
+}
+
+/* Check dispatch of every hwirq against the expected handler layout */
+static void check_dispatch(struct sbiunit_test_case *test, const u8 *owned)
+{
+	u32 i, count;
+	int rc;
+
+	for (i = 0; i < TEST_CHIP_NUM_HWIRQ; i++) {
+		count = test_callback_count;
+		test_eoi_count = 0;
+		rc = sbi_irqchip_process_hwirq(&test_chip, i);
+		SBIUNIT_EXPECT_EQ(test, test_eoi_count, 1);
+		switch (owned[i]) {
+		case TEST_HWIRQ_HANDLED:
+			SBIUNIT_EXPECT_EQ(test, rc, 0);
+			SBIUNIT_EXPECT_EQ(test, test_callback_count, count + 1);
+			SBIUNIT_EXPECT_EQ(test, test_last_hwirq, i);
+			break;
+		case TEST_HWIRQ_RESERVED:
+			SBIUNIT_EXPECT_EQ(test, rc, 0);
+			SBIUNIT_EXPECT_EQ(test, test_callback_count, count);
+			break;
+		default:
+			SBIUNIT_EXPECT_EQ(test, rc, SBI_ENOENT);
+			SBIUNIT_EXPECT_EQ(test, test_callback_count, count);
+			break;
+		}
+	}
+}
+
+static void irqchip_dispatch_test(struct sbiunit_test_case *test)
+{
+	u8 owned[TEST_CHIP_NUM_HWIRQ] = { TEST_HWIRQ_FREE };
+	u32 hart_index;
+
+	setup_chip(test);
+
+	/* Nothing registered yet */
+	check_dispatch(test, owned);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_get_affinity(&test_chip, 8,
+							 &hart_index),
+			  SBI_ENOTSUPP);
+
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_handler(&test_chip, 8, 4,
+				SBI_HWIRQ_FLAGS_NONE, test_callback, NULL), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_handler(&test_chip, 255, 1,
+				SBI_HWIRQ_FLAGS_NONE, test_callback, NULL), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_reserved(&test_chip, 0, 2), 0);
+	sbi_memset(&owned[0], TEST_HWIRQ_RESERVED, 2);
+	sbi_memset(&owned[8], TEST_HWIRQ_HANDLED, 4);
+	owned[255] = TEST_HWIRQ_HANDLED;
+	check_dispatch(test, owned);
+
+	/* Handler return value is propagated */
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_handler(&test_chip, 100, 1,
+				SBI_HWIRQ_FLAGS_NONE, test_callback,
+				(void *)(unsigned long)SBI_EFAIL), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_process_hwirq(&test_chip, 100),
+			  SBI_EFAIL);
+
+	/* Overlapping registrations are rejected */
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_register_handler(&test_chip, 6, 3,
+				SBI_HWIRQ_FLAGS_NONE, test_callback, NULL),
+			  SBI_EALREADY);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_register_reserved(&test_chip, 11, 1),
+			  SBI_EALREADY);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_get_affinity(&test_chip, 8,
+							 &hart_index), 0);
+	SBIUNIT_EXPECT_EQ(test, hart_index, current_hartindex());
+
+	/* Only whole handlers can be unregistered */
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 8, 2),
+			  SBI_ENODEV);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 8, 4), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 255, 1), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 100, 1), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 0, 2), 0);
+	sbi_memset(owned, TEST_HWIRQ_FREE, sizeof(owned));
+	check_dispatch(test, owned);
+
+	teardown_chip(test);
+}
+
+static void irqchip_msi_test(struct sbiunit_test_case *test)
+{
+	struct sbi_irqchip_msi_msg msg = { 0 };
+	u32 first_a, first_b;
+
+	setup_chip(test);
+
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_reserved(&test_chip, 0, 4), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_msi(&test_chip, 8,
+				test_write_msi, test_callback, NULL, &first_a), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_msi(&test_chip, 8,
+				test_write_msi, test_callback, NULL, &first_b), 0);
+	SBIUNIT_EXPECT_EQ(test, first_a, 4);
+	SBIUNIT_EXPECT_EQ(test, first_b, 12);
+
+	/* MSI writes reach the handler owning the hwirq */
+	test_msi_count = 0;
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_write_msi(&test_chip, first_b + 7,
+						      &msg), 0);
+	SBIUNIT_EXPECT_EQ(test, test_msi_count, 1);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_write_msi(&test_chip, 2, &msg),
+			  SBI_ENOTSUPP);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_write_msi(&test_chip, first_b + 8,
+						      &msg), SBI_EFAIL);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_process_hwirq(&test_chip, first_a), 0);
+	SBIUNIT_EXPECT_EQ(test, test_last_hwirq, first_a);
+
+	/* Freed range is handed out again */
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip,
+							       first_a, 8), 0);
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_msi(&test_chip, 8,
+				test_write_msi, test_callback, NULL, &first_a), 0);
+	SBIUNIT_EXPECT_EQ(test, first_a, 4);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip,
+							       first_a, 8), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip,
+							       first_b, 8), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 0, 4), 0);
+
+	teardown_chip(test);
+}
+
+static void irqchip_remove_test(struct sbiunit_test_case *test)
+{
+	setup_chip(test);
+
+	/* Chips with handlers can't be removed */
+	SBIUNIT_ASSERT_EQ(test, sbi_irqchip_register_reserved(&test_chip, 0, 1), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_remove_device(&test_chip),
+			  SBI_EINVALID_STATE);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_unregister_handler(&test_chip, 0, 1), 0);
+
+	teardown_chip(test);
+	SBIUNIT_EXPECT_EQ(test, sbi_irqchip_remove_device(&test_chip), SBI_EINVAL);
+}
+
+static struct sbiunit_test_case irqchip_test_cases[] = {
+	SBIUNIT_TEST_CASE(irqchip_dispatch_test),
+	SBIUNIT_TEST_CASE(irqchip_msi_test),
+	SBIUNIT_TEST_CASE(irqchip_remove_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(irqchip_test_suite, irqchip_test_cases);
@@ -0,0 +1,205 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_byteorder.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_TRACE_RECORDS	4
+#define TEST_TRACE_BUF_ORDER	8
+#define TEST_TRACE_EVENT	SBI_TRACE_SSE_COMPLETE
+#define TEST_TRACE_OTHER_EVENT	SBI_TRACE_SSE_INJECT
+#define TEST_TRACE_WRAP_COUNT	4096
+
+_Static_assert(TEST_TRACE_RECORDS * sizeof(struct sbi_trace_record) <=
+	       (1UL << TEST_TRACE_BUF_ORDER), "trace test buffer too small");
+
+/* Records are read into a buffer which S-mode of the test domain owns */
+static struct sbi_trace_record test_trace_buf[TEST_TRACE_RECORDS]
+				__aligned(1UL << TEST_TRACE_BUF_ORDER);
+static struct sbi_trace_record test_trace_nobuf[TEST_TRACE_RECORDS]
+				__aligned(1UL << TEST_TRACE_BUF_ORDER);
+
+static struct sbi_domain_memregion test_trace_regions[2];
+
+static struct sbi_domain test_trace_dom = {
+	.name = "trace_test",
+	.regions = test_trace_regions,
+};
+
+static struct sbi_domain *test_trace_prev_dom;
+static unsigned long test_trace_prev_events;
+
+static void trace_test_enter(struct sbiunit_test_case *test)
+{
+	test_trace_regions[0].base = (unsigned long)test_trace_buf;
+	test_trace_regions[0].order = TEST_TRACE_BUF_ORDER;
+	test_trace_regions[0].flags = SBI_DOMAIN_MEMREGION_SU_READABLE |
+				      SBI_DOMAIN_MEMREGION_SU_WRITABLE;
+
+	SBIUNIT_ASSERT_EQ(test, sbi_trace_set_events(BIT(TEST_TRACE_EVENT),
+						     &test_trace_prev_events), 0);
+
+	test_trace_prev_dom = sbi_domain_thishart_ptr();
+	sbi_update_hartindex_to_domain(current_hartindex(), &test_trace_dom);
+}
+
+static void trace_test_exit(struct sbiunit_test_case *test)
+{
+	unsigned long events;
+
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_set_events(test_trace_prev_events,
+						     &events), 0);
+	SBIUNIT_EXPECT_EQ(test, events, BIT(TEST_TRACE_EVENT));
+
+	sbi_update_hartindex_to_domain(current_hartindex(),
+				       test_trace_prev_dom);
+}
+
+static int trace_test_read(unsigned long start, u32 count, u32 *out_count)
+{
+	return sbi_trace_read_records(current_hartid(), start, count,
+				      (unsigned long)test_trace_buf, out_count);
+}
+
+/* Sequence number of the next record of current HART */
+static unsigned long trace_test_head(struct sbiunit_test_case *test)
+{
+	unsigned long head = 0;
+	u32 count;
+
+	do {
+		SBIUNIT_ASSERT_EQ(test, trace_test_read(head,
+					TEST_TRACE_RECORDS, &count), 0);
+		if (count)
+			head = le64_to_cpu(test_trace_buf[count - 1].seq) + 1;
+	} while (count);
+
+	return head;
+}
+
+static void trace_set_events_test(struct sbiunit_test_case *test)
+{
+	unsigned long prev, events = sbi_trace_events;
+
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_set_events(BIT(SBI_TRACE_EVENT_MAX),
+						     &prev), SBI_EINVAL);
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_events, events);
+
+	SBIUNIT_ASSERT_EQ(test, sbi_trace_set_events(SBI_TRACE_EVENT_ALL,
+						     &prev), 0);
+	SBIUNIT_EXPECT_EQ(test, prev, events);
+	SBIUNIT_ASSERT_EQ(test, sbi_trace_set_events(events, &prev), 0);
+	SBIUNIT_EXPECT_EQ(test, prev, SBI_TRACE_EVENT_ALL);
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_events, events);
+}
+
+static void trace_read_test(struct sbiunit_test_case *test)
+{
+	unsigned long head;
+	u32 i, count;
+
+	trace_test_enter(test);
+	head = trace_test_head(test);
+
+	/* Disabled events are not recorded */
+	for (i = 0; i < 3; i++) {
+		sbi_trace(TEST_TRACE_EVENT, i, 0x22, 0x33, 0x44);
+		sbi_trace(TEST_TRACE_OTHER_EVENT, i, 0, 0, 0);
+	}
+
+	SBIUNIT_EXPECT_EQ(test, trace_test_read(head, TEST_TRACE_RECORDS,
+						&count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, 3);
+	for (i = 0; i < count; i++) {
+		SBIUNIT_EXPECT_EQ(test, le64_to_cpu(test_trace_buf[i].seq),
+				  head + i);
+		SBIUNIT_EXPECT_EQ(test, le32_to_cpu(test_trace_buf[i].event),
+				  TEST_TRACE_EVENT);
+		SBIUNIT_EXPECT_EQ(test, le32_to_cpu(test_trace_buf[i].hartid),
+				  current_hartid());
+		SBIUNIT_EXPECT_EQ(test, le64_to_cpu(test_trace_buf[i].args[0]),
+				  i);
+		SBIUNIT_EXPECT_EQ(test, le64_to_cpu(test_trace_buf[i].args[3]),
+				  0x44);
+	}
+
+	/* Reads resume at any sequence number up to the head */
+	SBIUNIT_EXPECT_EQ(test, trace_test_read(head + 2, TEST_TRACE_RECORDS,
+						&count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, 1);
+	SBIUNIT_EXPECT_EQ(test, le64_to_cpu(test_trace_buf[0].seq), head + 2);
+	SBIUNIT_EXPECT_EQ(test, trace_test_read(head + 3, TEST_TRACE_RECORDS,
+						&count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, 0);
+	SBIUNIT_EXPECT_EQ(test, trace_test_read(head + 4, TEST_TRACE_RECORDS,
+						&count), SBI_EINVAL);
+
+	trace_test_exit(test);
+}
+
+static void trace_wrap_test(struct sbiunit_test_case *test)
+{
+	unsigned long head, first;
+	u32 i, count;
+
+	trace_test_enter(test);
+	head = trace_test_head(test);
+
+	for (i = 0; i < TEST_TRACE_WRAP_COUNT; i++)
+		sbi_trace(TEST_TRACE_EVENT, i, 0, 0, 0);
+
+	/* Overwritten records are skipped */
+	SBIUNIT_EXPECT_EQ(test, trace_test_read(head, TEST_TRACE_RECORDS,
+						&count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, TEST_TRACE_RECORDS);
+	first = le64_to_cpu(test_trace_buf[0].seq);
+	SBIUNIT_EXPECT(test, first > head);
+	SBIUNIT_EXPECT_EQ(test, le64_to_cpu(test_trace_buf[0].args[0]),
+			  first - head);
+	SBIUNIT_EXPECT_EQ(test, trace_test_head(test),
+			  head + TEST_TRACE_WRAP_COUNT);
+
+	trace_test_exit(test);
+}
+
+static void trace_read_args_test(struct sbiunit_test_case *test)
+{
+	u32 count = 1;
+
+	trace_test_enter(test);
+
+	/* Buffer outside the memory of the domain */
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_read_records(current_hartid(), 0,
+				TEST_TRACE_RECORDS,
+				(unsigned long)test_trace_nobuf, &count),
+			  SBI_EINVALID_ADDR);
+
+	/* Buffer crossing the end of the memory of the domain */
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_read_records(current_hartid(), 0,
+				TEST_TRACE_RECORDS,
+				(unsigned long)&test_trace_buf[1], &count),
+			  SBI_EINVALID_ADDR);
+
+	SBIUNIT_EXPECT_EQ(test, sbi_trace_read_records(-1U, 0,
+				TEST_TRACE_RECORDS,
+				(unsigned long)test_trace_buf, &count),
+			  SBI_EINVAL);
+
+	SBIUNIT_EXPECT_EQ(test, trace_test_read(0, 0, &count), 0);
+	SBIUNIT_EXPECT_EQ(test, count, 0);
+
+	trace_test_exit(test);
+}
+
+static struct sbiunit_test_case trace_test_cases[] = {
+	SBIUNIT_TEST_CASE(trace_set_events_test),
+	SBIUNIT_TEST_CASE(trace_read_test),
+	SBIUNIT_TEST_CASE(trace_wrap_test),
+	SBIUNIT_TEST_CASE(trace_read_args_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(trace_test_suite, trace_test_cases);
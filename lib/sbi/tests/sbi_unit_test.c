@@ -13,7 +13,7 @@
 
 extern struct sbiunit_test_suite *const sbi_unit_tests[];
 
-static void run_test_suite(struct sbiunit_test_suite *suite)
+static u32 run_test_suite(struct sbiunit_test_suite *suite)
 {
 	struct sbiunit_test_case *s_case;
 	u32 count_pass = 0, count_fail = 0;
@@ -39,14 +39,18 @@ static void run_test_suite(struct sbiunit_test_suite *suite)
 
 	sbi_printf("%u PASSED / %u FAILED / %u TOTAL\n", count_pass, count_fail,
 		   count_pass + count_fail);
+
+	return count_fail;
 }
 
-void run_all_tests(void)
+u32 run_all_tests(void)
 {
-	u32 i;
+	u32 i, count_fail = 0;
 
 	sbi_printf("\n# Running SBIUNIT tests #\n");
 
 	for (i = 0; sbi_unit_tests[i]; i++)
-		run_test_suite(sbi_unit_tests[i]);
+		count_fail += run_test_suite(sbi_unit_tests[i]);
+
+	return count_fail;
 }
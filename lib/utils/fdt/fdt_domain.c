@@ -17,6 +17,7 @@
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi_utils/fdt/fdt_domain.h>
+#include <sbi_utils/fdt/fdt_fixup.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 
 int fdt_iterate_each_domain(void *fdt, void *opaque,
@@ -125,22 +126,6 @@ static int __fixup_find_domain_offset(void *fdt, int doff, void *p)
 				 SBI_DOMAIN_MEMREGION_WRITEABLE | \
 				 SBI_DOMAIN_MEMREGION_EXECUTABLE)
 
-static int __fixup_count_disable_devices(void *fdt, int doff, int roff,
-					 u32 perm, void *p)
-{
-	int len;
-	u32 *dcount = p;
-
-	if (perm & DISABLE_DEVICES_MASK)
-		return 0;
-
-	len = 0;
-	if (fdt_getprop(fdt, roff, "devices", &len))
-		*dcount += len / sizeof(u32);
-
-	return 0;
-}
-
 static int __fixup_disable_devices(void *fdt, int doff, int roff,
 				   u32 raccess, void *p)
 {
@@ -162,7 +147,7 @@ static int __fixup_disable_devices(void *fdt, int doff, int roff,
 		if (coff < 0)
 			return coff;
 
-		fdt_setprop_string(fdt, coff, "status", "disabled");
+		fdt_fixup_setprop_string(fdt, coff, "status", "disabled");
 	}
 
 	return 0;
@@ -170,7 +155,7 @@ static int __fixup_disable_devices(void *fdt, int doff, int roff,
 
 void fdt_domain_fixup(void *fdt)
 {
-	u32 i, dcount;
+	u32 i;
 	int err, poffset, doffset;
 	struct sbi_domain *dom = sbi_domain_thishart_ptr();
 	struct __fixup_find_domain_offset_info fdo;
@@ -202,29 +187,14 @@ void fdt_domain_fixup(void *fdt)
 	if (doffset < 0)
 		goto skip_device_disable;
 
-	/* Count current domain device DT nodes to be disabled */
-	dcount = 0;
-	fdt_iterate_each_memregion(fdt, doffset, &dcount,
-				   __fixup_count_disable_devices);
-	if (!dcount)
-		goto skip_device_disable;
-
-	/* Expand FDT based on device DT nodes to be disabled */
-	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + dcount * 32);
-	if (err < 0)
-		return;
-
-	/* Again find current domain DT node */
-	doffset = -1;
-	fdo.name = dom->name;
-	fdo.doffset = &doffset;
-	fdt_iterate_each_domain(fdt, &fdo, __fixup_find_domain_offset);
-	if (doffset < 0)
-		goto skip_device_disable;
-
-	/* Disable device DT nodes for current domain */
+	/*
+	 * Disable device DT nodes for current domain. The edits are
+	 * collected so DT node offsets don't change while iterating.
+	 */
+	fdt_fixup_plan_begin();
 	fdt_iterate_each_memregion(fdt, doffset, NULL,
 				   __fixup_disable_devices);
+	fdt_fixup_plan_end(fdt);
 skip_device_disable:
 
 	/* Remove the OpenSBI domain config DT node */
@@ -354,7 +324,7 @@ static int __fdt_parse_domain(const void *fdt, int domain_offset, void *opaque)
 	len = len / sizeof(u32);
 	if (val && len) {
 		for (i = 0; i < len; i++) {
-			cpu_offset = fdt_node_offset_by_phandle(fdt,
+			cpu_offset = fdt_node_offset_by_phandle_cached(fdt,
 							fdt32_to_cpu(val[i]));
 			if (cpu_offset < 0) {
 				err = cpu_offset;
@@ -426,7 +396,7 @@ static int __fdt_parse_domain(const void *fdt, int domain_offset, void *opaque)
 	val32 = current_hartid();
 	val = fdt_getprop(fdt, domain_offset, "boot-hart", &len);
 	if (val && len >= 4) {
-		cpu_offset = fdt_node_offset_by_phandle(fdt,
+		cpu_offset = fdt_node_offset_by_phandle_cached(fdt,
 							 fdt32_to_cpu(*val));
 		if (cpu_offset >= 0 && fdt_node_is_enabled(fdt, cpu_offset))
 			fdt_parse_hart_id(fdt, cpu_offset, &val32);
@@ -509,7 +479,7 @@ static int __fdt_parse_domain(const void *fdt, int domain_offset, void *opaque)
 			continue;
 
 		/* However, it should be valid if specified */
-		doffset = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+		doffset = fdt_node_offset_by_phandle_cached(fdt, fdt32_to_cpu(*val));
 		if (doffset < 0) {
 			err = doffset;
 			goto fail_free_all;
@@ -567,7 +537,7 @@ int fdt_domains_populate(const void *fdt)
 
 		val = fdt_getprop(fdt, cpu_offset, "opensbi-domain", &len);
 		if (val && len >= 4)
-			cold_domain_offset = fdt_node_offset_by_phandle(fdt,
+			cold_domain_offset = fdt_node_offset_by_phandle_cached(fdt,
 							   fdt32_to_cpu(*val));
 
 		break;
@@ -7,6 +7,7 @@
 #include <libfdt.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
 #include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 
@@ -54,9 +55,147 @@ found:
 	return rc;
 }
 
-static int fdt_driver_init_scan(const void *fdt,
-				const struct fdt_driver *const *drivers,
-				bool one)
+/*
+ * Index of compatible strings of all DT nodes
+ *
+ * Walking every DT node and comparing each compatible string against
+ * each match table entry of each driver is expensive on devicetrees
+ * with thousands of nodes, especially because every subsystem does
+ * its own scan. The index is built once and is a hash table mapping
+ * the hash of each compatible string to the nodes having it. Each hash
+ * chain is kept in devicetree order, so a scan merges the chains of all
+ * match table entries and only visits nodes which may match a driver.
+ *
+ * The index is rebuilt when the devicetree blob moves, when the size of
+ * its structure block changes, or after fdt_driver_index_invalidate()
+ * is called by code which modifies the devicetree.
+ */
+struct fdt_compat_entry {
+	int nodeoff;
+	u32 hash;
+	/* Index + 1 of the next entry in the same bucket (0 at the end) */
+	u32 next;
+};
+
+static struct {
+	const void *fdt;
+	u32 size_dt_struct;
+	bool stale;
+	u32 count;
+	struct fdt_compat_entry *entries;
+	u32 bucket_mask;
+	/* Index + 1 of the first entry of each bucket (0 if empty) */
+	u32 *buckets;
+	/* Number of scans in progress (driver init can do nested scans) */
+	u32 scan_depth;
+} compat_index;
+
+static u32 fdt_compat_hash(const char *str, int len)
+{
+	u32 hash = 2166136261U;
+
+	while (len-- > 0 && *str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static u32 fdt_compat_index_fill(const void *fdt,
+				 struct fdt_compat_entry *entries)
+{
+	int nodeoff, prop_len, compat_len;
+	const char *compat_str;
+	u32 count = 0;
+
+	for (nodeoff = fdt_next_node(fdt, -1, NULL);
+	     nodeoff >= 0;
+	     nodeoff = fdt_next_node(fdt, nodeoff, NULL)) {
+		compat_str = fdt_getprop(fdt, nodeoff, "compatible", &prop_len);
+		if (!compat_str)
+			continue;
+
+		while ((compat_len = strnlen(compat_str, prop_len) + 1) <= prop_len) {
+			if (entries) {
+				entries[count].nodeoff = nodeoff;
+				entries[count].hash = fdt_compat_hash(compat_str,
+								      compat_len);
+			}
+			count++;
+
+			compat_str += compat_len;
+			prop_len -= compat_len;
+		}
+	}
+
+	return count;
+}
+
+void fdt_driver_index_invalidate(void)
+{
+	compat_index.stale = true;
+}
+
+static bool fdt_compat_index_update(const void *fdt)
+{
+	struct fdt_compat_entry *ent;
+	u32 count, table_size, i, *bucket;
+
+	if (compat_index.entries && !compat_index.stale &&
+	    compat_index.fdt == fdt &&
+	    compat_index.size_dt_struct == fdt_size_dt_struct(fdt))
+		return true;
+
+	/* Never free the index while an outer scan is using it */
+	if (compat_index.scan_depth)
+		return false;
+
+	sbi_free(compat_index.entries);
+	sbi_free(compat_index.buckets);
+	compat_index.entries = NULL;
+	compat_index.buckets = NULL;
+
+	count = fdt_compat_index_fill(fdt, NULL);
+
+	/* Keep the hash table at most half full */
+	table_size = 2;
+	while (table_size < 2 * count)
+		table_size <<= 1;
+
+	compat_index.entries = sbi_malloc(sizeof(*compat_index.entries) *
+					  (count ? count : 1));
+	compat_index.buckets = sbi_zalloc(sizeof(*compat_index.buckets) *
+					  table_size);
+	if (!compat_index.entries || !compat_index.buckets) {
+		sbi_free(compat_index.entries);
+		sbi_free(compat_index.buckets);
+		compat_index.entries = NULL;
+		compat_index.buckets = NULL;
+		return false;
+	}
+
+	compat_index.fdt = fdt;
+	compat_index.size_dt_struct = fdt_size_dt_struct(fdt);
+	compat_index.stale = false;
+	compat_index.bucket_mask = table_size - 1;
+	compat_index.count = fdt_compat_index_fill(fdt, compat_index.entries);
+
+	/* Insert backwards so each chain is in devicetree order */
+	for (i = compat_index.count; i > 0; i--) {
+		ent = &compat_index.entries[i - 1];
+		bucket = &compat_index.buckets[ent->hash &
+					       compat_index.bucket_mask];
+		ent->next = *bucket;
+		*bucket = i;
+	}
+
+	return true;
+}
+
+static int fdt_driver_init_scan_nodes(const void *fdt,
+				      const struct fdt_driver *const *drivers,
+				      bool one)
 {
 	int nodeoff, rc;
 
@@ -75,6 +214,89 @@ static int fdt_driver_init_scan(const void *fdt,
 	return one ? SBI_ENODEV : 0;
 }
 
+static int fdt_driver_init_scan_index(const void *fdt,
+				      const struct fdt_driver *const *drivers,
+				      bool one)
+{
+	const struct fdt_compat_entry *entries = compat_index.entries;
+	u32 i, j, match_count = 0, best, *hashes, *cursors;
+	const struct fdt_driver *driver;
+	const struct fdt_match *match;
+	int last = -1, rc;
+
+	for (i = 0; (driver = drivers[i]); i++)
+		for (match = driver->match_table; match->compatible; match++)
+			match_count++;
+
+	/* Hash and current chain position of each match table entry */
+	hashes = sbi_malloc(2 * sizeof(*hashes) *
+			    (match_count ? match_count : 1));
+	if (!hashes)
+		return fdt_driver_init_scan_nodes(fdt, drivers, one);
+	cursors = hashes + match_count;
+
+	j = 0;
+	for (i = 0; (driver = drivers[i]); i++) {
+		for (match = driver->match_table; match->compatible; match++) {
+			hashes[j] = fdt_compat_hash(match->compatible, INT_MAX);
+			cursors[j] = compat_index.buckets[hashes[j] &
+							  compat_index.bucket_mask];
+			j++;
+		}
+	}
+
+	while (true) {
+		/* Find the first node after the last one visited */
+		best = 0;
+		for (j = 0; j < match_count; j++) {
+			while (cursors[j] &&
+			       (entries[cursors[j] - 1].hash != hashes[j] ||
+				entries[cursors[j] - 1].nodeoff <= last))
+				cursors[j] = entries[cursors[j] - 1].next;
+			if (cursors[j] && (!best ||
+			    entries[cursors[j] - 1].nodeoff <
+			    entries[best - 1].nodeoff))
+				best = cursors[j];
+		}
+		if (!best)
+			break;
+		last = entries[best - 1].nodeoff;
+
+		/* Exact match is done using the compatible strings of node */
+		rc = fdt_driver_init_by_offset(fdt, last, drivers);
+		if (rc == SBI_ENODEV)
+			continue;
+		if (rc < 0)
+			goto done;
+		if (one) {
+			rc = 0;
+			goto done;
+		}
+	}
+
+	rc = one ? SBI_ENODEV : 0;
+done:
+	sbi_free(hashes);
+	return rc;
+}
+
+static int fdt_driver_init_scan(const void *fdt,
+				const struct fdt_driver *const *drivers,
+				bool one)
+{
+	int rc;
+
+	/* Fallback to walking all nodes if the index is not available */
+	if (!fdt_compat_index_update(fdt))
+		return fdt_driver_init_scan_nodes(fdt, drivers, one);
+
+	compat_index.scan_depth++;
+	rc = fdt_driver_init_scan_index(fdt, drivers, one);
+	compat_index.scan_depth--;
+
+	return rc;
+}
+
 int fdt_driver_init_all(const void *fdt,
 			const struct fdt_driver *const *drivers)
 {
@@ -17,6 +17,7 @@
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_timer.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_fixup.h>
 #include <sbi_utils/fdt/fdt_pmu.h>
 #include <sbi_utils/fdt/fdt_helper.h>
@@ -124,14 +125,12 @@ void fdt_cpu_fixup(void *fdt)
 			  sbi_hart_has_csr(scratch, SBI_HART_CSR_CYCLE) &&
 			  sbi_hart_has_csr(scratch, SBI_HART_CSR_INSTRET);
 
-	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 32);
-	if (err < 0)
-		return;
-
 	cpus_offset = fdt_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0)
 		return;
 
+	fdt_fixup_plan_begin();
+
 	fdt_for_each_subnode(cpu_offset, fdt, cpus_offset) {
 		err = fdt_parse_hart_id(fdt, cpu_offset, &hartid);
 		if (err)
@@ -150,8 +149,8 @@ void fdt_cpu_fixup(void *fdt)
 		mmu_type = fdt_getprop(fdt, cpu_offset, "mmu-type", &len);
 		if (!sbi_domain_is_assigned_hart(dom, hartindex) ||
 		    !mmu_type || !len)
-			fdt_setprop_string(fdt, cpu_offset, "status",
-					   "disabled");
+			fdt_fixup_setprop_string(fdt, cpu_offset, "status",
+						 "disabled");
 
 		if (!emulated_zicntr)
 			continue;
@@ -163,15 +162,13 @@ void fdt_cpu_fixup(void *fdt)
 		 * property if there hasn't been already one.
 		 */
 		if (extensions &&
-		    !fdt_stringlist_contains(extensions, len, "zicntr")) {
-			err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 16);
-			if (err)
-				continue;
-
-			fdt_appendprop_string(fdt, cpu_offset,
-					      "riscv,isa-extensions", "zicntr");
-		}
+		    !fdt_stringlist_contains(extensions, len, "zicntr"))
+			fdt_fixup_appendprop_string(fdt, cpu_offset,
+						    "riscv,isa-extensions",
+						    "zicntr");
 	}
+
+	fdt_fixup_plan_end(fdt);
 }
 
 static void fdt_domain_based_fixup_one(void *fdt, int nodeoff)
@@ -185,12 +182,8 @@ static void fdt_domain_based_fixup_one(void *fdt, int nodeoff)
 		return;
 
 	if (!sbi_domain_check_addr(dom, reg_addr, dom->next_mode,
-				    SBI_DOMAIN_READ | SBI_DOMAIN_WRITE | SBI_DOMAIN_MMIO)) {
-		rc = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 32);
-		if (rc < 0)
-			return;
-		fdt_setprop_string(fdt, nodeoff, "status", "disabled");
-	}
+				    SBI_DOMAIN_READ | SBI_DOMAIN_WRITE | SBI_DOMAIN_MMIO))
+		fdt_fixup_setprop_string(fdt, nodeoff, "status", "disabled");
 }
 
 static void fdt_fixup_node(void *fdt, const char *compatible)
@@ -463,12 +456,20 @@ void fdt_fixups(void *fdt)
 {
 	struct fdt_general_fixup *f;
 
+	fdt_lookup_cache_invalidate();
+	fdt_driver_index_invalidate();
+
+	fdt_fixup_plan_begin();
+
 	fdt_aplic_fixup(fdt);
 
 	fdt_imsic_fixup(fdt);
 
 	fdt_plic_fixup(fdt);
 
+	/* Nodes are added below so apply the collected edits first */
+	fdt_fixup_plan_apply(fdt);
+
 	fdt_reserved_memory_fixup(fdt);
 
 #ifndef CONFIG_FDT_FIXUPS_PRESERVE_PMU_NODE
@@ -477,6 +478,14 @@ void fdt_fixups(void *fdt)
 
 	fdt_config_fixup(fdt);
 
-	sbi_list_for_each_entry(f, &fixup_list, head)
+	/* General fixups may edit the device tree directly using libfdt */
+	sbi_list_for_each_entry(f, &fixup_list, head) {
 		f->do_fixup(f, fdt);
+		fdt_fixup_plan_apply(fdt);
+	}
+
+	fdt_fixup_plan_end(fdt);
+
+	fdt_lookup_cache_invalidate();
+	fdt_driver_index_invalidate();
 }
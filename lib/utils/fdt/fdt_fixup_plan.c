@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * fdt_fixup_plan.c - Batched DT property edits for DT fixups
+ *
+ * Every property added or grown by libfdt moves the rest of the blob, so
+ * fixups which touch many nodes (such as disabling CPUs or devices) cost
+ * a memmove of the devicetree per edited node. While a plan is active,
+ * property edits are only recorded. They are applied later in a single
+ * sweep which moves every byte of the devicetree at most once.
+ */
+
+#include <libfdt.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_string.h>
+#include <sbi_utils/fdt/fdt_driver.h>
+#include <sbi_utils/fdt/fdt_fixup.h>
+#include <sbi_utils/fdt/fdt_helper.h>
+
+#define FDT_FIXUP_ALIGN(__len)		\
+	(((__len) + FDT_TAGSIZE - 1) & ~(FDT_TAGSIZE - 1))
+#define FDT_FIXUP_PROP_SIZE(__len)	\
+	(sizeof(struct fdt_property) + FDT_FIXUP_ALIGN(__len))
+
+struct fdt_fixup_edit {
+	/* Recorded edit (name and value are stored in the pool) */
+	int nodeoff;
+	u32 name;
+	u32 val;
+	u32 len;
+	bool append;
+	/* Resolved by fdt_fixup_plan_apply() */
+	int pos;
+	int old_size;
+	int new_size;
+	u32 nameoff;
+};
+
+static struct {
+	u32 depth;
+	u32 count;
+	u32 max;
+	struct fdt_fixup_edit *edits;
+	u32 pool_used;
+	u32 pool_size;
+	char *pool;
+} plan;
+
+static bool fdt_fixup_plan_grow(u32 pool_need)
+{
+	struct fdt_fixup_edit *edits;
+	u32 max, size;
+	char *pool;
+
+	if (plan.count == plan.max) {
+		max = plan.max ? plan.max * 2 : 32;
+		edits = sbi_malloc(sizeof(*edits) * max);
+		if (!edits)
+			return false;
+		if (plan.edits)
+			sbi_memcpy(edits, plan.edits, sizeof(*edits) * plan.count);
+		sbi_free(plan.edits);
+		plan.edits = edits;
+		plan.max = max;
+	}
+
+	if (plan.pool_size - plan.pool_used < pool_need) {
+		size = plan.pool_size ? plan.pool_size : 256;
+		while (size - plan.pool_used < pool_need)
+			size *= 2;
+		pool = sbi_malloc(size);
+		if (!pool)
+			return false;
+		if (plan.pool)
+			sbi_memcpy(pool, plan.pool, plan.pool_used);
+		sbi_free(plan.pool);
+		plan.pool = pool;
+		plan.pool_size = size;
+	}
+
+	return true;
+}
+
+static u32 fdt_fixup_plan_store(const void *data, u32 len)
+{
+	u32 ret = plan.pool_used;
+
+	sbi_memcpy(plan.pool + ret, data, len);
+	plan.pool_used += len;
+
+	return ret;
+}
+
+static struct fdt_fixup_edit *fdt_fixup_plan_find(int nodeoff,
+						  const char *name)
+{
+	u32 i;
+
+	/* Fixups usually edit the same node back to back so search backwards */
+	for (i = plan.count; i > 0; i--) {
+		if (plan.edits[i - 1].nodeoff == nodeoff &&
+		    !sbi_strcmp(plan.pool + plan.edits[i - 1].name, name))
+			return &plan.edits[i - 1];
+	}
+
+	return NULL;
+}
+
+static int fdt_fixup_plan_add(int nodeoff, const char *name,
+			      const void *val, int len, bool append)
+{
+	struct fdt_fixup_edit *e = fdt_fixup_plan_find(nodeoff, name);
+	u32 name_len = sbi_strlen(name) + 1, val_off, i;
+
+	if (e) {
+		/* Merge with the edit already recorded for the property */
+		i = e - plan.edits;
+		if (!fdt_fixup_plan_grow(append ? e->len + len : len))
+			return SBI_ENOMEM;
+		e = &plan.edits[i];
+		val_off = plan.pool_used;
+		if (append)
+			fdt_fixup_plan_store(plan.pool + e->val, e->len);
+		fdt_fixup_plan_store(val, len);
+		e->val = val_off;
+		e->len = plan.pool_used - val_off;
+		e->append = append ? e->append : false;
+		return 0;
+	}
+
+	if (!fdt_fixup_plan_grow(name_len + len))
+		return SBI_ENOMEM;
+
+	e = &plan.edits[plan.count++];
+	e->nodeoff = nodeoff;
+	e->name = fdt_fixup_plan_store(name, name_len);
+	e->val = fdt_fixup_plan_store(val, len);
+	e->len = len;
+	e->append = append;
+
+	return 0;
+}
+
+static int fdt_fixup_edit_direct(void *fdt, int nodeoff, const char *name,
+				 const void *val, int len, bool append)
+{
+	int err, old_size = fdt_size_dt_struct(fdt);
+	u32 i;
+
+	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) +
+			    FDT_FIXUP_PROP_SIZE(len) + sbi_strlen(name) + 1);
+	if (err < 0)
+		return err;
+
+	if (append)
+		err = fdt_appendprop(fdt, nodeoff, name, val, len);
+	else
+		err = fdt_setprop(fdt, nodeoff, name, val, len);
+	if (err < 0)
+		return err;
+
+	/* Nodes after the edited node have moved */
+	for (i = 0; i < plan.count; i++) {
+		if (plan.edits[i].nodeoff > nodeoff)
+			plan.edits[i].nodeoff +=
+				fdt_size_dt_struct(fdt) - old_size;
+	}
+
+	return 0;
+}
+
+static int fdt_fixup_edit(void *fdt, int nodeoff, const char *name,
+			  const void *val, int len, bool append)
+{
+	int rc;
+
+	if (!fdt || nodeoff < 0 || !name || (len && !val) || len < 0)
+		return SBI_EINVAL;
+
+	if (plan.depth) {
+		rc = fdt_fixup_plan_add(nodeoff, name, val, len, append);
+		if (rc != SBI_ENOMEM || fdt_fixup_plan_find(nodeoff, name))
+			return rc;
+	}
+
+	return fdt_fixup_edit_direct(fdt, nodeoff, name, val, len, append);
+}
+
+int fdt_fixup_setprop(void *fdt, int nodeoff, const char *name,
+		      const void *val, int len)
+{
+	return fdt_fixup_edit(fdt, nodeoff, name, val, len, false);
+}
+
+int fdt_fixup_appendprop(void *fdt, int nodeoff, const char *name,
+			 const void *val, int len)
+{
+	return fdt_fixup_edit(fdt, nodeoff, name, val, len, true);
+}
+
+void fdt_fixup_plan_begin(void)
+{
+	plan.depth++;
+}
+
+static int fdt_fixup_find_string(const char *strtab, int size,
+				 const char *s)
+{
+	int len = sbi_strlen(s) + 1;
+	const char *p;
+
+	for (p = strtab; p + len <= strtab + size; p++) {
+		if (!sbi_memcmp(p, s, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/* Find the property location and size change of each recorded edit */
+static int fdt_fixup_plan_resolve(void *fdt, u32 *out_count,
+				  int *out_delta, int *out_strings)
+{
+	const char *strtab = (const char *)fdt + fdt_off_dt_strings(fdt);
+	int strtab_size = fdt_size_dt_strings(fdt);
+	const struct fdt_property *prop;
+	struct fdt_fixup_edit *e, tmp;
+	int delta = 0, strings = 0, next, oldlen, off;
+	u32 i, j, count = 0;
+	const char *name;
+
+	for (i = 0; i < plan.count; i++) {
+		e = &plan.edits[i];
+		name = plan.pool + e->name;
+
+		/* Node removed (replaced by NOPs) after the edit was recorded */
+		if (fdt_next_tag(fdt, e->nodeoff, &next) != FDT_BEGIN_NODE)
+			continue;
+
+		prop = fdt_get_property(fdt, e->nodeoff, name, &oldlen);
+		if (prop) {
+			e->pos = (const char *)prop -
+				 (const char *)fdt_offset_ptr(fdt, 0, 0);
+			e->old_size = FDT_FIXUP_PROP_SIZE(oldlen);
+			e->nameoff = fdt32_to_cpu(prop->nameoff);
+			if (!e->append)
+				oldlen = 0;
+		} else {
+			/* New properties are added before existing ones */
+			e->pos = next;
+			e->old_size = 0;
+			e->append = false;
+			oldlen = 0;
+
+			off = fdt_fixup_find_string(strtab, strtab_size, name);
+			if (off < 0) {
+				/* Pending new strings are in the pool */
+				for (j = 0; j < count; j++) {
+					if (plan.edits[j].nameoff >= strtab_size &&
+					    !sbi_strcmp(plan.pool + plan.edits[j].name,
+							name))
+						break;
+				}
+				if (j < count) {
+					off = plan.edits[j].nameoff;
+				} else {
+					off = strtab_size + strings;
+					strings += sbi_strlen(name) + 1;
+				}
+			}
+			e->nameoff = off;
+		}
+
+		/* Shrinking properties are padded with NOPs */
+		e->new_size = FDT_FIXUP_PROP_SIZE(oldlen + e->len);
+		if (e->new_size < e->old_size)
+			e->new_size = e->old_size;
+		delta += e->new_size - e->old_size;
+
+		/*
+		 * Keep resolved edits sorted by position (stable) with new
+		 * properties before an existing property at same position.
+		 */
+		tmp = *e;
+		for (j = count; j > 0; j--) {
+			if (plan.edits[j - 1].pos < tmp.pos ||
+			    (plan.edits[j - 1].pos == tmp.pos &&
+			     (!plan.edits[j - 1].old_size || tmp.old_size)))
+				break;
+			plan.edits[j] = plan.edits[j - 1];
+		}
+		plan.edits[j] = tmp;
+		count++;
+	}
+
+	*out_count = count;
+	*out_delta = delta;
+	*out_strings = strings;
+	return 0;
+}
+
+static void fdt_fixup_plan_write(char *dst, const char *src,
+				 const struct fdt_fixup_edit *e)
+{
+	struct fdt_property *prop = (struct fdt_property *)dst;
+	u32 oldlen = 0, newlen, i;
+	fdt32_t *nop;
+
+	/* Old value of appended property may overlap with destination */
+	if (e->append && e->old_size) {
+		oldlen = fdt32_to_cpu(((const struct fdt_property *)src)->len);
+		sbi_memmove(prop->data, src + sizeof(*prop), oldlen);
+	}
+	newlen = oldlen + e->len;
+
+	prop->tag = cpu_to_fdt32(FDT_PROP);
+	prop->len = cpu_to_fdt32(newlen);
+	prop->nameoff = cpu_to_fdt32(e->nameoff);
+	sbi_memcpy(prop->data + oldlen, plan.pool + e->val, e->len);
+	sbi_memset(prop->data + newlen, 0, FDT_FIXUP_ALIGN(newlen) - newlen);
+
+	nop = (fdt32_t *)(dst + FDT_FIXUP_PROP_SIZE(newlen));
+	for (i = FDT_FIXUP_PROP_SIZE(newlen); i < e->new_size; i += FDT_TAGSIZE)
+		*nop++ = cpu_to_fdt32(FDT_NOP);
+}
+
+int fdt_fixup_plan_apply(void *fdt)
+{
+	int rc, delta, strings, used, shift, seg, src_end, off;
+	const char *name;
+	char *base;
+	u32 i, count;
+
+	if (!plan.count)
+		return 0;
+
+	rc = fdt_fixup_plan_resolve(fdt, &count, &delta, &strings);
+	if (rc)
+		goto done;
+
+	/* Resize the devicetree only once */
+	used = fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt);
+	rc = fdt_open_into(fdt, fdt, MAX((int)fdt_totalsize(fdt),
+					 used + delta + strings));
+	if (rc < 0)
+		goto done;
+	used = fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt);
+	if (used + delta + strings > fdt_totalsize(fdt)) {
+		rc = -FDT_ERR_NOSPACE;
+		goto done;
+	}
+	base = (char *)fdt + fdt_off_dt_struct(fdt);
+	src_end = fdt_size_dt_struct(fdt);
+
+	/* Move the strings block (and anything between) as a whole */
+	sbi_memmove(base + src_end + delta, base + src_end,
+		    used - fdt_off_dt_struct(fdt) - src_end);
+
+	/* Move each segment of the structure block once, from the end */
+	shift = delta;
+	for (i = count; i > 0; i--) {
+		const struct fdt_fixup_edit *e = &plan.edits[i - 1];
+
+		seg = e->pos + e->old_size;
+		sbi_memmove(base + seg + shift, base + seg, src_end - seg);
+		shift -= e->new_size - e->old_size;
+		fdt_fixup_plan_write(base + e->pos + shift, base + e->pos, e);
+		src_end = e->pos;
+	}
+
+	fdt_set_size_dt_struct(fdt, fdt_size_dt_struct(fdt) + delta);
+	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + delta);
+
+	/* Append new property names to the strings block in order */
+	while (strings) {
+		off = fdt_size_dt_strings(fdt);
+		for (i = 0; i < count; i++) {
+			if (plan.edits[i].nameoff == off)
+				break;
+		}
+		if (i == count)
+			break;
+		name = plan.pool + plan.edits[i].name;
+		sbi_memcpy((char *)fdt + fdt_off_dt_strings(fdt) + off,
+			   name, sbi_strlen(name) + 1);
+		fdt_set_size_dt_strings(fdt, off + sbi_strlen(name) + 1);
+		strings -= sbi_strlen(name) + 1;
+	}
+
+done:
+	plan.count = 0;
+	plan.pool_used = 0;
+	fdt_lookup_cache_invalidate();
+	fdt_driver_index_invalidate();
+	return rc < 0 ? rc : 0;
+}
+
+int fdt_fixup_plan_end(void *fdt)
+{
+	int rc;
+
+	if (!plan.depth)
+		return SBI_EINVAL;
+
+	if (--plan.depth)
+		return 0;
+
+	rc = fdt_fixup_plan_apply(fdt);
+
+	sbi_free(plan.edits);
+	sbi_free(plan.pool);
+	sbi_memset(&plan, 0, sizeof(plan));
+
+	return rc;
+}
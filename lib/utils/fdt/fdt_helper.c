@@ -10,6 +10,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_hart.h>
@@ -33,6 +34,211 @@
 #define DEFAULT_SHAKTI_UART_FREQ		50000000
 #define DEFAULT_SHAKTI_UART_BAUD		115200
 
+/*
+ * Lookup cache of phandles and parents of DT nodes
+ *
+ * Both fdt_node_offset_by_phandle() and fdt_parent_offset() of libfdt
+ * walk the devicetree from the start for every call which is expensive
+ * on large devicetrees because drivers resolve phandles and parse the
+ * "reg" DT property of many nodes. The cache is built by walking the
+ * devicetree once and has the parent offset of every node (sorted by
+ * node offset) along with a hash table of phandles.
+ *
+ * The cache is rebuilt when the devicetree blob moves or the size of
+ * its structure block changes. It must be invalidated explicitly by
+ * code which modifies the devicetree without changing its size (such
+ * as fdt_nop_node()). Every cached result is also sanity checked so
+ * lookups fallback to libfdt for stale entries.
+ */
+struct fdt_lookup_node {
+	int offset;
+	int parent;
+};
+
+struct fdt_lookup_phandle {
+	u32 phandle;
+	int offset;
+};
+
+static struct {
+	const void *fdt;
+	u32 size_dt_struct;
+	u32 node_count;
+	struct fdt_lookup_node *nodes;
+	u32 phandle_mask;
+	struct fdt_lookup_phandle *phandles;
+} lookup_cache;
+
+static inline u32 fdt_lookup_phandle_hash(u32 phandle)
+{
+	return phandle * 0x9e3779b1U;
+}
+
+void fdt_lookup_cache_invalidate(void)
+{
+	sbi_free(lookup_cache.nodes);
+	sbi_free(lookup_cache.phandles);
+	memset(&lookup_cache, 0, sizeof(lookup_cache));
+}
+
+static void fdt_lookup_cache_fill(const void *fdt, int *stack)
+{
+	struct fdt_lookup_phandle *ph;
+	int offset, depth = 0;
+	u32 phandle, i;
+
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		stack[depth] = offset;
+		i = lookup_cache.node_count++;
+		lookup_cache.nodes[i].offset = offset;
+		lookup_cache.nodes[i].parent = depth ? stack[depth - 1] :
+						       -FDT_ERR_NOTFOUND;
+
+		phandle = fdt_get_phandle(fdt, offset);
+		if (!phandle || phandle == (u32)-1)
+			continue;
+
+		i = fdt_lookup_phandle_hash(phandle);
+		while (true) {
+			ph = &lookup_cache.phandles[i & lookup_cache.phandle_mask];
+			if (!ph->phandle) {
+				ph->phandle = phandle;
+				ph->offset = offset;
+				break;
+			}
+			/* First node wins for duplicate phandles like libfdt */
+			if (ph->phandle == phandle)
+				break;
+			i++;
+		}
+	}
+}
+
+static bool fdt_lookup_cache_update(const void *fdt)
+{
+	u32 node_count = 0, phandle_count = 0, max_depth = 0, table_size;
+	int offset, depth = 0, *stack;
+
+	if (lookup_cache.fdt == fdt &&
+	    lookup_cache.size_dt_struct == fdt_size_dt_struct(fdt))
+		return lookup_cache.nodes != NULL;
+
+	/* Heap is not available during early boot */
+	if (!sbi_heap_free_space())
+		return false;
+
+	fdt_lookup_cache_invalidate();
+
+	/* Don't retry for the same devicetree if allocation fails below */
+	lookup_cache.fdt = fdt;
+	lookup_cache.size_dt_struct = fdt_size_dt_struct(fdt);
+
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		node_count++;
+		if (max_depth < depth)
+			max_depth = depth;
+		if (fdt_get_phandle(fdt, offset))
+			phandle_count++;
+	}
+	if (offset != -FDT_ERR_NOTFOUND && depth >= 0)
+		return false;
+
+	/* Keep the phandle hash table at most half full */
+	table_size = 2;
+	while (table_size < 2 * phandle_count)
+		table_size <<= 1;
+
+	stack = sbi_malloc(sizeof(*stack) * (max_depth + 1));
+	lookup_cache.nodes = sbi_malloc(sizeof(*lookup_cache.nodes) *
+					node_count);
+	lookup_cache.phandles = sbi_zalloc(sizeof(*lookup_cache.phandles) *
+					   table_size);
+	if (!stack || !lookup_cache.nodes || !lookup_cache.phandles) {
+		sbi_free(stack);
+		sbi_free(lookup_cache.nodes);
+		sbi_free(lookup_cache.phandles);
+		lookup_cache.nodes = NULL;
+		lookup_cache.phandles = NULL;
+		return false;
+	}
+
+	lookup_cache.phandle_mask = table_size - 1;
+	fdt_lookup_cache_fill(fdt, stack);
+	sbi_free(stack);
+
+	return true;
+}
+
+static bool fdt_lookup_is_node(const void *fdt, int offset)
+{
+	int next;
+
+	return fdt_next_tag(fdt, offset, &next) == FDT_BEGIN_NODE;
+}
+
+int fdt_node_offset_by_phandle_cached(const void *fdt, u32 phandle)
+{
+	struct fdt_lookup_phandle *ph;
+	u32 i;
+
+	if (!fdt || !phandle || phandle == (u32)-1 ||
+	    !fdt_lookup_cache_update(fdt))
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	i = fdt_lookup_phandle_hash(phandle);
+	while (true) {
+		ph = &lookup_cache.phandles[i & lookup_cache.phandle_mask];
+		if (!ph->phandle)
+			return -FDT_ERR_NOTFOUND;
+		if (ph->phandle == phandle)
+			break;
+		i++;
+	}
+
+	if (!fdt_lookup_is_node(fdt, ph->offset) ||
+	    fdt_get_phandle(fdt, ph->offset) != phandle) {
+		fdt_lookup_cache_invalidate();
+		return fdt_node_offset_by_phandle(fdt, phandle);
+	}
+
+	return ph->offset;
+}
+
+int fdt_parent_offset_cached(const void *fdt, int nodeoffset)
+{
+	struct fdt_lookup_node *node;
+	u32 lo, hi, mid;
+
+	if (!fdt || nodeoffset < 0 || !fdt_lookup_cache_update(fdt))
+		return fdt_parent_offset(fdt, nodeoffset);
+
+	lo = 0;
+	hi = lookup_cache.node_count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		node = &lookup_cache.nodes[mid];
+		if (node->offset == nodeoffset)
+			goto found;
+		if (node->offset < nodeoffset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return fdt_parent_offset(fdt, nodeoffset);
+
+found:
+	if (!fdt_lookup_is_node(fdt, nodeoffset) ||
+	    (node->parent >= 0 && !fdt_lookup_is_node(fdt, node->parent))) {
+		fdt_lookup_cache_invalidate();
+		return fdt_parent_offset(fdt, nodeoffset);
+	}
+
+	return node->parent;
+}
+
 int fdt_parse_phandle_with_args(const void *fdt, int nodeoff,
 				const char *prop, const char *cells_prop,
 				int index, struct fdt_phandle_args *out_args)
@@ -50,7 +256,7 @@ int fdt_parse_phandle_with_args(const void *fdt, int nodeoff,
 	list_end = list + (len / sizeof(*list));
 
 	while (list < list_end) {
-		pnodeoff = fdt_node_offset_by_phandle(fdt,
+		pnodeoff = fdt_node_offset_by_phandle_cached(fdt,
 						fdt32_to_cpu(*list));
 		if (pnodeoff < 0)
 			return pnodeoff;
@@ -94,7 +300,7 @@ static int fdt_translate_address(const void *fdt, uint64_t reg, int parent,
 		if (cell_child_addr < 1)
 			return SBI_ENODEV;
 
-		cell_parent_addr = fdt_address_cells(fdt, fdt_parent_offset(fdt, parent));
+		cell_parent_addr = fdt_address_cells(fdt, fdt_parent_offset_cached(fdt, parent));
 		if (cell_parent_addr < 1)
 			return SBI_ENODEV;
 
@@ -133,7 +339,7 @@ int fdt_get_node_addr_size(const void *fdt, int node, int index,
 	if (!fdt || node < 0 || index < 0)
 		return SBI_EINVAL;
 
-	parent = fdt_parent_offset(fdt, node);
+	parent = fdt_parent_offset_cached(fdt, node);
 	if (parent < 0)
 		return parent;
 	cell_addr = fdt_address_cells(fdt, parent);
@@ -163,7 +369,7 @@ int fdt_get_node_addr_size(const void *fdt, int node, int index,
 			rc  = fdt_translate_address(fdt, temp, parent, addr);
 			if (rc)
 				break;
-			parent = fdt_parent_offset(fdt, parent);
+			parent = fdt_parent_offset_cached(fdt, parent);
 			temp = *addr;
 		} while (1);
 	}
@@ -588,7 +794,7 @@ static int fdt_aplic_find_imsic_node(const void *fdt, int nodeoff,
 
 	val = fdt_getprop(fdt, nodeoff, "msi-parent", &len);
 	if (val && len >= sizeof(fdt32_t)) {
-		noff = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+		noff = fdt_node_offset_by_phandle_cached(fdt, fdt32_to_cpu(*val));
 		if (noff < 0)
 			return noff;
 
@@ -614,7 +820,7 @@ static int fdt_aplic_find_imsic_node(const void *fdt, int nodeoff,
 	len /= sizeof(fdt32_t);
 
 	for (i = 0; i < len; i++) {
-		noff = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(val[i]));
+		noff = fdt_node_offset_by_phandle_cached(fdt, fdt32_to_cpu(val[i]));
 		if (noff < 0)
 			return noff;
 
@@ -979,11 +1185,11 @@ int fdt_parse_aclint_node(const void *fdt, int nodeoffset,
 		phandle = fdt32_to_cpu(val[2 * i]);
 		hwirq = fdt32_to_cpu(val[(2 * i) + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_node_offset_by_phandle_cached(fdt, phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
-		cpu_offset = fdt_parent_offset(fdt, cpu_intc_offset);
+		cpu_offset = fdt_parent_offset_cached(fdt, cpu_intc_offset);
 		if (cpu_offset < 0)
 			continue;
 
@@ -1037,11 +1243,11 @@ int fdt_parse_plmt_node(const void *fdt, int nodeoffset, unsigned long *plmt_bas
 		phandle = fdt32_to_cpu(val[2 * i]);
 		hwirq = fdt32_to_cpu(val[2 * i + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_node_offset_by_phandle_cached(fdt, phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
-		cpu_offset = fdt_parent_offset(fdt, cpu_intc_offset);
+		cpu_offset = fdt_parent_offset_cached(fdt, cpu_intc_offset);
 		if (cpu_offset < 0)
 			continue;
 
@@ -1093,11 +1299,11 @@ int fdt_parse_plicsw_node(const void *fdt, int nodeoffset, unsigned long *plicsw
 		phandle = fdt32_to_cpu(val[2 * i]);
 		hwirq = fdt32_to_cpu(val[2 * i + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_node_offset_by_phandle_cached(fdt, phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
-		cpu_offset = fdt_parent_offset(fdt, cpu_intc_offset);
+		cpu_offset = fdt_parent_offset_cached(fdt, cpu_intc_offset);
 		if (cpu_offset < 0)
 			continue;
 
@@ -46,11 +46,12 @@ int fdt_pmu_fixup(void *fdt)
 	if (pmu_offset < 0)
 		return SBI_EFAIL;
 
-	fdt_delprop(fdt, pmu_offset, "riscv,event-to-mhpmcounters");
-	fdt_delprop(fdt, pmu_offset, "riscv,event-to-mhpmevent");
-	fdt_delprop(fdt, pmu_offset, "riscv,raw-event-to-mhpmcounters");
+	/* Replace with NOPs instead of deleting to avoid moving the DT */
+	fdt_nop_property(fdt, pmu_offset, "riscv,event-to-mhpmcounters");
+	fdt_nop_property(fdt, pmu_offset, "riscv,event-to-mhpmevent");
+	fdt_nop_property(fdt, pmu_offset, "riscv,raw-event-to-mhpmcounters");
 	if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SSCOFPMF))
-		fdt_delprop(fdt, pmu_offset, "interrupts-extended");
+		fdt_nop_property(fdt, pmu_offset, "interrupts-extended");
 
 	return 0;
 }
@@ -31,11 +31,11 @@ static int irqchip_aplic_update_idc_map(const void *fdt, int nodeoff,
 	for (i = 0; i < count; i += 2) {
 		phandle = fdt32_to_cpu(val[i]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_node_offset_by_phandle_cached(fdt, phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
-		cpu_offset = fdt_parent_offset(fdt, cpu_intc_offset);
+		cpu_offset = fdt_parent_offset_cached(fdt, cpu_intc_offset);
 		if (cpu_offset < 0)
 			continue;
 
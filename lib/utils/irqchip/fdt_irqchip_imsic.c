@@ -32,11 +32,11 @@ static int irqchip_imsic_update_hartid_table(const void *fdt, int nodeoff,
 		phandle = fdt32_to_cpu(val[i]);
 		hwirq = fdt32_to_cpu(val[i + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_node_offset_by_phandle_cached(fdt, phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
-		cpu_offset = fdt_parent_offset(fdt, cpu_intc_offset);
+		cpu_offset = fdt_parent_offset_cached(fdt, cpu_intc_offset);
 		if (cpu_offset < 0)
 			continue;
 
@@ -9,8 +9,11 @@
  */
 
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
 #include <sbi/riscv_io.h>
 #include <sbi/riscv_encoding.h>
+#include <sbi/sbi_bitmap.h>
+#include <sbi/sbi_bitops.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_csr_detect.h>
 #include <sbi/sbi_domain.h>
@@ -96,6 +99,45 @@ static unsigned long imsic_file_offset;
 #define imsic_set_hart_file(__scratch, __file)				\
 	sbi_scratch_write_type((__scratch), long, imsic_file_offset, (__file))
 
+static unsigned long imsic_msi_addr_offset;
+
+#define imsic_get_hart_msi_addr(__scratch)				\
+	sbi_scratch_read_type((__scratch), unsigned long, imsic_msi_addr_offset)
+
+#define imsic_set_hart_msi_addr(__scratch, __addr)			\
+	sbi_scratch_write_type((__scratch), unsigned long,		\
+			       imsic_msi_addr_offset, (__addr))
+
+static unsigned long imsic_sync_offset;
+
+#define imsic_get_hart_sync_ptr(__scratch)				\
+	sbi_scratch_offset_ptr((__scratch), imsic_sync_offset)
+
+/* M-mode identities enabled on every HART (beyond the IPI) */
+static DECLARE_BITMAP(imsic_enabled_ids, IMSIC_MAX_ID + 1);
+
+/* Address of the little-endian MSI page of an interrupt file */
+static unsigned long imsic_file_msi_addr(struct imsic_data *data, int file)
+{
+	struct imsic_regs *regs;
+	unsigned long reloff;
+
+	if (!data || !data->targets_mmode || file < 0)
+		return 0;
+
+	regs = &data->regs[0];
+	reloff = file * (1UL << data->guest_index_bits) * IMSIC_MMIO_PAGE_SZ;
+	while (regs->size && (regs->size <= reloff)) {
+		reloff -= regs->size;
+		regs++;
+	}
+
+	if (!regs->size || (regs->size <= reloff))
+		return 0;
+
+	return regs->addr + reloff + IMSIC_MMIO_PAGE_LE;
+}
+
 int imsic_map_hartid_to_data(u32 hartid, struct imsic_data *imsic, int file)
 {
 	struct sbi_scratch *scratch;
@@ -116,6 +158,7 @@ int imsic_map_hartid_to_data(u32 hartid, struct imsic_data *imsic, int file)
 
 	imsic_set_hart_data_ptr(scratch, imsic);
 	imsic_set_hart_file(scratch, file);
+	imsic_set_hart_msi_addr(scratch, imsic_file_msi_addr(imsic, file));
 	return 0;
 }
 
@@ -150,51 +193,60 @@ int imsic_get_target_file(u32 hartindex)
 static int imsic_process_hwirqs(struct sbi_irqchip_device *chip)
 {
 	ulong mirq;
+	int rc;
 
 	while ((mirq = csr_swap(CSR_MTOPEI, 0))) {
 		mirq = (mirq >> IMSIC_TOPEI_ID_SHIFT);
 
-		switch (mirq) {
-		case IMSIC_IPI_ID:
-			sbi_ipi_process();
-			break;
-		default:
-			sbi_printf("%s: unhandled IRQ%d\n",
-				   __func__, (u32)mirq);
-			break;
-		}
+		/* Dispatch through the per-identity raw handler table */
+		rc = sbi_irqchip_process_hwirq(chip, mirq);
+		if (rc)
+			sbi_printf("%s: unhandled IRQ%d (error %d)\n",
+				   __func__, (u32)mirq, rc);
 	}
 
 	return 0;
 }
 
+static void imsic_local_eie_sync(u32 num_hwirq)
+{
+	unsigned long i, isel, ireg;
+
+	for (i = 0; i < BITS_TO_LONGS(num_hwirq); i++) {
+		ireg = imsic_enabled_ids[i];
+		if (!i)
+			ireg |= BIT(IMSIC_IPI_ID);
+
+		isel = IMSIC_EIE0 + i * (__riscv_xlen / IMSIC_EIEx_BITS);
+		imsic_csr_write(isel, ireg);
+	}
+}
+
+static int imsic_ipi_raw_handler(struct sbi_irqchip_device *chip, u32 hwirq)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+
+	/* Another HART changed the enabled identities targeting this HART */
+	if (atomic_raw_xchg_ulong(imsic_get_hart_sync_ptr(scratch), 0))
+		imsic_local_eie_sync(chip->num_hwirq);
+
+	sbi_ipi_process();
+	return 0;
+}
+
 static void imsic_ipi_send(u32 hart_index)
 {
-	unsigned long reloff;
-	struct imsic_regs *regs;
-	struct imsic_data *data;
 	struct sbi_scratch *scratch;
-	int file;
+	unsigned long addr;
 
 	scratch = sbi_hartindex_to_scratch(hart_index);
 	if (!scratch)
 		return;
 
-	data = imsic_get_hart_data_ptr(scratch);
-	file = imsic_get_hart_file(scratch);
-	if (!data || !data->targets_mmode)
-		return;
-
-	regs = &data->regs[0];
-	reloff = file * (1UL << data->guest_index_bits) * IMSIC_MMIO_PAGE_SZ;
-	while (regs->size && (regs->size <= reloff)) {
-		reloff -= regs->size;
-		regs++;
-	}
-
-	if (regs->size && (reloff < regs->size))
-		writel_relaxed(IMSIC_IPI_ID,
-			(void *)(regs->addr + reloff + IMSIC_MMIO_PAGE_LE));
+	/* Precomputed when the HART was mapped to its interrupt file */
+	addr = imsic_get_hart_msi_addr(scratch);
+	if (addr)
+		writel_relaxed(IMSIC_IPI_ID, (void *)addr);
 }
 
 static struct sbi_ipi_device imsic_ipi_device = {
@@ -259,11 +311,17 @@ void imsic_local_irqchip_init(void)
 static int imsic_warm_irqchip_init(struct sbi_irqchip_device *dev)
 {
 	struct imsic_data *imsic = imsic_get_data(current_hartindex());
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 
 	/* Sanity checks */
 	if (!imsic || !imsic->targets_mmode)
 		return SBI_EINVAL;
 
+	/* Refresh the MSI address used for sending IPIs to this HART */
+	imsic_set_hart_msi_addr(scratch,
+		imsic_file_msi_addr(imsic,
+				    imsic_get_target_file(current_hartindex())));
+
 	/* Disable all interrupts */
 	imsic_local_eix_update(1, imsic->num_ids, false, false);
 
@@ -273,6 +331,10 @@ static int imsic_warm_irqchip_init(struct sbi_irqchip_device *dev)
 	/* Local IMSIC initialization */
 	imsic_local_irqchip_init();
 
+	/* Enable identities having an MSI handler */
+	atomic_raw_xchg_ulong(imsic_get_hart_sync_ptr(scratch), 0);
+	imsic_local_eie_sync(dev->num_hwirq);
+
 	return 0;
 }
 
@@ -353,10 +415,100 @@ static int imsic_hwirq_setup(struct sbi_irqchip_device *chip, u32 hwirq, u32 hwi
 	return 0;
 }
 
+/* Update the enable bit of a hwirq in the interrupt file of a HART */
+static void imsic_hwirq_update(u32 hart_index, u32 hwirq, bool enable)
+{
+	struct sbi_scratch *scratch;
+
+	if (hart_index == current_hartindex()) {
+		imsic_local_eix_update(hwirq, 1, false, enable);
+		return;
+	}
+
+	scratch = sbi_hartindex_to_scratch(hart_index);
+	if (!scratch)
+		return;
+
+	/*
+	 * The enable bits can only be written by the HART owning the
+	 * interrupt file so ask it to sync them with imsic_enabled_ids
+	 * using an IMSIC IPI. This works even if the IPI device is not
+	 * the IMSIC or the HART runs in another domain. A HART which is
+	 * not running syncs them in its warm init instead.
+	 */
+	atomic_raw_xchg_ulong(imsic_get_hart_sync_ptr(scratch), 1);
+	wmb();
+	imsic_ipi_send(hart_index);
+}
+
+/* Point the MSI of a hwirq to the M-mode interrupt file of a HART */
+static int imsic_hwirq_set_affinity(struct sbi_irqchip_device *chip,
+				    u32 hwirq, u32 hart_index)
+{
+	struct sbi_irqchip_msi_msg msg;
+	struct sbi_scratch *scratch;
+	unsigned long addr;
+	int rc;
+
+	scratch = sbi_hartindex_to_scratch(hart_index);
+	if (!scratch)
+		return SBI_EINVAL;
+
+	addr = imsic_get_hart_msi_addr(scratch);
+	if (!addr)
+		return SBI_ENODEV;
+
+	msg.address_lo = (u32)addr;
+	msg.address_hi = (u32)((u64)addr >> 32);
+	msg.data = hwirq;
+	rc = sbi_irqchip_write_msi(chip, hwirq, &msg);
+
+	/* Reserved identities have no MSI to be written */
+	if (rc == SBI_ENOTSUPP)
+		return 0;
+	if (rc)
+		return rc;
+
+	/* The new target HART must have an unmasked identity enabled */
+	if (bitmap_test(imsic_enabled_ids, hwirq))
+		imsic_hwirq_update(hart_index, hwirq, true);
+
+	return 0;
+}
+
+static void imsic_hwirq_unmask(struct sbi_irqchip_device *chip, u32 hwirq)
+{
+	u32 hart_index;
+
+	if (hwirq <= IMSIC_IPI_ID)
+		return;
+
+	atomic_raw_set_bit(hwirq, imsic_enabled_ids);
+
+	if (!sbi_irqchip_get_affinity(chip, hwirq, &hart_index))
+		imsic_hwirq_update(hart_index, hwirq, true);
+}
+
+static void imsic_hwirq_mask(struct sbi_irqchip_device *chip, u32 hwirq)
+{
+	u32 hart_index;
+
+	if (hwirq <= IMSIC_IPI_ID)
+		return;
+
+	atomic_raw_clear_bit(hwirq, imsic_enabled_ids);
+
+	if (!sbi_irqchip_get_affinity(chip, hwirq, &hart_index))
+		imsic_hwirq_update(hart_index, hwirq, false);
+}
+
 static struct sbi_irqchip_device imsic_device = {
-	.warm_init	= imsic_warm_irqchip_init,
-	.process_hwirqs	= imsic_process_hwirqs,
-	.hwirq_setup	= imsic_hwirq_setup,
+	.warm_init		= imsic_warm_irqchip_init,
+	.process_hwirqs		= imsic_process_hwirqs,
+	.hwirq_setup		= imsic_hwirq_setup,
+	.hwirq_set_affinity	= imsic_hwirq_set_affinity,
+	.hwirq_mask		= imsic_hwirq_mask,
+	.hwirq_unmask		= imsic_hwirq_unmask,
 };
 
 int imsic_cold_irqchip_init(struct imsic_data *imsic)
@@ -386,6 +538,22 @@ int imsic_cold_irqchip_init(struct imsic_data *imsic)
 			return SBI_ENOMEM;
 	}
 
+	/* Allocate scratch space MSI address */
+	if (!imsic_msi_addr_offset) {
+		imsic_msi_addr_offset =
+			sbi_scratch_alloc_type_offset(unsigned long);
+		if (!imsic_msi_addr_offset)
+			return SBI_ENOMEM;
+	}
+
+	/* Allocate scratch space enable sync request */
+	if (!imsic_sync_offset) {
+		imsic_sync_offset =
+			sbi_scratch_alloc_type_offset(unsigned long);
+		if (!imsic_sync_offset)
+			return SBI_ENOMEM;
+	}
+
 	/* Add IMSIC regions to the root domain */
 	for (i = 0; i < IMSIC_MAX_REGS && imsic->regs[i].size; i++) {
 		rc = sbi_domain_root_add_memrange(imsic->regs[i].addr,
@@ -412,6 +580,12 @@ int imsic_cold_irqchip_init(struct imsic_data *imsic)
 	if (rc)
 		return rc;
 
+	/* IPIs bypass the default handler lookup */
+	rc = sbi_irqchip_set_raw_handler(&imsic_device, IMSIC_IPI_ID,
+					 imsic_ipi_raw_handler);
+	if (rc)
+		return rc;
+
 	/* Register IPI device */
 	sbi_ipi_add_device(&imsic_ipi_device);
 
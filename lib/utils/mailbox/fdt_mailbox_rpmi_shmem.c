@@ -13,6 +13,7 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_heap.h>
+#include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/riscv_io.h>
 #include <sbi/riscv_locks.h>
@@ -22,6 +23,7 @@
 #include <sbi_utils/mailbox/mailbox.h>
 #include <sbi_utils/mailbox/fdt_mailbox.h>
 #include <sbi_utils/mailbox/rpmi_mailbox.h>
+#include <sbi_utils/mailbox/rpmi_soft_puc.h>
 
 /** Minimum Base group version required */
 #define RPMI_BASE_VERSION_MIN		RPMI_VERSION(1, 0)
@@ -120,6 +122,19 @@ struct smq_queue_ctx {
 	char name[RPMI_NAME_CHARS_MAX];
 };
 
+/** Maximum number of transfers waiting for an acknowledgement */
+#define RPMI_SHMEM_MAX_WAITERS		64
+
+/** Maximum number of transfers in a single batch */
+#define RPMI_SHMEM_MAX_BATCH		16
+
+/** Transfer waiting for an acknowledgement (indexed by token) */
+struct rpmi_shmem_waiter {
+	struct mbox_xfer *xfer;
+	u16 token;
+	volatile bool done;
+};
+
 struct rpmi_srvgrp_chan {
 	u32 servicegroup_id;
 	u32 servicegroup_version;
@@ -149,6 +164,13 @@ struct rpmi_shmem_mbox_controller {
 		u8 f0_priv_level;
 		bool f0_ev_notif_en;
 	} base_flags;
+	/* Transfers waiting for an acknowledgement (protected by P2A ACK queue lock) */
+	struct rpmi_shmem_waiter waiters[RPMI_SHMEM_MAX_WAITERS];
+	/* P2A doorbell system MSI */
+	struct mbox_chan *sysmsi_chan;
+	u32 p2a_doorbell_hwirq;
+	/* Software PuC serving the queues (if any) */
+	struct rpmi_soft_puc *soft_puc;
 };
 
 /**************** Shared Memory Queues Helpers **************/
@@ -165,15 +187,9 @@ static bool __smq_queue_empty(struct smq_queue_ctx *qctx)
 		le32_to_cpu(*qctx->tailptr)) ? true : false;
 }
 
-static int __smq_rx(struct smq_queue_ctx *qctx, u32 slot_size,
-		    u32 service_group_id, struct mbox_xfer *xfer)
+static int __smq_rx_check(u32 slot_size, struct mbox_xfer *xfer)
 {
-	void *dst, *src;
-	struct rpmi_message *msg;
-	u32 i, tmp, pos, dlen, msgidn, headidx, tailidx;
 	struct rpmi_message_args *args = xfer->args;
-	bool no_rx_token = (args->flags & RPMI_MSG_FLAGS_NO_RX_TOKEN) ?
-			   true : false;
 
 	/* Rx sanity checks */
 	if ((sizeof(u32) * args->rx_endian_words) >
@@ -182,6 +198,46 @@ static int __smq_rx(struct smq_queue_ctx *qctx, u32 slot_size,
 	if ((sizeof(u32) * args->rx_endian_words) > xfer->rx_len)
 		return SBI_EINVAL;
 
+	return SBI_OK;
+}
+
+static void __smq_rx_copy(struct rpmi_message *msg, struct mbox_xfer *xfer)
+{
+	struct rpmi_message_args *args = xfer->args;
+	void *dst, *src;
+	u32 i, dlen;
+
+	if (!xfer->rx)
+		return;
+
+	args->rx_data_len = dlen = GET_DLEN(msg);
+	if (dlen > xfer->rx_len)
+		dlen = xfer->rx_len;
+	src = (void *)msg + sizeof(struct rpmi_message_header);
+	dst = xfer->rx;
+	for (i = 0; i < args->rx_endian_words; i++)
+		((u32 *)dst)[i] = le32_to_cpu(((u32 *)src)[i]);
+	dst += sizeof(u32) * args->rx_endian_words;
+	src += sizeof(u32) * args->rx_endian_words;
+	sbi_memcpy(dst, src,
+		xfer->rx_len - (sizeof(u32) * args->rx_endian_words));
+}
+
+static int __smq_rx(struct smq_queue_ctx *qctx, u32 slot_size,
+		    u32 service_group_id, struct mbox_xfer *xfer)
+{
+	void *dst, *src;
+	struct rpmi_message *msg;
+	u32 i, tmp, pos, msgidn, headidx, tailidx;
+	struct rpmi_message_args *args = xfer->args;
+	bool no_rx_token = (args->flags & RPMI_MSG_FLAGS_NO_RX_TOKEN) ?
+			   true : false;
+	int ret;
+
+	ret = __smq_rx_check(slot_size, xfer);
+	if (ret)
+		return ret;
+
 	/* There should be some message in the queue */
 	if (__smq_queue_empty(qctx))
 		return SBI_ENOENT;
@@ -225,19 +281,7 @@ static int __smq_rx(struct smq_queue_ctx *qctx, u32 slot_size,
 		args->rx_token = GET_TOKEN(msg);
 
 	/* Extract data from the first message */
-	if (xfer->rx) {
-		args->rx_data_len = dlen = GET_DLEN(msg);
-		if (dlen > xfer->rx_len)
-			dlen = xfer->rx_len;
-		src = (void *)msg + sizeof(struct rpmi_message_header);
-		dst = xfer->rx;
-		for (i = 0; i < args->rx_endian_words; i++)
-			((u32 *)dst)[i] = le32_to_cpu(((u32 *)src)[i]);
-		dst += sizeof(u32) * args->rx_endian_words;
-		src += sizeof(u32) * args->rx_endian_words;
-		sbi_memcpy(dst, src,
-			xfer->rx_len - (sizeof(u32) * args->rx_endian_words));
-	}
+	__smq_rx_copy(msg, xfer);
 
 	/* Update the head/read index */
 	*qctx->headptr = cpu_to_le32(headidx + 1) % qctx->num_slots;
@@ -248,9 +292,44 @@ static int __smq_rx(struct smq_queue_ctx *qctx, u32 slot_size,
 	return SBI_OK;
 }
 
-static int __smq_tx(struct smq_queue_ctx *qctx, struct rpmi_mb_regs *mb_regs,
-		    u32 a2p_doorbell_value, u32 slot_size, u32 service_group_id,
-		    struct mbox_xfer *xfer)
+/*
+ * Hand over all acknowledgements in the P2A ACK queue to the transfers
+ * waiting for them. Acknowledgements are consumed in order so there is
+ * no need to search the queue or move slots around. Acknowledgements
+ * without a waiter (for example after a timeout) are dropped.
+ */
+static void __smq_ack_drain(struct rpmi_shmem_mbox_controller *mctl,
+			    struct smq_queue_ctx *qctx)
+{
+	struct rpmi_shmem_waiter *w;
+	struct rpmi_message *msg;
+	u32 headidx, token;
+
+	if (__smq_queue_empty(qctx))
+		return;
+
+	while (!__smq_queue_empty(qctx)) {
+		headidx = le32_to_cpu(*qctx->headptr);
+		msg = (void *)qctx->buffer + (headidx * mctl->slot_size);
+		token = GET_TOKEN(msg);
+
+		w = &mctl->waiters[token % RPMI_SHMEM_MAX_WAITERS];
+		if (w->xfer && !w->done && w->token == token) {
+			__smq_rx_copy(msg, w->xfer);
+			/* Make sure the response is visible before done */
+			smp_wmb();
+			w->done = true;
+		}
+
+		*qctx->headptr = cpu_to_le32((headidx + 1) % qctx->num_slots);
+	}
+
+	/* Make sure updates to head are immediately visible to PuC */
+	smp_wmb();
+}
+
+static int __smq_tx(struct smq_queue_ctx *qctx, u32 slot_size,
+		    u32 service_group_id, struct mbox_xfer *xfer)
 {
 	u32 i, tailidx;
 	void *dst, *src;
@@ -300,13 +379,27 @@ static int __smq_tx(struct smq_queue_ctx *qctx, struct rpmi_mb_regs *mb_regs,
 	/* Update the tail/write index */
 	*qctx->tailptr = cpu_to_le32(tailidx + 1) % qctx->num_slots;
 
-	/* Ring the RPMI doorbell if present */
-	if (mb_regs)
-		writel(a2p_doorbell_value, &mb_regs->db_reg);
-
 	return SBI_OK;
 }
 
+static void __smq_soft_puc_kick(struct rpmi_shmem_mbox_controller *mctl)
+{
+#ifdef CONFIG_FDT_MAILBOX_RPMI_SHMEM_SOFT_PUC
+	/* Software PuC serves requests in the context of the doorbell */
+	if (mctl->soft_puc)
+		rpmi_soft_puc_poll(mctl->soft_puc);
+#endif
+}
+
+static void __smq_ring_doorbell(struct rpmi_shmem_mbox_controller *mctl)
+{
+	/* Ring the RPMI doorbell if present */
+	if (mctl->mb_regs)
+		writel(mctl->a2p_doorbell_value, &mctl->mb_regs->db_reg);
+	else
+		__smq_soft_puc_kick(mctl);
+}
+
 static int smq_rx(struct rpmi_shmem_mbox_controller *mctl,
 		  u32 queue_id, u32 service_group_id, struct mbox_xfer *xfer)
 {
@@ -366,8 +459,9 @@ static int smq_tx(struct rpmi_shmem_mbox_controller *mctl,
 	 */
 	do {
 		spin_lock(&qctx->queue_lock);
-		ret = __smq_tx(qctx, mctl->mb_regs, mctl->a2p_doorbell_value,
-				mctl->slot_size, service_group_id, xfer);
+		ret = __smq_tx(qctx, mctl->slot_size, service_group_id, xfer);
+		if (!ret)
+			__smq_ring_doorbell(mctl);
 		spin_unlock(&qctx->queue_lock);
 		if (!ret)
 			return 0;
@@ -379,6 +473,202 @@ static int smq_tx(struct rpmi_shmem_mbox_controller *mctl,
 	return SBI_ETIMEDOUT;
 }
 
+/*
+ * Write a batch of transfers to a queue and ring the doorbell once
+ * for all of them (or once whenever the queue becomes full).
+ */
+static int smq_tx_batch(struct rpmi_shmem_mbox_controller *mctl,
+			u32 queue_id, u32 service_group_id,
+			struct mbox_xfer *xfers, u32 count)
+{
+	struct smq_queue_ctx *qctx = &mctl->queue_ctx_tbl[queue_id];
+	int ret = 0, txretry = 0;
+	u32 done = 0;
+
+	while (done < count) {
+		spin_lock(&qctx->queue_lock);
+		while (done < count) {
+			ret = __smq_tx(qctx, mctl->slot_size, service_group_id,
+				       &xfers[done]);
+			if (ret)
+				break;
+			done++;
+			txretry = 0;
+		}
+		__smq_ring_doorbell(mctl);
+		spin_unlock(&qctx->queue_lock);
+
+		if (ret == SBI_ENOMEM) {
+			if (txretry++ >= xfers[done].tx_timeout)
+				return SBI_ETIMEDOUT;
+			sbi_timer_mdelay(1);
+		} else if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static struct rpmi_shmem_waiter *smq_ack_wait_add(
+				struct rpmi_shmem_mbox_controller *mctl,
+				struct mbox_xfer *xfer)
+{
+	struct smq_queue_ctx *qctx =
+			&mctl->queue_ctx_tbl[RPMI_QUEUE_IDX_P2A_ACK];
+	u16 token = xfer->seq & RPMI_MSG_TOKEN_MASK;
+	struct rpmi_shmem_waiter *w;
+	int retry = 0;
+
+	w = &mctl->waiters[token % RPMI_SHMEM_MAX_WAITERS];
+	do {
+		spin_lock(&qctx->queue_lock);
+		if (!w->xfer) {
+			w->xfer = xfer;
+			w->token = token;
+			w->done = false;
+			spin_unlock(&qctx->queue_lock);
+			return w;
+		}
+		spin_unlock(&qctx->queue_lock);
+
+		/* Another transfer with the same index is in flight */
+		sbi_timer_mdelay(1);
+	} while (retry++ < xfer->rx_timeout);
+
+	return NULL;
+}
+
+static void smq_ack_wait_remove(struct rpmi_shmem_mbox_controller *mctl,
+				struct rpmi_shmem_waiter *w)
+{
+	struct smq_queue_ctx *qctx =
+			&mctl->queue_ctx_tbl[RPMI_QUEUE_IDX_P2A_ACK];
+
+	spin_lock(&qctx->queue_lock);
+	w->xfer = NULL;
+	w->done = false;
+	spin_unlock(&qctx->queue_lock);
+}
+
+static bool smq_ack_wait_done(struct rpmi_shmem_mbox_controller *mctl,
+			      struct rpmi_shmem_waiter **waiters, u32 count)
+{
+	struct smq_queue_ctx *qctx =
+			&mctl->queue_ctx_tbl[RPMI_QUEUE_IDX_P2A_ACK];
+	u32 i;
+
+	for (i = 0; i < count; i++) {
+		if (!waiters[i]->done)
+			break;
+	}
+	if (i == count) {
+		/* Pairs with smp_wmb() in __smq_ack_drain() */
+		smp_rmb();
+		return true;
+	}
+
+	/* Requests may be left pending when the P2A ACK queue was full */
+	__smq_soft_puc_kick(mctl);
+
+	/* Whoever holds the lock is already draining for everyone */
+	if (spin_trylock(&qctx->queue_lock)) {
+		__smq_ack_drain(mctl, qctx);
+		spin_unlock(&qctx->queue_lock);
+	}
+
+	return false;
+}
+
+/*
+ * Wait for acknowledgements of already registered transfers. Any HART
+ * (or the P2A doorbell interrupt) draining the P2A ACK queue completes
+ * the transfers of all other HARTs as well.
+ */
+static int smq_ack_wait(struct rpmi_shmem_mbox_controller *mctl,
+			struct rpmi_shmem_waiter **waiters, u32 count,
+			unsigned long timeout)
+{
+	unsigned long rxretry = 0;
+	bool done;
+	u32 i;
+
+	do {
+		done = smq_ack_wait_done(mctl, waiters, count);
+		if (done)
+			break;
+
+		sbi_timer_mdelay(1);
+		rxretry += 1;
+	} while (rxretry < timeout);
+
+	for (i = 0; i < count; i++)
+		smq_ack_wait_remove(mctl, waiters[i]);
+
+	return done ? 0 : SBI_ETIMEDOUT;
+}
+
+/*
+ * Send (optionally) and receive acknowledgements for a set of transfers.
+ * The transfers are registered as waiters before anything is sent so the
+ * acknowledgements can be handed over directly when the P2A ACK queue is
+ * drained, irrespective of the order in which they arrive.
+ */
+static int rpmi_shmem_mbox_xfer_ack(struct rpmi_shmem_mbox_controller *mctl,
+				    struct rpmi_srvgrp_chan *srvgrp_chan,
+				    bool do_tx, struct mbox_xfer *xfers,
+				    u32 count)
+{
+	struct rpmi_shmem_waiter *waiters[RPMI_SHMEM_MAX_BATCH];
+	struct rpmi_message_args *args;
+	unsigned long timeout = 0;
+	u32 i, j;
+	int ret;
+
+	if (RPMI_QUEUE_IDX_P2A_ACK >= mctl->queue_count)
+		return SBI_EINVAL;
+
+	for (i = 0; i < count; i++) {
+		args = xfers[i].args;
+		if (args->flags & RPMI_MSG_FLAGS_NO_RX_TOKEN) {
+			ret = SBI_ENOTSUPP;
+			goto fail_remove_waiters;
+		}
+
+		ret = __smq_rx_check(mctl->slot_size, &xfers[i]);
+		if (ret)
+			goto fail_remove_waiters;
+
+		waiters[i] = smq_ack_wait_add(mctl, &xfers[i]);
+		if (!waiters[i]) {
+			ret = SBI_ETIMEDOUT;
+			goto fail_remove_waiters;
+		}
+
+		if (timeout < xfers[i].rx_timeout)
+			timeout = xfers[i].rx_timeout;
+	}
+
+	if (do_tx) {
+		if (count == 1)
+			ret = smq_tx(mctl, RPMI_QUEUE_IDX_A2P_REQ,
+				     srvgrp_chan->servicegroup_id, xfers);
+		else
+			ret = smq_tx_batch(mctl, RPMI_QUEUE_IDX_A2P_REQ,
+					   srvgrp_chan->servicegroup_id,
+					   xfers, count);
+		if (ret)
+			goto fail_remove_waiters;
+	}
+
+	return smq_ack_wait(mctl, waiters, count, timeout);
+
+fail_remove_waiters:
+	for (j = 0; j < i; j++)
+		smq_ack_wait_remove(mctl, waiters[j]);
+	return ret;
+}
+
 static int rpmi_get_platform_info(struct rpmi_shmem_mbox_controller *mctl)
 {
 	int ret = SBI_OK;
@@ -477,6 +767,10 @@ static int rpmi_shmem_mbox_xfer(struct mbox_chan *chan, struct mbox_xfer *xfer)
 		return SBI_ENOTSUPP;
 	}
 
+	if (do_rx && rx_qid == RPMI_QUEUE_IDX_P2A_ACK)
+		return rpmi_shmem_mbox_xfer_ack(mctl, srvgrp_chan, do_tx,
+						xfer, 1);
+
 	if (do_tx) {
 		ret = smq_tx(mctl, tx_qid, srvgrp_chan->servicegroup_id, xfer);
 		if (ret)
@@ -492,6 +786,32 @@ static int rpmi_shmem_mbox_xfer(struct mbox_chan *chan, struct mbox_xfer *xfer)
 	return 0;
 }
 
+static int rpmi_shmem_mbox_xfer_batch(struct mbox_chan *chan,
+				      struct mbox_xfer *xfers, u32 count)
+{
+	struct rpmi_shmem_mbox_controller *mctl =
+			container_of(chan->mbox,
+				     struct rpmi_shmem_mbox_controller,
+				     controller);
+	struct rpmi_srvgrp_chan *srvgrp_chan = to_srvgrp_chan(chan);
+	struct rpmi_message_args *args;
+	u32 i;
+
+	if (!count || count > RPMI_SHMEM_MAX_BATCH)
+		return SBI_EINVAL;
+
+	/* Only normal requests with an acknowledgement can be batched */
+	for (i = 0; i < count; i++) {
+		args = xfers[i].args;
+		if (args->type != RPMI_MSG_NORMAL_REQUEST ||
+		    (args->flags & (RPMI_MSG_FLAGS_NO_TX |
+				    RPMI_MSG_FLAGS_NO_RX)))
+			return SBI_EINVAL;
+	}
+
+	return rpmi_shmem_mbox_xfer_ack(mctl, srvgrp_chan, true, xfers, count);
+}
+
 static int rpmi_shmem_mbox_get_attribute(struct mbox_chan *chan,
 					 int attr_id, void *out_value)
 {
@@ -580,6 +900,101 @@ static void rpmi_shmem_mbox_free_chan(struct mbox_controller *mbox,
 	sbi_free(srvgrp_chan);
 }
 
+#ifdef CONFIG_FDT_MAILBOX_RPMI_SHMEM_P2A_MSI
+static int rpmi_shmem_p2a_doorbell_irq(u32 hwirq, void *priv)
+{
+	struct rpmi_shmem_mbox_controller *mctl = priv;
+	struct smq_queue_ctx *qctx =
+			&mctl->queue_ctx_tbl[RPMI_QUEUE_IDX_P2A_ACK];
+
+	spin_lock(&qctx->queue_lock);
+	__smq_ack_drain(mctl, qctx);
+	spin_unlock(&qctx->queue_lock);
+
+	return 0;
+}
+
+static void rpmi_shmem_p2a_doorbell_write_msi(u32 hwirq,
+					const struct sbi_irqchip_msi_msg *msg,
+					void *priv)
+{
+	struct rpmi_shmem_mbox_controller *mctl = priv;
+	struct rpmi_sysmsi_set_msi_target_req treq;
+	struct rpmi_sysmsi_set_msi_target_resp tresp;
+	struct rpmi_sysmsi_set_msi_state_req sreq;
+	struct rpmi_sysmsi_set_msi_state_resp sresp;
+	int rc;
+
+	treq.sys_msi_index = mctl->p2a_doorbell_sysmsi_index;
+	treq.sys_msi_address_low = msg->address_lo;
+	treq.sys_msi_address_high = msg->address_hi;
+	treq.sys_msi_data = msg->data;
+	rc = rpmi_normal_request_with_status(mctl->sysmsi_chan,
+				RPMI_SYSMSI_SRV_SET_MSI_TARGET,
+				&treq, rpmi_u32_count(treq),
+				rpmi_u32_count(treq),
+				&tresp, rpmi_u32_count(tresp),
+				rpmi_u32_count(tresp));
+	if (rc)
+		goto fail;
+
+	sreq.sys_msi_index = mctl->p2a_doorbell_sysmsi_index;
+	sreq.sys_msi_state = RPMI_SYSMSI_MSI_STATE_ENABLE;
+	rc = rpmi_normal_request_with_status(mctl->sysmsi_chan,
+				RPMI_SYSMSI_SRV_SET_MSI_STATE,
+				&sreq, rpmi_u32_count(sreq),
+				rpmi_u32_count(sreq),
+				&sresp, rpmi_u32_count(sresp),
+				rpmi_u32_count(sresp));
+	if (rc)
+		goto fail;
+
+	return;
+
+fail:
+	sbi_printf("%s: failed to setup P2A doorbell MSI (error %d)\n",
+		   __func__, rc);
+}
+
+/*
+ * Route the P2A doorbell system MSI to an MSI capable irqchip so that
+ * acknowledgements are handed over to waiting transfers as soon as
+ * they arrive. Polling remains in place so this is purely optional.
+ */
+static void rpmi_shmem_p2a_doorbell_init(struct rpmi_shmem_mbox_controller *mctl)
+{
+	struct sbi_irqchip_device *chip;
+	u32 chan_args[MBOX_CHAN_MAX_ARGS] = { 0 };
+	int rc;
+
+	if (mctl->p2a_doorbell_sysmsi_index == -1U)
+		return;
+
+	chip = sbi_irqchip_find_device_by_caps(SBI_IRQCHIP_CAPS_MSI, NULL);
+	if (!chip)
+		return;
+
+	chan_args[0] = RPMI_SRVGRP_SYSTEM_MSI;
+	mctl->sysmsi_chan = mbox_controller_request_chan(&mctl->controller,
+							 chan_args);
+	if (!mctl->sysmsi_chan)
+		return;
+
+	rc = sbi_irqchip_register_msi(chip, 1,
+				      rpmi_shmem_p2a_doorbell_write_msi,
+				      rpmi_shmem_p2a_doorbell_irq, mctl,
+				      &mctl->p2a_doorbell_hwirq);
+	if (rc) {
+		mbox_controller_free_chan(mctl->sysmsi_chan);
+		mctl->sysmsi_chan = NULL;
+	}
+}
+#else
+static void rpmi_shmem_p2a_doorbell_init(struct rpmi_shmem_mbox_controller *mctl)
+{
+}
+#endif
+
 extern struct fdt_mailbox fdt_mailbox_rpmi_shmem;
 
 static int rpmi_shmem_transport_init(struct rpmi_shmem_mbox_controller *mctl,
@@ -692,21 +1107,109 @@ static int rpmi_shmem_transport_init(struct rpmi_shmem_mbox_controller *mctl,
 	return SBI_SUCCESS;
 }
 
+#ifdef CONFIG_FDT_MAILBOX_RPMI_SHMEM_SOFT_PUC
+/** Default number of slots in each queue served by the software PuC */
+#define RPMI_SOFT_PUC_DEF_QUEUE_SLOTS	32
+
+static const char *const rpmi_soft_puc_queue_names[] = {
+	"a2p-req", "p2a-ack", "p2a-req", "a2p-ack",
+};
+
+/*
+ * Set up the queues in memory allocated from the heap and let the
+ * software PuC serve them. There are no doorbell registers, instead
+ * the software PuC is run whenever the doorbell is rung.
+ */
+static int rpmi_shmem_soft_transport_init(struct rpmi_shmem_mbox_controller *mctl,
+					  const void *fdt, int nodeoff)
+{
+	unsigned long queue_size;
+	const fdt32_t *prop;
+	struct smq_queue_ctx *qctx;
+	u32 num_slots;
+	void *base;
+	int len, qid, ret;
+
+	prop = fdt_getprop(fdt, nodeoff, "riscv,slot-size", &len);
+	mctl->slot_size = prop ? fdt32_to_cpu(*prop) : RPMI_SLOT_SIZE_MIN;
+	if (mctl->slot_size < RPMI_SLOT_SIZE_MIN)
+		mctl->slot_size = RPMI_SLOT_SIZE_MIN;
+
+	prop = fdt_getprop(fdt, nodeoff, "opensbi,queue-slots", &len);
+	num_slots = prop ? fdt32_to_cpu(*prop) : RPMI_SOFT_PUC_DEF_QUEUE_SLOTS;
+	if (num_slots < 2)
+		return SBI_EINVAL;
+
+	prop = fdt_getprop(fdt, nodeoff, "riscv,p2a-doorbell-sysmsi-index", &len);
+	mctl->p2a_doorbell_sysmsi_index = prop ? fdt32_to_cpu(*prop) : -1U;
+
+	queue_size = (num_slots + RPMI_QUEUE_HEADER_SLOTS) * mctl->slot_size;
+	base = sbi_zalloc(RPMI_QUEUE_IDX_MAX_COUNT * queue_size);
+	if (!base)
+		return SBI_ENOMEM;
+
+	mctl->soft_puc = sbi_zalloc(sizeof(*mctl->soft_puc));
+	if (!mctl->soft_puc) {
+		sbi_free(base);
+		return SBI_ENOMEM;
+	}
+
+	ret = rpmi_soft_puc_init(mctl->soft_puc, base, queue_size,
+				 mctl->slot_size);
+	if (ret) {
+		sbi_free(mctl->soft_puc);
+		mctl->soft_puc = NULL;
+		sbi_free(base);
+		return ret;
+	}
+	mctl->soft_puc->p2a_doorbell_sysmsi_index =
+					mctl->p2a_doorbell_sysmsi_index;
+
+	mctl->queue_count = RPMI_QUEUE_IDX_MAX_COUNT;
+	for (qid = 0; qid < mctl->queue_count; qid++) {
+		qctx = &mctl->queue_ctx_tbl[qid];
+		qctx->num_slots = num_slots;
+		qctx->headptr = base + qid * queue_size +
+				RPMI_QUEUE_HEAD_SLOT * mctl->slot_size;
+		qctx->tailptr = base + qid * queue_size +
+				RPMI_QUEUE_TAIL_SLOT * mctl->slot_size;
+		qctx->buffer = base + qid * queue_size +
+				RPMI_QUEUE_HEADER_SLOTS * mctl->slot_size;
+		sbi_strncpy(qctx->name, rpmi_soft_puc_queue_names[qid],
+			    sizeof(qctx->name));
+		qctx->queue_id = qid;
+		SPIN_LOCK_INIT(qctx->queue_lock);
+	}
+
+	return SBI_SUCCESS;
+}
+#else
+static int rpmi_shmem_soft_transport_init(struct rpmi_shmem_mbox_controller *mctl,
+					  const void *fdt, int nodeoff)
+{
+	return SBI_ENODEV;
+}
+#endif
+
 static int rpmi_shmem_mbox_init(const void *fdt, int nodeoff,
 				const struct fdt_match *match)
 {
 	struct rpmi_base_get_attributes_resp resp;
 	struct rpmi_shmem_mbox_controller *mctl;
+	struct rpmi_normal_request base_reqs[3] = { 0 };
 	struct rpmi_srvgrp_chan *base_srvgrp;
-	u32 tval[2], args[1];
-	int ret = 0;
+	u32 tval[2], args[1], base_vals[3][2];
+	int i, ret = 0;
 
 	mctl = sbi_zalloc(sizeof(*mctl));
 	if (!mctl)
 		return SBI_ENOMEM;
 
 	/* Initialization transport from device tree */
-	ret = rpmi_shmem_transport_init(mctl, fdt, nodeoff);
+	if (match->data)
+		ret = rpmi_shmem_soft_transport_init(mctl, fdt, nodeoff);
+	else
+		ret = rpmi_shmem_transport_init(mctl, fdt, nodeoff);
 	if (ret)
 		goto fail_free_controller;
 
@@ -718,6 +1221,7 @@ static int rpmi_shmem_mbox_init(const void *fdt, int nodeoff,
 	mctl->controller.request_chan = rpmi_shmem_mbox_request_chan;
 	mctl->controller.free_chan = rpmi_shmem_mbox_free_chan;
 	mctl->controller.xfer = rpmi_shmem_mbox_xfer;
+	mctl->controller.xfer_batch = rpmi_shmem_mbox_xfer_batch;
 	mctl->controller.get_attribute = rpmi_shmem_mbox_get_attribute;
 	ret = mbox_controller_add(&mctl->controller);
 	if (ret)
@@ -745,27 +1249,22 @@ static int rpmi_shmem_mbox_init(const void *fdt, int nodeoff,
 		goto fail_free_chan;
 	}
 
-	/* Get implementation id */
-	ret = smq_base_get_two_u32(mctl,
-				   RPMI_BASE_SRV_GET_IMPLEMENTATION_VERSION,
-				   NULL, tval);
-	if (ret)
-		goto fail_free_chan;
-	mctl->impl_version = tval[1];
-
-	/* Get implementation version */
-	ret = smq_base_get_two_u32(mctl, RPMI_BASE_SRV_GET_IMPLEMENTATION_IDN,
-				   NULL, tval);
-	if (ret)
-		goto fail_free_chan;
-	mctl->impl_id = tval[1];
-
-	/* Get specification version */
-	ret = smq_base_get_two_u32(mctl, RPMI_BASE_SRV_GET_SPEC_VERSION,
-				   NULL, tval);
+	/* Get implementation version, implementation id and spec version */
+	for (i = 0; i < array_size(base_reqs); i++) {
+		base_reqs[i].resp = base_vals[i];
+		base_reqs[i].resp_words = 2;
+		base_reqs[i].resp_endian_words = 2;
+	}
+	base_reqs[0].service_id = RPMI_BASE_SRV_GET_IMPLEMENTATION_VERSION;
+	base_reqs[1].service_id = RPMI_BASE_SRV_GET_IMPLEMENTATION_IDN;
+	base_reqs[2].service_id = RPMI_BASE_SRV_GET_SPEC_VERSION;
+	ret = rpmi_normal_requests_with_status(mctl->base_chan, base_reqs,
+					       array_size(base_reqs));
 	if (ret)
 		goto fail_free_chan;
-	mctl->spec_version = tval[1];
+	mctl->impl_version = base_vals[0][1];
+	mctl->impl_id = base_vals[1][1];
+	mctl->spec_version = base_vals[2][1];
 	if (mctl->spec_version < RPMI_BASE_VERSION_MIN ||
 	    mctl->spec_version != base_srvgrp->servicegroup_version) {
 		ret = SBI_EINVAL;
@@ -799,6 +1298,9 @@ static int rpmi_shmem_mbox_init(const void *fdt, int nodeoff,
 	 */
 	rpmi_get_platform_info(mctl);
 
+	/* Optional interrupt driven completion of acknowledgements */
+	rpmi_shmem_p2a_doorbell_init(mctl);
+
 	return 0;
 
 fail_free_chan:
@@ -812,6 +1314,9 @@ fail_free_controller:
 
 static const struct fdt_match rpmi_shmem_mbox_match[] = {
 	{ .compatible = "riscv,rpmi-shmem-mbox" },
+#ifdef CONFIG_FDT_MAILBOX_RPMI_SHMEM_SOFT_PUC
+	{ .compatible = "opensbi,rpmi-soft-shmem-mbox", .data = (void *)true },
+#endif
 	{ },
 };
 
@@ -822,3 +1327,42 @@ struct fdt_mailbox fdt_mailbox_rpmi_shmem = {
 	},
 	.xlate = fdt_mailbox_simple_xlate,
 };
+
+#ifdef CONFIG_FDT_MAILBOX_RPMI_SHMEM_SOFT_PUC_BENCH
+/** Number of iterations of the RPMI mailbox benchmark */
+#define RPMI_SOFT_PUC_BENCH_ITERATIONS	256
+
+/*
+ * Early driver probing every software PuC mailbox (even without any
+ * consumer) and benchmarking the RPMI service groups it serves.
+ */
+static int rpmi_soft_puc_bench_init(const void *fdt, int nodeoff,
+				    const struct fdt_match *match)
+{
+	struct mbox_controller *mbox = mbox_controller_find(nodeoff);
+	int ret;
+
+	if (!mbox) {
+		ret = rpmi_shmem_mbox_init(fdt, nodeoff, match);
+		if (ret)
+			return ret;
+
+		mbox = mbox_controller_find(nodeoff);
+		if (!mbox)
+			return SBI_ENOSYS;
+	}
+
+	rpmi_mailbox_bench(mbox, RPMI_SOFT_PUC_BENCH_ITERATIONS);
+	return 0;
+}
+
+static const struct fdt_match rpmi_soft_puc_bench_match[] = {
+	{ .compatible = "opensbi,rpmi-soft-shmem-mbox", .data = (void *)true },
+	{ },
+};
+
+const struct fdt_driver fdt_mailbox_rpmi_soft_puc_bench = {
+	.match_table = rpmi_soft_puc_bench_match,
+	.init = rpmi_soft_puc_bench_init,
+};
+#endif
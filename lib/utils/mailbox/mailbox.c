@@ -113,6 +113,42 @@ int mbox_chan_xfer(struct mbox_chan *chan, struct mbox_xfer *xfer)
 	return chan->mbox->xfer(chan, xfer);
 }
 
+int mbox_chan_xfer_batch(struct mbox_chan *chan,
+			 struct mbox_xfer *xfers, u32 count)
+{
+	long seq;
+	u32 i;
+	int ret;
+
+	if (!xfers || !count || !chan || !chan->mbox || !chan->mbox->xfer)
+		return SBI_EINVAL;
+
+	for (i = 0; i < count; i++) {
+		if (xfers[i].tx && (xfers[i].tx_len > chan->mbox->max_xfer_len))
+			return SBI_EINVAL;
+		if (xfers[i].rx && (xfers[i].rx_len > chan->mbox->max_xfer_len))
+			return SBI_EINVAL;
+	}
+
+	if (!chan->mbox->xfer_batch) {
+		for (i = 0; i < count; i++) {
+			ret = mbox_chan_xfer(chan, &xfers[i]);
+			if (ret)
+				return ret;
+		}
+		return 0;
+	}
+
+	/* Allocate a contiguous block of sequence numbers */
+	seq = atomic_add_return(&chan->mbox->xfer_next_seq, count) - count + 1;
+	for (i = 0; i < count; i++) {
+		if (!(xfers[i].flags & MBOX_XFER_SEQ))
+			mbox_xfer_set_sequence(&xfers[i], seq + i);
+	}
+
+	return chan->mbox->xfer_batch(chan, xfers, count);
+}
+
 int mbox_chan_get_attribute(struct mbox_chan *chan, int attr_id, void *out_value)
 {
 	if (!chan || !chan->mbox || !out_value)
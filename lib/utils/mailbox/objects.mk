@@ -13,6 +13,10 @@ libsbiutils-objs-$(CONFIG_FDT_MAILBOX) += mailbox/fdt_mailbox_drivers.carray.o
 libsbiutils-objs-$(CONFIG_MAILBOX) += mailbox/mailbox.o
 
 libsbiutils-objs-$(CONFIG_RPMI_MAILBOX) += mailbox/rpmi_mailbox.o
+libsbiutils-objs-$(CONFIG_RPMI_SOFT_PUC) += mailbox/rpmi_soft_puc.o
+libsbiutils-objs-$(CONFIG_RPMI_MAILBOX_BENCH) += mailbox/rpmi_mailbox_bench.o
 
 carray-fdt_mailbox_drivers-$(CONFIG_FDT_MAILBOX_RPMI_SHMEM) += fdt_mailbox_rpmi_shmem
 libsbiutils-objs-$(CONFIG_FDT_MAILBOX_RPMI_SHMEM) += mailbox/fdt_mailbox_rpmi_shmem.o
+
+carray-fdt_early_drivers-$(CONFIG_FDT_MAILBOX_RPMI_SHMEM_SOFT_PUC_BENCH) += fdt_mailbox_rpmi_soft_puc_bench
@@ -8,6 +8,7 @@
  */
 
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_string.h>
 #include <sbi_utils/mailbox/mailbox.h>
 #include <sbi_utils/mailbox/rpmi_mailbox.h>
 
@@ -73,6 +74,52 @@ int rpmi_normal_request_with_status(
 	return rpmi_xlate_error(((u32 *)resp)[0]);
 }
 
+/** Maximum number of requests sent back to back by a single batch */
+#define RPMI_NORMAL_REQUEST_BATCH	8
+
+int rpmi_normal_requests_with_status(struct mbox_chan *chan,
+				     struct rpmi_normal_request *reqs,
+				     u32 count)
+{
+	struct rpmi_message_args args[RPMI_NORMAL_REQUEST_BATCH];
+	struct mbox_xfer xfers[RPMI_NORMAL_REQUEST_BATCH];
+	struct rpmi_normal_request *r;
+	u32 i, pos, num;
+	int ret;
+
+	for (pos = 0; pos < count; pos += num) {
+		num = count - pos;
+		if (num > RPMI_NORMAL_REQUEST_BATCH)
+			num = RPMI_NORMAL_REQUEST_BATCH;
+
+		for (i = 0; i < num; i++) {
+			r = &reqs[pos + i];
+			sbi_memset(&args[i], 0, sizeof(args[i]));
+			args[i].type = RPMI_MSG_NORMAL_REQUEST;
+			args[i].service_id = r->service_id;
+			args[i].tx_endian_words = r->req_endian_words;
+			args[i].rx_endian_words = r->resp_endian_words;
+			mbox_xfer_init_txrx(&xfers[i], &args[i],
+				r->req, sizeof(u32) * r->req_words,
+				RPMI_DEF_TX_TIMEOUT,
+				r->resp, sizeof(u32) * r->resp_words,
+				RPMI_DEF_RX_TIMEOUT);
+		}
+
+		ret = mbox_chan_xfer_batch(chan, xfers, num);
+		if (ret)
+			return ret;
+
+		for (i = 0; i < num; i++) {
+			ret = rpmi_xlate_error(((u32 *)reqs[pos + i].resp)[0]);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
 int rpmi_posted_request(
 		struct mbox_chan *chan, u32 service_id,
 		void *req, u32 req_words, u32 req_endian_words)
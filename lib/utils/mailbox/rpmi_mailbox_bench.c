@@ -0,0 +1,140 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Latency and throughput benchmark of RPMI service groups.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_timer.h>
+#include <sbi_utils/mailbox/mailbox.h>
+#include <sbi_utils/mailbox/rpmi_mailbox.h>
+
+/** Number of requests sent back to back for throughput measurement */
+#define RPMI_BENCH_BATCH		8
+
+struct rpmi_bench_case {
+	const char *name;
+	u32 servicegroup_id;
+	u32 service_id;
+	u32 req_words;
+	u32 resp_words;
+};
+
+/* Cheap side-effect free request of each service group */
+static const struct rpmi_bench_case rpmi_bench_cases[] = {
+	{ "base", RPMI_SRVGRP_BASE,
+	  RPMI_BASE_SRV_GET_IMPLEMENTATION_VERSION, 0, 2 },
+	{ "system-msi", RPMI_SRVGRP_SYSTEM_MSI,
+	  RPMI_SYSMSI_SRV_GET_MSI_STATE, 1, 2 },
+	{ "hsm", RPMI_SRVGRP_HSM,
+	  RPMI_HSM_SRV_GET_HART_STATUS, 1, 2 },
+	{ "clock", RPMI_SRVGRP_CLOCK,
+	  RPMI_CLOCK_SRV_GET_RATE, 1, 3 },
+	{ "performance", RPMI_SRVGRP_PERFORMANCE,
+	  RPMI_PERF_SRV_GET_LEVEL, 1, 2 },
+};
+
+static unsigned long rpmi_bench_ticks_to_ns(u64 ticks, u64 freq)
+{
+	return (ticks * 1000000000ULL) / freq;
+}
+
+static void rpmi_bench_run(struct mbox_chan *chan,
+			   const struct rpmi_bench_case *bc,
+			   u32 iterations, u64 freq)
+{
+	struct rpmi_normal_request reqs[RPMI_BENCH_BATCH] = { 0 };
+	u32 i, j, num, req[1], resp[RPMI_BENCH_BATCH][4];
+	u64 start, ticks, total = 0, min = -1ULL, max = 0;
+	int ret;
+
+	/* HSM requests use the current HART and everything else index 0 */
+	req[0] = (bc->servicegroup_id == RPMI_SRVGRP_HSM) ?
+		 current_hartid() : 0;
+
+	/* Latency of individual requests */
+	for (i = 0; i < iterations; i++) {
+		start = sbi_timer_value();
+		ret = rpmi_normal_request_with_status(chan, bc->service_id,
+						      req, bc->req_words,
+						      bc->req_words,
+						      resp[0], bc->resp_words,
+						      bc->resp_words);
+		ticks = sbi_timer_value() - start;
+		if (ret) {
+			sbi_printf("RPMI bench %-12s: request failed (error %d)\n",
+				   bc->name, ret);
+			return;
+		}
+		total += ticks;
+		if (ticks < min)
+			min = ticks;
+		if (max < ticks)
+			max = ticks;
+	}
+
+	/* Throughput of requests sent back to back */
+	for (j = 0; j < RPMI_BENCH_BATCH; j++) {
+		reqs[j].service_id = bc->service_id;
+		reqs[j].req = req;
+		reqs[j].req_words = bc->req_words;
+		reqs[j].req_endian_words = bc->req_words;
+		reqs[j].resp = resp[j];
+		reqs[j].resp_words = bc->resp_words;
+		reqs[j].resp_endian_words = bc->resp_words;
+	}
+	start = sbi_timer_value();
+	for (i = 0; i < iterations; i += num) {
+		num = iterations - i;
+		if (num > RPMI_BENCH_BATCH)
+			num = RPMI_BENCH_BATCH;
+		ret = rpmi_normal_requests_with_status(chan, reqs, num);
+		if (ret) {
+			sbi_printf("RPMI bench %-12s: batch failed (error %d)\n",
+				   bc->name, ret);
+			return;
+		}
+	}
+	ticks = sbi_timer_value() - start;
+	if (!ticks)
+		ticks = 1;
+
+	sbi_printf("RPMI bench %-12s: latency min %lu avg %lu max %lu ns, "
+		   "throughput %lu req/s\n", bc->name,
+		   rpmi_bench_ticks_to_ns(min, freq),
+		   rpmi_bench_ticks_to_ns(total / iterations, freq),
+		   rpmi_bench_ticks_to_ns(max, freq),
+		   (unsigned long)(((u64)iterations * freq) / ticks));
+}
+
+void rpmi_mailbox_bench(struct mbox_controller *mbox, u32 iterations)
+{
+	const struct rpmi_bench_case *bc;
+	const struct sbi_timer_device *timer = sbi_timer_get_device();
+	struct mbox_chan *chan;
+	u32 i, chan_args[MBOX_CHAN_MAX_ARGS] = { 0 };
+
+	if (!mbox || !iterations)
+		return;
+
+	if (!timer || !timer->timer_freq) {
+		sbi_printf("RPMI bench: no timer available\n");
+		return;
+	}
+
+	for (i = 0; i < array_size(rpmi_bench_cases); i++) {
+		bc = &rpmi_bench_cases[i];
+
+		/* Channels are shared with drivers so they are not freed */
+		chan_args[0] = bc->servicegroup_id;
+		chan = mbox_controller_request_chan(mbox, chan_args);
+		if (!chan) {
+			sbi_printf("RPMI bench %-12s: not available\n",
+				   bc->name);
+			continue;
+		}
+
+		rpmi_bench_run(chan, bc, iterations, timer->timer_freq);
+	}
+}
@@ -0,0 +1,614 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Software stand-in for an RPMI platform microcontroller (PuC). It
+ * serves the base, HSM, clock, performance and system MSI service
+ * groups over the RPMI shared memory transport using plain memory
+ * so that RPMI drivers can be exercised without external firmware.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_io.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi_utils/mailbox/rpmi_soft_puc.h>
+
+#define SOFT_PUC_IMPL_ID		0x4f534249	/* "OSBI" */
+#define SOFT_PUC_VERSION		RPMI_VERSION(1, 0)
+#define SOFT_PUC_PLAT_INFO		"opensbi-soft-puc"
+
+/* Maximum number of request words looked at by any service */
+#define SOFT_PUC_MAX_REQ_WORDS		8
+
+enum soft_puc_queue_idx {
+	SOFT_PUC_QUEUE_A2P_REQ = 0,
+	SOFT_PUC_QUEUE_P2A_ACK = 1,
+	SOFT_PUC_QUEUE_P2A_REQ = 2,
+	SOFT_PUC_QUEUE_A2P_ACK = 3,
+};
+
+static const u64 soft_puc_clock_rates[] = {
+	100000000ULL, 200000000ULL, 400000000ULL, 800000000ULL,
+};
+
+/* Response being built by a service handler */
+struct soft_puc_resp {
+	u32 *data;
+	/* Number of valid bytes in data */
+	u32 len;
+	/* Number of leading u32 words needing endianness conversion */
+	u32 endian_words;
+	/* Maximum number of bytes in data */
+	u32 max_len;
+};
+
+static void __soft_puc_resp_set(struct soft_puc_resp *r, const u32 *words,
+				u32 count)
+{
+	u32 i;
+
+	for (i = 0; i < count; i++)
+		r->data[i] = words[i];
+
+	r->len = r->endian_words = count;
+	r->len *= sizeof(u32);
+}
+
+#define soft_puc_resp_words(__r, ...)					\
+do {									\
+	const u32 __w[] = { __VA_ARGS__ };				\
+	__soft_puc_resp_set((__r), __w, array_size(__w));		\
+} while (0)
+
+static void soft_puc_resp_status(struct soft_puc_resp *r, s32 status)
+{
+	soft_puc_resp_words(r, (u32)status);
+}
+
+/* Append a name string (not endian converted) after the response words */
+static void soft_puc_resp_name(struct soft_puc_resp *r, const char *fmt,
+			       u32 index)
+{
+	char *name = (char *)r->data + r->len;
+
+	sbi_memset(name, 0, RPMI_NAME_CHARS_MAX);
+	sbi_snprintf(name, RPMI_NAME_CHARS_MAX, fmt, index);
+	r->len += RPMI_NAME_CHARS_MAX;
+}
+
+/* Number of list entries (each of entry_words) fitting after hdr_words */
+static u32 soft_puc_resp_list_max(struct soft_puc_resp *r, u32 hdr_words,
+				  u32 entry_words)
+{
+	return (r->max_len / sizeof(u32) - hdr_words) / entry_words;
+}
+
+/**************** Base Service Group ****************/
+
+static bool soft_puc_group_supported(u32 group)
+{
+	switch (group) {
+	case RPMI_SRVGRP_BASE:
+	case RPMI_SRVGRP_SYSTEM_MSI:
+	case RPMI_SRVGRP_HSM:
+	case RPMI_SRVGRP_CLOCK:
+	case RPMI_SRVGRP_PERFORMANCE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void soft_puc_base(struct rpmi_soft_puc *puc, u8 service,
+			  const u32 *req, struct soft_puc_resp *r)
+{
+	u32 len;
+
+	switch (service) {
+	case RPMI_BASE_SRV_GET_IMPLEMENTATION_VERSION:
+		soft_puc_resp_words(r, RPMI_SUCCESS, SOFT_PUC_VERSION);
+		break;
+	case RPMI_BASE_SRV_GET_IMPLEMENTATION_IDN:
+		soft_puc_resp_words(r, RPMI_SUCCESS, SOFT_PUC_IMPL_ID);
+		break;
+	case RPMI_BASE_SRV_GET_SPEC_VERSION:
+		soft_puc_resp_words(r, RPMI_SUCCESS, SOFT_PUC_VERSION);
+		break;
+	case RPMI_BASE_SRV_GET_PLATFORM_INFO:
+		len = sizeof(SOFT_PUC_PLAT_INFO);
+		soft_puc_resp_words(r, RPMI_SUCCESS, len);
+		sbi_memcpy((char *)r->data + r->len, SOFT_PUC_PLAT_INFO, len);
+		r->len += len;
+		break;
+	case RPMI_BASE_SRV_PROBE_SERVICE_GROUP:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    soft_puc_group_supported(req[0]) ?
+				    SOFT_PUC_VERSION : 0);
+		break;
+	case RPMI_BASE_SRV_GET_ATTRIBUTES:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_BASE_FLAGS_F0_PRIVILEGE, 0, 0, 0);
+		break;
+	default:
+		soft_puc_resp_status(r, RPMI_ERR_NOTSUPP);
+		break;
+	}
+}
+
+/**************** System MSI Service Group ****************/
+
+static void soft_puc_sysmsi(struct rpmi_soft_puc *puc, u8 service,
+			    const u32 *req, struct soft_puc_resp *r)
+{
+	u32 idx = req[0];
+
+	if (service > RPMI_SYSMSI_SRV_GET_ATTRIBUTES &&
+	    idx >= RPMI_SOFT_PUC_NUM_SYSMSI) {
+		soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+		return;
+	}
+
+	switch (service) {
+	case RPMI_SYSMSI_SRV_GET_ATTRIBUTES:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_SOFT_PUC_NUM_SYSMSI, 0, 0);
+		break;
+	case RPMI_SYSMSI_SRV_GET_MSI_ATTRIBUTES:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_SYSMSI_MSI_ATTRIBUTES_FLAG0_PREF_PRIV, 0);
+		soft_puc_resp_name(r, "msi%d", idx);
+		break;
+	case RPMI_SYSMSI_SRV_SET_MSI_STATE:
+		puc->sysmsi[idx].state = req[1] & RPMI_SYSMSI_MSI_STATE_ENABLE;
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_SYSMSI_SRV_GET_MSI_STATE:
+		soft_puc_resp_words(r, RPMI_SUCCESS, puc->sysmsi[idx].state);
+		break;
+	case RPMI_SYSMSI_SRV_SET_MSI_TARGET:
+		puc->sysmsi[idx].addr = ((u64)req[2] << 32) | req[1];
+		puc->sysmsi[idx].data = req[3];
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_SYSMSI_SRV_GET_MSI_TARGET:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    (u32)puc->sysmsi[idx].addr,
+				    (u32)(puc->sysmsi[idx].addr >> 32),
+				    puc->sysmsi[idx].data);
+		break;
+	default:
+		soft_puc_resp_status(r, RPMI_ERR_NOTSUPP);
+		break;
+	}
+}
+
+/**************** HSM Service Group ****************/
+
+static u32 *soft_puc_hart_state(struct rpmi_soft_puc *puc, u32 hartid)
+{
+	u32 hartindex = sbi_hartid_to_hartindex(hartid);
+
+	if (!sbi_hartindex_valid(hartindex))
+		return NULL;
+
+	return &puc->hart_state[hartindex];
+}
+
+static void soft_puc_hsm(struct rpmi_soft_puc *puc, u8 service,
+			 const u32 *req, struct soft_puc_resp *r)
+{
+	u32 i, max, count, *state = NULL;
+
+	switch (service) {
+	case RPMI_HSM_SRV_GET_HART_STATUS:
+	case RPMI_HSM_SRV_HART_START:
+	case RPMI_HSM_SRV_HART_STOP:
+	case RPMI_HSM_SRV_HART_SUSPEND:
+		state = soft_puc_hart_state(puc, req[0]);
+		if (!state) {
+			soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	switch (service) {
+	case RPMI_HSM_SRV_GET_HART_STATUS:
+		soft_puc_resp_words(r, RPMI_SUCCESS, *state);
+		break;
+	case RPMI_HSM_SRV_GET_HART_LIST:
+		max = soft_puc_resp_list_max(r, 3, 1);
+		count = 0;
+		for (i = req[0]; i < sbi_hart_count() && count < max; i++)
+			r->data[3 + count++] = sbi_hartindex_to_hartid(i);
+		r->data[0] = RPMI_SUCCESS;
+		r->data[1] = (req[0] + count < sbi_hart_count()) ?
+			     sbi_hart_count() - (req[0] + count) : 0;
+		r->data[2] = count;
+		r->len = r->endian_words = 3 + count;
+		r->len *= sizeof(u32);
+		break;
+	case RPMI_HSM_SRV_GET_SUSPEND_TYPES:
+		/* Single default retentive suspend type */
+		if (req[0])
+			soft_puc_resp_words(r, RPMI_SUCCESS, 0, 0);
+		else
+			soft_puc_resp_words(r, RPMI_SUCCESS, 0, 1, 0);
+		break;
+	case RPMI_HSM_SRV_GET_SUSPEND_INFO:
+		if (req[0])
+			soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+		else
+			soft_puc_resp_words(r, RPMI_SUCCESS, 0,
+					    10, 10, 10, 100);
+		break;
+	case RPMI_HSM_SRV_HART_START:
+		if (*state != SBI_HSM_STATE_STOPPED) {
+			soft_puc_resp_status(r, RPMI_ERR_ALREADY);
+			break;
+		}
+		*state = SBI_HSM_STATE_STARTED;
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_HSM_SRV_HART_STOP:
+		*state = SBI_HSM_STATE_STOPPED;
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_HSM_SRV_HART_SUSPEND:
+		if (req[1]) {
+			soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+			break;
+		}
+		*state = SBI_HSM_STATE_SUSPENDED;
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	default:
+		soft_puc_resp_status(r, RPMI_ERR_NOTSUPP);
+		break;
+	}
+}
+
+/**************** Clock Service Group ****************/
+
+static void soft_puc_clock(struct rpmi_soft_puc *puc, u8 service,
+			   const u32 *req, struct soft_puc_resp *r)
+{
+	u32 i, max, count, id = req[0];
+	u64 rate;
+
+	if (service > RPMI_CLOCK_SRV_GET_NUM_CLOCKS &&
+	    id >= RPMI_SOFT_PUC_NUM_CLOCKS) {
+		soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+		return;
+	}
+
+	switch (service) {
+	case RPMI_CLOCK_SRV_GET_NUM_CLOCKS:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_SOFT_PUC_NUM_CLOCKS);
+		break;
+	case RPMI_CLOCK_SRV_GET_ATTRIBUTES:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_CLOCK_FLAGS_FORMAT_DISCRETE,
+				    (u32)array_size(soft_puc_clock_rates), 0);
+		soft_puc_resp_name(r, "clk%d", id);
+		break;
+	case RPMI_CLOCK_SRV_GET_SUPPORTED_RATES:
+		max = soft_puc_resp_list_max(r, 4, 2);
+		count = 0;
+		for (i = req[1]; i < array_size(soft_puc_clock_rates) &&
+				 count < max; i++, count++) {
+			r->data[4 + 2 * count] = (u32)soft_puc_clock_rates[i];
+			r->data[5 + 2 * count] = soft_puc_clock_rates[i] >> 32;
+		}
+		r->data[0] = RPMI_SUCCESS;
+		r->data[1] = RPMI_CLOCK_FLAGS_FORMAT_DISCRETE;
+		r->data[2] = (req[1] + count < array_size(soft_puc_clock_rates)) ?
+			     array_size(soft_puc_clock_rates) - (req[1] + count) : 0;
+		r->data[3] = count;
+		r->len = r->endian_words = 4 + 2 * count;
+		r->len *= sizeof(u32);
+		break;
+	case RPMI_CLOCK_SRV_SET_CONFIG:
+		puc->clocks[id].config = req[1] & RPMI_CLOCK_CONFIG_ENABLE;
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_CLOCK_SRV_GET_CONFIG:
+		soft_puc_resp_words(r, RPMI_SUCCESS, puc->clocks[id].config);
+		break;
+	case RPMI_CLOCK_SRV_SET_RATE:
+		rate = ((u64)req[3] << 32) | req[2];
+		for (i = 0; i < array_size(soft_puc_clock_rates); i++) {
+			if (soft_puc_clock_rates[i] == rate)
+				break;
+		}
+		if (i == array_size(soft_puc_clock_rates)) {
+			soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+			break;
+		}
+		puc->clocks[id].rate = rate;
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_CLOCK_SRV_GET_RATE:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    (u32)puc->clocks[id].rate,
+				    (u32)(puc->clocks[id].rate >> 32));
+		break;
+	default:
+		soft_puc_resp_status(r, RPMI_ERR_NOTSUPP);
+		break;
+	}
+}
+
+/**************** Performance Service Group ****************/
+
+static void soft_puc_perf(struct rpmi_soft_puc *puc, u8 service,
+			  const u32 *req, struct soft_puc_resp *r)
+{
+	u32 i, max, count, id = req[0];
+
+	if (service > RPMI_PERF_SRV_GET_NUM_DOMAINS &&
+	    service != RPMI_PERF_SRV_GET_FAST_CHANNEL_REGION &&
+	    id >= RPMI_SOFT_PUC_NUM_PERF_DOMAINS) {
+		soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+		return;
+	}
+
+	switch (service) {
+	case RPMI_PERF_SRV_GET_NUM_DOMAINS:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_SOFT_PUC_NUM_PERF_DOMAINS);
+		break;
+	case RPMI_PERF_SRV_GET_ATTRIBUTES:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    RPMI_PERF_DOMAIN_ATTRS_FLAGS_PERF_LVL_CHG_SUPP |
+				    RPMI_PERF_DOMAIN_ATTRS_FLAGS_PERF_LIMIT_CHG_SUPP,
+				    RPMI_SOFT_PUC_NUM_PERF_LEVELS, 0);
+		soft_puc_resp_name(r, "perf%d", id);
+		break;
+	case RPMI_PERF_SRV_GET_SUPPORTED_LEVELS:
+		max = soft_puc_resp_list_max(r, 4, 4);
+		count = 0;
+		for (i = req[1]; i < RPMI_SOFT_PUC_NUM_PERF_LEVELS &&
+				 count < max; i++, count++) {
+			r->data[4 + 4 * count] = i;
+			r->data[5 + 4 * count] = (i + 1) * 1000;
+			r->data[6 + 4 * count] = (i + 1) * 100000;
+			r->data[7 + 4 * count] = 100;
+		}
+		r->data[0] = RPMI_SUCCESS;
+		r->data[1] = 0;
+		r->data[2] = (req[1] + count < RPMI_SOFT_PUC_NUM_PERF_LEVELS) ?
+			     RPMI_SOFT_PUC_NUM_PERF_LEVELS - (req[1] + count) : 0;
+		r->data[3] = count;
+		r->len = r->endian_words = 4 + 4 * count;
+		r->len *= sizeof(u32);
+		break;
+	case RPMI_PERF_SRV_GET_LEVEL:
+		soft_puc_resp_words(r, RPMI_SUCCESS, puc->perf[id].level);
+		break;
+	case RPMI_PERF_SRV_SET_LEVEL:
+		if (req[1] < puc->perf[id].limit_min ||
+		    req[1] > puc->perf[id].limit_max) {
+			soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+			break;
+		}
+		puc->perf[id].level = req[1];
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	case RPMI_PERF_SRV_GET_LIMIT:
+		soft_puc_resp_words(r, RPMI_SUCCESS,
+				    puc->perf[id].limit_max,
+				    puc->perf[id].limit_min);
+		break;
+	case RPMI_PERF_SRV_SET_LIMIT:
+		if (req[1] < req[2] || req[1] >= RPMI_SOFT_PUC_NUM_PERF_LEVELS) {
+			soft_puc_resp_status(r, RPMI_ERR_INVALID_PARAM);
+			break;
+		}
+		puc->perf[id].limit_max = req[1];
+		puc->perf[id].limit_min = req[2];
+		if (puc->perf[id].level > req[1])
+			puc->perf[id].level = req[1];
+		if (puc->perf[id].level < req[2])
+			puc->perf[id].level = req[2];
+		soft_puc_resp_status(r, RPMI_SUCCESS);
+		break;
+	default:
+		/* No fast channels */
+		soft_puc_resp_status(r, RPMI_ERR_NOTSUPP);
+		break;
+	}
+}
+
+/**************** Transport ****************/
+
+static bool soft_puc_queue_empty(struct rpmi_soft_puc_queue *q)
+{
+	return le32_to_cpu(*q->headptr) == le32_to_cpu(*q->tailptr);
+}
+
+static bool soft_puc_queue_full(struct rpmi_soft_puc_queue *q)
+{
+	return ((le32_to_cpu(*q->tailptr) + 1) % q->num_slots) ==
+		le32_to_cpu(*q->headptr);
+}
+
+static void soft_puc_serve(struct rpmi_soft_puc *puc, u16 group, u8 service,
+			   const u32 *req, struct soft_puc_resp *r)
+{
+	switch (group) {
+	case RPMI_SRVGRP_BASE:
+		soft_puc_base(puc, service, req, r);
+		break;
+	case RPMI_SRVGRP_SYSTEM_MSI:
+		soft_puc_sysmsi(puc, service, req, r);
+		break;
+	case RPMI_SRVGRP_HSM:
+		soft_puc_hsm(puc, service, req, r);
+		break;
+	case RPMI_SRVGRP_CLOCK:
+		soft_puc_clock(puc, service, req, r);
+		break;
+	case RPMI_SRVGRP_PERFORMANCE:
+		soft_puc_perf(puc, service, req, r);
+		break;
+	default:
+		soft_puc_resp_status(r, RPMI_ERR_NOTSUPP);
+		return;
+	}
+
+	if (group < RPMI_SRVGRP_ID_MAX_COUNT)
+		puc->served[group]++;
+}
+
+/* Serve the request at the head of A2P REQ queue */
+static void soft_puc_serve_one(struct rpmi_soft_puc *puc,
+			       struct rpmi_message *msg)
+{
+	struct rpmi_soft_puc_queue *ackq = &puc->queues[SOFT_PUC_QUEUE_P2A_ACK];
+	u32 i, nwords, tailidx, req[SOFT_PUC_MAX_REQ_WORDS] = { 0 };
+	struct rpmi_message *ack;
+	struct soft_puc_resp r;
+	u8 type;
+
+	nwords = le16_to_cpu(msg->header.datalen) / sizeof(u32);
+	if (nwords > SOFT_PUC_MAX_REQ_WORDS)
+		nwords = SOFT_PUC_MAX_REQ_WORDS;
+	for (i = 0; i < nwords; i++)
+		req[i] = le32_to_cpu(((le32_t *)msg->data)[i]);
+
+	r.data = puc->resp;
+	r.max_len = RPMI_MSG_DATA_SIZE(puc->slot_size);
+	soft_puc_serve(puc, le16_to_cpu(msg->header.servicegroup_id),
+		       msg->header.service_id, req, &r);
+
+	type = (msg->header.flags & RPMI_MSG_FLAGS_TYPE) >>
+		RPMI_MSG_FLAGS_TYPE_POS;
+	if (type != RPMI_MSG_NORMAL_REQUEST)
+		return;
+
+	tailidx = le32_to_cpu(*ackq->tailptr);
+	ack = (void *)ackq->buffer + tailidx * puc->slot_size;
+	ack->header.servicegroup_id = msg->header.servicegroup_id;
+	ack->header.service_id = msg->header.service_id;
+	ack->header.flags = RPMI_MSG_ACKNOWLDGEMENT << RPMI_MSG_FLAGS_TYPE_POS;
+	ack->header.datalen = cpu_to_le16(r.len);
+	ack->header.token = msg->header.token;
+	for (i = 0; i < r.endian_words; i++)
+		((le32_t *)ack->data)[i] = cpu_to_le32(r.data[i]);
+	sbi_memcpy(ack->data + r.endian_words * sizeof(u32),
+		   (u8 *)r.data + r.endian_words * sizeof(u32),
+		   r.len - r.endian_words * sizeof(u32));
+
+	/* Make sure the acknowledgement is written before the tail */
+	smp_wmb();
+	*ackq->tailptr = cpu_to_le32((tailidx + 1) % ackq->num_slots);
+}
+
+u32 rpmi_soft_puc_poll(struct rpmi_soft_puc *puc)
+{
+	struct rpmi_soft_puc_queue *reqq = &puc->queues[SOFT_PUC_QUEUE_A2P_REQ];
+	struct rpmi_soft_puc_queue *ackq = &puc->queues[SOFT_PUC_QUEUE_P2A_ACK];
+	struct rpmi_message *msg;
+	u32 headidx, msi, served = 0;
+
+	spin_lock(&puc->lock);
+
+	while (!soft_puc_queue_empty(reqq)) {
+		/* Read the request only after observing the tail update */
+		smp_rmb();
+
+		headidx = le32_to_cpu(*reqq->headptr);
+		msg = (void *)reqq->buffer + headidx * puc->slot_size;
+
+		/* Leave the request pending until there is space for the ack */
+		if (((msg->header.flags & RPMI_MSG_FLAGS_TYPE) >>
+		     RPMI_MSG_FLAGS_TYPE_POS) == RPMI_MSG_NORMAL_REQUEST &&
+		    soft_puc_queue_full(ackq))
+			break;
+
+		soft_puc_serve_one(puc, msg);
+
+		/* Make sure the request is consumed before the head moves */
+		smp_mb();
+		*reqq->headptr = cpu_to_le32((headidx + 1) % reqq->num_slots);
+		served++;
+	}
+
+	/* Ring the P2A doorbell system MSI if the AP has configured it */
+	msi = puc->p2a_doorbell_sysmsi_index;
+	if (served && msi < RPMI_SOFT_PUC_NUM_SYSMSI &&
+	    puc->sysmsi[msi].state && puc->sysmsi[msi].addr)
+		writel(puc->sysmsi[msi].data,
+		       (void *)(unsigned long)puc->sysmsi[msi].addr);
+
+	spin_unlock(&puc->lock);
+
+	return served;
+}
+
+void __noreturn rpmi_soft_puc_run(struct rpmi_soft_puc *puc)
+{
+	while (1) {
+		if (!rpmi_soft_puc_poll(puc))
+			cpu_relax();
+	}
+}
+
+int rpmi_soft_puc_init(struct rpmi_soft_puc *puc, void *base,
+		       unsigned long queue_size, u32 slot_size)
+{
+	struct rpmi_soft_puc_queue *q;
+	u32 i;
+
+	if (!puc || !base || slot_size < RPMI_SLOT_SIZE_MIN ||
+	    queue_size < (RPMI_QUEUE_HEADER_SLOTS + 2) * slot_size)
+		return SBI_EINVAL;
+
+	sbi_memset(puc, 0, sizeof(*puc));
+	puc->slot_size = slot_size;
+	puc->p2a_doorbell_sysmsi_index = -1U;
+	SPIN_LOCK_INIT(puc->lock);
+
+	puc->resp = sbi_zalloc(RPMI_MSG_DATA_SIZE(slot_size));
+	if (!puc->resp)
+		return SBI_ENOMEM;
+
+	puc->hart_state = sbi_calloc(sbi_hart_count(), sizeof(*puc->hart_state));
+	if (!puc->hart_state) {
+		sbi_free(puc->resp);
+		return SBI_ENOMEM;
+	}
+	/* All HARTs are running OpenSBI when the PuC comes up */
+	for (i = 0; i < sbi_hart_count(); i++)
+		puc->hart_state[i] = SBI_HSM_STATE_STARTED;
+
+	for (i = 0; i < RPMI_SOFT_PUC_NUM_CLOCKS; i++)
+		puc->clocks[i].rate = soft_puc_clock_rates[0];
+
+	for (i = 0; i < RPMI_SOFT_PUC_NUM_PERF_DOMAINS; i++)
+		puc->perf[i].limit_max = RPMI_SOFT_PUC_NUM_PERF_LEVELS - 1;
+
+	for (i = 0; i < RPMI_SOFT_PUC_QUEUE_COUNT; i++) {
+		q = &puc->queues[i];
+		sbi_memset(base + i * queue_size, 0, queue_size);
+		q->headptr = base + i * queue_size +
+			     RPMI_QUEUE_HEAD_SLOT * slot_size;
+		q->tailptr = base + i * queue_size +
+			     RPMI_QUEUE_TAIL_SLOT * slot_size;
+		q->buffer = base + i * queue_size +
+			    RPMI_QUEUE_HEADER_SLOTS * slot_size;
+		q->num_slots = (queue_size / slot_size) - RPMI_QUEUE_HEADER_SLOTS;
+	}
+
+	return 0;
+}
@@ -241,9 +241,14 @@ int generic_final_init(bool cold_boot)
 	if (!cold_boot)
 		return 0;
 
+	/* Collect DT property edits of all fixups and apply them together */
+	fdt_fixup_plan_begin();
 	fdt_cpu_fixup(fdt);
 	fdt_fixups(fdt);
 	fdt_domain_fixup(fdt);
+	fdt_fixup_plan_end(fdt);
+	fdt_lookup_cache_invalidate();
+	fdt_driver_index_invalidate();
 
 	/* Set the empty space in FDT based on kconfig option */
 	fdt_pack(fdt);